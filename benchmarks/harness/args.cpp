@@ -0,0 +1,61 @@
+#include <harness/args.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <engine/log.h>
+
+namespace mau {
+
+  void BenchmarkArgs::Add(const char *name, String &value) {
+    m_Options.push_back({name, true, [&value](const char *text) -> void { value = text; }});
+  }
+
+  void BenchmarkArgs::Add(const char *name, std::string_view &value) {
+    m_Options.push_back({name, true, [&value](const char *text) -> void { value = text; }});
+  }
+
+  static TUint32 parse_uint(const char *text, TUint32 min, TUint32 max) {
+    const long long parsed = std::strtoll(text, nullptr, 10);
+    return static_cast<TUint32>(std::clamp(parsed, static_cast<long long>(min), static_cast<long long>(max)));
+  }
+
+  void BenchmarkArgs::Add(const char *name, TUint32 &value, TUint32 min, TUint32 max) {
+    m_Options.push_back({name, true, [&value, min, max](const char *text) -> void { value = parse_uint(text, min, max); }});
+  }
+
+  void BenchmarkArgs::Add(const char *name, Vector<TUint32> &values, TUint32 min, TUint32 max) {
+    m_Options.push_back({name, true, [&values, min, max](const char *text) -> void { values.push_back(parse_uint(text, min, max)); }});
+  }
+
+  void BenchmarkArgs::Add(const char *name, TFloat32 &value, TFloat32 min, TFloat32 max) {
+    m_Options.push_back({name, true, [&value, min, max](const char *text) -> void { value = std::clamp(static_cast<TFloat32>(std::atof(text)), min, max); }});
+  }
+
+  void BenchmarkArgs::AddSwitch(const char *name, std::function<void()> action) {
+    m_Options.push_back({name, false, [action = std::move(action)](const char *) -> void { action(); }});
+  }
+
+  bool BenchmarkArgs::Parse(int argc, char **argv) const {
+    for (int i = 1; i < argc; i++) {
+      auto option = std::find_if(m_Options.begin(), m_Options.end(), [&](const Option &o) -> bool { return std::strcmp(argv[i], o.Name) == 0; });
+
+      if (option == m_Options.end()) {
+        LOG_ERROR("unknown argument %s", argv[i]);
+        return false;
+      }
+
+      if (!option->HasValue) {
+        option->Apply(nullptr);
+      } else if (i + 1 < argc) {
+        option->Apply(argv[++i]);
+      } else {
+        LOG_ERROR("argument %s needs a value", argv[i]);
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+} // namespace mau
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cfloat>
+#include <functional>
+#include <string_view>
+#include <engine/types.h>
+
+namespace mau {
+
+  // command line of a benchmark, every option is registered with the value it writes and Parse fills them in.
+  // numbers are clamped to their range, an unknown argument or a missing value fails the parse
+  class BenchmarkArgs {
+  public:
+    BenchmarkArgs() = default;
+    ~BenchmarkArgs() = default;
+
+  public:
+    void Add(const char *name, String &value);
+    // points into argv, which outlives main
+    void Add(const char *name, std::string_view &value);
+    void Add(const char *name, TUint32 &value, TUint32 min = 0u, TUint32 max = UINT32_MAX);
+    // appends every time the option is given
+    void Add(const char *name, Vector<TUint32> &values, TUint32 min = 0u, TUint32 max = UINT32_MAX);
+    void Add(const char *name, TFloat32 &value, TFloat32 min = -FLT_MAX, TFloat32 max = FLT_MAX);
+    // an option without value, runs action when it is given
+    void AddSwitch(const char *name, std::function<void()> action);
+
+    bool Parse(int argc, char **argv) const;
+
+  private:
+    struct Option {
+      const char                            *Name = nullptr;
+      bool                                   HasValue = true;
+      std::function<void(const char *value)> Apply = nullptr;
+    };
+
+  private:
+    Vector<Option> m_Options = {};
+  };
+
+} // namespace mau
@@ -0,0 +1,264 @@
+#include <harness/bvh.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "loader/mesh-cache.h"
+#include "scene/bvh.h"
+#include "scene/camera.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  // rays per job when tracing, packets are 4x2 pixel blocks
+  constexpr TUint32 BVH_BENCH_GRAIN = 4096u;
+  constexpr TUint32 BVH_BENCH_PACKET_WIDTH = 4u;
+  constexpr TUint32 BVH_BENCH_PACKET_HEIGHT = BVH_PACKET_SIZE / BVH_BENCH_PACKET_WIDTH;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  static TFloat64 mrays(TUint64 ray_count, TFloat64 ms) { return ms > 0.0 ? static_cast<TFloat64>(ray_count) / (ms * 1e3) : 0.0; }
+
+  // camera rays the way basic.rgen makes them, through the inverse view and projection. the camera sits in the
+  // middle of the scene looking down its longest horizontal axis
+  static Vector<BvhRay> make_primary_rays(const glm::vec3 &bounds_min, const glm::vec3 &bounds_max, TUint32 width, TUint32 height) {
+    const glm::vec3 extent = bounds_max - bounds_min;
+
+    Camera camera = {};
+    camera.Position = 0.5f * (bounds_min + bounds_max);
+    camera.Direction = extent.x >= extent.z ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    const glm::mat4 view_inverse = glm::inverse(camera.GetView());
+    const glm::mat4 proj_inverse = glm::inverse(camera.GetProj(glm::vec2(static_cast<TFloat32>(width), static_cast<TFloat32>(height))));
+    const glm::vec3 origin = glm::vec3(view_inverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    // stored in packet order so both single rays and packets walk the image block by block
+    Vector<BvhRay> rays(static_cast<size_t>(width) * height);
+    TUint32        index = 0u;
+    for (TUint32 block_y = 0u; block_y < height; block_y += BVH_BENCH_PACKET_HEIGHT) {
+      for (TUint32 block_x = 0u; block_x < width; block_x += BVH_BENCH_PACKET_WIDTH) {
+        for (TUint32 y = block_y; y < std::min(block_y + BVH_BENCH_PACKET_HEIGHT, height); y++) {
+          for (TUint32 x = block_x; x < std::min(block_x + BVH_BENCH_PACKET_WIDTH, width); x++) {
+            const glm::vec2 uv = (glm::vec2(static_cast<TFloat32>(x), static_cast<TFloat32>(y)) + 0.5f) / glm::vec2(static_cast<TFloat32>(width), static_cast<TFloat32>(height));
+            const glm::vec2 d = uv * 2.0f - 1.0f;
+            const glm::vec4 target = proj_inverse * glm::vec4(d.x, -d.y, 1.0f, 1.0f);
+
+            BvhRay &ray = rays[index++];
+            ray.Origin = origin;
+            ray.Direction = glm::vec3(view_inverse * glm::vec4(glm::normalize(glm::vec3(target)), 0.0f));
+            ray.TMin = 0.001f;
+            ray.TMax = 10000.0f;
+          }
+        }
+      }
+    }
+
+    return rays;
+  }
+
+  static Vector<BvhRay> make_incoherent_rays(const glm::vec3 &bounds_min, const glm::vec3 &bounds_max, TUint32 count) {
+    std::mt19937                             rng(1337u);
+    std::uniform_real_distribution<TFloat32> unit(0.0f, 1.0f);
+    std::normal_distribution<TFloat32>       normal(0.0f, 1.0f);
+
+    Vector<BvhRay> rays(count);
+    for (BvhRay &ray : rays) {
+      ray.Origin = bounds_min + (bounds_max - bounds_min) * glm::vec3(unit(rng), unit(rng), unit(rng));
+
+      glm::vec3 direction = glm::vec3(0.0f);
+      while (glm::dot(direction, direction) < 1e-6f) {
+        direction = glm::vec3(normal(rng), normal(rng), normal(rng));
+      }
+      ray.Direction = glm::normalize(direction);
+      ray.TMin = 0.001f;
+      ray.TMax = 10000.0f;
+    }
+
+    return rays;
+  }
+
+  // closest hit distance over every triangle, the reference the bvh has to agree with
+  static TFloat32 brute_force_hit(const Vector<MeshGeometry> &submeshes, const BvhRay &ray) {
+    TFloat32 closest = ray.TMax;
+    for (const MeshGeometry &submesh : submeshes) {
+      for (size_t i = 0; i + 2u < submesh.Indices.size(); i += 3u) {
+        const glm::vec3 v0 = submesh.Vertices[submesh.Indices[i]].pos;
+        const glm::vec3 e1 = submesh.Vertices[submesh.Indices[i + 1u]].pos - v0;
+        const glm::vec3 e2 = submesh.Vertices[submesh.Indices[i + 2u]].pos - v0;
+
+        const glm::vec3 p = glm::cross(ray.Direction, e2);
+        const TFloat32  det = glm::dot(e1, p);
+        if (std::fabs(det) < 1e-12f)
+          continue;
+
+        const TFloat32  inv_det = 1.0f / det;
+        const glm::vec3 s = ray.Origin - v0;
+        const TFloat32  u = glm::dot(s, p) * inv_det;
+        const glm::vec3 q = glm::cross(s, e1);
+        const TFloat32  v = glm::dot(ray.Direction, q) * inv_det;
+        const TFloat32  t = glm::dot(e2, q) * inv_det;
+
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= ray.TMin && t < closest) {
+          closest = t;
+        }
+      }
+    }
+
+    return closest;
+  }
+
+  template <TUint32 Width> static BvhWidthResult benchmark_width(const Vector<BvhGeometry> &geometries, const Vector<MeshGeometry> &submeshes, const Vector<BvhRay> &primary_rays,
+                                                                  const Vector<BvhRay> &incoherent_rays, const BvhBenchmarkConfig &config) {
+    JobSystem &jobs = JobSystem::Ref();
+
+    BvhWidthResult result = {.Width = Width, .BuildMs = 1e30, .ParallelBuildMs = 1e30};
+    Bvh<Width>     bvh = {};
+
+    for (TUint32 iteration = 0u; iteration < config.Iterations; iteration++) {
+      bvh.Build(geometries, {.Parallel = false});
+      result.BuildMs = std::min(result.BuildMs, bvh.GetStats().BuildMs);
+
+      bvh.Build(geometries, {.Parallel = true});
+      result.ParallelBuildMs = std::min(result.ParallelBuildMs, bvh.GetStats().BuildMs);
+    }
+
+    const BvhBuildStats &stats = bvh.GetStats();
+    result.NodeCount = stats.NodeCount;
+    result.LeafCount = stats.LeafCount;
+    result.MaxDepth = stats.MaxDepth;
+    result.SahCost = stats.SahCost;
+
+    // the hit count keeps the traversal from being optimized away and is compared between the ways of tracing
+    auto trace = [&](const Vector<BvhRay> &rays, bool packets, bool occlusion, TUint64 &hit_count) -> TFloat64 {
+      const TUint32        count = static_cast<TUint32>(rays.size());
+      std::atomic<TUint64> hits = 0u;
+
+      // packets are split across jobs as a whole
+      const TUint32 item_count = packets ? (count + BVH_PACKET_SIZE - 1u) / BVH_PACKET_SIZE : count;
+      const TUint32 grain = packets ? BVH_BENCH_GRAIN / BVH_PACKET_SIZE : BVH_BENCH_GRAIN;
+
+      const Clock::time_point start = Clock::now();
+      jobs.ParallelFor(item_count, grain, [&](TUint32 begin, TUint32 end) {
+        TUint64 range_hits = 0u;
+        if (packets) {
+          BvhHit packet_hits[BVH_PACKET_SIZE];
+          for (TUint32 i = begin * BVH_PACKET_SIZE; i < std::min(end * BVH_PACKET_SIZE, count); i += BVH_PACKET_SIZE) {
+            const TUint32 packet_count = std::min(BVH_PACKET_SIZE, count - i);
+            bvh.IntersectPacket(&rays[i], packet_hits, packet_count);
+            for (TUint32 k = 0u; k < packet_count; k++) {
+              range_hits += packet_hits[k].IsHit() ? 1u : 0u;
+            }
+          }
+        } else if (occlusion) {
+          for (TUint32 i = begin; i < end; i++) {
+            range_hits += bvh.Occluded(rays[i]) ? 1u : 0u;
+          }
+        } else {
+          BvhHit hit = {};
+          for (TUint32 i = begin; i < end; i++) {
+            range_hits += bvh.Intersect(rays[i], hit) ? 1u : 0u;
+          }
+        }
+        hits.fetch_add(range_hits, std::memory_order_relaxed);
+      });
+
+      hit_count = hits.load();
+      return elapsed_ms(start);
+    };
+
+    TFloat64 primary_ms = 1e30, packet_ms = 1e30, incoherent_ms = 1e30, occlusion_ms = 1e30;
+    TUint64  primary_hits = 0u, packet_hits = 0u, incoherent_hits = 0u, occluded_hits = 0u;
+
+    for (TUint32 iteration = 0u; iteration < config.Iterations; iteration++) {
+      primary_ms = std::min(primary_ms, trace(primary_rays, false, false, primary_hits));
+      packet_ms = std::min(packet_ms, trace(primary_rays, true, false, packet_hits));
+      incoherent_ms = std::min(incoherent_ms, trace(incoherent_rays, false, false, incoherent_hits));
+      occlusion_ms = std::min(occlusion_ms, trace(incoherent_rays, false, true, occluded_hits));
+    }
+
+    result.PrimaryMrays = mrays(primary_rays.size(), primary_ms);
+    result.PacketMrays = mrays(primary_rays.size(), packet_ms);
+    result.IncoherentMrays = mrays(incoherent_rays.size(), incoherent_ms);
+    result.OcclusionMrays = mrays(incoherent_rays.size(), occlusion_ms);
+
+    if (primary_hits != packet_hits || incoherent_hits != occluded_hits) {
+      LOG_WARN("bvh%u hit counts disagree [single: %llu, packet: %llu, closest: %llu, occluded: %llu]", Width, static_cast<unsigned long long>(primary_hits),
+               static_cast<unsigned long long>(packet_hits), static_cast<unsigned long long>(incoherent_hits), static_cast<unsigned long long>(occluded_hits));
+    }
+
+    // half primary and half incoherent rays, spread over the whole set
+    const TUint32         validation_count = std::min(config.ValidationRayCount, static_cast<TUint32>(std::min(primary_rays.size(), incoherent_rays.size())));
+    std::atomic<TUint32> mismatches = 0u;
+    jobs.ParallelFor(validation_count, 1u, [&](TUint32 begin, TUint32 end) {
+      for (TUint32 i = begin; i < end; i++) {
+        const Vector<BvhRay> &rays = (i & 1u) ? incoherent_rays : primary_rays;
+        const BvhRay         &ray = rays[static_cast<size_t>(i) * rays.size() / validation_count];
+
+        BvhHit         hit = {};
+        const TFloat32 expected = brute_force_hit(submeshes, ray);
+        const TFloat32 found = bvh.Intersect(ray, hit) ? hit.T : ray.TMax;
+        if (std::fabs(expected - found) > 1e-4f * std::max(1.0f, expected)) {
+          mismatches.fetch_add(1u, std::memory_order_relaxed);
+        }
+      }
+    });
+    result.Mismatches = mismatches.load();
+
+    return result;
+  }
+
+  bool BenchmarkBvh(const BvhBenchmarkConfig &config, BvhBenchmarkResult &result) {
+    const String mesh_path = config.MeshPath.empty() ? GetAssetFolderPath() + "assets/models/Sponza/glTF/Sponza.gltf" : config.MeshPath;
+
+    const Clock::time_point load_start = Clock::now();
+    Vector<MeshGeometry>    submeshes = {};
+    if (!load_mesh_geometry(mesh_path, submeshes))
+      return false;
+
+    result = {};
+    result.LoadMs = elapsed_ms(load_start);
+    result.ThreadCount = JobSystem::Ref().GetThreadCount();
+
+    Vector<BvhGeometry> geometries = {};
+    for (const MeshGeometry &submesh : submeshes) {
+      if (submesh.Indices.empty())
+        continue;
+
+      geometries.push_back({
+          .Positions = &submesh.Vertices[0].pos,
+          .PositionStride = sizeof(Vertex),
+          .VertexCount = submesh.Vertices.size(),
+          .Indices = submesh.Indices.data(),
+          .IndexCount = submesh.Indices.size(),
+      });
+      result.TriangleCount += static_cast<TUint32>(submesh.Indices.size() / 3u);
+    }
+
+    if (result.TriangleCount == 0u) {
+      LOG_ERROR("mesh %s has no triangles", mesh_path.c_str());
+      return false;
+    }
+
+    LOG_INFO("bvh benchmark started %s [triangles: %u, threads: %u, load: %.1f ms]", mesh_path.c_str(), result.TriangleCount, result.ThreadCount, result.LoadMs);
+
+    // bounds for the rays come from a throwaway build so the rays do not depend on the width being measured
+    Bvh4 bounds_bvh = {};
+    bounds_bvh.Build(geometries);
+
+    const Vector<BvhRay> primary_rays = make_primary_rays(bounds_bvh.GetBoundsMin(), bounds_bvh.GetBoundsMax(), config.Width, config.Height);
+    const Vector<BvhRay> incoherent_rays = make_incoherent_rays(bounds_bvh.GetBoundsMin(), bounds_bvh.GetBoundsMax(), config.IncoherentRayCount);
+
+    result.Bvh4 = benchmark_width<4u>(geometries, submeshes, primary_rays, incoherent_rays, config);
+    result.Bvh8 = benchmark_width<8u>(geometries, submeshes, primary_rays, incoherent_rays, config);
+    return true;
+  }
+
+} // namespace mau
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct BvhBenchmarkConfig {
+    // empty benchmarks sponza
+    String  MeshPath = "";
+    TUint32 Width = 1280u;
+    TUint32 Height = 720u;
+    TUint32 IncoherentRayCount = 1u << 20u;
+    // rays checked against testing every triangle
+    TUint32 ValidationRayCount = 256u;
+    TUint32 Iterations = 3u;
+  };
+
+  // best of all iterations. primary rays start at the camera and go through every pixel, incoherent rays start
+  // anywhere inside the scene bounds in random directions. mismatches are validation rays whose closest hit
+  // differs from the brute force one
+  struct BvhWidthResult {
+    TUint32  Width = 0u;
+    TFloat64 BuildMs = 0.0;
+    TFloat64 ParallelBuildMs = 0.0;
+    TUint32  NodeCount = 0u;
+    TUint32  LeafCount = 0u;
+    TUint32  MaxDepth = 0u;
+    TFloat32 SahCost = 0.0f;
+    TFloat64 PrimaryMrays = 0.0;
+    TFloat64 PacketMrays = 0.0;
+    TFloat64 IncoherentMrays = 0.0;
+    TFloat64 OcclusionMrays = 0.0;
+    TUint32  Mismatches = 0u;
+  };
+
+  struct BvhBenchmarkResult {
+    TUint32        TriangleCount = 0u;
+    TUint32        ThreadCount = 0u;
+    TFloat64       LoadMs = 0.0;
+    BvhWidthResult Bvh4 = {};
+    BvhWidthResult Bvh8 = {};
+  };
+
+  // builds 4 and 8 wide cpu bvhs over a mesh, single threaded and on the job system, and traces rays against them.
+  // only needs the job system, the mesh is read without a gpu. false when the mesh could not be loaded
+  bool BenchmarkBvh(const BvhBenchmarkConfig &config, BvhBenchmarkResult &result);
+
+} // namespace mau
@@ -0,0 +1,81 @@
+#include <harness/cpu-reference.h>
+
+#include <chrono>
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+
+#include "renderer/cpu-path-tracer.h"
+#include "loader/image-writer.h"
+#include "scene/camera-path.h"
+#include "scene/transform-system.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  bool RenderCpuReference(const CpuReferenceConfig &config, CpuReferenceResult &result) {
+    const String scene_path = config.ScenePath.empty() ? GetAssetFolderPath() + "assets/models/Sponza/glTF/Sponza.gltf" : config.ScenePath;
+
+    result = {};
+    result.ThreadCount = JobSystem::Ref().GetThreadCount();
+
+    // placed where the engine places it, the camera paths are recorded against that
+    const TransformComponent transform = GetSceneTransform();
+    CpuScene                 scene = {};
+    if (!scene.Load(scene_path, compose_transform(transform.Position, transform.Rotation, transform.Scale)))
+      return false;
+
+    result.TriangleCount = scene.GetTriangleCount();
+    result.LoadMs = scene.GetLoadMs();
+
+    CpuPathTracer tracer(scene, {
+                                    .Width = config.Width,
+                                    .Height = config.Height,
+                                    .TileSize = config.TileSize,
+                                    .MinSamples = config.MinSamples,
+                                    .MaxSamples = config.MaxSamples,
+                                    .NoiseThreshold = config.NoiseThreshold,
+                                });
+
+    CameraPath path = {};
+    if (!config.CameraPath.empty() && path.Load(config.CameraPath)) {
+      tracer.SetCamera(path.Sample(config.CameraTime));
+    }
+
+    LOG_INFO("cpu reference started [%ux%u, samples: %u-%u, threads: %u]", config.Width, config.Height, config.MinSamples, config.MaxSamples, result.ThreadCount);
+
+    // every pass adds a few samples to the tiles that are still noisy
+    const Clock::time_point start = Clock::now();
+    while (tracer.RenderPass()) {
+      const CpuPathTracerStats &stats = tracer.GetStats();
+      LOG_INFO("cpu reference pass %u [active tiles: %u/%u, %.1f s]", stats.Passes, stats.ActiveTiles, stats.TileCount,
+               std::chrono::duration<TFloat64>(Clock::now() - start).count());
+    }
+    result.RenderSeconds = std::chrono::duration<TFloat64>(Clock::now() - start).count();
+
+    const CpuPathTracerStats &stats = tracer.GetStats();
+    result.Passes = stats.Passes;
+    result.TileCount = stats.TileCount;
+    result.Samples = stats.Samples;
+    result.Rays = stats.Rays;
+    result.SamplesPerPixel = static_cast<TFloat64>(stats.Samples) / (static_cast<TFloat64>(config.Width) * config.Height);
+    result.MraysPerSecond = result.RenderSeconds > 0.0 ? static_cast<TFloat64>(stats.Rays) / result.RenderSeconds * 1e-6 : 0.0;
+    result.MsamplesPerSecond = result.RenderSeconds > 0.0 ? static_cast<TFloat64>(stats.Samples) / result.RenderSeconds * 1e-6 : 0.0;
+
+    LOG_INFO("cpu reference done [%.2f s, %.1f spp, %.2f Mrays/s, %.2f Msamples/s]", result.RenderSeconds, result.SamplesPerPixel, result.MraysPerSecond, result.MsamplesPerSecond);
+
+    if (config.OutputPath.empty())
+      return true;
+
+    Vector<TFloat32> linear = {}, display = {};
+    tracer.Resolve(linear, display);
+
+    if (!write_pfm(config.OutputPath + ".pfm", config.Width, config.Height, linear.data()) || !write_ppm(config.OutputPath + ".ppm", config.Width, config.Height, display.data()))
+      return false;
+
+    LOG_INFO("cpu reference written to %s.pfm and %s.ppm", config.OutputPath.c_str(), config.OutputPath.c_str());
+    return true;
+  }
+
+} // namespace mau
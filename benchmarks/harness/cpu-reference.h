@@ -0,0 +1,42 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct CpuReferenceConfig {
+    // empty renders sponza
+    String   ScenePath = "";
+    // camera keyframes sampled at CameraTime, empty keeps the renderer's default camera
+    String   CameraPath = "";
+    TFloat32 CameraTime = 0.0f;
+    TUint32  Width = 1280u;
+    TUint32  Height = 720u;
+    TUint32  TileSize = 16u;
+    TUint32  MinSamples = 16u;
+    TUint32  MaxSamples = 256u;
+    // relative noise a tile has to get below before it stops short of MaxSamples
+    TFloat32 NoiseThreshold = 0.02f;
+    // writes <path>.pfm with the linear image and <path>.ppm gamma corrected, empty writes nothing
+    String   OutputPath = "reference";
+  };
+
+  struct CpuReferenceResult {
+    TUint32  TriangleCount = 0u;
+    TUint32  ThreadCount = 0u;
+    TUint32  Passes = 0u;
+    TUint32  TileCount = 0u;
+    TFloat64 LoadMs = 0.0;
+    TFloat64 RenderSeconds = 0.0;
+    TUint64  Samples = 0u;
+    TUint64  Rays = 0u;
+    TFloat64 SamplesPerPixel = 0.0;
+    TFloat64 MraysPerSecond = 0.0;
+    TFloat64 MsamplesPerSecond = 0.0;
+  };
+
+  // renders a scene with the cpu path tracer, the same camera, random sequence, bounces and light as the raytracing
+  // shaders. only needs the job system, nothing touches the gpu. false when the scene could not be loaded or written
+  bool RenderCpuReference(const CpuReferenceConfig &config, CpuReferenceResult &result);
+
+} // namespace mau
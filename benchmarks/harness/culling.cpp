@@ -0,0 +1,117 @@
+#include <harness/culling.h>
+
+#include <chrono>
+#include <random>
+#include <engine/core/job-system.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "renderer/frustum-culler.h"
+#include "scene/camera.h"
+#include "scene/transform-system.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  // laid out like a snapshot draw so the culler reads it with a stride
+  struct CullingItem {
+    glm::mat4      Model = glm::mat4(1.0f);
+    BoundingBox    Bounds = {};
+    BoundingSphere Sphere = {};
+  };
+
+  struct CullingVariant {
+    const char *Name = "";
+    TUint32     Width = 0u; // 0 is the scalar test
+    bool        Parallel = false;
+  };
+
+  void BenchmarkFrustumCulling(const CullingBenchmarkConfig &config, CullingBenchmarkResult &result) {
+    std::mt19937                          rng(config.Seed);
+    std::uniform_real_distribution<float> position(-config.SceneExtent, config.SceneExtent);
+    std::uniform_real_distribution<float> rotation(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    // a few items have no bounds and are always drawn
+    Vector<CullingItem> items(std::max(config.ItemCount, 1u));
+    for (TUint32 i = 0; i < items.size(); i++) {
+      CullingItem &item = items[i];
+      item.Model = compose_transform(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(rotation(rng), rotation(rng), rotation(rng)),
+                                     glm::vec3(scale(rng), scale(rng), scale(rng)));
+      if (i % 1024u == 0u)
+        continue;
+
+      const glm::vec3 center = glm::vec3(direction(rng), direction(rng), direction(rng));
+      const glm::vec3 extent = glm::vec3(size(rng), size(rng), size(rng));
+      item.Bounds = {.Min = center - extent, .Max = center + extent};
+      item.Sphere = {.Center = center, .Radius = glm::length(extent)};
+    }
+
+    const CullInput input = {
+        .Models = &items[0].Model,
+        .Boxes = &items[0].Bounds,
+        .Spheres = &items[0].Sphere,
+        .Stride = sizeof(CullingItem),
+        .Count = static_cast<TUint32>(items.size()),
+    };
+
+    const CullingVariant variants[] = {
+        {.Name = "scalar"},
+        {.Name = "simd4", .Width = 4u},
+        {.Name = "simd8", .Width = 8u},
+        {.Name = "simd4-jobs", .Width = 4u, .Parallel = true},
+        {.Name = "simd8-jobs", .Width = 8u, .Parallel = true},
+    };
+
+    FrustumCuller   culler4(4u), culler8(8u);
+    Vector<TUint32> reference = {}, visible = {};
+
+    result.ThreadCount = JobSystem::Get() ? JobSystem::Ref().GetThreadCount() : 1u;
+    result.Variants.resize(std::size(variants));
+    for (TUint32 v = 0; v < std::size(variants); v++) {
+      result.Variants[v].Name = variants[v].Name;
+    }
+
+    for (TUint32 iteration = 0; iteration < config.Iterations; iteration++) {
+      Camera camera = {};
+      camera.Direction = glm::normalize(glm::vec3(direction(rng), 0.5f * direction(rng), direction(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+      const Frustum frustum = make_frustum(camera.GetMVP(glm::vec2(1920.0f, 1080.0f)));
+
+      for (TUint32 v = 0; v < std::size(variants); v++) {
+        const CullingVariant &variant = variants[v];
+        CullingVariantResult &variant_result = result.Variants[v];
+        Vector<TUint32>      &output = v == 0u ? reference : visible;
+
+        const Clock::time_point start = Clock::now();
+        if (variant.Width == 0u) {
+          output.clear();
+          for (TUint32 i = 0; i < items.size(); i++) {
+            if (is_visible(frustum, items[i].Model, items[i].Bounds, items[i].Sphere))
+              output.push_back(i);
+          }
+          variant_result.CullMs += elapsed_ms(start);
+        } else {
+          FrustumCuller   &culler = variant.Width == 4u ? culler4 : culler8;
+          const CullStats &stats = culler.Cull(frustum, input, output, variant.Parallel);
+          variant_result.CullMs += stats.CullMs;
+          variant_result.JobCount = std::max(variant_result.JobCount, stats.JobCount);
+        }
+        variant_result.VisibleCount += static_cast<TFloat64>(output.size());
+
+        if (v > 0u && output != reference)
+          result.Mismatches++;
+      }
+    }
+
+    const TFloat64 iterations = static_cast<TFloat64>(std::max(config.Iterations, 1u));
+    for (CullingVariantResult &variant_result : result.Variants) {
+      variant_result.CullMs /= iterations;
+      variant_result.VisibleCount /= iterations;
+    }
+  }
+
+} // namespace mau
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct CullingBenchmarkConfig {
+    // random boxes with random transforms spread over a cube of this half size around the camera, every iteration
+    // looks into another direction
+    TUint32  ItemCount = 100000u;
+    TFloat32 SceneExtent = 500.0f;
+    TUint32  Iterations = 50u;
+    TUint32  Seed = 1337u;
+  };
+
+  // average of all iterations in milliseconds
+  struct CullingVariantResult {
+    String   Name = "";
+    TFloat64 CullMs = 0.0;
+    TFloat64 VisibleCount = 0.0;
+    TUint32  JobCount = 0u;
+  };
+
+  // mismatches are iterations where a variant's visible list differs from the scalar test
+  struct CullingBenchmarkResult {
+    TUint32                      ThreadCount = 0u;
+    Vector<CullingVariantResult> Variants = {};
+    TUint32                      Mismatches = 0u;
+  };
+
+  // culls random scenes with the scalar test and the 4 and 8 wide ones, serial and on the job system. only needs the
+  // job system
+  void BenchmarkFrustumCulling(const CullingBenchmarkConfig &config, CullingBenchmarkResult &result);
+
+} // namespace mau
@@ -0,0 +1,163 @@
+#include <harness/draw-recording.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include "graphics/vulkan-arena.h"
+#include "graphics/vulkan-bindless.h"
+#include "loader/mesh-loader.h"
+#include "renderer/renderer.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  // number of distinct meshes the synthetic draws cycle through
+  static const TUint32 BENCHMARK_MESH_COUNT = 64u;
+
+  static Handle<GeometryAllocation> create_benchmark_cube(TFloat32 size) {
+    Vector<Vertex>  vertices = {};
+    Vector<TUint32> indices = {};
+
+    for (TUint32 face = 0u; face < 6u; face++) {
+      const TUint32   axis = face / 2u;
+      const TFloat32  sign = (face % 2u) ? -1.0f : 1.0f;
+      glm::vec3       normal = glm::vec3(0.0f);
+      normal[axis] = sign;
+      const glm::vec3 u = glm::vec3(normal.y, normal.z, normal.x);
+      const glm::vec3 v = glm::cross(normal, u);
+
+      const TUint32 first = static_cast<TUint32>(vertices.size());
+      for (TUint32 corner = 0u; corner < 4u; corner++) {
+        const TFloat32 s = (corner & 1u) ? 1.0f : -1.0f;
+        const TFloat32 t = (corner & 2u) ? 1.0f : -1.0f;
+        vertices.push_back({.pos = (normal + u * s + v * t) * size, .normal = normal, .tex = glm::vec2(s, t) * 0.5f + 0.5f});
+      }
+
+      indices.insert(indices.end(), {first, first + 1u, first + 3u, first, first + 3u, first + 2u});
+    }
+
+    return GeometryArena::Ref().Allocate(vertices.data(), vertices.size(), indices.data(), indices.size());
+  }
+
+  DrawRecordingResult BenchmarkDrawRecording(TUint32 draw_count, TUint32 iterations) {
+    MAU_PROFILE_SCOPE("BenchmarkDrawRecording");
+    ASSERT(Renderer::Get() && iterations > 0u);
+
+    // the benchmark borrows the pipeline and push constant, the render thread must be idle
+    Renderer &renderer = Renderer::Ref();
+    renderer.WaitFrame();
+
+    const Handle<Pipeline>                       &pipeline = renderer.GetRasterPipeline();
+    const Handle<PushConstant<VertexShaderData>> &push_constant = renderer.GetPushConstant();
+    const Handle<ParallelDrawRecorder>           &recorder = renderer.GetRecorder();
+
+    Vector<Handle<GeometryAllocation>> meshes = {};
+    for (TUint32 i = 0u; i < BENCHMARK_MESH_COUNT; i++) {
+      meshes.push_back(create_benchmark_cube(0.1f + 0.01f * static_cast<TFloat32>(i)));
+    }
+    VulkanState::Ref().GetUploadRing()->Flush();
+
+    // the recorder's secondaries of frame 0 are reused below
+    VulkanState::Ref().GetDeviceHandle()->WaitIdle();
+
+    // the commands are never submitted, only the cost of filling the command buffer is of interest
+    Handle<CommandPool>   cmd_pool = VulkanState::Ref().GetCommandPool(VK_QUEUE_GRAPHICS_BIT);
+    Handle<CommandBuffer> cmd = cmd_pool->AllocateCommandBuffers(1u, VK_COMMAND_BUFFER_LEVEL_SECONDARY)[0];
+
+    const VkCommandBufferInheritanceInfo inheritance = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = nullptr,
+        .renderPass = renderer.GetRasterRenderpass()->Get(),
+        .subpass = 0u,
+        .framebuffer = VK_NULL_HANDLE,
+    };
+
+    const Vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
+    Handle<IndirectDrawList>       draw_list = make_handle<IndirectDrawList>(1u);
+    const VertexShaderData         saved_data = push_constant->GetData();
+    VertexShaderData               data = saved_data;
+
+    auto record = [&](bool indirect) -> TFloat64 {
+      const Clock::time_point start = Clock::now();
+
+      cmd->Reset();
+      cmd->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &inheritance);
+
+      vkCmdBindPipeline(cmd->Get(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Get());
+      push_constant->Bind(cmd, pipeline);
+      vkCmdBindDescriptorSets(cmd->Get(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetLayout(), 0u, static_cast<TUint32>(sets.size()), sets.data(), 0u, nullptr);
+
+      if (indirect) {
+        draw_list->RecordIndirect(cmd, 0u);
+      } else {
+        draw_list->RecordDirect(cmd);
+      }
+
+      cmd->End();
+      return elapsed_ms(start);
+    };
+
+    auto record_parallel = [&]() -> TFloat64 {
+      const SecondaryRecordState state = {
+          .Inheritance = inheritance,
+          .Pipeline = pipeline->Get(),
+          .Layout = pipeline->GetLayout(),
+          .DescriptorSets = sets.data(),
+          .DescriptorSetCount = static_cast<TUint32>(sets.size()),
+          .PushConstants = &data,
+          .PushConstantSize = static_cast<TUint32>(sizeof(VertexShaderData)),
+          .Viewport = {.width = 1.0f, .height = 1.0f, .maxDepth = 1.0f},
+          .Scissor = {.extent = {1u, 1u}},
+          .Indirect = false,
+      };
+
+      const Clock::time_point start = Clock::now();
+      recorder->RecordSecondaries(*draw_list, 0u, state);
+      return elapsed_ms(start);
+    };
+
+    DrawRecordingResult result = {
+        .DrawCount = draw_count,
+        .BuildMs = DBL_MAX,
+        .UploadMs = DBL_MAX,
+        .DirectRecordMs = DBL_MAX,
+        .IndirectRecordMs = DBL_MAX,
+        .ParallelRecordMs = DBL_MAX,
+    };
+
+    for (TUint32 iteration = 0u; iteration < iterations; iteration++) {
+      Clock::time_point start = Clock::now();
+
+      draw_list->Clear();
+      for (TUint32 i = 0u; i < draw_count; i++) {
+        const glm::vec3 position = glm::vec3(static_cast<TFloat32>(i % 100u), static_cast<TFloat32>((i / 100u) % 100u), static_cast<TFloat32>(i / 10000u));
+        draw_list->Add(*meshes[i % BENCHMARK_MESH_COUNT], glm::translate(glm::mat4(1.0f), position), UINT32_MAX);
+      }
+      result.BuildMs = std::min(result.BuildMs, elapsed_ms(start));
+
+      start = Clock::now();
+      data.draw_data_address = draw_list->Upload(0u);
+      push_constant->Update(data);
+      result.UploadMs = std::min(result.UploadMs, elapsed_ms(start));
+
+      result.DirectRecordMs = std::min(result.DirectRecordMs, record(false));
+      result.IndirectRecordMs = std::min(result.IndirectRecordMs, record(true));
+      result.ParallelRecordMs = std::min(result.ParallelRecordMs, record_parallel());
+    }
+
+    result.IndirectBatches = draw_list->GetBatchCount();
+    result.RecordingThreads = recorder->GetChunkCount(draw_count);
+    push_constant->Update(saved_data);
+
+    LOG_INFO("draw recording [draws: %u, build: %.3f ms, upload: %.3f ms, direct: %.3f ms, indirect: %.3f ms, parallel: %.3f ms on %u threads]", draw_count, result.BuildMs,
+             result.UploadMs, result.DirectRecordMs, result.IndirectRecordMs, result.ParallelRecordMs, result.RecordingThreads);
+    return result;
+  }
+
+} // namespace mau
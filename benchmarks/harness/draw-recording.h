@@ -0,0 +1,23 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // best of all iterations, recording times only cover filling a secondary command buffer
+  struct DrawRecordingResult {
+    TUint32  DrawCount = 0u;
+    TUint32  IndirectBatches = 0u;
+    TUint32  RecordingThreads = 0u;
+    TFloat64 BuildMs = 0.0;
+    TFloat64 UploadMs = 0.0;
+    TFloat64 DirectRecordMs = 0.0;
+    TFloat64 IndirectRecordMs = 0.0;
+    TFloat64 ParallelRecordMs = 0.0;
+  };
+
+  // records draw_count synthetic submeshes with a vkCmdDrawIndexed per draw, through the indirect
+  // draw list of the raster path and per draw split across the recording threads. the engine has to be created
+  DrawRecordingResult BenchmarkDrawRecording(TUint32 draw_count, TUint32 iterations = 16u);
+
+} // namespace mau
@@ -0,0 +1,247 @@
+#include <harness/frame-benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <engine/engine.h>
+#include <engine/log.h>
+
+#include "renderer/renderer.h"
+#include "graphics/vulkan-pipeline-cache.h"
+#include "graphics/shader-cache.h"
+#include "scene/camera-path.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  struct FrameStage {
+    const char *Name = nullptr;
+    TFloat64 FrameSample::*Member = nullptr;
+  };
+
+  // column order of the csv and the json summary
+  static const FrameStage FRAME_STAGES[] = {
+      {"frame_ms", &FrameSample::FrameMs},   {"update_ms", &FrameSample::UpdateMs}, {"imgui_ms", &FrameSample::ImGuiMs}, {"fence_wait_ms", &FrameSample::FenceWaitMs},
+      {"record_ms", &FrameSample::RecordMs}, {"submit_ms", &FrameSample::SubmitMs}, {"render_ms", &FrameSample::RenderMs}, {"gpu_ms", &FrameSample::GpuMs},
+  };
+
+  static const TFloat64 SUMMARY_PERCENTILES[] = {50.0, 90.0, 95.0, 99.0};
+
+  static TFloat64 nearest_rank(const Vector<TFloat64> &sorted, TFloat64 percentile) {
+    const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<TFloat64>(sorted.size())));
+    return sorted[std::clamp(rank, static_cast<size_t>(1u), sorted.size()) - 1u];
+  }
+
+  static void write_summary(std::ofstream &file, const TimingSummary &summary) {
+    file << "{\"mean\": " << summary.Mean << ", \"min\": " << summary.Min << ", \"p50\": " << summary.P50 << ", \"p90\": " << summary.P90 << ", \"p95\": " << summary.P95
+         << ", \"p99\": " << summary.P99 << ", \"max\": " << summary.Max << "}";
+  }
+
+  FrameBenchmarkResult BenchmarkFrames(const FrameBenchmarkConfig &config) {
+    Engine   &engine = Engine::Ref();
+    Renderer &renderer = Renderer::Ref();
+
+    CameraPath path = {};
+    if (!config.CameraPath.empty() && !path.Load(config.CameraPath)) {
+      LOG_WARN("benchmarking without a camera path");
+    }
+
+    const TUint32 frame_count = config.WarmupFrames + config.MeasuredFrames;
+    // gpu timestamps come back once a swapchain image is used again, the extra frames bring in the last ones
+    const TUint32 drain_count = renderer.GetImageCount() + 2u;
+    const TUint64 first_frame = engine.GetFrameCount();
+
+    Vector<FrameSample> samples(static_cast<size_t>(frame_count));
+    for (TUint32 i = 0u; i < frame_count; i++) {
+      samples[i].Frame = i;
+      samples[i].Time = static_cast<TFloat32>(i) * config.FrameStep;
+    }
+
+    auto sample_of = [&samples, first_frame](TUint64 frame) -> FrameSample * {
+      if (frame == UINT64_MAX || frame < first_frame || frame - first_frame >= samples.size())
+        return nullptr;
+      return &samples[frame - first_frame];
+    };
+
+    LOG_INFO("frame benchmark started [warmup: %u, measured: %u, frames in flight: %u]", config.WarmupFrames, config.MeasuredFrames, renderer.GetFramesInFlight());
+
+    Clock::time_point measure_start = Clock::now();
+    Clock::time_point measure_end = measure_start;
+
+    for (TUint32 i = 0u; i < frame_count + drain_count; i++) {
+      if (i == config.WarmupFrames) {
+        measure_start = Clock::now();
+      }
+
+      if (!path.IsEmpty()) {
+        renderer.SetCamera(path.Sample(static_cast<TFloat32>(i) * config.FrameStep));
+      }
+
+      engine.RunFrame(config.FrameStep);
+
+      if (i + 1u == frame_count) {
+        measure_end = Clock::now();
+      }
+
+      // stages of one frame arrive over several iterations when frames are pipelined
+      const FrameTiming &timing = engine.GetFrameTiming();
+      if (FrameSample *sample = sample_of(timing.Frame)) {
+        sample->FrameMs = timing.FrameMs;
+        sample->UpdateMs = timing.UpdateMs;
+        sample->ImGuiMs += timing.ImGuiMs;
+      }
+
+      if (FrameSample *sample = sample_of(timing.RenderFrame)) {
+        sample->ImGuiMs += timing.CaptureMs;
+        sample->FenceWaitMs = timing.FenceWaitMs;
+        sample->RecordMs = timing.RecordMs;
+        sample->SubmitMs = timing.SubmitMs;
+        sample->RenderMs = timing.RenderMs;
+        sample->DrawCount = timing.DrawCount;
+        sample->TriangleCount = timing.TriangleCount;
+        sample->LodTriangleCount = timing.LodTriangleCount;
+      }
+
+      if (FrameSample *sample = sample_of(timing.GpuFrame)) {
+        sample->GpuMs = timing.GpuMs;
+      }
+    }
+
+    renderer.WaitFrame();
+    VulkanState::Ref().GetDeviceHandle()->WaitIdle();
+
+    FrameBenchmarkResult result = {};
+    result.Frames.assign(samples.begin() + config.WarmupFrames, samples.end());
+    result.TotalSeconds = std::chrono::duration<TFloat64>(measure_end - measure_start).count();
+    result.FramesInFlight = renderer.GetFramesInFlight();
+    result.Headless = VulkanState::Ref().IsHeadless();
+    result.ShaderLoadMs = renderer.GetShaderLoadMs();
+    result.CachedShaders = ShaderCache::Get() ? ShaderCache::Ref().GetHitCount() : 0u;
+    result.PipelineCreateMs = renderer.GetPipelineCreateMs();
+    result.PipelineCacheWarm = VulkanPipelineCache::Get() && VulkanPipelineCache::Ref().IsWarm();
+
+    const TimingSummary frame_summary = SummarizeFrameStage(result, "frame_ms");
+    LOG_INFO("frame benchmark done [%u frames in %.2f s, frame ms p50: %.3f, p99: %.3f]", config.MeasuredFrames, result.TotalSeconds, frame_summary.P50, frame_summary.P99);
+    return result;
+  }
+
+  TimingSummary SummarizeFrameStage(const FrameBenchmarkResult &result, const String &stage) {
+    const FrameStage *found = std::find_if(std::begin(FRAME_STAGES), std::end(FRAME_STAGES), [&stage](const FrameStage &s) -> bool { return stage == s.Name; });
+    if (found == std::end(FRAME_STAGES)) {
+      LOG_ERROR("unknown frame stage %s", stage.c_str());
+      return {};
+    }
+
+    // frames without a gpu result are left out
+    Vector<TFloat64> values = {};
+    values.reserve(result.Frames.size());
+    for (const FrameSample &sample : result.Frames) {
+      if (sample.*found->Member >= 0.0) {
+        values.push_back(sample.*found->Member);
+      }
+    }
+
+    if (values.empty())
+      return {};
+
+    std::sort(values.begin(), values.end());
+
+    TFloat64 sum = 0.0;
+    for (TFloat64 value : values) {
+      sum += value;
+    }
+
+    return {
+        .Mean = sum / static_cast<TFloat64>(values.size()),
+        .Min = values.front(),
+        .P50 = nearest_rank(values, SUMMARY_PERCENTILES[0]),
+        .P90 = nearest_rank(values, SUMMARY_PERCENTILES[1]),
+        .P95 = nearest_rank(values, SUMMARY_PERCENTILES[2]),
+        .P99 = nearest_rank(values, SUMMARY_PERCENTILES[3]),
+        .Max = values.back(),
+    };
+  }
+
+  bool WriteFrameBenchmarkCsv(const FrameBenchmarkResult &result, const String &path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", path.c_str());
+      return false;
+    }
+
+    file << "frame,time";
+    for (const FrameStage &stage : FRAME_STAGES) {
+      file << "," << stage.Name;
+    }
+    file << ",draws,triangles,lod_triangles\n";
+
+    file << std::fixed << std::setprecision(4);
+    for (const FrameSample &sample : result.Frames) {
+      file << sample.Frame << "," << sample.Time;
+      for (const FrameStage &stage : FRAME_STAGES) {
+        file << "," << sample.*stage.Member;
+      }
+      file << "," << sample.DrawCount << "," << sample.TriangleCount << "," << sample.LodTriangleCount << "\n";
+    }
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write %s", path.c_str());
+      return false;
+    }
+
+    LOG_INFO("frame timings written to %s", path.c_str());
+    return true;
+  }
+
+  bool WriteFrameBenchmarkJson(const FrameBenchmarkResult &result, const String &path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", path.c_str());
+      return false;
+    }
+
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"frames_in_flight\": " << result.FramesInFlight << ",\n";
+    file << "  \"headless\": " << (result.Headless ? "true" : "false") << ",\n";
+    file << "  \"measured_frames\": " << result.Frames.size() << ",\n";
+    file << "  \"total_seconds\": " << result.TotalSeconds << ",\n";
+    file << "  \"shader_load_ms\": " << result.ShaderLoadMs << ",\n";
+    file << "  \"cached_shaders\": " << result.CachedShaders << ",\n";
+    file << "  \"pipeline_create_ms\": " << result.PipelineCreateMs << ",\n";
+    file << "  \"pipeline_cache_warm\": " << (result.PipelineCacheWarm ? "true" : "false") << ",\n";
+
+    file << "  \"summary\": {\n";
+    for (size_t i = 0; i < std::size(FRAME_STAGES); i++) {
+      file << "    \"" << FRAME_STAGES[i].Name << "\": ";
+      write_summary(file, SummarizeFrameStage(result, FRAME_STAGES[i].Name));
+      file << (i + 1u < std::size(FRAME_STAGES) ? ",\n" : "\n");
+    }
+    file << "  },\n";
+
+    file << "  \"frames\": [\n";
+    for (size_t i = 0; i < result.Frames.size(); i++) {
+      const FrameSample &sample = result.Frames[i];
+      file << "    {\"frame\": " << sample.Frame << ", \"time\": " << sample.Time;
+      for (const FrameStage &stage : FRAME_STAGES) {
+        file << ", \"" << stage.Name << "\": " << sample.*stage.Member;
+      }
+      file << ", \"draws\": " << sample.DrawCount << ", \"triangles\": " << sample.TriangleCount << ", \"lod_triangles\": " << sample.LodTriangleCount << "}"
+           << (i + 1u < result.Frames.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write %s", path.c_str());
+      return false;
+    }
+
+    LOG_INFO("frame timings written to %s", path.c_str());
+    return true;
+  }
+
+} // namespace mau
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // one measured frame with every stage matched up to it. imgui includes the scene and ui capture,
+  // gpu is negative when the device has no timestamps
+  struct FrameSample {
+    TUint64  Frame = 0u;
+    TFloat32 Time = 0.0f;
+    TFloat64 FrameMs = 0.0;
+    TFloat64 UpdateMs = 0.0;
+    TFloat64 ImGuiMs = 0.0;
+    TFloat64 FenceWaitMs = 0.0;
+    TFloat64 RecordMs = 0.0;
+    TFloat64 SubmitMs = 0.0;
+    TFloat64 RenderMs = 0.0;
+    TFloat64 GpuMs = -1.0;
+    TUint32  DrawCount = 0u;
+    TUint64  TriangleCount = 0u;
+    TUint64  LodTriangleCount = 0u;
+  };
+
+  struct TimingSummary {
+    TFloat64 Mean = 0.0;
+    TFloat64 Min = 0.0;
+    TFloat64 P50 = 0.0;
+    TFloat64 P90 = 0.0;
+    TFloat64 P95 = 0.0;
+    TFloat64 P99 = 0.0;
+    TFloat64 Max = 0.0;
+  };
+
+  struct FrameBenchmarkConfig {
+    // keyframe file, see CameraPath. empty keeps the camera where it is
+    String   CameraPath = "";
+    TUint32  WarmupFrames = 120u;
+    TUint32  MeasuredFrames = 1000u;
+    // fixed time step, the camera path is sampled at frame * FrameStep so every run renders the same frames
+    TFloat32 FrameStep = 1.0f / 60.0f;
+  };
+
+  struct FrameBenchmarkResult {
+    Vector<FrameSample> Frames = {};
+    TFloat64            TotalSeconds = 0.0;
+    TUint32             FramesInFlight = 0u;
+    bool                Headless = false;
+    // startup cost of the renderer's shaders and pipelines, warm when the pipelines came from a pipeline cache file
+    TFloat64 ShaderLoadMs = 0.0;
+    TUint32  CachedShaders = 0u;
+    TFloat64 PipelineCreateMs = 0.0;
+    bool     PipelineCacheWarm = false;
+  };
+
+  // runs warmup and measured frames through the engine's main loop with the camera on the scripted path.
+  // the engine has to be created
+  FrameBenchmarkResult BenchmarkFrames(const FrameBenchmarkConfig &config);
+
+  // nearest rank percentiles, stage is one of the FrameSample columns written by WriteFrameBenchmarkCsv
+  TimingSummary SummarizeFrameStage(const FrameBenchmarkResult &result, const String &stage);
+
+  // per frame rows, one column per stage
+  bool WriteFrameBenchmarkCsv(const FrameBenchmarkResult &result, const String &path);
+  // summaries of every stage followed by the per frame samples
+  bool WriteFrameBenchmarkJson(const FrameBenchmarkResult &result, const String &path);
+
+} // namespace mau
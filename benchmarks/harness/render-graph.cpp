@@ -0,0 +1,427 @@
+#include <harness/render-graph.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <engine/log.h>
+
+#include "renderer/rendergraph/compiler.h"
+#include "renderer/rendergraph/passes/lambertian-pass.h"
+#include "renderer/rendergraph/passes/raytracing-pass.h"
+#include "renderer/rendergraph/passes/denoiser-pass.h"
+#include "renderer/rendergraph/passes/imgui-pass.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  static bool covers(TUint32 mask, TUint32 bits) { return (mask & bits) == bits; }
+
+  // what the gpu would see of one resource while the compiled graph runs
+  struct ReplayState {
+    VkImageLayout        Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags WriteStages = 0u;
+    VkAccessFlags        WriteAccess = 0u;
+    // stages and accesses the last write is visible to
+    VkPipelineStageFlags SyncedStages = 0u;
+    VkAccessFlags        SyncedAccess = 0u;
+    // reads since the last write and the stages that wait for all of them
+    VkPipelineStageFlags ReadStages = 0u;
+    VkPipelineStageFlags ReadsDoneStages = 0u;
+  };
+
+  static ReplayState replay_initial(const GraphResourceDesc &desc) {
+    ReplayState state = {};
+    if (desc.Initial == ResourceUsage::NONE)
+      return state;
+
+    const ResourceUsageInfo &info = GetResourceUsageInfo(desc.Initial);
+    state.Layout = desc.Type != ResourceType::BUFFER ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    if (info.Write) {
+      state.WriteStages = info.Stages;
+      state.WriteAccess = info.Access & RESOURCE_WRITE_ACCESS;
+    } else {
+      state.ReadStages = info.Stages;
+    }
+    return state;
+  }
+
+  static TUint32 replay_barrier(ReplayState &state, const GraphBarrier &barrier) {
+    TUint32 errors = 0u;
+    if (barrier.Type != ResourceType::BUFFER && barrier.OldLayout != VK_IMAGE_LAYOUT_UNDEFINED && barrier.OldLayout != state.Layout)
+      errors++;
+
+    const bool write_done = covers(barrier.SrcStages, state.WriteStages) && covers(barrier.SrcAccess, state.WriteAccess);
+    const bool reads_done = covers(barrier.SrcStages, state.ReadStages);
+
+    if (barrier.OldLayout != barrier.NewLayout) {
+      // a transition is a write of its own and comes after everything before it, the contents only have to be
+      // made available when they are kept
+      if (!covers(barrier.SrcStages, state.WriteStages | state.ReadStages))
+        errors++;
+      if (barrier.OldLayout != VK_IMAGE_LAYOUT_UNDEFINED && !covers(barrier.SrcAccess, state.WriteAccess))
+        errors++;
+
+      state = {
+          .Layout = barrier.NewLayout,
+          .WriteStages = barrier.DstStages,
+          .SyncedStages = barrier.DstStages,
+          .SyncedAccess = barrier.DstAccess,
+      };
+      return errors;
+    }
+
+    if (write_done) {
+      state.SyncedStages |= barrier.DstStages;
+      state.SyncedAccess |= barrier.DstAccess;
+    }
+    if (reads_done)
+      state.ReadsDoneStages |= barrier.DstStages;
+
+    return errors;
+  }
+
+  static TUint32 replay_access(ReplayState &state, ResourceType type, ResourceUsage usage) {
+    if (usage == ResourceUsage::NONE)
+      return 0u;
+
+    const ResourceUsageInfo &info = GetResourceUsageInfo(usage);
+    TUint32                  errors = 0u;
+
+    if (type != ResourceType::BUFFER && state.Layout != info.Layout)
+      errors++;
+    if (state.WriteStages != 0u && !covers(state.SyncedStages, info.Stages))
+      errors++;
+    if (state.WriteAccess != 0u && !covers(state.SyncedAccess, info.Access))
+      errors++;
+
+    if (info.Write) {
+      if (state.ReadStages != 0u && !covers(state.ReadsDoneStages, info.Stages))
+        errors++;
+
+      state.WriteStages = info.Stages;
+      state.WriteAccess = info.Access & RESOURCE_WRITE_ACCESS;
+      state.SyncedStages = 0u;
+      state.SyncedAccess = 0u;
+      state.ReadStages = 0u;
+      state.ReadsDoneStages = 0u;
+    } else {
+      state.ReadStages |= info.Stages;
+      state.ReadsDoneStages = 0u;
+    }
+
+    return errors;
+  }
+
+  // transient resources that overlap in memory must never be alive at the same time and have to fit their heap
+  static TUint32 validate_placements(const Vector<GraphResourceDesc> &resources, const Vector<GraphPassDesc> &passes, const CompiledGraph &compiled,
+                                     Vector<GraphPlacement> &lifetimes, Vector<Vector<TUint32>> &aliases) {
+    TUint32 errors = 0u;
+
+    lifetimes.assign(resources.size(), {});
+    aliases.assign(resources.size(), {});
+    for (TUint32 i = 0u; i < compiled.Passes.size(); i++) {
+      for (const GraphAccess &access : passes[compiled.Passes[i].Pass].Accesses) {
+        const TUint32 resource = compiled.Resources.at(access.Source);
+        if (access.Usage == ResourceUsage::NONE)
+          continue;
+
+        lifetimes[resource].FirstUse = std::min(lifetimes[resource].FirstUse, i);
+        lifetimes[resource].LastUse = std::max(lifetimes[resource].LastUse, i);
+      }
+    }
+
+    for (size_t a = 0u; a < resources.size(); a++) {
+      if (!resources[a].Transient)
+        continue;
+
+      const GraphPlacement &pa = compiled.Placements[a];
+      if (pa.Offset % std::max<TUint64>(resources[a].Alignment, 1u) != 0u || pa.Heap >= compiled.HeapSizes.size() || pa.Offset + resources[a].Size > compiled.HeapSizes[pa.Heap])
+        errors++;
+
+      for (size_t b = a + 1u; b < resources.size(); b++) {
+        const GraphPlacement &pb = compiled.Placements[b];
+        if (!resources[b].Transient || pa.Heap != pb.Heap || pa.Offset >= pb.Offset + resources[b].Size || pb.Offset >= pa.Offset + resources[a].Size)
+          continue;
+        if (lifetimes[a].FirstUse == UINT32_MAX || lifetimes[b].FirstUse == UINT32_MAX)
+          continue;
+
+        if (lifetimes[a].FirstUse <= lifetimes[b].LastUse && lifetimes[b].FirstUse <= lifetimes[a].LastUse)
+          errors++;
+        aliases[a].push_back(static_cast<TUint32>(b));
+        aliases[b].push_back(static_cast<TUint32>(a));
+      }
+    }
+
+    return errors;
+  }
+
+  // runs three frames of the compiled graph, the first one with every carried over resource still undefined, and
+  // checks pass order, layouts and synchronization of every access. transient resources start each frame undefined
+  // with whatever was last done to their memory still in flight
+  static TUint32 validate(const Vector<GraphResourceDesc> &resources, const Vector<GraphPassDesc> &passes, const CompiledGraph &compiled) {
+    TUint32 errors = 0u;
+
+    Vector<GraphPlacement>  lifetimes = {};
+    Vector<Vector<TUint32>> aliases = {};
+    errors += validate_placements(resources, passes, compiled, lifetimes, aliases);
+
+    // a pass runs after the producers of its sources, and a name is written after it was read
+    Vector<TUint32> position(passes.size(), UINT32_MAX);
+    for (size_t i = 0u; i < compiled.Passes.size(); i++) {
+      position[compiled.Passes[i].Pass] = static_cast<TUint32>(i);
+    }
+
+    for (const CompiledPass &pass : compiled.Passes) {
+      for (const GraphAccess &access : passes[pass.Pass].Accesses) {
+        for (TUint32 other = 0u; other < passes.size(); other++) {
+          if (other == pass.Pass)
+            continue;
+
+          for (const GraphAccess &other_access : passes[other].Accesses) {
+            if (other_access.Sink == access.Source && position[other] >= position[pass.Pass])
+              errors++;
+            if (other_access.Source == access.Source && position[other] != UINT32_MAX && GetResourceUsageInfo(other_access.Usage).Write && !GetResourceUsageInfo(access.Usage).Write &&
+                position[other] < position[pass.Pass])
+              errors++;
+          }
+        }
+      }
+    }
+
+    Vector<ReplayState> states(resources.size());
+    for (size_t r = 0u; r < resources.size(); r++) {
+      states[r] = replay_initial(resources[r]);
+    }
+
+    for (TUint32 frame = 0u; frame < 3u; frame++) {
+      const bool first = frame == 0u;
+
+      for (TUint32 i = 0u; i < compiled.Passes.size(); i++) {
+        const CompiledPass &pass = compiled.Passes[i];
+
+        for (size_t r = 0u; r < resources.size(); r++) {
+          if (!resources[r].Transient || lifetimes[r].FirstUse != i)
+            continue;
+
+          ReplayState state = {.WriteStages = states[r].WriteStages, .WriteAccess = states[r].WriteAccess, .ReadStages = states[r].ReadStages};
+          for (TUint32 alias : aliases[r]) {
+            state.WriteStages |= states[alias].WriteStages;
+            state.WriteAccess |= states[alias].WriteAccess;
+            state.ReadStages |= states[alias].ReadStages;
+          }
+          states[r] = state;
+        }
+
+        for (const GraphBarrier &barrier : first ? pass.FirstBarriers : pass.Barriers) {
+          errors += replay_barrier(states[barrier.Resource], barrier);
+        }
+        for (const GraphAccess &access : passes[pass.Pass].Accesses) {
+          const TUint32 resource = compiled.Resources.at(access.Source);
+          errors += replay_access(states[resource], resources[resource].Type, access.Usage);
+        }
+      }
+
+      for (const GraphBarrier &barrier : first ? compiled.FirstFinalBarriers : compiled.FinalBarriers) {
+        errors += replay_barrier(states[barrier.Resource], barrier);
+      }
+      for (size_t r = 0u; r < resources.size(); r++) {
+        errors += replay_access(states[r], resources[r].Type, resources[r].Final);
+      }
+
+      // resources handed over outside the graph come back in their initial usage
+      for (size_t r = 0u; r < resources.size(); r++) {
+        if (resources[r].Initial != ResourceUsage::NONE)
+          states[r] = replay_initial(resources[r]);
+      }
+    }
+
+    return errors;
+  }
+
+  static TUint32 batch_count(const CompiledGraph &compiled) {
+    TUint32 batches = compiled.FinalBarriers.empty() ? 0u : 1u;
+    for (const CompiledPass &pass : compiled.Passes) {
+      batches += pass.Barriers.empty() ? 0u : 1u;
+    }
+    return batches;
+  }
+
+  static void compile_graph(const String &name, const Vector<GraphResourceDesc> &resources, const Vector<GraphPassDesc> &passes, const Vector<String> &outputs, TUint32 iterations,
+                            RenderGraphCompileResult &result) {
+    CompiledGraph compiled = {};
+    TFloat64      best_ms = 0.0;
+    bool          compiled_ok = false;
+
+    for (TUint32 i = 0u; i < iterations; i++) {
+      const Clock::time_point start = Clock::now();
+      compiled_ok = RenderGraphCompiler::Compile(resources, passes, outputs, compiled);
+      const TFloat64 ms = elapsed_ms(start);
+      best_ms = i == 0u ? ms : std::min(best_ms, ms);
+    }
+
+    result.Name = name;
+    result.PassCount += static_cast<TUint32>(passes.size());
+    result.CompileMs += best_ms;
+
+    if (!compiled_ok) {
+      LOG_ERROR("failed to compile %s graph: %s", name.c_str(), compiled.Error.c_str());
+      result.Errors++;
+      return;
+    }
+
+    result.CulledCount += static_cast<TUint32>(compiled.Culled.size());
+    result.TransientBytes += compiled.TransientSize;
+    result.UnaliasedBytes += compiled.UnaliasedSize;
+    result.BarrierCount += compiled.BarrierCount;
+    result.BarrierBatches += batch_count(compiled);
+    result.Errors += validate(resources, passes, compiled);
+  }
+
+  // size of a transient image at 1080p, the alignment stands in for what drivers ask of render targets
+  static GraphResourceDesc transient_desc(const String &name, const TransientImageDesc &desc) {
+    const TUint64 alignment = 64u * 1024u;
+    const TUint64 texel_size = desc.Format == VK_FORMAT_R32G32B32A32_SFLOAT ? 16u : 4u;
+    const TUint64 size = 1920u * 1080u * texel_size * static_cast<TUint64>(desc.Samples);
+    return {.Name = name, .Transient = true, .Size = (size + alignment - 1u) / alignment * alignment, .Alignment = alignment};
+  }
+
+  // the graph the renderer builds, see Renderer::Renderer and RenderGraph::Build
+  static void compile_renderer_graph(bool ray_traced, TUint32 iterations, RenderGraphCompileResult &result) {
+    const TransientImageDesc viewport = {.Format = VK_FORMAT_R32G32B32A32_SFLOAT};
+    Vector<GraphResourceDesc> resources = {
+        {.Name = "$backbuffer", .Initial = ResourceUsage::PRESENT, .Final = ResourceUsage::PRESENT},
+        {.Name = "$depthbuffer"},
+        {.Name = "rt-accum-buffer"},
+        transient_desc("imgui-viewport-color", viewport),
+        transient_desc("rt-albedo-buffer", viewport),
+        transient_desc("rt-normal-buffer", viewport),
+    };
+
+    Vector<Handle<Pass>> passes = {make_handle<LambertianPass>(VK_FORMAT_D32_SFLOAT)};
+    if (ray_traced) {
+      passes.push_back(make_handle<RayTracingPass>());
+      passes.push_back(make_handle<DenoiserPass>());
+      passes.push_back(make_handle<DenoiserOutputPass>());
+    }
+    passes.push_back(make_handle<ImGuiPass>(ray_traced ? "denoised-color" : "lambertian-color"));
+
+    Vector<GraphPassDesc> descs = {};
+    for (const Handle<Pass> &pass : passes) {
+      descs.push_back({.Name = pass->GetName(), .Accesses = pass->GetAccesses()});
+      for (const TransientImage &transient : pass->GetTransients()) {
+        TransientImageDesc desc = transient.Desc;
+        desc.Format = desc.Format != VK_FORMAT_UNDEFINED ? desc.Format : viewport.Format;
+        resources.push_back(transient_desc(transient.Name, desc));
+      }
+    }
+
+    compile_graph(ray_traced ? "ray traced" : "raster", resources, descs, {"$present"}, iterations, result);
+  }
+
+  // every pass writes the latest version of one or two resources and reads the latest version of a few others, so
+  // the graph is valid in generation order. passes are then shuffled for the compiler to sort them again. resources
+  // that are written before they are read are made transient, most of them
+  static void make_random_graph(std::mt19937 &rng, const RenderGraphBenchmarkConfig &config, Vector<GraphResourceDesc> &resources, Vector<GraphPassDesc> &passes,
+                                Vector<String> &outputs) {
+    const ResourceUsage image_writes[] = {ResourceUsage::COLOR_ATTACHMENT_WRITE, ResourceUsage::STORAGE_WRITE_COMPUTE, ResourceUsage::STORAGE_READ_WRITE_COMPUTE, ResourceUsage::TRANSFER_WRITE};
+    const ResourceUsage image_reads[] = {ResourceUsage::SAMPLED_FRAGMENT, ResourceUsage::SAMPLED_COMPUTE, ResourceUsage::TRANSFER_READ};
+    const ResourceUsage buffer_writes[] = {ResourceUsage::STORAGE_WRITE_COMPUTE, ResourceUsage::TRANSFER_WRITE};
+    const ResourceUsage buffer_reads[] = {ResourceUsage::INDIRECT_READ, ResourceUsage::UNIFORM_READ, ResourceUsage::TRANSFER_READ};
+
+    const TUint32 resource_count = std::max(config.ResourceCount, 4u);
+    const TUint32 pass_count = std::max(config.PassCount, 1u);
+
+    resources.clear();
+    passes.clear();
+    outputs.clear();
+
+    Vector<String> latest(resource_count);
+    Vector<bool>   read_first(resource_count, false);
+    for (TUint32 r = 0u; r < resource_count; r++) {
+      GraphResourceDesc desc = {.Name = "resource-" + std::to_string(r)};
+      desc.Type = r % 4u == 3u ? ResourceType::BUFFER : ResourceType::IMAGE;
+      // a few come from outside every frame and have to be handed back in a given state
+      if (r % 8u == 0u) {
+        desc.Initial = ResourceUsage::SAMPLED_FRAGMENT;
+        desc.Final = ResourceUsage::SAMPLED_FRAGMENT;
+      }
+      resources.push_back(desc);
+      latest[r] = desc.Name;
+    }
+
+    std::uniform_int_distribution<TUint32> pick(0u, resource_count - 1u);
+    std::uniform_int_distribution<TUint32> count(1u, 3u);
+
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      GraphPassDesc   pass = {.Name = "pass-" + std::to_string(p)};
+      Vector<TUint32> used = {};
+
+      const TUint32 write_count = 1u + (count(rng) == 3u ? 1u : 0u);
+      const TUint32 read_count = count(rng);
+
+      for (TUint32 i = 0u; i < write_count + read_count; i++) {
+        const TUint32 r = pick(rng);
+        if (std::find(used.begin(), used.end(), r) != used.end())
+          continue;
+        used.push_back(r);
+
+        const bool buffer = resources[r].Type == ResourceType::BUFFER;
+        if (i < write_count) {
+          const ResourceUsage usage = buffer ? buffer_writes[rng() % 2u] : image_writes[rng() % 4u];
+          const String        sink = "pass-" + std::to_string(p) + "-" + std::to_string(r);
+          pass.Accesses.push_back({.Source = latest[r], .Sink = sink, .Usage = usage});
+          latest[r] = sink;
+        } else {
+          const ResourceUsage usage = buffer ? buffer_reads[rng() % 3u] : image_reads[rng() % 3u];
+          pass.Accesses.push_back({.Source = latest[r], .Usage = usage});
+          read_first[r] = read_first[r] || latest[r] == resources[r].Name;
+        }
+      }
+
+      passes.push_back(pass);
+    }
+
+    for (TUint32 r = 0u; r < resource_count; r++) {
+      GraphResourceDesc &desc = resources[r];
+      if (read_first[r] || desc.Initial != ResourceUsage::NONE || rng() % 4u == 0u)
+        continue;
+
+      // two memory types with sizes of a few render targets
+      desc.Transient = true;
+      desc.Heap = rng() % 2u;
+      desc.Alignment = 64u * 1024u;
+      desc.Size = (1u + rng() % 16u) * desc.Alignment;
+    }
+
+    for (TUint32 i = 0u; i < std::min(config.OutputCount, resource_count); i++) {
+      const String &name = latest[pick(rng)];
+      if (std::find(outputs.begin(), outputs.end(), name) == outputs.end())
+        outputs.push_back(name);
+    }
+
+    std::shuffle(passes.begin(), passes.end(), rng);
+  }
+
+  void BenchmarkRenderGraph(const RenderGraphBenchmarkConfig &config, RenderGraphBenchmarkResult &result) {
+    result = {};
+    const TUint32 iterations = std::max(config.Iterations, 1u);
+
+    compile_renderer_graph(false, iterations, result.Raster);
+    compile_renderer_graph(true, iterations, result.RayTraced);
+
+    result.Random.Name = "random";
+    std::mt19937              rng(config.Seed);
+    Vector<GraphResourceDesc> resources = {};
+    Vector<GraphPassDesc>     passes = {};
+    Vector<String>            outputs = {};
+
+    for (TUint32 g = 0u; g < config.GraphCount; g++) {
+      make_random_graph(rng, config, resources, passes, outputs);
+      compile_graph("random", resources, passes, outputs, iterations, result.Random);
+    }
+  }
+
+} // namespace mau
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct RenderGraphBenchmarkConfig {
+    // random graphs, each pass reads and writes a few resources and passes are added in shuffled order
+    TUint32 PassCount = 512u;
+    TUint32 ResourceCount = 64u;
+    TUint32 OutputCount = 4u;
+    TUint32 GraphCount = 16u;
+    TUint32 Iterations = 10u;
+    TUint32 Seed = 1337u;
+  };
+
+  // errors are graphs that did not compile or whose passes and barriers failed the replay: a pass running before
+  // what it reads was written, an access in the wrong layout or one that is not synchronized with the last write,
+  // or transient resources that share memory while they are alive
+  struct RenderGraphCompileResult {
+    String   Name = "";
+    TUint32  PassCount = 0u;
+    TUint32  CulledCount = 0u;
+    TUint32  BarrierCount = 0u;
+    // calls to vkCmdPipelineBarrier, the barriers in front of a pass are recorded with one
+    TUint32  BarrierBatches = 0u;
+    TFloat64 CompileMs = 0.0;
+    // memory of the transient resources for one frame, with and without aliasing
+    TUint64 TransientBytes = 0u;
+    TUint64 UnaliasedBytes = 0u;
+    TUint32 Errors = 0u;
+  };
+
+  struct RenderGraphBenchmarkResult {
+    // the graphs the renderer builds, raster and ray traced
+    RenderGraphCompileResult Raster = {};
+    RenderGraphCompileResult RayTraced = {};
+    // summed over all random graphs, compile time is the best iteration of each
+    RenderGraphCompileResult Random = {};
+  };
+
+  // compiles the renderer's graphs and random ones and replays the result to check it, needs no device
+  void BenchmarkRenderGraph(const RenderGraphBenchmarkConfig &config, RenderGraphBenchmarkResult &result);
+
+} // namespace mau
@@ -0,0 +1,163 @@
+#include <harness/tlas.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <engine/log.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "graphics/tlas-instance-table.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  // what the scene holds, the table has to match it after every frame
+  struct ReferenceInstance {
+    glm::mat4 Transform = glm::mat4(1.0f);
+    TUint32   BLAS = 0u;
+  };
+
+  // stands in for the device address of a blas, only ever compared
+  static TUint64 blas_address(TUint32 blas) { return 0x10000ull * (static_cast<TUint64>(blas) + 1u); }
+
+  static bool matches(const VkAccelerationStructureInstanceKHR &record, const ReferenceInstance &instance) {
+    if (record.accelerationStructureReference != blas_address(instance.BLAS) || record.instanceCustomIndex != instance.BLAS)
+      return false;
+
+    // the tlas keeps the top three rows, the translation is the last column
+    for (TUint32 row = 0; row < 3u; row++) {
+      if (record.transform.matrix[row][3] != instance.Transform[3][row])
+        return false;
+    }
+    return true;
+  }
+
+  static TUint32 check_table(const TLASInstanceTable &table, const UnorderedMap<TUint64, ReferenceInstance> &reference, const Vector<VkAccelerationStructureInstanceKHR> &gpu) {
+    if (table.GetCount() != reference.size() || gpu.size() != table.GetCount())
+      return 1u;
+
+    // the gpu copy only received the changed records and still has to equal the table
+    TUint32 errors = std::memcmp(gpu.data(), table.GetInstances(), gpu.size() * sizeof(gpu[0])) != 0 ? 1u : 0u;
+
+    for (TUint32 i = 0; i < table.GetCount(); i++) {
+      if (table.Find(table.GetKey(i)) != table.GetInstances() + i)
+        errors++;
+    }
+
+    for (const auto &[key, instance] : reference) {
+      const VkAccelerationStructureInstanceKHR *record = table.Find(key);
+      if (!record || !matches(*record, instance))
+        errors++;
+    }
+    return errors;
+  }
+
+  void BenchmarkTLASInstances(const TLASBenchmarkConfig &config, TLASBenchmarkResult &result) {
+    std::mt19937                             rng(config.Seed);
+    std::uniform_real_distribution<float>    position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float>    step(-0.5f, 0.5f);
+    std::uniform_int_distribution<TUint32>   blas(0u, std::max(config.BLASCount, 1u) - 1u);
+    UnorderedMap<TUint64, ReferenceInstance> reference = {};
+    Vector<TUint64>                          live = {};
+    TUint32                                  next_entity = 0u;
+
+    auto add_instance = [&]() -> void {
+      const TUint64 key = make_tlas_instance_key(next_entity++, 0u);
+      reference[key] = {.Transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng))), .BLAS = blas(rng)};
+      live.push_back(key);
+    };
+
+    auto pick = [&]() -> TUint32 { return std::uniform_int_distribution<TUint32>(0u, static_cast<TUint32>(live.size()) - 1u)(rng); };
+
+    for (TUint32 i = 0; i < config.InstanceCount; i++) {
+      add_instance();
+    }
+
+    TLASInstanceTable                                    table = {};
+    Vector<std::pair<TUint64, const ReferenceInstance *>> snapshot = {};
+    Vector<VkAccelerationStructureInstanceKHR>           gpu = {};
+    TFloat64                                             update_ms = 0.0;
+    TUint64                                              copied = 0u;
+    TUint64                                              ranges = 0u;
+
+    result = {.Frames = config.Frames};
+    for (TUint32 frame = 0; frame < config.Frames; frame++) {
+      bool structural = frame == 0u;
+
+      if (frame > 0u && !live.empty()) {
+        const TUint32 moving = static_cast<TUint32>(static_cast<TFloat32>(live.size()) * config.MovingFraction);
+        for (TUint32 i = 0; i < moving; i++) {
+          glm::mat4 &transform = reference[live[pick()]].Transform;
+          transform = glm::translate(transform, glm::vec3(step(rng), step(rng), step(rng)));
+        }
+
+        if (config.ChurnInterval > 0u && frame % config.ChurnInterval == 0u) {
+          const TUint32 churn = std::max(1u, static_cast<TUint32>(static_cast<TFloat32>(live.size()) * config.ChurnFraction));
+          for (TUint32 i = 0; i < churn; i++) {
+            const TUint32 index = pick();
+            reference.erase(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+            add_instance();
+          }
+
+          for (TUint32 i = 0; i < churn; i++) {
+            ReferenceInstance &instance = reference[live[pick()]];
+            instance.BLAS = (instance.BLAS + 1u) % std::max(config.BLASCount, 1u);
+          }
+          structural = true;
+        }
+      }
+
+      // the renderer gets the instances as a flat list in the frame snapshot
+      snapshot.clear();
+      for (TUint64 key : live) {
+        snapshot.push_back({key, &reference[key]});
+      }
+
+      // what the renderer does every frame, every instance of the scene is set
+      const Clock::time_point start = Clock::now();
+      table.BeginFrame();
+      for (const auto &[key, instance] : snapshot) {
+        table.Set(key, instance->Transform, blas_address(instance->BLAS), instance->BLAS);
+      }
+      table.EndFrame();
+      const TLASInstanceChanges changes = table.TakeChanges();
+      update_ms += elapsed_ms(start);
+
+      // a refit has to keep the instance count and every blas
+      if (!changes.Rebuild) {
+        if (structural || gpu.size() != table.GetCount())
+          result.Errors++;
+
+        for (const TLASInstanceRange &range : changes.Ranges) {
+          for (TUint32 i = range.First; i < range.First + range.Count && i < gpu.size(); i++) {
+            if (gpu[i].accelerationStructureReference != table.GetInstances()[i].accelerationStructureReference)
+              result.Errors++;
+          }
+        }
+      }
+
+      gpu.resize(table.GetCount());
+      for (const TLASInstanceRange &range : changes.Ranges) {
+        std::memcpy(gpu.data() + range.First, table.GetInstances() + range.First, range.Count * sizeof(gpu[0]));
+      }
+
+      result.Errors += check_table(table, reference, gpu);
+      changes.Rebuild ? result.RebuildFrames++ : result.RefitFrames++;
+      copied += changes.RecordCount;
+      ranges += changes.Ranges.size();
+    }
+
+    const TFloat64 frames = static_cast<TFloat64>(std::max(config.Frames, 1u));
+    result.InstanceCount = table.GetCount();
+    result.UpdateMs = update_ms / frames;
+    result.CopiedRecords = static_cast<TFloat64>(copied) / frames;
+    result.CopyRanges = static_cast<TFloat64>(ranges) / frames;
+  }
+
+} // namespace mau
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct TLASBenchmarkConfig {
+    // a scene of instances drawing a few shared blases, every frame some of them move. every churn interval frames
+    // some are replaced and some switch their blas, those frames need a rebuild and the others a refit
+    TUint32  InstanceCount = 100000u;
+    TUint32  BLASCount = 64u;
+    TUint32  Frames = 120u;
+    TFloat32 MovingFraction = 0.05f;
+    TFloat32 ChurnFraction = 0.01f;
+    TUint32  ChurnInterval = 8u;
+    TUint32  Seed = 1337u;
+  };
+
+  // errors are frames where the records copied to the simulated gpu buffer do not match the table, an instance is
+  // missing or stale, or a frame asked for a refit although instances were added, removed or changed their blas
+  struct TLASBenchmarkResult {
+    TUint32  InstanceCount = 0u;
+    TUint32  Frames = 0u;
+    TUint32  RebuildFrames = 0u;
+    TUint32  RefitFrames = 0u;
+    // average per frame, update is setting every instance and taking the changes
+    TFloat64 UpdateMs = 0.0;
+    TFloat64 CopiedRecords = 0.0;
+    TFloat64 CopyRanges = 0.0;
+    TUint32  Errors = 0u;
+  };
+
+  // drives the scene tlas instance table through random frames and checks the changes it reports, needs no device
+  void BenchmarkTLASInstances(const TLASBenchmarkConfig &config, TLASBenchmarkResult &result);
+
+} // namespace mau
@@ -0,0 +1,191 @@
+#include <harness/transforms.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <engine/scene/scene.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  enum class TransformBenchMode { FULL, PARTIAL, STATIC };
+
+  // the model matrix the renderer used to build per draw, with the scale it ignored
+  static glm::mat4 reference_local(const TransformComponent &transform) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), transform.Position);
+    model = glm::rotate(model, transform.Rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    model = glm::rotate(model, transform.Rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, transform.Rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(model, transform.Scale);
+  }
+
+  // world matrices of every entity through the parent chain, serial and without any caching between calls
+  struct ReferenceWorlds {
+    Vector<glm::mat4>    Matrices = {}; // [entity index]
+    Vector<TUint32>      Computed = {}; // [entity index]
+    Vector<entt::entity> Chain = {};
+    TUint32              Pass = 0u;
+  };
+
+  static void compute_reference(Scene &scene, const Vector<entt::entity> &entities, ReferenceWorlds &reference) {
+    reference.Pass++;
+    for (entt::entity entity : entities) {
+      // up to the first ancestor that is done already, then back down
+      reference.Chain.clear();
+      for (entt::entity current = entity; current != entt::null; current = scene.GetEntity(current).Get<HierarchyComponent>().Parent) {
+        if (reference.Computed[static_cast<TUint32>(entt::to_entity(current))] == reference.Pass)
+          break;
+        reference.Chain.push_back(current);
+      }
+
+      for (auto it = reference.Chain.rbegin(); it != reference.Chain.rend(); it++) {
+        Entity             current = scene.GetEntity(*it);
+        const TUint32      index = static_cast<TUint32>(entt::to_entity(*it));
+        const glm::mat4    local = reference_local(current.Get<TransformComponent>());
+        const entt::entity parent = current.Get<HierarchyComponent>().Parent;
+
+        reference.Matrices[index] = parent != entt::null ? reference.Matrices[static_cast<TUint32>(entt::to_entity(parent))] * local : local;
+        reference.Computed[index] = reference.Pass;
+      }
+    }
+  }
+
+  // world matrices that differ from the reference and world flags that do not match the update
+  static TUint32 check_worlds(Scene &scene, const Vector<entt::entity> &entities, const ReferenceWorlds &reference, TUint32 updated_count) {
+    TUint32 mismatches = 0u;
+    TUint32 flagged = 0u;
+    for (entt::entity entity : entities) {
+      const WorldTransformComponent &world = scene.GetEntity(entity).Get<WorldTransformComponent>();
+      const glm::mat4               &expected = reference.Matrices[static_cast<TUint32>(entt::to_entity(entity))];
+      flagged += world.Updated ? 1u : 0u;
+
+      for (TUint32 column = 0; column < 4u; column++) {
+        const glm::vec4 difference = glm::abs(world.Matrix[column] - expected[column]);
+        const glm::vec4 magnitude = glm::abs(expected[column]);
+        if (std::max({difference.x, difference.y, difference.z, difference.w}) > 1e-3f * (1.0f + std::max({magnitude.x, magnitude.y, magnitude.z, magnitude.w}))) {
+          mismatches++;
+          break;
+        }
+      }
+    }
+    return mismatches + (flagged != updated_count ? 1u : 0u);
+  }
+
+  static void run_mode(Scene &scene, const Vector<entt::entity> &entities, const TransformBenchmarkConfig &config, TransformBenchMode mode, std::mt19937 &rng,
+                       ReferenceWorlds &reference, TransformUpdateResult &result, TUint32 &mismatches) {
+    std::uniform_real_distribution<float>  jitter(-0.1f, 0.1f);
+    std::uniform_int_distribution<TUint32> pick(0u, static_cast<TUint32>(entities.size()) - 1u);
+
+    const TUint32 dirty_count = static_cast<TUint32>(static_cast<TFloat32>(entities.size()) * config.DirtyFraction);
+    const TUint32 reparent_count = static_cast<TUint32>(static_cast<TFloat32>(entities.size()) * config.ReparentFraction);
+
+    for (TUint32 iteration = 0; iteration < config.Iterations; iteration++) {
+      if (mode == TransformBenchMode::FULL) {
+        for (entt::entity entity : entities) {
+          scene.GetEntity(entity).Get<TransformComponent>().Updated = true;
+        }
+      } else if (mode == TransformBenchMode::PARTIAL) {
+        for (TUint32 i = 0; i < dirty_count; i++) {
+          TransformComponent &transform = scene.GetEntity(entities[pick(rng)]).Get<TransformComponent>();
+          transform.Position += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+          transform.Rotation += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+          transform.Updated = true;
+        }
+
+        // some move to another parent and a few become roots, parenting into the own subtree is refused
+        for (TUint32 i = 0; i < reparent_count; i++) {
+          Entity child = scene.GetEntity(entities[pick(rng)]);
+          if (i % 8u == 0u)
+            scene.RemoveParent(child);
+          else
+            scene.SetParent(child, scene.GetEntity(entities[pick(rng)]));
+        }
+      }
+
+      const Clock::time_point    start = Clock::now();
+      const TransformUpdateStats stats = scene.UpdateTransforms();
+      result.TotalMs += elapsed_ms(start);
+      result.GatherMs += stats.GatherMs;
+      result.ComputeMs += stats.ComputeMs;
+      result.DirtyCount += stats.DirtyCount;
+      result.UpdatedCount += stats.UpdatedCount;
+      result.LevelCount = std::max(result.LevelCount, stats.LevelCount);
+
+      const Clock::time_point serial_start = Clock::now();
+      compute_reference(scene, entities, reference);
+      result.SerialMs += elapsed_ms(serial_start);
+
+      mismatches += check_worlds(scene, entities, reference, stats.UpdatedCount);
+    }
+
+    const TFloat64 iterations = static_cast<TFloat64>(std::max(config.Iterations, 1u));
+    result.TotalMs /= iterations;
+    result.GatherMs /= iterations;
+    result.ComputeMs /= iterations;
+    result.SerialMs /= iterations;
+    result.DirtyCount = static_cast<TUint32>(result.DirtyCount / iterations);
+    result.UpdatedCount = static_cast<TUint32>(result.UpdatedCount / iterations);
+  }
+
+  void BenchmarkTransforms(const TransformBenchmarkConfig &config, TransformBenchmarkResult &result) {
+    std::mt19937                          rng(config.Seed);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> rotation(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> scale(0.8f, 1.25f);
+
+    Handle<Scene>        scene = make_handle<Scene>();
+    Vector<entt::entity> entities = {};
+    entities.reserve(config.EntityCount);
+
+    const TUint32 root_count = std::clamp(config.RootCount, 1u, std::max(config.EntityCount, 1u));
+    for (TUint32 i = 0; i < std::max(config.EntityCount, 1u); i++) {
+      Entity entity = scene->CreateEntity();
+
+      TransformComponent &transform = entity.Get<TransformComponent>();
+      transform.Position = glm::vec3(position(rng), position(rng), position(rng));
+      transform.Rotation = glm::vec3(rotation(rng), rotation(rng), rotation(rng));
+      transform.Scale = glm::vec3(scale(rng), scale(rng), scale(rng));
+
+      // a few tries for a parent with room below it, roots otherwise
+      if (i >= root_count) {
+        for (TUint32 attempt = 0; attempt < 8u; attempt++) {
+          Entity parent = scene->GetEntity(entities[std::uniform_int_distribution<TUint32>(0u, i - 1u)(rng)]);
+          if (parent.Get<HierarchyComponent>().Depth + 1u < config.MaxDepth) {
+            scene->SetParent(entity, parent);
+            break;
+          }
+        }
+      }
+      entities.push_back(entity.GetId());
+    }
+
+    TUint32 entity_range = 0u;
+    for (entt::entity entity : entities) {
+      entity_range = std::max(entity_range, static_cast<TUint32>(entt::to_entity(entity)) + 1u);
+      result.MaxDepth = std::max(result.MaxDepth, scene->GetEntity(entity).Get<HierarchyComponent>().Depth);
+    }
+
+    ReferenceWorlds reference = {};
+    reference.Matrices.resize(entity_range);
+    reference.Computed.resize(entity_range, 0u);
+
+    // the first update computes everything that was created
+    scene->UpdateTransforms();
+
+    result.ThreadCount = JobSystem::Get() ? JobSystem::Ref().GetThreadCount() : 1u;
+    result.Full.Name = "full";
+    result.Partial.Name = "partial";
+    result.Static.Name = "static";
+    run_mode(*scene, entities, config, TransformBenchMode::FULL, rng, reference, result.Full, result.Mismatches);
+    run_mode(*scene, entities, config, TransformBenchMode::PARTIAL, rng, reference, result.Partial, result.Mismatches);
+    run_mode(*scene, entities, config, TransformBenchMode::STATIC, rng, reference, result.Static, result.Mismatches);
+  }
+
+} // namespace mau
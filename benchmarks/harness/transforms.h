@@ -0,0 +1,45 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  struct TransformBenchmarkConfig {
+    // every entity after the roots is parented to a random earlier one that is not at the maximum depth yet
+    TUint32  EntityCount = 100000u;
+    TUint32  RootCount = 64u;
+    TUint32  MaxDepth = 16u;
+    // partial updates move this fraction of the entities and reparent some of them
+    TFloat32 DirtyFraction = 0.01f;
+    TFloat32 ReparentFraction = 0.001f;
+    TUint32  Iterations = 20u;
+    TUint32  Seed = 1337u;
+  };
+
+  // average of all iterations in milliseconds. serial is recomputing every world matrix on one thread the way the
+  // renderer did before the transforms were cached
+  struct TransformUpdateResult {
+    String   Name = "";
+    TUint32  DirtyCount = 0u;
+    TUint32  UpdatedCount = 0u;
+    TUint32  LevelCount = 0u;
+    TFloat64 GatherMs = 0.0;
+    TFloat64 ComputeMs = 0.0;
+    TFloat64 TotalMs = 0.0;
+    TFloat64 SerialMs = 0.0;
+  };
+
+  // mismatches are world matrices that differ from a recursive recompute of the whole scene after an update
+  struct TransformBenchmarkResult {
+    TUint32               ThreadCount = 0u;
+    TUint32               MaxDepth = 0u;
+    TransformUpdateResult Full = {};
+    TransformUpdateResult Partial = {};
+    TransformUpdateResult Static = {};
+    TUint32               Mismatches = 0u;
+  };
+
+  // updates the world transforms of a random scene with everything, a few or nothing moved. only needs the job system
+  void BenchmarkTransforms(const TransformBenchmarkConfig &config, TransformBenchmarkResult &result);
+
+} // namespace mau
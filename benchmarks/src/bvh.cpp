@@ -0,0 +1,44 @@
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <harness/args.h>
+#include <harness/bvh.h>
+
+using namespace mau;
+
+static void log_result(const BvhWidthResult &result) {
+  LOG_INFO("bvh%u build %9.2f ms %9.2f ms parallel [nodes: %u, leaves: %u, depth: %u, sah: %.2f]", result.Width, result.BuildMs, result.ParallelBuildMs, result.NodeCount,
+           result.LeafCount, result.MaxDepth, result.SahCost);
+  LOG_INFO("bvh%u Mrays/s primary %8.2f packet %8.2f incoherent %8.2f occlusion %8.2f [mismatches: %u]", result.Width, result.PrimaryMrays, result.PacketMrays,
+           result.IncoherentMrays, result.OcclusionMrays, result.Mismatches);
+}
+
+// builds 4 and 8 wide cpu bvhs over a mesh and measures build time and ray throughput. needs no gpu.
+// usage: mau-bench-bvh [--mesh path] [--width pixels] [--height pixels] [--rays incoherent rays] [--iterations count] [--workers count]
+int main(int argc, char **argv) {
+  BvhBenchmarkConfig config = {};
+  TUint32            workers = UINT32_MAX;
+
+  BenchmarkArgs args;
+  args.Add("--mesh", config.MeshPath);
+  args.Add("--width", config.Width, 1u);
+  args.Add("--height", config.Height, 1u);
+  args.Add("--rays", config.IncoherentRayCount, 1u);
+  args.Add("--iterations", config.Iterations, 1u);
+  args.Add("--workers", workers);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  JobSystem::Create(workers);
+
+  BvhBenchmarkResult result = {};
+  const bool         loaded = BenchmarkBvh(config, result);
+
+  if (loaded) {
+    log_result(result.Bvh4);
+    log_result(result.Bvh8);
+  }
+
+  JobSystem::Destroy();
+  return loaded && result.Bvh4.Mismatches == 0u && result.Bvh8.Mismatches == 0u ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <harness/args.h>
+#include <harness/cpu-reference.h>
+
+using namespace mau;
+
+// renders a reference image with the cpu path tracer and reports its throughput. needs no gpu.
+// usage: mau-bench-cpu-path-tracer [--scene path] [--camera path] [--time seconds] [--width pixels] [--height pixels]
+//                                  [--min-samples count] [--max-samples count] [--noise threshold] [--tile pixels]
+//                                  [--out path without extension] [--workers count]
+int main(int argc, char **argv) {
+  CpuReferenceConfig config = {};
+  config.CameraPath = GetAssetFolderPath() + "bench/sponza.camera";
+  TUint32 workers = UINT32_MAX;
+
+  BenchmarkArgs args;
+  args.Add("--scene", config.ScenePath);
+  args.Add("--camera", config.CameraPath);
+  args.Add("--time", config.CameraTime);
+  args.Add("--width", config.Width, 1u);
+  args.Add("--height", config.Height, 1u);
+  args.Add("--min-samples", config.MinSamples, 1u);
+  args.Add("--max-samples", config.MaxSamples, 1u);
+  args.Add("--noise", config.NoiseThreshold);
+  args.Add("--tile", config.TileSize, 1u);
+  args.Add("--out", config.OutputPath);
+  args.Add("--workers", workers);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  JobSystem::Create(workers);
+
+  CpuReferenceResult result = {};
+  const bool         rendered = RenderCpuReference(config, result);
+
+  if (rendered) {
+    LOG_INFO("triangles %u, threads %u, tiles %u, passes %u", result.TriangleCount, result.ThreadCount, result.TileCount, result.Passes);
+    LOG_INFO("%.2f s, %.1f spp, %.2f Mrays/s, %.3f Msamples/s", result.RenderSeconds, result.SamplesPerPixel, result.MraysPerSecond, result.MsamplesPerSecond);
+  }
+
+  JobSystem::Destroy();
+  return rendered ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/exceptions.h>
+#include <harness/args.h>
+#include <harness/draw-recording.h>
+
+using namespace mau;
+
+// compares the cpu cost of recording the raster path with one draw call per submesh against the indirect draw list
+// and against per draw recording split across the recording threads.
+// usage: mau-bench-draw-recording [--iterations count] [--draws count]..., defaults to 1k, 10k and 100k draws
+int main(int argc, char **argv) {
+  EngineConfig config;
+  config.Width = 1280u;
+  config.Height = 720u;
+  config.FramesInFlight = 3u;
+  config.WindowName = "Mau Draw Recording Benchmark";
+  config.ValidationSeverity = VulkanValidationLogSeverity::ERROR;
+
+  TUint32         iterations = 16u;
+  Vector<TUint32> draw_counts = {};
+
+  BenchmarkArgs args;
+  args.Add("--iterations", iterations, 1u);
+  args.Add("--draws", draw_counts, 1u);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  if (draw_counts.empty()) {
+    draw_counts = {1000u, 10000u, 100000u};
+  }
+
+  try {
+    Engine::Create(config);
+
+    Vector<DrawRecordingResult> results = {};
+    for (TUint32 draw_count : draw_counts) {
+      results.push_back(BenchmarkDrawRecording(draw_count, iterations));
+    }
+
+    LOG_INFO("%10s %10s %12s %12s %12s %12s %10s %12s %8s", "draws", "batches", "build ms", "upload ms", "direct ms", "indirect ms", "speedup", "parallel ms", "threads");
+    for (const DrawRecordingResult &result : results) {
+      const TFloat64 speedup = result.IndirectRecordMs > 0.0 ? result.DirectRecordMs / result.IndirectRecordMs : 0.0;
+      LOG_INFO("%10u %10u %12.3f %12.3f %12.3f %12.3f %9.1fx %12.3f %8u", result.DrawCount, result.IndirectBatches, result.BuildMs, result.UploadMs, result.DirectRecordMs,
+               result.IndirectRecordMs, speedup, result.ParallelRecordMs, result.RecordingThreads);
+    }
+
+    Engine::Destroy();
+  } catch (GraphicsException e) {
+    LOG_FATAL("%s", e.what().data());
+  } catch (WindowException e) {
+    LOG_FATAL("%s", e.what().data());
+  } catch (std::exception e) {
+    LOG_FATAL("%s", e.what());
+  }
+
+  return 0;
+}
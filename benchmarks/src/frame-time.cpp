@@ -0,0 +1,75 @@
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/exceptions.h>
+#include <harness/args.h>
+#include <harness/frame-benchmark.h>
+
+using namespace mau;
+
+// renders a scene along a scripted camera path and writes per frame cpu stage and gpu timings with percentiles.
+// headless unless --window is given, so it runs unattended.
+// usage: mau-bench-frame-time [--scene path] [--camera path] [--warmup frames] [--frames frames]
+//                             [--frames-in-flight count] [--out path without extension] [--window]
+//                             [--pipeline-cache path] [--no-pipeline-cache] [--no-shader-cache]
+// run it twice with the same caches to compare cold and warm startup
+int main(int argc, char **argv) {
+  EngineConfig config;
+  config.Width = 1920u;
+  config.Height = 1080u;
+  config.FramesInFlight = 2u;
+  config.Headless = true;
+  config.WindowName = "Mau Frame Time Benchmark";
+  config.ValidationSeverity = VulkanValidationLogSeverity::ERROR;
+
+  FrameBenchmarkConfig bench_config = {};
+  bench_config.CameraPath = GetAssetFolderPath() + "bench/sponza.camera";
+  String output_path = "frame-time";
+
+  BenchmarkArgs args;
+  args.AddSwitch("--window", [&config]() -> void { config.Headless = false; });
+  args.Add("--scene", config.ScenePath);
+  args.Add("--camera", bench_config.CameraPath);
+  args.Add("--warmup", bench_config.WarmupFrames);
+  args.Add("--frames", bench_config.MeasuredFrames, 1u);
+  args.Add("--frames-in-flight", config.FramesInFlight, 1u);
+  args.Add("--pipeline-cache", config.PipelineCachePath);
+  args.AddSwitch("--no-pipeline-cache", [&config]() -> void { config.PipelineCachePath = ""; });
+  args.AddSwitch("--no-shader-cache", [&config]() -> void { config.ShaderCachePath = ""; });
+  args.Add("--out", output_path);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  int exit_code = 0;
+
+  try {
+    Engine::Create(config);
+
+    const FrameBenchmarkResult result = BenchmarkFrames(bench_config);
+
+    LOG_INFO("shader loading %.2f ms [from cache: %u]", result.ShaderLoadMs, result.CachedShaders);
+    LOG_INFO("pipeline creation %.2f ms [pipeline cache: %s]", result.PipelineCreateMs, result.PipelineCacheWarm ? "warm" : "cold");
+    LOG_INFO("%14s %10s %10s %10s %10s %10s", "stage", "mean", "p50", "p90", "p99", "max");
+    for (const char *stage : {"frame_ms", "update_ms", "imgui_ms", "fence_wait_ms", "record_ms", "submit_ms", "render_ms", "gpu_ms"}) {
+      const TimingSummary summary = SummarizeFrameStage(result, stage);
+      LOG_INFO("%14s %10.3f %10.3f %10.3f %10.3f %10.3f", stage, summary.Mean, summary.P50, summary.P90, summary.P99, summary.Max);
+    }
+
+    if (!WriteFrameBenchmarkJson(result, output_path + ".json") || !WriteFrameBenchmarkCsv(result, output_path + ".csv")) {
+      exit_code = 1;
+    }
+
+    Engine::Destroy();
+  } catch (GraphicsException e) {
+    LOG_FATAL("%s", e.what().data());
+    exit_code = 1;
+  } catch (WindowException e) {
+    LOG_FATAL("%s", e.what().data());
+    exit_code = 1;
+  } catch (std::exception e) {
+    LOG_FATAL("%s", e.what());
+    exit_code = 1;
+  }
+
+  return exit_code;
+}
@@ -0,0 +1,38 @@
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <harness/args.h>
+#include <harness/culling.h>
+
+using namespace mau;
+
+// culls random boxes against cameras looking into random directions with the scalar test and the 4 and 8 wide simd
+// ones, serial and on the job system, and checks that they agree. needs no gpu.
+// usage: mau-bench-frustum-culling [--items count] [--extent size] [--iterations count] [--seed value] [--workers count]
+int main(int argc, char **argv) {
+  CullingBenchmarkConfig config = {};
+  TUint32                workers = UINT32_MAX;
+
+  BenchmarkArgs args;
+  args.Add("--items", config.ItemCount, 1u);
+  args.Add("--extent", config.SceneExtent, 1.0f);
+  args.Add("--iterations", config.Iterations, 1u);
+  args.Add("--seed", config.Seed);
+  args.Add("--workers", workers);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  JobSystem::Create(workers);
+
+  CullingBenchmarkResult result = {};
+  BenchmarkFrustumCulling(config, result);
+
+  LOG_INFO("%u items, %u threads", config.ItemCount, result.ThreadCount);
+  for (const CullingVariantResult &variant : result.Variants) {
+    LOG_INFO("%-12s %8.3f ms [visible: %.0f, culled: %.0f, jobs: %u]", variant.Name.c_str(), variant.CullMs, variant.VisibleCount, config.ItemCount - variant.VisibleCount, variant.JobCount);
+  }
+  LOG_INFO("mismatches: %u", result.Mismatches);
+
+  JobSystem::Destroy();
+  return result.Mismatches == 0u ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <harness/args.h>
+
+using namespace mau;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+// enough math per element that a range costs more than scheduling it
+static TFloat32 busy_work(TUint32 index) {
+  TFloat32 value = static_cast<TFloat32>(index);
+  for (TUint32 i = 0u; i < 64u; i++) {
+    value = std::sin(value) * 0.5f + std::sqrt(value + 1.0f);
+  }
+  return value;
+}
+
+struct JobSystemResult {
+  TUint32  Workers = 0u;
+  TFloat64 DispatchNs = 0.0;
+  TFloat64 GraphNs = 0.0;
+  TFloat64 ParallelForMs = 0.0;
+  TUint64  Stolen = 0u;
+};
+
+static JobSystemResult run(TUint32 workers, TUint32 job_count, TUint32 element_count, TUint32 iterations) {
+  JobSystem::Create(workers);
+  JobSystem &jobs = JobSystem::Ref();
+
+  JobSystemResult result = {.Workers = workers, .DispatchNs = 1e30, .GraphNs = 1e30, .ParallelForMs = 1e30};
+
+  // empty jobs, the whole cost is scheduling, stealing and counting
+  for (TUint32 iteration = 0u; iteration < iterations; iteration++) {
+    std::atomic<TUint32> executed = 0u;
+    JobCounter           counter;
+
+    const Clock::time_point start = Clock::now();
+    for (TUint32 i = 0u; i < job_count; i++) {
+      jobs.Schedule([&executed]() -> void { executed.fetch_add(1u, std::memory_order_relaxed); }, &counter);
+    }
+    jobs.Wait(counter);
+    result.DispatchNs = std::min(result.DispatchNs, elapsed_ms(start) * 1e6 / job_count);
+
+    if (executed.load() != job_count) {
+      LOG_ERROR("dispatch ran %u of %u jobs", executed.load(), job_count);
+    }
+  }
+
+  // a fan out and fan in graph, every leaf depends on the root and the sink on every leaf
+  for (TUint32 iteration = 0u; iteration < iterations; iteration++) {
+    std::atomic<TUint32> executed = 0u;
+    JobGraph             graph;
+
+    const TUint32 root = graph.Add([&executed]() -> void { executed.fetch_add(1u, std::memory_order_relaxed); });
+    const TUint32 sink = graph.Add([&executed]() -> void { executed.fetch_add(1u, std::memory_order_relaxed); });
+    for (TUint32 i = 0u; i < job_count / 16u; i++) {
+      const TUint32 leaf = graph.Add([&executed]() -> void { executed.fetch_add(1u, std::memory_order_relaxed); });
+      graph.Depend(leaf, root);
+      graph.Depend(sink, leaf);
+    }
+
+    const Clock::time_point start = Clock::now();
+    graph.RunAndWait();
+    result.GraphNs = std::min(result.GraphNs, elapsed_ms(start) * 1e6 / graph.GetJobCount());
+
+    if (executed.load() != graph.GetJobCount()) {
+      LOG_ERROR("graph ran %u of %u jobs", executed.load(), graph.GetJobCount());
+    }
+  }
+
+  Vector<TFloat32> output(static_cast<size_t>(element_count), 0.0f);
+  for (TUint32 iteration = 0u; iteration < iterations; iteration++) {
+    const Clock::time_point start = Clock::now();
+    jobs.ParallelFor(element_count, 256u, [&output](TUint32 begin, TUint32 end) -> void {
+      for (TUint32 i = begin; i < end; i++) {
+        output[i] = busy_work(i);
+      }
+    });
+    result.ParallelForMs = std::min(result.ParallelForMs, elapsed_ms(start));
+  }
+
+  result.Stolen = jobs.GetStolenCount();
+  JobSystem::Destroy();
+  return result;
+}
+
+// measures the cost of a single job and how parallel for scales with the number of workers.
+// usage: mau-bench-job-system [--iterations count] [--jobs count] [--elements parallel for elements]
+int main(int argc, char **argv) {
+  TUint32 iterations = 8u;
+  TUint32 job_count = 100000u;
+  TUint32 element_count = 1u << 20u;
+
+  BenchmarkArgs args;
+  args.Add("--iterations", iterations, 1u);
+  args.Add("--jobs", job_count, 16u);
+  args.Add("--elements", element_count, 1u);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  const TUint32 hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // no workers first, it is the baseline the speedup is measured against
+  Vector<TUint32> worker_counts = {0u};
+  for (TUint32 threads = 2u; threads < hardware_threads; threads *= 2u) {
+    worker_counts.push_back(threads - 1u);
+  }
+  if (hardware_threads > 1u) {
+    worker_counts.push_back(hardware_threads - 1u);
+  }
+
+  Vector<JobSystemResult> results = {};
+  for (TUint32 workers : worker_counts) {
+    results.push_back(run(workers, job_count, element_count, iterations));
+  }
+
+  LOG_INFO("%8s %14s %14s %16s %10s %10s", "threads", "dispatch ns", "graph ns/job", "parallel for ms", "speedup", "stolen");
+  for (const JobSystemResult &result : results) {
+    const TFloat64 speedup = result.ParallelForMs > 0.0 ? results.front().ParallelForMs / result.ParallelForMs : 0.0;
+    LOG_INFO("%8u %14.1f %14.1f %16.3f %9.2fx %10llu", result.Workers + 1u, result.DispatchNs, result.GraphNs, result.ParallelForMs, speedup,
+             static_cast<unsigned long long>(result.Stolen));
+  }
+
+  return 0;
+}
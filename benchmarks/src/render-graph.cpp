@@ -0,0 +1,38 @@
+#include <engine/log.h>
+#include <harness/args.h>
+#include <harness/render-graph.h>
+
+using namespace mau;
+
+static void log_result(const RenderGraphCompileResult &result) {
+  const TFloat64 mb = 1024.0 * 1024.0;
+  LOG_INFO("%-10s %9.3f ms [passes: %u, culled: %u, barriers: %u, barrier calls: %u, transient: %.1f MB, unaliased: %.1f MB, errors: %u]", result.Name.c_str(), result.CompileMs,
+           result.PassCount, result.CulledCount, result.BarrierCount, result.BarrierBatches, result.TransientBytes / mb, result.UnaliasedBytes / mb, result.Errors);
+}
+
+// compiles the renderer's render graphs and random ones, then replays them to check pass order, layouts and
+// barriers. needs no gpu.
+// usage: mau-bench-render-graph [--passes count] [--resources count] [--outputs count] [--graphs count] [--iterations count] [--seed value]
+int main(int argc, char **argv) {
+  RenderGraphBenchmarkConfig config = {};
+
+  BenchmarkArgs args;
+  args.Add("--passes", config.PassCount, 1u);
+  args.Add("--resources", config.ResourceCount, 1u);
+  args.Add("--outputs", config.OutputCount, 1u);
+  args.Add("--graphs", config.GraphCount);
+  args.Add("--iterations", config.Iterations, 1u);
+  args.Add("--seed", config.Seed);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  RenderGraphBenchmarkResult result = {};
+  BenchmarkRenderGraph(config, result);
+
+  log_result(result.Raster);
+  log_result(result.RayTraced);
+  log_result(result.Random);
+
+  return result.Raster.Errors == 0u && result.RayTraced.Errors == 0u && result.Random.Errors == 0u ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#include <engine/log.h>
+#include <harness/args.h>
+#include <harness/tlas.h>
+
+using namespace mau;
+
+// keeps a scene tlas instance table in sync with random frames of moving, added and removed instances and checks
+// that the copied records rebuild the table and that refits are only asked for when they are allowed. needs no gpu.
+// usage: mau-bench-tlas-instances [--instances count] [--blases count] [--frames count] [--moving fraction] [--churn fraction] [--churn-interval frames] [--seed value]
+int main(int argc, char **argv) {
+  TLASBenchmarkConfig config = {};
+
+  BenchmarkArgs args;
+  args.Add("--instances", config.InstanceCount, 1u);
+  args.Add("--blases", config.BLASCount, 1u);
+  args.Add("--frames", config.Frames, 1u);
+  args.Add("--moving", config.MovingFraction, 0.0f, 1.0f);
+  args.Add("--churn", config.ChurnFraction, 0.0f, 1.0f);
+  args.Add("--churn-interval", config.ChurnInterval);
+  args.Add("--seed", config.Seed);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  TLASBenchmarkResult result = {};
+  BenchmarkTLASInstances(config, result);
+
+  LOG_INFO("tlas instances %u, frames %u [rebuilds: %u, refits: %u]", result.InstanceCount, result.Frames, result.RebuildFrames, result.RefitFrames);
+  LOG_INFO("update %.3f ms per frame, copied %.1f records in %.1f ranges per frame (%.2f%% of the table), errors: %u", result.UpdateMs, result.CopiedRecords, result.CopyRanges,
+           result.InstanceCount > 0u ? 100.0 * result.CopiedRecords / result.InstanceCount : 0.0, result.Errors);
+
+  return result.Errors == 0u ? 0 : 1;
+}
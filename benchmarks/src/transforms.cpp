@@ -0,0 +1,46 @@
+#include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <harness/args.h>
+#include <harness/transforms.h>
+
+using namespace mau;
+
+static void log_result(const TransformUpdateResult &result) {
+  LOG_INFO("%-8s %8.3f ms [gather: %.3f ms, compute: %.3f ms, dirty: %u, updated: %u, levels: %u] serial recompute %8.3f ms", result.Name.c_str(), result.TotalMs, result.GatherMs,
+           result.ComputeMs, result.DirtyCount, result.UpdatedCount, result.LevelCount, result.SerialMs);
+}
+
+// builds a random transform hierarchy and updates its world transforms with everything, a few entities or nothing
+// moved, then checks them against a serial recompute. needs no gpu.
+// usage: mau-bench-transforms [--entities count] [--roots count] [--depth levels] [--dirty fraction] [--reparent fraction] [--iterations count] [--seed value] [--workers count]
+int main(int argc, char **argv) {
+  TransformBenchmarkConfig config = {};
+  TUint32                  workers = UINT32_MAX;
+
+  BenchmarkArgs args;
+  args.Add("--entities", config.EntityCount, 1u);
+  args.Add("--roots", config.RootCount, 1u);
+  args.Add("--depth", config.MaxDepth, 1u);
+  args.Add("--dirty", config.DirtyFraction, 0.0f, 1.0f);
+  args.Add("--reparent", config.ReparentFraction, 0.0f, 1.0f);
+  args.Add("--iterations", config.Iterations, 1u);
+  args.Add("--seed", config.Seed);
+  args.Add("--workers", workers);
+
+  if (!args.Parse(argc, argv))
+    return 1;
+
+  JobSystem::Create(workers);
+
+  TransformBenchmarkResult result = {};
+  BenchmarkTransforms(config, result);
+
+  LOG_INFO("%u entities, depth %u, %u threads", config.EntityCount, result.MaxDepth, result.ThreadCount);
+  log_result(result.Full);
+  log_result(result.Partial);
+  log_result(result.Static);
+  LOG_INFO("mismatches: %u", result.Mismatches);
+
+  JobSystem::Destroy();
+  return result.Mismatches == 0u ? 0 : 1;
+}
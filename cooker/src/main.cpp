@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <engine/log.h>
+#include <engine/loader/cooker.h>
+
+using namespace mau;
+
+static bool is_image(const String &path) {
+  String extension = std::filesystem::path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) -> char { return static_cast<char>(std::tolower(c)); });
+  return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+// cooks every mesh or image given on the command line, the cooked file is written next to the source.
+// meshes also cook the textures they reference, images given directly are cooked as color unless --normal precedes them
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    LOG_INFO("usage: mau-cooker [--normal] <mesh|image> [[--normal] <mesh|image> ...]");
+    return 1;
+  }
+
+  int  failed = 0;
+  int  total = 0;
+  bool normal = false;
+
+  for (int i = 1; i < argc; i++) {
+    const String argument = argv[i];
+    if (argument == "--normal") {
+      normal = true;
+      continue;
+    }
+
+    const bool cooked = is_image(argument) ? CookTexture(argument, normal ? TextureKind::NORMAL : TextureKind::COLOR) : CookMesh(argument);
+    if (!cooked)
+      failed++;
+
+    total++;
+    normal = false;
+  }
+
+  if (failed > 0) {
+    LOG_ERROR("failed to cook %d of %d files", failed, total);
+    return 1;
+  }
+
+  return 0;
+}
@@ -4,6 +4,8 @@
 #include "common/limits.glsl"
 
 #extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_buffer_reference2 : require
 
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normal;
@@ -13,18 +15,42 @@ layout (location = 0) out vec4 color;
 layout (location = 1) out vec2 out_tex_coord;
 layout (location = 2) flat out uint out_material_index;
 
+// written by IndirectDrawList, one entry per submesh
+struct DrawData {
+  mat4 model;
+  uint material_index;
+  uint pad1;
+  uint pad2;
+  uint pad3;
+};
+
+layout (buffer_reference, scalar) readonly buffer DrawDataBuffer { DrawData d[]; };
+
 layout (push_constant) uniform Constants {
   vec4 color;
-  mat4 mvp;
+  mat4 view_proj;
   uint material_index;
   uint rt_storage_index;
   uint camera_buffer_index;
-  uint padding;
+  uint current_frame;
+  uint accum_storage_index;
+  uint alb_storage_index;
+  uint nrm_storage_index;
+
+  uint pad1;
+
+  vec4 light_col;
+  vec4 light_dir;
+
+  DrawDataBuffer draws;
 } push_constant;
 
 void main() {
-  gl_Position = push_constant.mvp * vec4(pos, 1.0);
+  // every draw is a single instance starting at its own index into the draw data
+  DrawData draw = push_constant.draws.d[gl_InstanceIndex];
+
+  gl_Position = push_constant.view_proj * draw.model * vec4(pos, 1.0);
   color = vec4(tex_coord, 0.0, 1.0);
   out_tex_coord = tex_coord;
-  out_material_index = push_constant.material_index;
+  out_material_index = draw.material_index;
 }
@@ -0,0 +1,54 @@
+#version 460
+#pragma shader_stage(compute)
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// one dispatch per level, every texel keeps the farthest depth of the texels below it
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (set = 1, binding = 0) uniform sampler2DMS depth_sampler[];
+layout (set = 3, binding = 0, r32f) uniform image2D pyramid_image[];
+
+layout (push_constant) uniform Constants {
+  uint source_index;
+  uint target_index;
+  uint source_width;
+  uint source_height;
+  uint target_width;
+  uint target_height;
+  uint sample_count;
+  uint from_depth;
+} push_constant;
+
+float load_source(ivec2 texel) {
+  // level 0 reads every sample of the multisampled depth
+  if (push_constant.from_depth != 0) {
+    float depth = 0.0;
+    for (int s = 0; s < int(push_constant.sample_count); s++) {
+      depth = max(depth, texelFetch(depth_sampler[push_constant.source_index], texel, s).r);
+    }
+    return depth;
+  }
+  return imageLoad(pyramid_image[push_constant.source_index], texel).r;
+}
+
+void main() {
+  uvec2 target = gl_GlobalInvocationID.xy;
+  if (target.x >= push_constant.target_width || target.y >= push_constant.target_height) return;
+
+  // two by two source texels, the last row and column also take the odd one left over by the halving
+  uvec2 source_max = uvec2(push_constant.source_width, push_constant.source_height) - 1;
+  uvec2 first = min(target * 2, source_max);
+  uvec2 last = min(first + 1, source_max);
+  if (target.x == push_constant.target_width - 1) last.x = source_max.x;
+  if (target.y == push_constant.target_height - 1) last.y = source_max.y;
+
+  float depth = 0.0;
+  for (uint y = first.y; y <= last.y; y++) {
+    for (uint x = first.x; x <= last.x; x++) {
+      depth = max(depth, load_source(ivec2(x, y)));
+    }
+  }
+
+  imageStore(pyramid_image[push_constant.target_index], ivec2(target), vec4(depth));
+}
@@ -0,0 +1,149 @@
+#version 460
+#pragma shader_stage(compute)
+
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_buffer_reference2 : require
+
+// one invocation per draw, visible commands are appended to the culled commands of the draw's batch
+layout (local_size_x = 64) in;
+
+// written by IndirectDrawList, one entry per submesh
+struct DrawData {
+  mat4 model;
+  uint material_index;
+  uint pad1;
+  uint pad2;
+  uint pad3;
+};
+
+// local bounds, a negative radius marks a draw without bounds
+struct DrawBounds {
+  vec4 sphere;
+  vec3 box_min;
+  uint batch;
+  vec3 box_max;
+  uint batch_first_draw;
+};
+
+struct DrawCommand {
+  uint index_count;
+  uint instance_count;
+  uint first_index;
+  int  vertex_offset;
+  uint first_instance;
+};
+
+// written by GpuCuller every frame
+struct CullData {
+  vec4 planes[6];
+  mat4 pyramid_view_proj;
+  uint pyramid_width;
+  uint pyramid_height;
+  uint pyramid_levels;
+  uint pyramid_texture;
+  uint draw_count;
+  uint occlusion;
+  uint pad1;
+  uint pad2;
+};
+
+layout (buffer_reference, scalar) readonly buffer CullDataBuffer { CullData d; };
+layout (buffer_reference, scalar) readonly buffer DrawDataBuffer { DrawData d[]; };
+layout (buffer_reference, scalar) readonly buffer DrawBoundsBuffer { DrawBounds d[]; };
+layout (buffer_reference, scalar) readonly buffer DrawCommandBuffer { DrawCommand d[]; };
+layout (buffer_reference, scalar) writeonly buffer CulledCommandBuffer { DrawCommand d[]; };
+layout (buffer_reference, scalar) buffer DrawCountBuffer { uint d[]; };
+
+layout (set = 1, binding = 0) uniform sampler2D tex_sampler[];
+
+layout (push_constant) uniform Constants {
+  CullDataBuffer      cull;
+  DrawDataBuffer      draws;
+  DrawBoundsBuffer    bounds;
+  DrawCommandBuffer   commands;
+  CulledCommandBuffer culled_commands;
+  DrawCountBuffer     counts;
+} push_constant;
+
+// the same test as is_visible in frustum-culler.cpp
+bool is_in_frustum(CullData cull, vec3 center, vec3 extent, vec3 sphere_center, float radius_squared) {
+  for (int p = 0; p < 6; p++) {
+    vec4  plane = cull.planes[p];
+    float sphere_distance = dot(plane.xyz, sphere_center) + plane.w;
+    float box_distance = dot(plane.xyz, center) + plane.w;
+    float box_radius = dot(abs(plane.xyz), extent);
+
+    if ((sphere_distance < 0.0 && sphere_distance * sphere_distance > radius_squared) || box_distance + box_radius < 0.0) return false;
+  }
+  return true;
+}
+
+// projects the world box with the camera the pyramid was built with and compares its nearest depth against the
+// farthest depth of the pyramid texels under it, on the level where the box covers at most two by two texels
+bool is_occluded(CullData cull, vec3 center, vec3 extent) {
+  vec2  uv_min = vec2(1.0);
+  vec2  uv_max = vec2(0.0);
+  float depth_min = 1.0;
+
+  for (uint i = 0; i < 8; i++) {
+    vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+    vec4 clip = cull.pyramid_view_proj * vec4(corner, 1.0);
+
+    // reaches behind the camera, nothing to compare against
+    if (clip.w <= 1e-5) return false;
+
+    // the viewport is flipped, ndc y points up and texel rows down
+    vec3 ndc = clip.xyz / clip.w;
+    vec2 uv = vec2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);
+    uv_min = min(uv_min, uv);
+    uv_max = max(uv_max, uv);
+    depth_min = min(depth_min, ndc.z);
+  }
+
+  uv_min = clamp(uv_min, vec2(0.0), vec2(1.0));
+  uv_max = clamp(uv_max, vec2(0.0), vec2(1.0));
+  if (uv_min.x >= uv_max.x || uv_min.y >= uv_max.y) return false;
+
+  vec2 size = (uv_max - uv_min) * vec2(cull.pyramid_width, cull.pyramid_height);
+  int  level = min(int(ceil(log2(max(max(size.x, size.y), 1.0)))), int(cull.pyramid_levels) - 1);
+
+  ivec2 level_size = textureSize(tex_sampler[cull.pyramid_texture], level);
+  ivec2 texel_min = clamp(ivec2(uv_min * vec2(level_size)), ivec2(0), level_size - 1);
+  ivec2 texel_max = clamp(ivec2(uv_max * vec2(level_size)), ivec2(0), min(texel_min + 1, level_size - 1));
+
+  float depth_max = 0.0;
+  for (int y = texel_min.y; y <= texel_max.y; y++) {
+    for (int x = texel_min.x; x <= texel_max.x; x++) {
+      depth_max = max(depth_max, texelFetch(tex_sampler[cull.pyramid_texture], ivec2(x, y), level).r);
+    }
+  }
+
+  return depth_min > depth_max;
+}
+
+void main() {
+  CullData cull = push_constant.cull.d;
+  uint     index = gl_GlobalInvocationID.x;
+  if (index >= cull.draw_count) return;
+
+  DrawBounds bounds = push_constant.bounds.d[index];
+  if (bounds.sphere.w >= 0.0) {
+    // world bounds in the same order as is_visible
+    mat4 model = push_constant.draws.d[index].model;
+    vec3 c = (bounds.box_min + bounds.box_max) * 0.5;
+    vec3 e = (bounds.box_max - bounds.box_min) * 0.5;
+
+    vec3  center = model[0].xyz * c.x + model[1].xyz * c.y + model[2].xyz * c.z + model[3].xyz;
+    vec3  extent = abs(model[0].xyz) * e.x + abs(model[1].xyz) * e.y + abs(model[2].xyz) * e.z;
+    vec3  sphere_center = model[0].xyz * bounds.sphere.x + model[1].xyz * bounds.sphere.y + model[2].xyz * bounds.sphere.z + model[3].xyz;
+    float scale_squared = max(max(dot(model[0].xyz, model[0].xyz), dot(model[1].xyz, model[1].xyz)), dot(model[2].xyz, model[2].xyz));
+    float radius_squared = bounds.sphere.w * bounds.sphere.w * scale_squared;
+
+    if (!is_in_frustum(cull, center, extent, sphere_center, radius_squared)) return;
+    if (cull.occlusion != 0 && is_occluded(cull, center, extent)) return;
+  }
+
+  uint slot = atomicAdd(push_constant.counts.d[bounds.batch], 1);
+  push_constant.culled_commands.d[bounds.batch_first_draw + slot] = push_constant.commands.d[index];
+}
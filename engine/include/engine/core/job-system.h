@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <engine/types.h>
+#include <engine/utils/singleton.h>
+
+namespace mau {
+
+  using JobFunction = std::function<void()>;
+  using RangeFunction = std::function<void(TUint32 begin, TUint32 end)>;
+
+  // number of unfinished jobs, scheduling against a counter adds one and finishing a job removes it
+  class JobCounter {
+  public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+  public:
+    inline bool    IsDone() const { return m_Value.load(std::memory_order_acquire) == 0u; }
+    inline TUint32 GetValue() const { return m_Value.load(std::memory_order_acquire); }
+
+  private:
+    friend class JobSystem;
+    friend class JobGraph;
+
+    std::atomic<TUint32> m_Value = 0u;
+  };
+
+  // work stealing scheduler. every thread owns a deque, owners push and pop at the back while idle threads
+  // steal from the front of the others. thread 0 is the thread that created the job system, threads that
+  // are not part of it queue their jobs on thread 0's deque. waiting runs queued jobs instead of blocking,
+  // and sleeps next to the idle workers once the rest of its jobs run elsewhere. without workers every job
+  // runs on the thread that waits for it
+  class JobSystem: public Singleton<JobSystem> {
+    friend class Singleton<JobSystem>;
+    friend class JobGraph;
+
+  private:
+    JobSystem(TUint32 worker_count = UINT32_MAX);
+    ~JobSystem();
+
+  public:
+    void Schedule(JobFunction function, JobCounter *counter = nullptr);
+    // long running work like decoding files, only workers run it once they found no other job. waiting threads never
+    // pick it up, so it doesn't stall a frame. without workers it runs right away on the calling thread
+    void ScheduleBackground(JobFunction function, JobCounter *counter = nullptr);
+    void Wait(const JobCounter &counter);
+
+    // splits [0, count) into ranges of at least grain_size and returns once all of them ran
+    void ParallelFor(TUint32 count, TUint32 grain_size, const RangeFunction &function);
+
+    // runs one queued job on the calling thread, false when there was nothing to run
+    bool RunPendingJob();
+
+  public:
+    // workers plus the creating thread
+    inline TUint32 GetThreadCount() const { return static_cast<TUint32>(m_Queues.size()); }
+    inline TUint32 GetWorkerCount() const { return static_cast<TUint32>(m_Workers.size()); }
+    inline TUint64 GetExecutedCount() const { return m_Executed.load(std::memory_order_relaxed); }
+    inline TUint64 GetStolenCount() const { return m_Stolen.load(std::memory_order_relaxed); }
+
+    // index of the calling thread in [0, GetThreadCount()), UINT32_MAX for threads outside the job system
+    static TUint32 GetThreadIndex();
+
+  private:
+    struct Job {
+      JobFunction Function = nullptr;
+      JobCounter *Counter = nullptr;
+    };
+
+    struct WorkQueue {
+      std::mutex      Mutex = {};
+      std::deque<Job> Jobs = {};
+    };
+
+  private:
+    bool TryPop(TUint32 thread_index, Job &job);
+    bool TrySteal(TUint32 thread_index, Job &job);
+    bool TryPopBackground(Job &job);
+    void Execute(Job &job);
+    // finishes one job of the counter, wakes the waiters when it was the last one
+    void Release(JobCounter &counter);
+    void WorkerLoop(std::stop_token stop_token, TUint32 thread_index);
+
+  private:
+    Vector<std::unique_ptr<WorkQueue>> m_Queues = {};
+    Vector<std::jthread>               m_Workers = {};
+
+    // sleeping workers are only woken when there are any, scheduling stays lock free otherwise
+    std::mutex                  m_SleepMutex = {};
+    std::condition_variable_any m_SleepCondition = {};
+    std::atomic<TUint32>        m_Queued = 0u;
+    std::atomic<TUint32>        m_Sleeping = 0u;
+
+    // background jobs sit apart from the deques, only workers take them
+    WorkQueue            m_Background = {};
+    std::atomic<TUint32> m_BackgroundQueued = 0u;
+
+    std::atomic<TUint64> m_Executed = 0u;
+    std::atomic<TUint64> m_Stolen = 0u;
+  };
+
+  // jobs with dependencies between them, a job is scheduled once everything it depends on has finished.
+  // the graph has to outlive its run
+  class JobGraph {
+  public:
+    JobGraph() = default;
+    ~JobGraph() = default;
+
+  public:
+    TUint32 Add(JobFunction function);
+    void    Depend(TUint32 job, TUint32 dependency);
+
+    // schedules every job without dependencies, counter reaches zero when the whole graph ran
+    void Run(JobCounter &counter);
+    void RunAndWait();
+
+  public:
+    inline TUint32 GetJobCount() const { return static_cast<TUint32>(m_Nodes.size()); }
+
+  private:
+    struct Node {
+      JobFunction          Function = nullptr;
+      Vector<TUint32>      Dependents = {};
+      TUint32              DependencyCount = 0u;
+      std::atomic<TUint32> Remaining = 0u;
+    };
+
+  private:
+    void Schedule(TUint32 job, JobCounter &counter);
+
+  private:
+    Vector<std::unique_ptr<Node>> m_Nodes = {};
+  };
+
+} // namespace mau
@@ -10,9 +10,23 @@ namespace mau {
     TUint32          Width = 0u;
     TUint32          Height = 0u;
     TUint32          ValidationSeverity = 0u;
+    // above 1 the next frame is updated while a render thread submits the current one. layers that
+    // create or destroy gpu resources from OnUpdate have to run with 1
     TUint32          FramesInFlight = 1u;
+    // no window, surface or present. frames go to offscreen images as fast as the device allows
+    bool             Headless = false;
+    // Run returns after this many frames, 0 runs until the window is closed
+    TUint32          FrameLimit = 0u;
     std::string_view WindowName;
     std::string_view ApplicationName;
+    // mesh loaded into the default scene, empty loads sponza from the asset folder
+    std::string_view ScenePath;
+    // driver pipeline cache, read at startup and written at shutdown. empty keeps it in memory only
+    std::string_view PipelineCachePath = "pipeline-cache.bin";
+    // folder of compiled spir-v keyed by shader source, includes and options. empty compiles every shader every run
+    std::string_view ShaderCachePath = "shader-cache";
+    // descriptors in each bindless array, clamped to the device limits
+    TUint32          BindlessDescriptorCount = 1024u;
   };
 
 } // namespace mau
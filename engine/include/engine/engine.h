@@ -7,10 +7,13 @@
 #include <engine/enums.h>
 #include <engine/scene/scene.h>
 #include <engine/core/layers.h>
+#include <engine/frame-timing.h>
 
 namespace mau {
 
   std::string GetAssetFolderPath();
+  // where the engine places the scene it loads, the cpu reference renders it with the same transform
+  TransformComponent GetSceneTransform();
 
   class Engine: public Singleton<Engine> {
     friend Singleton<Engine>;
@@ -21,6 +24,8 @@ namespace mau {
 
   public:
     void Run() noexcept;
+    // one iteration of the main loop, for tools that drive the engine with their own time step
+    void RunFrame(TFloat32 delta_time);
     void SetVulkanValidationLogSeverity(VulkanValidationLogSeverity severity, bool enabled) noexcept;
 
     void PushLayer(Handle<Layer> layer) noexcept;
@@ -28,17 +33,25 @@ namespace mau {
     void PopLayer(const String &name) noexcept;
     void PopOverlay(const String &name) noexcept;
 
+    // stages of the last frame run, see FrameTiming for which frame each of them belongs to
+    inline const FrameTiming &GetFrameTiming() const { return m_FrameTiming; }
+    inline TUint64            GetFrameCount() const { return m_FrameCount; }
+
   private:
     void ImGuiSceneList();
     void OnEvent(Event &event);
     void OnUpdate(TFloat32 dt);
 
   private:
-    Window       m_Window;
+    // the window is created from the validated config, keep it declared first
     EngineConfig m_Config;
+    Window       m_Window;
 
     Handle<Scene> m_Scene;
 
+    FrameTiming m_FrameTiming = {};
+    TUint64     m_FrameCount = 0u;
+
     // layers & overlays
     LayerStack m_LayerStack;
     LayerStack m_OverlayStack;
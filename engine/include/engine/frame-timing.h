@@ -0,0 +1,31 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // stages of one run of the main loop in milliseconds. update and imgui were measured on the main thread for Frame,
+  // the render stages belong to RenderFrame, one frame behind Frame when frames are pipelined. the gpu time
+  // belongs to GpuFrame whose timestamps were read back this frame. UINT64_MAX marks a frame that has no value yet
+  struct FrameTiming {
+    TUint64  Frame = 0u;
+    TFloat64 FrameMs = 0.0;
+    TFloat64 UpdateMs = 0.0;
+    TFloat64 ImGuiMs = 0.0;
+
+    TUint64  RenderFrame = UINT64_MAX;
+    TFloat64 CaptureMs = 0.0;
+    TFloat64 FenceWaitMs = 0.0;
+    TFloat64 RecordMs = 0.0;
+    TFloat64 SubmitMs = 0.0;
+    TFloat64 RenderMs = 0.0;
+    TUint32  DrawCount = 0u;
+    // of the scene at full detail and at the selected levels of detail
+    TUint64  TriangleCount = 0u;
+    TUint64  LodTriangleCount = 0u;
+
+    TUint64  GpuFrame = UINT64_MAX;
+    TFloat64 GpuMs = 0.0;
+  };
+
+} // namespace mau
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // selects the mip filter and block format used when cooking a texture
+  enum class TextureKind : TUint32 {
+    COLOR = 0,
+    NORMAL = 1,
+  };
+
+  // path of the cooked mesh that Mesh looks for next to the source file
+  String GetCookedMeshPath(const String &source_path);
+
+  // imports a mesh through assimp and writes the flattened per-material blocks, empty cooked_path writes next to the source
+  bool CookMesh(const String &source_path, const String &cooked_path = "");
+
+  // path of the cooked texture that the texture streamer looks for next to the source image
+  String GetCookedTexturePath(const String &source_path);
+
+  // writes the full block compressed mip chain of an image, empty cooked_path writes next to the source
+  bool CookTexture(const String &source_path, TextureKind kind = TextureKind::COLOR, const String &cooked_path = "");
+
+} // namespace mau
@@ -5,3 +5,5 @@
 #define MAU_FRAME_MARK() FrameMark
 #define MAU_PROFILE_SCOPE(name) ZoneScopedN(name)
 #define MAU_PROFILE_SCOPR_COLOR(name, color) ZoneScopedNC(name, color)
+#define MAU_PROFILE_THREAD(name) tracy::SetThreadName(name)
+#define MAU_PROFILE_PLOT(name, value) TracyPlot(name, value)
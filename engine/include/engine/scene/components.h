@@ -1,10 +1,13 @@
 #pragma once
 
+#include <entt/entt.hpp>
 #include <engine/types.h>
 #include <glm/glm.hpp>
 
 namespace mau {
 
+  // local to the parent, or to the world without one. set Updated after changing it, the world transform of the
+  // entity and everything below it is recomputed by Scene::UpdateTransforms
   struct TransformComponent {
     glm::vec3 Position = glm::vec3(0.0f);
     glm::vec3 Rotation = glm::vec3(0.0f);
@@ -13,6 +16,20 @@ namespace mau {
     bool Updated = true;
   };
 
+  // links of the transform tree, changed through Scene::SetParent. children form a list through NextSibling
+  struct HierarchyComponent {
+    entt::entity Parent = entt::null;
+    entt::entity FirstChild = entt::null;
+    entt::entity NextSibling = entt::null;
+    TUint32      Depth = 0u;
+  };
+
+  // cached by Scene::UpdateTransforms, Updated is set for the frame the matrix changed in
+  struct WorldTransformComponent {
+    glm::mat4 Matrix = glm::mat4(1.0f);
+    bool      Updated = false;
+  };
+
   struct NameComponent {
     String Name = "";
   };
@@ -12,6 +12,18 @@ namespace mau {
 
   using EntityIterator = std::function<void(Entity entity)>;
 
+  class TransformSystem;
+
+  // what the last UpdateTransforms did, times in milliseconds
+  struct TransformUpdateStats {
+    // entities whose transform or parent changed and the world matrices recomputed for them and their subtrees
+    TUint32  DirtyCount = 0u;
+    TUint32  UpdatedCount = 0u;
+    TUint32  LevelCount = 0u;
+    TFloat64 GatherMs = 0.0;
+    TFloat64 ComputeMs = 0.0;
+  };
+
   class Scene: public HandledObject {
   public:
     Scene();
@@ -23,8 +35,18 @@ namespace mau {
 
     void Each(EntityIterator func);
 
+    // false when parent is child or below it. the child keeps its local transform, now relative to parent
+    bool SetParent(Entity child, Entity parent);
+    void RemoveParent(Entity child);
+
+    // recomputes the world transform of every entity whose transform or parent changed and of everything below
+    // it, level by level with the levels split across the job system
+    TransformUpdateStats UpdateTransforms();
+
   private:
-    entt::registry m_Registry;
+    entt::registry          m_Registry;
+    // only defined in the engine, created by the constructor
+    Handle<TransformSystem> m_TransformSystem;
   };
 
 } // namespace mau
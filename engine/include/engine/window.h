@@ -13,12 +13,16 @@ namespace mau {
     friend class Engine;
 
   private:
-    Window(TUint32 width, TUint32 height, std::string_view name);
+    // a headless window never touches glfw, it only keeps the size the offscreen images are created with
+    Window(TUint32 width, TUint32 height, std::string_view name, bool headless = false);
     ~Window();
 
   public:
     inline void             *GetRawWindow() const { return m_InternalState; }
     inline EventEmitFunction GetEventCallback() const { return m_EventCallback; }
+    inline bool              IsHeadless() const { return m_Headless; }
+    inline TUint32           GetWidth() const { return m_Width; }
+    inline TUint32           GetHeight() const { return m_Height; }
 
   private:
     bool ShouldClose() const noexcept;
@@ -35,6 +39,7 @@ namespace mau {
 
     TUint32 m_Width = 0u;
     TUint32 m_Height = 0u;
+    bool    m_Headless = false;
   };
 
 } // namespace mau
@@ -7,11 +7,13 @@
 #include <engine/events/key-events.h>
 #include <engine/events/mouse-events.h>
 
+#include "../graphics/vulkan-pipeline-cache.h"
+
 namespace mau {
 
   ImGuiContext::ImGuiContext(void *window, Handle<Renderpass> renderpass) {
-    Handle<VulkanSwapchain> swapchain = VulkanState::Ref().GetSwapchainHandle();
-    Handle<VulkanDevice>    device = VulkanState::Ref().GetDeviceHandle();
+    const Handle<VulkanSwapchain> &swapchain = VulkanState::Ref().GetSwapchainHandle();
+    const Handle<VulkanDevice>    &device = VulkanState::Ref().GetDeviceHandle();
 
     // init imgui
     VkDescriptorPoolSize imgui_pool_sizes[] = {
@@ -33,7 +35,7 @@ namespace mau {
     init_info.Device = device->GetDevice();
     init_info.QueueFamily = device->GetGraphicsQueueIndex();
     init_info.Queue = device->GetGraphicsQueue()->Get();
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = GetPipelineCache();
     init_info.DescriptorPool = m_DescriptorPool;
     init_info.Subpass = 0;
     init_info.MinImageCount = swapchain->GetSurfaceCapabilities().minImageCount;
@@ -46,8 +48,15 @@ namespace mau {
     ImGuiIO &io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 
-    GLFWwindow *glfw_window = reinterpret_cast<GLFWwindow *>(window);
-    ImGui_ImplGlfw_InitForVulkan(glfw_window, true);
+    m_Headless = window == nullptr;
+    if (m_Headless) {
+      const VkExtent2D extent = swapchain->GetExtent();
+      m_DisplaySize = ImVec2(static_cast<float>(extent.width), static_cast<float>(extent.height));
+      io.IniFilename = nullptr;
+    } else {
+      GLFWwindow *glfw_window = reinterpret_cast<GLFWwindow *>(window);
+      ImGui_ImplGlfw_InitForVulkan(glfw_window, true);
+    }
     ImGui_ImplVulkan_Init(&init_info, renderpass->Get());
 
     Handle<CommandPool>   pool = VulkanState::Ref().GetCommandPool(VK_QUEUE_GRAPHICS_BIT);
@@ -57,10 +66,8 @@ namespace mau {
     ImGui_ImplVulkan_CreateFontsTexture(command_buffer->Get());
 
     command_buffer->End();
-    Handle<VulkanQueue> graphics_queue = device->GetGraphicsQueue();
-    graphics_queue->Submit(command_buffer);
-
-    vkDeviceWaitIdle(device->GetDevice());
+    device->GetGraphicsQueue()->Submit(command_buffer);
+    device->WaitIdle();
 
     ImGui_ImplVulkan_DestroyFontUploadObjects();
   }
@@ -68,17 +75,31 @@ namespace mau {
   ImGuiContext::~ImGuiContext() {
     vkDestroyDescriptorPool(VulkanState::Ref().GetDevice(), m_DescriptorPool, nullptr);
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (!m_Headless) {
+      ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
   }
 
   void ImGuiContext::StartFrame() {
     ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
+    if (m_Headless) {
+      // a fixed step keeps headless runs reproducible
+      ImGuiIO &io = ImGui::GetIO();
+      io.DisplaySize = m_DisplaySize;
+      io.DeltaTime = 1.0f / 60.0f;
+    } else {
+      ImGui_ImplGlfw_NewFrame();
+    }
     ImGui::NewFrame();
     ImGuiDockspace();
   }
 
+  void ImGuiContext::EndFrame(ImGuiDrawSnapshot &snapshot) {
+    ImGui::Render();
+    snapshot.Capture(ImGui::GetDrawData());
+  }
+
   void ImGuiContext::OnEvent(Event &event) {
     auto handle_event = [](Event &e) -> void { e.Handle(); };
 
@@ -115,4 +136,37 @@ namespace mau {
     ImGui::End();
   }
 
+  // draw snapshot
+  ImGuiDrawSnapshot::~ImGuiDrawSnapshot() { Clear(); }
+
+  void ImGuiDrawSnapshot::Capture(const ImDrawData *draw_data) {
+    Clear();
+
+    if (!draw_data || !draw_data->Valid)
+      return;
+
+    // the draw lists belong to the imgui context and are rebuilt by the next frame
+    m_DrawData = *draw_data;
+    for (ImDrawList *&list : m_DrawData.CmdLists) {
+      list = list->CloneOutput();
+    }
+  }
+
+  void ImGuiDrawSnapshot::Clear() {
+    for (ImDrawList *list : m_DrawData.CmdLists) {
+      IM_DELETE(list);
+    }
+    m_DrawData.Clear();
+  }
+
+  void ImGuiDrawSnapshot::ReplaceTexture(ImTextureID from, ImTextureID to) {
+    for (ImDrawList *list : m_DrawData.CmdLists) {
+      for (ImDrawCmd &cmd : list->CmdBuffer) {
+        if (cmd.TextureId == from) {
+          cmd.TextureId = to;
+        }
+      }
+    }
+  }
+
 } // namespace mau
@@ -10,15 +10,41 @@
 
 namespace mau {
 
+  // the viewport image is only known once the render thread acquired a swapchain image, ui code draws
+  // this placeholder and the snapshot swaps it for the real texture before rendering
+  static const ImTextureID IMGUI_VIEWPORT_TEXTURE_ID = reinterpret_cast<ImTextureID>(~static_cast<uintptr_t>(0u));
+
+  // deep copy of the draw lists of one frame, stays valid after the next ImGui::NewFrame
+  class ImGuiDrawSnapshot {
+  public:
+    ImGuiDrawSnapshot() = default;
+    ~ImGuiDrawSnapshot();
+    ImGuiDrawSnapshot(const ImGuiDrawSnapshot &) = delete;
+    ImGuiDrawSnapshot &operator=(const ImGuiDrawSnapshot &) = delete;
+
+  public:
+    void Capture(const ImDrawData *draw_data);
+    void Clear();
+    void ReplaceTexture(ImTextureID from, ImTextureID to);
+
+    inline ImDrawData *Get() { return m_DrawData.Valid ? &m_DrawData : nullptr; }
+
+  private:
+    ImDrawData m_DrawData = {};
+  };
+
   class ImGuiContext: public Singleton<ImGuiContext> {
     friend class Singleton<ImGuiContext>;
 
   private:
+    // without a window there is no platform backend, the display is the size of the offscreen images
     ImGuiContext(void *window, Handle<Renderpass> renderpass);
     ~ImGuiContext();
 
   public:
     void StartFrame();
+    // finishes the ui of this frame and copies the draw data into snapshot
+    void EndFrame(ImGuiDrawSnapshot &snapshot);
     void OnEvent(Event &event);
 
     inline void BlockEvents(bool block) { m_BlockEvents = block; }
@@ -29,6 +55,8 @@ namespace mau {
   private:
     VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
     bool             m_BlockEvents = false;
+    bool             m_Headless = false;
+    ImVec2           m_DisplaySize = {};
   };
 
 } // namespace mau
@@ -0,0 +1,325 @@
+#include <engine/core/job-system.h>
+
+#include <algorithm>
+#include <engine/assert.h>
+#include <engine/log.h>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  // idle workers spin this many times on the queued count before they go to sleep
+  static const TUint32 WORKER_SPIN_COUNT = 64u;
+
+  // ranges per thread handed out by ParallelFor, more than one lets stealing even out uneven ranges
+  static const TUint32 RANGES_PER_THREAD = 4u;
+
+  static thread_local TUint32 t_ThreadIndex = UINT32_MAX;
+
+  JobSystem::JobSystem(TUint32 worker_count) {
+    // the creating thread counts as one, a single core gets no workers and runs every job where it is waited for
+    if (worker_count == UINT32_MAX) {
+      worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1u;
+    }
+
+    for (TUint32 i = 0; i <= worker_count; i++) {
+      m_Queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    t_ThreadIndex = 0u;
+
+    for (TUint32 i = 1; i <= worker_count; i++) {
+      m_Workers.emplace_back([this, i](std::stop_token stop_token) -> void { WorkerLoop(stop_token, i); });
+    }
+
+    if (worker_count == 0u) {
+      LOG_INFO("job system started without workers, jobs run on the threads that wait for them");
+    } else {
+      LOG_INFO("job system started [workers: %u]", worker_count);
+    }
+  }
+
+  JobSystem::~JobSystem() {
+    for (std::jthread &worker : m_Workers) {
+      worker.request_stop();
+    }
+    m_Workers.clear();
+
+    if (m_Queued.load() > 0u || m_BackgroundQueued.load() > 0u) {
+      LOG_WARN("job system destroyed with %u queued jobs [background: %u]", m_Queued.load(), m_BackgroundQueued.load());
+    }
+
+    m_Queues.clear();
+    t_ThreadIndex = UINT32_MAX;
+  }
+
+  void JobSystem::Schedule(JobFunction function, JobCounter *counter) {
+    if (counter) {
+      counter->m_Value.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    TUint32 thread_index = t_ThreadIndex;
+    if (thread_index >= m_Queues.size()) {
+      thread_index = 0u;
+    }
+
+    // counted before it is visible so that a worker never sees a job the count doesn't cover
+    m_Queued.fetch_add(1u);
+
+    {
+      WorkQueue                  &queue = *m_Queues[thread_index];
+      std::lock_guard<std::mutex> lock(queue.Mutex);
+      queue.Jobs.push_back({std::move(function), counter});
+    }
+
+    if (m_Sleeping.load() > 0u) {
+      { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+      m_SleepCondition.notify_one();
+    }
+  }
+
+  void JobSystem::ScheduleBackground(JobFunction function, JobCounter *counter) {
+    if (counter) {
+      counter->m_Value.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    Job job = {std::move(function), counter};
+    if (m_Workers.empty()) {
+      Execute(job);
+      return;
+    }
+
+    m_BackgroundQueued.fetch_add(1u);
+    {
+      std::lock_guard<std::mutex> lock(m_Background.Mutex);
+      m_Background.Jobs.push_back(std::move(job));
+    }
+
+    if (m_Sleeping.load() > 0u) {
+      { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+      m_SleepCondition.notify_all();
+    }
+  }
+
+  void JobSystem::Wait(const JobCounter &counter) {
+    MAU_PROFILE_SCOPE("JobSystem::Wait");
+
+    while (!counter.IsDone()) {
+      if (RunPendingJob())
+        continue;
+
+      // the remaining jobs run on other threads, sleep once a short spin saw neither them finish nor new work
+      bool ready = false;
+      for (TUint32 i = 0u; i < WORKER_SPIN_COUNT && !ready; i++) {
+        std::this_thread::yield();
+        ready = counter.IsDone() || m_Queued.load() > 0u;
+      }
+
+      if (ready)
+        continue;
+
+      // counts as sleeping before the counter is checked, Release does the opposite
+      std::unique_lock<std::mutex> lock(m_SleepMutex);
+      m_Sleeping.fetch_add(1u);
+      m_SleepCondition.wait(lock, [this, &counter]() -> bool { return counter.m_Value.load() == 0u || m_Queued.load() > 0u; });
+      m_Sleeping.fetch_sub(1u);
+    }
+  }
+
+  void JobSystem::ParallelFor(TUint32 count, TUint32 grain_size, const RangeFunction &function) {
+    MAU_PROFILE_SCOPE("JobSystem::ParallelFor");
+
+    if (count == 0u)
+      return;
+
+    const TUint32 range_count = GetThreadCount() * RANGES_PER_THREAD;
+    const TUint32 range_size = std::max(std::max(grain_size, 1u), (count + range_count - 1u) / range_count);
+
+    if (range_size >= count) {
+      function(0u, count);
+      return;
+    }
+
+    JobCounter counter;
+    for (TUint32 begin = 0u; begin < count; begin += range_size) {
+      const TUint32 end = std::min(count, begin + range_size);
+      Schedule([&function, begin, end]() -> void { function(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+  }
+
+  bool JobSystem::RunPendingJob() {
+    const TUint32 thread_index = t_ThreadIndex;
+
+    Job job = {};
+    if ((thread_index < m_Queues.size() && TryPop(thread_index, job)) || TrySteal(thread_index, job)) {
+      Execute(job);
+      return true;
+    }
+
+    return false;
+  }
+
+  TUint32 JobSystem::GetThreadIndex() { return t_ThreadIndex; }
+
+  bool JobSystem::TryPop(TUint32 thread_index, Job &job) {
+    WorkQueue                  &queue = *m_Queues[thread_index];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+
+    if (queue.Jobs.empty())
+      return false;
+
+    // newest first, its data is most likely still in cache
+    job = std::move(queue.Jobs.back());
+    queue.Jobs.pop_back();
+    m_Queued.fetch_sub(1u);
+    return true;
+  }
+
+  bool JobSystem::TrySteal(TUint32 thread_index, Job &job) {
+    const TUint32 queue_count = static_cast<TUint32>(m_Queues.size());
+
+    // threads outside the job system have no queue and may take from all of them
+    for (TUint32 i = 0u; i < queue_count; i++) {
+      const TUint32 victim = (thread_index + 1u + i) % queue_count;
+      if (victim == thread_index)
+        continue;
+
+      WorkQueue                  &queue = *m_Queues[victim];
+      std::lock_guard<std::mutex> lock(queue.Mutex);
+
+      if (queue.Jobs.empty())
+        continue;
+
+      // oldest first, usually the biggest piece of work left
+      job = std::move(queue.Jobs.front());
+      queue.Jobs.pop_front();
+      m_Queued.fetch_sub(1u);
+      m_Stolen.fetch_add(1u, std::memory_order_relaxed);
+      return true;
+    }
+
+    return false;
+  }
+
+  bool JobSystem::TryPopBackground(Job &job) {
+    std::lock_guard<std::mutex> lock(m_Background.Mutex);
+
+    if (m_Background.Jobs.empty())
+      return false;
+
+    job = std::move(m_Background.Jobs.front());
+    m_Background.Jobs.pop_front();
+    m_BackgroundQueued.fetch_sub(1u);
+    return true;
+  }
+
+  void JobSystem::Execute(Job &job) {
+    MAU_PROFILE_SCOPE("JobSystem::Execute");
+
+    job.Function();
+
+    if (job.Counter) {
+      Release(*job.Counter);
+    }
+    m_Executed.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  void JobSystem::Release(JobCounter &counter) {
+    // waiters sleep on the workers' condition, the counter may be gone as soon as it reached zero
+    if (counter.m_Value.fetch_sub(1u) == 1u && m_Sleeping.load() > 0u) {
+      { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+      m_SleepCondition.notify_all();
+    }
+  }
+
+  void JobSystem::WorkerLoop(std::stop_token stop_token, TUint32 thread_index) {
+    t_ThreadIndex = thread_index;
+
+    const String thread_name = "job worker " + std::to_string(thread_index);
+    MAU_PROFILE_THREAD(thread_name.c_str());
+
+    while (!stop_token.stop_requested()) {
+      Job job = {};
+      if (TryPop(thread_index, job) || TrySteal(thread_index, job) || TryPopBackground(job)) {
+        Execute(job);
+        continue;
+      }
+
+      bool queued = false;
+      for (TUint32 i = 0u; i < WORKER_SPIN_COUNT && !queued; i++) {
+        std::this_thread::yield();
+        queued = m_Queued.load() > 0u || m_BackgroundQueued.load() > 0u;
+      }
+
+      if (queued)
+        continue;
+
+      // the sleeping count is raised before the queued count is checked, schedule does the opposite
+      std::unique_lock<std::mutex> lock(m_SleepMutex);
+      m_Sleeping.fetch_add(1u);
+      m_SleepCondition.wait(lock, stop_token, [this]() -> bool { return m_Queued.load() > 0u || m_BackgroundQueued.load() > 0u; });
+      m_Sleeping.fetch_sub(1u);
+    }
+  }
+
+  // job graph
+  TUint32 JobGraph::Add(JobFunction function) {
+    std::unique_ptr<Node> node = std::make_unique<Node>();
+    node->Function = std::move(function);
+    m_Nodes.push_back(std::move(node));
+    return static_cast<TUint32>(m_Nodes.size() - 1u);
+  }
+
+  void JobGraph::Depend(TUint32 job, TUint32 dependency) {
+    ASSERT(job < m_Nodes.size() && dependency < m_Nodes.size() && job != dependency);
+    m_Nodes[dependency]->Dependents.push_back(job);
+    m_Nodes[job]->DependencyCount++;
+  }
+
+  void JobGraph::Run(JobCounter &counter) {
+    MAU_PROFILE_SCOPE("JobGraph::Run");
+
+    if (m_Nodes.empty())
+      return;
+
+    // the whole graph is counted up front so the counter can't reach zero between two jobs
+    counter.m_Value.fetch_add(static_cast<TUint32>(m_Nodes.size()), std::memory_order_relaxed);
+
+    Vector<TUint32> roots = {};
+    for (TUint32 i = 0u; i < m_Nodes.size(); i++) {
+      m_Nodes[i]->Remaining.store(m_Nodes[i]->DependencyCount, std::memory_order_relaxed);
+      if (m_Nodes[i]->DependencyCount == 0u) {
+        roots.push_back(i);
+      }
+    }
+
+    ASSERT(!roots.empty());
+    for (TUint32 root : roots) {
+      Schedule(root, counter);
+    }
+  }
+
+  void JobGraph::RunAndWait() {
+    JobCounter counter;
+    Run(counter);
+    JobSystem::Ref().Wait(counter);
+  }
+
+  void JobGraph::Schedule(TUint32 job, JobCounter &counter) {
+    JobSystem::Ref().Schedule([this, job, &counter]() -> void {
+      Node &node = *m_Nodes[job];
+      node.Function();
+
+      for (TUint32 dependent : node.Dependents) {
+        if (m_Nodes[dependent]->Remaining.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+          Schedule(dependent, counter);
+        }
+      }
+
+      // dependents are queued before this job stops counting
+      JobSystem::Ref().Release(counter);
+    });
+  }
+
+} // namespace mau
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <engine/types.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAU_SIMD_SSE 1
+#include <immintrin.h>
+#endif
+
+#if defined(MAU_SIMD_SSE) && defined(__AVX__)
+#define MAU_SIMD_AVX 1
+#endif
+
+namespace mau {
+
+  // 4 and 8 wide float lanes. sse where available, 8 wide is a pair of 4 wide halves unless the engine is built
+  // with avx. without sse every lane is a plain loop the compiler is free to vectorize.
+  // comparisons return a mask of the same width, GetBits packs it into the lowest bits of an integer, lane 0 first
+
+#ifdef MAU_SIMD_SSE
+
+  struct SimdFloat4 {
+    __m128 Value;
+
+    static inline SimdFloat4 Load(const TFloat32 *data) { return {_mm_loadu_ps(data)}; }
+    static inline SimdFloat4 Broadcast(TFloat32 value) { return {_mm_set1_ps(value)}; }
+    inline void              Store(TFloat32 *data) const { _mm_storeu_ps(data, Value); }
+  };
+
+  struct SimdMask4 {
+    __m128 Value;
+
+    inline TUint32 GetBits() const { return static_cast<TUint32>(_mm_movemask_ps(Value)); }
+  };
+
+  inline SimdFloat4 operator+(SimdFloat4 a, SimdFloat4 b) { return {_mm_add_ps(a.Value, b.Value)}; }
+  inline SimdFloat4 operator-(SimdFloat4 a, SimdFloat4 b) { return {_mm_sub_ps(a.Value, b.Value)}; }
+  inline SimdFloat4 operator*(SimdFloat4 a, SimdFloat4 b) { return {_mm_mul_ps(a.Value, b.Value)}; }
+  inline SimdFloat4 operator/(SimdFloat4 a, SimdFloat4 b) { return {_mm_div_ps(a.Value, b.Value)}; }
+  inline SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b) { return {_mm_min_ps(a.Value, b.Value)}; }
+  inline SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b) { return {_mm_max_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator<(SimdFloat4 a, SimdFloat4 b) { return {_mm_cmplt_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator<=(SimdFloat4 a, SimdFloat4 b) { return {_mm_cmple_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator>(SimdFloat4 a, SimdFloat4 b) { return {_mm_cmpgt_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator>=(SimdFloat4 a, SimdFloat4 b) { return {_mm_cmpge_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator&(SimdMask4 a, SimdMask4 b) { return {_mm_and_ps(a.Value, b.Value)}; }
+  inline SimdMask4  operator|(SimdMask4 a, SimdMask4 b) { return {_mm_or_ps(a.Value, b.Value)}; }
+  inline SimdMask4  AndNot(SimdMask4 a, SimdMask4 b) { return {_mm_andnot_ps(b.Value, a.Value)}; }
+  inline SimdFloat4 Select(SimdMask4 mask, SimdFloat4 a, SimdFloat4 b) { return {_mm_or_ps(_mm_and_ps(mask.Value, a.Value), _mm_andnot_ps(mask.Value, b.Value))}; }
+
+#else
+
+  struct SimdFloat4 {
+    TFloat32 Value[4];
+
+    static inline SimdFloat4 Load(const TFloat32 *data) { return {{data[0], data[1], data[2], data[3]}}; }
+    static inline SimdFloat4 Broadcast(TFloat32 value) { return {{value, value, value, value}}; }
+    inline void              Store(TFloat32 *data) const { std::copy(Value, Value + 4, data); }
+  };
+
+  struct SimdMask4 {
+    bool Value[4];
+
+    inline TUint32 GetBits() const { return (Value[0] ? 1u : 0u) | (Value[1] ? 2u : 0u) | (Value[2] ? 4u : 0u) | (Value[3] ? 8u : 0u); }
+  };
+
+#define MAU_SIMD_LANES_4(result, expression)                                                                                                                                                           \
+  for (TUint32 i = 0; i < 4u; i++) {                                                                                                                                                                   \
+    result.Value[i] = expression;                                                                                                                                                                      \
+  }
+
+  inline SimdFloat4 operator+(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] + b.Value[i]) return r; }
+  inline SimdFloat4 operator-(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] - b.Value[i]) return r; }
+  inline SimdFloat4 operator*(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] * b.Value[i]) return r; }
+  inline SimdFloat4 operator/(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] / b.Value[i]) return r; }
+  inline SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] < b.Value[i] ? a.Value[i] : b.Value[i]) return r; }
+  inline SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, a.Value[i] > b.Value[i] ? a.Value[i] : b.Value[i]) return r; }
+  inline SimdMask4  operator<(SimdFloat4 a, SimdFloat4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] < b.Value[i]) return r; }
+  inline SimdMask4  operator<=(SimdFloat4 a, SimdFloat4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] <= b.Value[i]) return r; }
+  inline SimdMask4  operator>(SimdFloat4 a, SimdFloat4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] > b.Value[i]) return r; }
+  inline SimdMask4  operator>=(SimdFloat4 a, SimdFloat4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] >= b.Value[i]) return r; }
+  inline SimdMask4  operator&(SimdMask4 a, SimdMask4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] && b.Value[i]) return r; }
+  inline SimdMask4  operator|(SimdMask4 a, SimdMask4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] || b.Value[i]) return r; }
+  inline SimdMask4  AndNot(SimdMask4 a, SimdMask4 b) { SimdMask4 r; MAU_SIMD_LANES_4(r, a.Value[i] && !b.Value[i]) return r; }
+  inline SimdFloat4 Select(SimdMask4 mask, SimdFloat4 a, SimdFloat4 b) { SimdFloat4 r; MAU_SIMD_LANES_4(r, mask.Value[i] ? a.Value[i] : b.Value[i]) return r; }
+
+#undef MAU_SIMD_LANES_4
+
+#endif
+
+#ifdef MAU_SIMD_AVX
+
+  struct SimdFloat8 {
+    __m256 Value;
+
+    static inline SimdFloat8 Load(const TFloat32 *data) { return {_mm256_loadu_ps(data)}; }
+    static inline SimdFloat8 Broadcast(TFloat32 value) { return {_mm256_set1_ps(value)}; }
+    inline void              Store(TFloat32 *data) const { _mm256_storeu_ps(data, Value); }
+  };
+
+  struct SimdMask8 {
+    __m256 Value;
+
+    inline TUint32 GetBits() const { return static_cast<TUint32>(_mm256_movemask_ps(Value)); }
+  };
+
+  inline SimdFloat8 operator+(SimdFloat8 a, SimdFloat8 b) { return {_mm256_add_ps(a.Value, b.Value)}; }
+  inline SimdFloat8 operator-(SimdFloat8 a, SimdFloat8 b) { return {_mm256_sub_ps(a.Value, b.Value)}; }
+  inline SimdFloat8 operator*(SimdFloat8 a, SimdFloat8 b) { return {_mm256_mul_ps(a.Value, b.Value)}; }
+  inline SimdFloat8 operator/(SimdFloat8 a, SimdFloat8 b) { return {_mm256_div_ps(a.Value, b.Value)}; }
+  inline SimdFloat8 Min(SimdFloat8 a, SimdFloat8 b) { return {_mm256_min_ps(a.Value, b.Value)}; }
+  inline SimdFloat8 Max(SimdFloat8 a, SimdFloat8 b) { return {_mm256_max_ps(a.Value, b.Value)}; }
+  inline SimdMask8  operator<(SimdFloat8 a, SimdFloat8 b) { return {_mm256_cmp_ps(a.Value, b.Value, _CMP_LT_OQ)}; }
+  inline SimdMask8  operator<=(SimdFloat8 a, SimdFloat8 b) { return {_mm256_cmp_ps(a.Value, b.Value, _CMP_LE_OQ)}; }
+  inline SimdMask8  operator>(SimdFloat8 a, SimdFloat8 b) { return {_mm256_cmp_ps(a.Value, b.Value, _CMP_GT_OQ)}; }
+  inline SimdMask8  operator>=(SimdFloat8 a, SimdFloat8 b) { return {_mm256_cmp_ps(a.Value, b.Value, _CMP_GE_OQ)}; }
+  inline SimdMask8  operator&(SimdMask8 a, SimdMask8 b) { return {_mm256_and_ps(a.Value, b.Value)}; }
+  inline SimdMask8  operator|(SimdMask8 a, SimdMask8 b) { return {_mm256_or_ps(a.Value, b.Value)}; }
+  inline SimdMask8  AndNot(SimdMask8 a, SimdMask8 b) { return {_mm256_andnot_ps(b.Value, a.Value)}; }
+  inline SimdFloat8 Select(SimdMask8 mask, SimdFloat8 a, SimdFloat8 b) { return {_mm256_blendv_ps(b.Value, a.Value, mask.Value)}; }
+
+#else
+
+  struct SimdFloat8 {
+    SimdFloat4 Low;
+    SimdFloat4 High;
+
+    static inline SimdFloat8 Load(const TFloat32 *data) { return {SimdFloat4::Load(data), SimdFloat4::Load(data + 4)}; }
+    static inline SimdFloat8 Broadcast(TFloat32 value) { return {SimdFloat4::Broadcast(value), SimdFloat4::Broadcast(value)}; }
+    inline void              Store(TFloat32 *data) const {
+      Low.Store(data);
+      High.Store(data + 4);
+    }
+  };
+
+  struct SimdMask8 {
+    SimdMask4 Low;
+    SimdMask4 High;
+
+    inline TUint32 GetBits() const { return Low.GetBits() | (High.GetBits() << 4u); }
+  };
+
+  inline SimdFloat8 operator+(SimdFloat8 a, SimdFloat8 b) { return {a.Low + b.Low, a.High + b.High}; }
+  inline SimdFloat8 operator-(SimdFloat8 a, SimdFloat8 b) { return {a.Low - b.Low, a.High - b.High}; }
+  inline SimdFloat8 operator*(SimdFloat8 a, SimdFloat8 b) { return {a.Low * b.Low, a.High * b.High}; }
+  inline SimdFloat8 operator/(SimdFloat8 a, SimdFloat8 b) { return {a.Low / b.Low, a.High / b.High}; }
+  inline SimdFloat8 Min(SimdFloat8 a, SimdFloat8 b) { return {Min(a.Low, b.Low), Min(a.High, b.High)}; }
+  inline SimdFloat8 Max(SimdFloat8 a, SimdFloat8 b) { return {Max(a.Low, b.Low), Max(a.High, b.High)}; }
+  inline SimdMask8  operator<(SimdFloat8 a, SimdFloat8 b) { return {a.Low < b.Low, a.High < b.High}; }
+  inline SimdMask8  operator<=(SimdFloat8 a, SimdFloat8 b) { return {a.Low <= b.Low, a.High <= b.High}; }
+  inline SimdMask8  operator>(SimdFloat8 a, SimdFloat8 b) { return {a.Low > b.Low, a.High > b.High}; }
+  inline SimdMask8  operator>=(SimdFloat8 a, SimdFloat8 b) { return {a.Low >= b.Low, a.High >= b.High}; }
+  inline SimdMask8  operator&(SimdMask8 a, SimdMask8 b) { return {a.Low & b.Low, a.High & b.High}; }
+  inline SimdMask8  operator|(SimdMask8 a, SimdMask8 b) { return {a.Low | b.Low, a.High | b.High}; }
+  inline SimdMask8  AndNot(SimdMask8 a, SimdMask8 b) { return {AndNot(a.Low, b.Low), AndNot(a.High, b.High)}; }
+  inline SimdFloat8 Select(SimdMask8 mask, SimdFloat8 a, SimdFloat8 b) { return {Select(mask.Low, a.Low, b.Low), Select(mask.High, a.High, b.High)}; }
+
+#endif
+
+  template <TUint32 Width> struct SimdLanes;
+
+  template <> struct SimdLanes<4u> {
+    using Float = SimdFloat4;
+    using Mask = SimdMask4;
+  };
+
+  template <> struct SimdLanes<8u> {
+    using Float = SimdFloat8;
+    using Mask = SimdMask8;
+  };
+
+  // SimdFloat<4> and SimdFloat<8>, for code templated on the lane count
+  template <TUint32 Width> using SimdFloat = typename SimdLanes<Width>::Float;
+  template <TUint32 Width> using SimdMask = typename SimdLanes<Width>::Mask;
+
+} // namespace mau
@@ -1,15 +1,22 @@
 #include <engine/engine.h>
 
 #include <chrono>
+#include <exception>
 #include <glm/glm.hpp>
 #include <imgui.h>
 #include <engine/log.h>
 #include <engine/profiler.h>
 #include <engine/input/input.h>
+#include <engine/core/job-system.h>
 
 #include "context/imgui-context.h"
 #include "renderer/renderer.h"
+#include "graphics/vulkan-arena.h"
 #include "graphics/vulkan-bindless.h"
+#include "graphics/vulkan-pipeline-cache.h"
+#include "graphics/shader-cache.h"
+#include "loader/mesh-loader.h"
+#include "loader/texture-streamer.h"
 #include "scene/internal-components.h"
 #include "optix/denoiser.h"
 
@@ -23,10 +30,20 @@ namespace mau {
       output_config.FramesInFlight = 1u;
     }
 
+    if (output_config.Headless && (output_config.Width == 0u || output_config.Height == 0u)) {
+      LOG_ERROR("headless rendering needs a size, using 1280x720");
+      output_config.Width = 1280u;
+      output_config.Height = 720u;
+    }
+
+    if (output_config.Headless && output_config.FrameLimit == 0u) {
+      LOG_WARN("headless without a frame limit, the engine runs until the process is stopped");
+    }
+
     return output_config;
   }
 
-  Engine::Engine(const EngineConfig &config): m_Config(validate_config(config)), m_Window(config.Width, config.Height, config.WindowName) {
+  Engine::Engine(const EngineConfig &config): m_Config(validate_config(config)), m_Window(m_Config.Width, m_Config.Height, m_Config.WindowName, m_Config.Headless) {
 
     m_Window.RegisterEventCallback(BIND_EVENT_FN(Engine::OnEvent));
 
@@ -36,26 +53,33 @@ namespace mau {
     bool enable_validation = false;
 #endif
 
-    VulkanState::Create(enable_validation);
+    JobSystem::Create();
+
+    VulkanState::Create(enable_validation, m_Config.Headless);
     VulkanState::Ref().SetValidationSeverity(config.ValidationSeverity);
-    VulkanState::Ref().Init(config.ApplicationName, m_Window.GetRawWindow());
+    VulkanState::Ref().Init(config.ApplicationName, m_Window.GetRawWindow(), {m_Config.Width, m_Config.Height});
+
+    VulkanPipelineCache::Create(String(m_Config.PipelineCachePath));
+    ShaderCache::Create(String(m_Config.ShaderCachePath));
+
+    VulkanBindless::Create(m_Config.BindlessDescriptorCount);
 
-    VulkanBindless::Create();
+    TextureStreamer::Create();
+
+    GeometryArena::Create(static_cast<TUint32>(sizeof(Vertex)));
 
     Denoiser::Create();
 
-    Renderer::Create(m_Window.GetRawWindow());
+    Renderer::Create(m_Window.GetRawWindow(), m_Config.FramesInFlight);
 
-    String model_path = GetAssetFolderPath() + "assets/models/Sponza/glTF/Sponza.gltf";
+    String model_path = m_Config.ScenePath.empty() ? GetAssetFolderPath() + "assets/models/Sponza/glTF/Sponza.gltf" : String(m_Config.ScenePath);
 
     Handle<Mesh> mesh = make_handle<Mesh>(model_path);
 
     m_Scene = make_handle<Scene>();
     Entity bag = m_Scene->CreateEntity("Bag");
 
-    TransformComponent &transform = bag.Get<TransformComponent>();
-    transform.Position = glm::vec3(0.0f, 0.0f, 2.0f);
-    transform.Rotation = glm::vec3(0.0f, 2.853, 0.0f);
+    bag.Get<TransformComponent>() = GetSceneTransform();
 
     bag.Add<MeshComponent>(mesh);
   };
@@ -64,51 +88,100 @@ namespace mau {
     m_Scene = nullptr;
     Renderer::Destroy();
     Denoiser::Destroy();
+    GeometryArena::Destroy();
+    TextureStreamer::Destroy();
     VulkanBindless::Destroy();
+    ShaderCache::Destroy();
+    VulkanPipelineCache::Destroy();
     VulkanState::Destroy();
+    JobSystem::Destroy();
   };
 
-  void Engine::Run() noexcept {
-    uint32_t frame_counter = 0;
-    uint32_t last_second_framerate = 0;
-    auto     last_time = std::chrono::high_resolution_clock::now();
-    float    passed_time = 0.0f;
-    float    delta_time = 0.0f;
+  using Clock = std::chrono::high_resolution_clock;
 
-    while (!m_Window.ShouldClose()) {
-      MAU_FRAME_MARK();
-      MAU_PROFILE_SCOPE("Engine::Loop");
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
 
-      auto current_time = std::chrono::high_resolution_clock::now();
-      auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(current_time - last_time);
-      delta_time = (float)dt.count() * (float)1e-9;
+  void Engine::Run() noexcept {
+    const TUint64           first_frame = m_FrameCount;
+    const Clock::time_point run_start = Clock::now();
+    Clock::time_point       last_time = run_start;
+
+    // what the render thread threw comes back through WaitFrame, the run stops there and the engine shuts down as usual.
+    // a frame the render thread may still be submitting is waited for by the device
+    try {
+      while (!m_Window.ShouldClose() && (m_Config.FrameLimit == 0u || m_FrameCount - first_frame < m_Config.FrameLimit)) {
+        const Clock::time_point current_time = Clock::now();
+        const TFloat32          delta_time = std::chrono::duration<TFloat32>(current_time - last_time).count();
+        last_time = current_time;
+
+        RunFrame(delta_time);
+      }
 
-      OnUpdate(delta_time);
+      Renderer::Ref().WaitFrame();
+    } catch (const std::exception &error) {
+      LOG_ERROR("frame %llu failed, stopping [%s]", static_cast<unsigned long long>(m_FrameCount), error.what());
+    } catch (...) {
+      LOG_ERROR("frame %llu failed, stopping", static_cast<unsigned long long>(m_FrameCount));
+    }
 
-      Renderer::Ref().StartFrame();
+    VulkanState::Ref().GetDeviceHandle()->WaitIdle();
 
-      Renderer::Ref().SubmitScene(m_Scene);
+    const TUint64  frame_count = m_FrameCount - first_frame;
+    const TFloat64 run_seconds = elapsed_ms(run_start) * 1e-3;
+    LOG_INFO("rendered %llu frames in %.2f s [%.1f fps]", static_cast<unsigned long long>(frame_count), run_seconds, run_seconds > 0.0 ? frame_count / run_seconds : 0.0);
+  }
 
-      ImGuiSceneList();
+  void Engine::RunFrame(TFloat32 delta_time) {
+    MAU_FRAME_MARK();
+    MAU_PROFILE_SCOPE("Engine::Loop");
+    const Clock::time_point frame_start = Clock::now();
 
-      Renderer::Ref().EndFrame();
+    FrameTiming timing = {.Frame = m_FrameCount};
 
-      Input::OnUpdate();
-      m_Window.PollEvents();
+    {
+      const Clock::time_point start = Clock::now();
+      OnUpdate(delta_time);
+      timing.UpdateMs = elapsed_ms(start);
+    }
 
-      // framerate
-      last_time = current_time;
-      passed_time += delta_time;
-      frame_counter++;
+    {
+      const Clock::time_point start = Clock::now();
+      Renderer::Ref().StartFrame();
+      Renderer::Ref().SubmitScene(m_Scene);
+      ImGuiSceneList();
+      timing.ImGuiMs = elapsed_ms(start);
+    }
 
-      if (passed_time > 1.0f) {
-        passed_time = 1.0f - passed_time;
-        last_second_framerate = frame_counter;
-        frame_counter = 0;
-      }
+    {
+      // after everything that moves entities, the capture reads the world transforms
+      const Clock::time_point start = Clock::now();
+      m_Scene->UpdateTransforms();
+      timing.UpdateMs += elapsed_ms(start);
     }
 
-    vkDeviceWaitIdle(VulkanState::Ref().GetDevice());
+    Renderer::Ref().EndFrame();
+
+    Input::OnUpdate();
+    m_Window.PollEvents();
+
+    timing.FrameMs = elapsed_ms(frame_start);
+
+    // with frames in flight these belong to the frame before, the gpu time to one a few frames back
+    const FrameStats &stats = Renderer::Ref().GetFrameStats();
+    timing.RenderFrame = stats.Frame;
+    timing.CaptureMs = stats.CaptureMs;
+    timing.FenceWaitMs = stats.FenceWaitMs;
+    timing.RecordMs = stats.RecordMs;
+    timing.SubmitMs = stats.SubmitMs;
+    timing.RenderMs = stats.RenderMs;
+    timing.DrawCount = stats.DrawCount;
+    timing.TriangleCount = stats.TriangleCount;
+    timing.LodTriangleCount = stats.LodTriangleCount;
+    timing.GpuFrame = stats.GpuFrame;
+    timing.GpuMs = stats.GpuMs;
+
+    m_FrameTiming = timing;
+    m_FrameCount++;
   }
 
   void Engine::SetVulkanValidationLogSeverity(VulkanValidationLogSeverity severity, bool enabled) noexcept { VulkanState::Ref().SetValidationSeverity(severity, enabled); }
@@ -141,6 +214,8 @@ namespace mau {
             transform.Updated = true;
           if (ImGui::DragFloat3("Rotation", &transform.Rotation[0], 0.01f))
             transform.Updated = true;
+          if (ImGui::DragFloat3("Scale", &transform.Scale[0], 0.01f))
+            transform.Updated = true;
         }
       });
     }
@@ -158,13 +233,6 @@ namespace mau {
   }
 
   void Engine::OnUpdate(TFloat32 dt) {
-    // set updated to false
-    m_Scene->Each([](Entity entity) -> void {
-      TransformComponent &transform = entity.Get<TransformComponent>();
-      if (transform.Updated)
-        transform.Updated = false;
-    });
-
     // update layers
     m_OverlayStack.OnUpdate(dt);
     m_LayerStack.OnUpdate(dt);
@@ -172,4 +240,11 @@ namespace mau {
 
   std::string GetAssetFolderPath() { return MAU_ASSET_FOLDER; }
 
+  TransformComponent GetSceneTransform() {
+    return {
+        .Position = glm::vec3(0.0f, 0.0f, 2.0f),
+        .Rotation = glm::vec3(0.0f, 2.853f, 0.0f),
+    };
+  }
+
 } // namespace mau
@@ -0,0 +1,212 @@
+#include "shader-cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <engine/engine.h>
+#include <engine/log.h>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  // 64 bit FNV-1a continued from hash
+  static TUint64 hash_bytes(TUint64 hash, const void *data, TUint64 size) {
+    const TUint8 *bytes = reinterpret_cast<const TUint8 *>(data);
+    for (TUint64 i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  static bool read_text(const String &path, String &text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+  }
+
+  // names in the #include directives of code, in the order they appear
+  static Vector<String> find_includes(const String &code) {
+    Vector<String> names = {};
+    size_t         line_start = 0u;
+
+    while (line_start < code.size()) {
+      size_t line_end = code.find('\n', line_start);
+      line_end = line_end == String::npos ? code.size() : line_end;
+
+      const size_t directive = code.find_first_not_of(" \t", line_start);
+      if (directive < line_end && code.compare(directive, 8u, "#include") == 0) {
+        const size_t open = code.find_first_of("\"<", directive + 8u);
+        if (open < line_end) {
+          const char   close_char = code[open] == '"' ? '"' : '>';
+          const size_t close = code.find(close_char, open + 1u);
+          if (close < line_end)
+            names.push_back(code.substr(open + 1u, close - open - 1u));
+        }
+      }
+
+      line_start = line_end + 1u;
+    }
+
+    return names;
+  }
+
+  bool read_shader_source(const String &path, ShaderSource &source) {
+    MAU_PROFILE_SCOPE("read_shader_source");
+
+    source = {.Path = path};
+    if (!read_text(path, source.Code)) {
+      LOG_ERROR("failed to open file: %s", path.c_str());
+      return false;
+    }
+
+    // includes are resolved the way the shaderc includer does, relative to the shader folder. directives in inactive
+    // preprocessor branches are read as well, which only makes the key stricter
+    Vector<String> pending = find_includes(source.Code);
+    while (!pending.empty()) {
+      const String name = pending.back();
+      pending.pop_back();
+      if (source.Includes.contains(name))
+        continue;
+
+      String code = "";
+      if (!read_text(GetAssetFolderPath() + "shaders/" + name, code)) {
+        LOG_ERROR("failed to open include %s of %s", name.c_str(), path.c_str());
+        continue;
+      }
+
+      for (String &nested : find_includes(code)) {
+        pending.push_back(std::move(nested));
+      }
+      source.Includes.emplace(name, std::move(code));
+    }
+
+    return true;
+  }
+
+  String get_shader_dependency_path(const String &path) { return std::filesystem::path(path).lexically_normal().generic_string(); }
+
+  TUint64 get_shader_key(const ShaderSource &source, TUint32 kind, TUint32 options) {
+    const TUint32 version = SHADER_CACHE_VERSION;
+    TUint64       key = 0xcbf29ce484222325ull;
+    key = hash_bytes(key, &version, sizeof(version));
+    key = hash_bytes(key, &kind, sizeof(kind));
+    key = hash_bytes(key, &options, sizeof(options));
+    key = hash_bytes(key, source.Code.data(), source.Code.size());
+
+    // sorted so the key does not depend on the order the includes were found in
+    Vector<const std::pair<const String, String> *> includes = {};
+    for (const auto &include : source.Includes) {
+      includes.push_back(&include);
+    }
+    std::sort(includes.begin(), includes.end(), [](const auto *a, const auto *b) -> bool { return a->first < b->first; });
+
+    for (const auto *include : includes) {
+      const TUint64 name_size = include->first.size();
+      const TUint64 code_size = include->second.size();
+      key = hash_bytes(key, &name_size, sizeof(name_size));
+      key = hash_bytes(key, include->first.data(), name_size);
+      key = hash_bytes(key, &code_size, sizeof(code_size));
+      key = hash_bytes(key, include->second.data(), code_size);
+    }
+
+    return key;
+  }
+
+  ShaderCache::ShaderCache(const String &directory): m_Directory(directory) {
+    if (m_Directory.empty())
+      return;
+
+    std::error_code error = {};
+    std::filesystem::create_directories(m_Directory, error);
+    if (error) {
+      LOG_WARN("failed to create shader cache %s, shaders are compiled every run: %s", m_Directory.c_str(), error.message().c_str());
+      m_Directory.clear();
+    }
+  }
+
+  String ShaderCache::GetPath(TUint64 key) const {
+    char name[32] = {};
+    std::snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(m_Directory) / name).string();
+  }
+
+  bool ShaderCache::Load(TUint64 key, Vector<TUint32> &code) {
+    if (m_Directory.empty())
+      return false;
+
+    MAU_PROFILE_SCOPE("ShaderCache::Load");
+
+    std::ifstream file(GetPath(key), std::ios::binary);
+    if (!file) {
+      m_Misses++;
+      return false;
+    }
+
+    // the code has to fill the rest of the file exactly, a damaged size never decides how much is allocated
+    std::error_code error = {};
+    const TUint64   file_size = std::filesystem::file_size(GetPath(key), error);
+
+    ShaderCacheHeader header = {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    const bool header_valid = file.good() && header.Magic == SHADER_CACHE_MAGIC && header.Version == SHADER_CACHE_VERSION && header.Key == key && header.CodeSize > 0u &&
+                              !error && file_size >= sizeof(header) && header.CodeSize == (file_size - sizeof(header)) / sizeof(TUint32) &&
+                              (file_size - sizeof(header)) % sizeof(TUint32) == 0u;
+
+    if (header_valid) {
+      code.resize(header.CodeSize);
+      file.read(reinterpret_cast<char *>(code.data()), static_cast<std::streamsize>(code.size() * sizeof(TUint32)));
+    }
+
+    if (!header_valid || !file.good() || hash_bytes(0xcbf29ce484222325ull, code.data(), code.size() * sizeof(TUint32)) != header.CodeHash) {
+      LOG_WARN("cached shader %s is damaged, compiling it again", GetPath(key).c_str());
+      code.clear();
+      m_Misses++;
+      return false;
+    }
+
+    m_Hits++;
+    return true;
+  }
+
+  void ShaderCache::Store(TUint64 key, const Vector<TUint32> &code) {
+    if (m_Directory.empty() || code.empty())
+      return;
+
+    MAU_PROFILE_SCOPE("ShaderCache::Store");
+
+    const ShaderCacheHeader header = {
+        .Key = key,
+        .CodeSize = code.size(),
+        .CodeHash = hash_bytes(0xcbf29ce484222325ull, code.data(), code.size() * sizeof(TUint32)),
+    };
+
+    // every thread writes its own temporary file, the rename makes a complete entry appear at once
+    const String path = GetPath(key);
+    const String temp_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char *>(code.data()), static_cast<std::streamsize>(code.size() * sizeof(TUint32)));
+      if (!file.good()) {
+        LOG_WARN("failed to write cached shader %s", temp_path.c_str());
+        return;
+      }
+    }
+
+    std::error_code error = {};
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+      LOG_WARN("failed to store cached shader %s: %s", path.c_str(), error.message().c_str());
+  }
+
+} // namespace mau
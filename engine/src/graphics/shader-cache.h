@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <engine/types.h>
+#include <engine/utils/singleton.h>
+
+namespace mau {
+
+  // cached shader layout: header, then the spir-v words. files are named after the key
+  constexpr TUint32 SHADER_CACHE_MAGIC = 0x5650534du; // "MSPV"
+  constexpr TUint32 SHADER_CACHE_VERSION = 1u;
+
+  struct ShaderCacheHeader {
+    TUint32 Magic = SHADER_CACHE_MAGIC;
+    TUint32 Version = SHADER_CACHE_VERSION;
+    TUint64 Key = 0u;
+    TUint64 CodeSize = 0u;
+    TUint64 CodeHash = 0u;
+  };
+
+  // glsl source of a shader and of every file it includes, directly or through other includes. includes are keyed
+  // by the name in the #include directive and resolved against the shader asset folder
+  struct ShaderSource {
+    String                       Path = "";
+    String                       Code = "";
+    UnorderedMap<String, String> Includes = {};
+  };
+
+  // reads the shader and its includes without a compiler, false when the shader itself can't be read
+  bool read_shader_source(const String &path, ShaderSource &source);
+
+  // path of a shader file as it appears in Shader::GetDependencies, so paths from different sources compare equal
+  String get_shader_dependency_path(const String &path);
+
+  // hash of everything the spir-v depends on: the source, the contents of the include set, the shader kind and the
+  // compile options
+  TUint64 get_shader_key(const ShaderSource &source, TUint32 kind, TUint32 options);
+
+  // compiled spir-v on disk keyed by get_shader_key. lookups and stores are safe from any thread
+  class ShaderCache: public Singleton<ShaderCache> {
+    friend class Singleton<ShaderCache>;
+
+  private:
+    // an empty directory disables the cache, every shader is compiled
+    ShaderCache(const String &directory = "");
+    ~ShaderCache() = default;
+
+  public:
+    bool Load(TUint64 key, Vector<TUint32> &code);
+    void Store(TUint64 key, const Vector<TUint32> &code);
+
+    inline const String &GetDirectory() const { return m_Directory; }
+    inline TUint32       GetHitCount() const { return m_Hits.load(std::memory_order_relaxed); }
+    inline TUint32       GetMissCount() const { return m_Misses.load(std::memory_order_relaxed); }
+
+  private:
+    String GetPath(TUint64 key) const;
+
+  private:
+    String               m_Directory = "";
+    std::atomic<TUint32> m_Hits = 0u;
+    std::atomic<TUint32> m_Misses = 0u;
+  };
+
+} // namespace mau
@@ -0,0 +1,164 @@
+#include "tlas-instance-table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  // glm is column major, the tlas wants the top three rows
+  static VkTransformMatrixKHR to_vk_transform(const glm::mat4 &transform) {
+    return {
+        transform[0][0], transform[1][0], transform[2][0], transform[3][0], transform[0][1], transform[1][1],
+        transform[2][1], transform[3][1], transform[0][2], transform[1][2], transform[2][2], transform[3][2],
+    };
+  }
+
+  void TLASInstanceTable::BeginFrame() {
+    m_Frame++;
+    m_NextIndex = 0u;
+  }
+
+  TUint32 TLASInstanceTable::EndFrame() {
+    MAU_PROFILE_SCOPE("TLASInstanceTable::EndFrame");
+
+    // backwards, the record moved into a removed slot was already looked at
+    TUint32 removed = 0u;
+    for (TUint32 i = GetCount(); i-- > 0u;) {
+      if (m_SetFrame[i] != m_Frame) {
+        Remove(m_Keys[i]);
+        removed++;
+      }
+    }
+    return removed;
+  }
+
+  bool TLASInstanceTable::Set(TUint64 key, const glm::mat4 &transform, TUint64 blas_address, TUint32 custom_index, TUint8 mask) {
+    const VkAccelerationStructureInstanceKHR instance = {
+        .transform = to_vk_transform(transform),
+        .instanceCustomIndex = custom_index,
+        .mask = mask,
+        .instanceShaderBindingTableRecordOffset = 0u,
+        .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
+        .accelerationStructureReference = blas_address,
+    };
+
+    // the scene is walked in the same order every frame, the record after the last one set is usually the next
+    TUint32 index = m_NextIndex;
+    if (index >= GetCount() || m_Keys[index] != key) {
+      auto found = m_Indices.find(key);
+      if (found == m_Indices.end()) {
+        index = GetCount();
+        m_Indices.emplace(key, index);
+        m_Instances.push_back(instance);
+        m_Keys.push_back(key);
+        m_SetFrame.push_back(m_Frame);
+        m_Changed.push_back(false);
+        MarkChanged(index);
+        m_NextIndex = index + 1u;
+        m_Rebuild = true;
+        return true;
+      }
+      index = found->second;
+    }
+
+    m_NextIndex = index + 1u;
+    m_SetFrame[index] = m_Frame;
+
+    VkAccelerationStructureInstanceKHR &record = m_Instances[index];
+    if (std::memcmp(&record, &instance, sizeof(instance)) == 0)
+      return false;
+
+    // a refit keeps the bvh of the old blas
+    if (record.accelerationStructureReference != instance.accelerationStructureReference)
+      m_Rebuild = true;
+
+    record = instance;
+    MarkChanged(index);
+    return true;
+  }
+
+  bool TLASInstanceTable::Remove(TUint64 key) {
+    auto found = m_Indices.find(key);
+    if (found == m_Indices.end())
+      return false;
+
+    const TUint32 index = found->second;
+    const TUint32 last = GetCount() - 1u;
+    m_Indices.erase(found);
+
+    if (index != last) {
+      m_Instances[index] = m_Instances[last];
+      m_Keys[index] = m_Keys[last];
+      m_SetFrame[index] = m_SetFrame[last];
+      m_Indices[m_Keys[index]] = index;
+      MarkChanged(index);
+    }
+
+    // a change of the popped record is dropped by TakeChanges
+    m_Instances.pop_back();
+    m_Keys.pop_back();
+    m_SetFrame.pop_back();
+    m_Changed.pop_back();
+    m_Rebuild = true;
+    return true;
+  }
+
+  void TLASInstanceTable::Clear() {
+    m_Rebuild |= !m_Instances.empty();
+    m_Instances.clear();
+    m_Keys.clear();
+    m_SetFrame.clear();
+    m_Changed.clear();
+    m_ChangedIndices.clear();
+    m_Indices.clear();
+  }
+
+  TLASInstanceChanges TLASInstanceTable::TakeChanges() {
+    MAU_PROFILE_SCOPE("TLASInstanceTable::TakeChanges");
+
+    TLASInstanceChanges changes = {.Rebuild = m_Rebuild};
+
+    // removals leave indices past the end and a slot that was removed and reused shows up twice
+    const TUint32 count = GetCount();
+    std::erase_if(m_ChangedIndices, [count](TUint32 index) -> bool { return index >= count; });
+    std::sort(m_ChangedIndices.begin(), m_ChangedIndices.end());
+    m_ChangedIndices.erase(std::unique(m_ChangedIndices.begin(), m_ChangedIndices.end()), m_ChangedIndices.end());
+
+    for (TUint32 index : m_ChangedIndices) {
+      m_Changed[index] = false;
+      if (!changes.Ranges.empty() && changes.Ranges.back().First + changes.Ranges.back().Count == index)
+        changes.Ranges.back().Count++;
+      else
+        changes.Ranges.push_back({.First = index, .Count = 1u});
+    }
+
+    changes.RecordCount = static_cast<TUint32>(m_ChangedIndices.size());
+    m_ChangedIndices.clear();
+    m_Rebuild = false;
+    return changes;
+  }
+
+  void TLASInstanceTable::MarkAllChanged() {
+    m_ChangedIndices.resize(GetCount());
+    for (TUint32 i = 0; i < GetCount(); i++) {
+      m_ChangedIndices[i] = i;
+      m_Changed[i] = true;
+    }
+    m_Rebuild = true;
+  }
+
+  const VkAccelerationStructureInstanceKHR *TLASInstanceTable::Find(TUint64 key) const {
+    auto found = m_Indices.find(key);
+    return found != m_Indices.end() ? &m_Instances[found->second] : nullptr;
+  }
+
+  void TLASInstanceTable::MarkChanged(TUint32 index) {
+    if (m_Changed[index])
+      return;
+
+    m_Changed[index] = true;
+    m_ChangedIndices.push_back(index);
+  }
+
+} // namespace mau
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <engine/types.h>
+
+namespace mau {
+
+  // instances are keyed by the entity they belong to and the submesh they draw
+  inline TUint64 make_tlas_instance_key(TUint32 entity, TUint32 submesh) { return (static_cast<TUint64>(entity) << 32u) | submesh; }
+
+  // records [First, First + Count) of the table
+  struct TLASInstanceRange {
+    TUint32 First = 0u;
+    TUint32 Count = 0u;
+  };
+
+  // what has to happen to the gpu copy of the table before the tlas can be used again
+  struct TLASInstanceChanges {
+    // changed records merged into ascending ranges, only these have to be copied
+    Vector<TLASInstanceRange> Ranges = {};
+    TUint32                   RecordCount = 0u;
+    // instances were added or removed or point at another blas, a refit is not enough
+    bool Rebuild = false;
+  };
+
+  // cpu side of the scene tlas, needs no device. records are kept packed in the layout the tlas build reads, a
+  // removed record is replaced by the last one so the table never has holes. records that changed since the last
+  // TakeChanges are tracked, unchanged ones are never copied again
+  class TLASInstanceTable {
+  public:
+    TLASInstanceTable() = default;
+    ~TLASInstanceTable() = default;
+
+  public:
+    // every instance of a frame is set between BeginFrame and EndFrame, EndFrame removes the ones that were not
+    void    BeginFrame();
+    TUint32 EndFrame();
+
+    // adds the instance or updates it, true when the record changed
+    bool Set(TUint64 key, const glm::mat4 &transform, TUint64 blas_address, TUint32 custom_index, TUint8 mask = 0xffu);
+    bool Remove(TUint64 key);
+    void Clear();
+
+    // hands out the changes since the last call and forgets them
+    TLASInstanceChanges TakeChanges();
+    // the next TakeChanges reports every record and a rebuild, after the gpu copy was recreated
+    void MarkAllChanged();
+
+    const VkAccelerationStructureInstanceKHR *Find(TUint64 key) const;
+
+    inline const VkAccelerationStructureInstanceKHR *GetInstances() const { return m_Instances.data(); }
+    inline TUint32                                   GetCount() const { return static_cast<TUint32>(m_Instances.size()); }
+    inline TUint64                                   GetKey(TUint32 index) const { return m_Keys[index]; }
+    inline TUint32                                   GetChangedCount() const { return static_cast<TUint32>(m_ChangedIndices.size()); }
+    inline bool                                      NeedsRebuild() const { return m_Rebuild; }
+
+  private:
+    void MarkChanged(TUint32 index);
+
+  private:
+    Vector<VkAccelerationStructureInstanceKHR> m_Instances = {};
+    Vector<TUint64>                            m_Keys = {};      // [instance]
+    Vector<TUint32>                            m_SetFrame = {};  // [instance], frame of the last Set
+    Vector<bool>                               m_Changed = {};   // [instance]
+    Vector<TUint32>                            m_ChangedIndices = {};
+    UnorderedMap<TUint64, TUint32>             m_Indices = {};
+    TUint32                                    m_Frame = 0u;
+    TUint32                                    m_NextIndex = 0u;
+    bool                                       m_Rebuild = false;
+  };
+
+} // namespace mau
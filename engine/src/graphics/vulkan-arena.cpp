@@ -0,0 +1,203 @@
+#include "vulkan-arena.h"
+
+#include <algorithm>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include "vulkan-state.h"
+
+namespace mau {
+
+  // range allocator
+  RangeAllocator::RangeAllocator(TUint64 capacity): m_Capacity(capacity) {
+    if (capacity > 0u)
+      m_FreeRanges.insert(std::make_pair(0u, capacity));
+  }
+
+  bool RangeAllocator::Allocate(TUint64 size, TUint64 &offset) {
+    if (size == 0u) {
+      offset = 0u;
+      return true;
+    }
+
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it) {
+      if (it->second < size)
+        continue;
+
+      offset = it->first;
+      const TUint64 remaining = it->second - size;
+      m_FreeRanges.erase(it);
+
+      if (remaining > 0u)
+        m_FreeRanges.insert(std::make_pair(offset + size, remaining));
+
+      m_Used += size;
+      return true;
+    }
+
+    return false;
+  }
+
+  void RangeAllocator::Free(TUint64 offset, TUint64 size) {
+    if (size == 0u)
+      return;
+
+    ASSERT(offset + size <= m_Capacity && m_Used >= size);
+    m_Used -= size;
+
+    auto next = m_FreeRanges.lower_bound(offset);
+
+    // merge with the range that ends where this one starts
+    if (next != m_FreeRanges.begin()) {
+      auto previous = std::prev(next);
+      ASSERT(previous->first + previous->second <= offset);
+
+      if (previous->first + previous->second == offset) {
+        offset = previous->first;
+        size += previous->second;
+        m_FreeRanges.erase(previous);
+      }
+    }
+
+    // and with the range that starts where this one ends
+    if (next != m_FreeRanges.end()) {
+      ASSERT(offset + size <= next->first);
+
+      if (offset + size == next->first) {
+        size += next->second;
+        m_FreeRanges.erase(next);
+      }
+    }
+
+    m_FreeRanges.insert(std::make_pair(offset, size));
+  }
+
+  // geometry allocation
+  GeometryAllocation::GeometryAllocation(TUint32 page, TUint64 first_vertex, TUint64 vertex_count, TUint64 first_index, TUint64 index_count)
+      : m_Page(page), m_FirstVertex(first_vertex), m_VertexCount(vertex_count), m_FirstIndex(first_index), m_IndexCount(index_count) { }
+
+  GeometryAllocation::~GeometryAllocation() {
+    if (GeometryArena::Get())
+      GeometryArena::Ref().Release(*this);
+  }
+
+  Handle<VertexBuffer> GeometryAllocation::GetVertexBuffer() const { return GeometryArena::Ref().GetVertexBuffer(m_Page); }
+
+  Handle<IndexBuffer> GeometryAllocation::GetIndexBuffer() const { return GeometryArena::Ref().GetIndexBuffer(m_Page); }
+
+  TUint64 GeometryAllocation::GetVertexByteOffset() const { return m_FirstVertex * GeometryArena::Ref().GetVertexStride(); }
+
+  TUint64 GeometryAllocation::GetIndexByteOffset() const { return m_FirstIndex * sizeof(TUint32); }
+
+  // geometry arena
+  GeometryArena::GeometryArena(TUint32 vertex_stride, TUint64 page_vertices, TUint64 page_indices)
+      : m_VertexStride(vertex_stride), m_PageVertices(page_vertices), m_PageIndices(page_indices) {
+    ASSERT(vertex_stride > 0u && page_vertices > 0u && page_indices > 0u);
+  }
+
+  GeometryArena::~GeometryArena() {
+    m_Retired.clear();
+    m_Pages.clear();
+  }
+
+  Handle<GeometryAllocation> GeometryArena::Allocate(const void *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count) {
+    MAU_PROFILE_SCOPE("GeometryArena::Allocate");
+    ASSERT(vertices && indices && vertex_count > 0u && index_count > 0u);
+
+    TUint32 page = 0u;
+    TUint64 first_vertex = 0u;
+    TUint64 first_index = 0u;
+
+    for (; page < m_Pages.size(); page++) {
+      Page &candidate = *m_Pages[page];
+      if (!candidate.VertexRanges.Allocate(vertex_count, first_vertex))
+        continue;
+
+      if (candidate.IndexRanges.Allocate(index_count, first_index))
+        break;
+
+      candidate.VertexRanges.Free(first_vertex, vertex_count);
+    }
+
+    if (page == m_Pages.size()) {
+      AddPage(vertex_count, index_count);
+
+      Page &added = *m_Pages.back();
+      added.VertexRanges.Allocate(vertex_count, first_vertex);
+      added.IndexRanges.Allocate(index_count, first_index);
+    }
+
+    UploadRing &upload_ring = *VulkanState::Ref().GetUploadRing();
+    upload_ring.EnqueueBuffer(m_Pages[page]->Vertices->Get(), vertices, vertex_count * m_VertexStride, first_vertex * m_VertexStride);
+    upload_ring.EnqueueBuffer(m_Pages[page]->Indices->Get(), indices, index_count * sizeof(TUint32), first_index * sizeof(TUint32));
+
+    return make_handle<GeometryAllocation>(page, first_vertex, vertex_count, first_index, index_count);
+  }
+
+  void GeometryArena::NextFrame(TUint32 frames_in_flight) {
+    m_Frame++;
+
+    if (m_Retired.empty())
+      return;
+
+    Vector<RetiredRange> retired = {};
+
+    for (const RetiredRange &range : m_Retired) {
+      if (range.Frame + frames_in_flight <= m_Frame) {
+        Page &page = *m_Pages[range.Page];
+        page.VertexRanges.Free(range.FirstVertex, range.VertexCount);
+        page.IndexRanges.Free(range.FirstIndex, range.IndexCount);
+      } else {
+        retired.push_back(range);
+      }
+    }
+
+    m_Retired.swap(retired);
+  }
+
+  TUint64 GeometryArena::GetUsedBytes() const {
+    TUint64 used = 0u;
+    for (const std::unique_ptr<Page> &page : m_Pages) {
+      used += page->VertexRanges.GetUsed() * m_VertexStride + page->IndexRanges.GetUsed() * sizeof(TUint32);
+    }
+    return used;
+  }
+
+  TUint64 GeometryArena::GetCapacityBytes() const {
+    TUint64 capacity = 0u;
+    for (const std::unique_ptr<Page> &page : m_Pages) {
+      capacity += page->Vertices->GetSize() + page->Indices->GetSize();
+    }
+    return capacity;
+  }
+
+  void GeometryArena::AddPage(TUint64 vertex_count, TUint64 index_count) {
+    MAU_PROFILE_SCOPE("GeometryArena::AddPage");
+
+    // meshes bigger than a page get a page of their own size
+    const TUint64 page_vertices = std::max(m_PageVertices, vertex_count);
+    const TUint64 page_indices = std::max(m_PageIndices, index_count);
+
+    std::unique_ptr<Page> page = std::make_unique<Page>();
+    page->Vertices = make_handle<VertexBuffer>(page_vertices * m_VertexStride);
+    page->Indices = make_handle<IndexBuffer>(page_indices * sizeof(TUint32));
+    page->VertexRanges = RangeAllocator(page_vertices);
+    page->IndexRanges = RangeAllocator(page_indices);
+    m_Pages.push_back(std::move(page));
+
+    LOG_INFO("geometry arena page %u added [vertices: %llu, indices: %llu]", static_cast<TUint32>(m_Pages.size() - 1u), static_cast<unsigned long long>(page_vertices),
+             static_cast<unsigned long long>(page_indices));
+  }
+
+  void GeometryArena::Release(const GeometryAllocation &allocation) {
+    RetiredRange range = {
+        .Page = allocation.GetPage(),
+        .FirstVertex = allocation.GetFirstVertex(),
+        .VertexCount = allocation.GetVertexCount(),
+        .FirstIndex = allocation.GetFirstIndex(),
+        .IndexCount = allocation.GetIndexCount(),
+        .Frame = m_Frame,
+    };
+    m_Retired.push_back(range);
+  }
+
+} // namespace mau
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <engine/types.h>
+#include <engine/utils/singleton.h>
+#include "common.h"
+#include "vulkan-buffers.h"
+
+namespace mau {
+
+  // 4M vertices and 16M indices per page, pages are only added when a mesh doesn't fit
+  constexpr TUint64 DEFAULT_ARENA_PAGE_VERTICES = 4ull * 1024ull * 1024ull;
+  constexpr TUint64 DEFAULT_ARENA_PAGE_INDICES = 16ull * 1024ull * 1024ull;
+
+  // first fit free list over [0, capacity), neighbouring free ranges are merged on free
+  class RangeAllocator {
+  public:
+    RangeAllocator(TUint64 capacity = 0u);
+    ~RangeAllocator() = default;
+
+  public:
+    bool Allocate(TUint64 size, TUint64 &offset);
+    void Free(TUint64 offset, TUint64 size);
+
+  public:
+    inline TUint64 GetCapacity() const { return m_Capacity; }
+    inline TUint64 GetUsed() const { return m_Used; }
+    inline TUint64 GetFreeRangeCount() const { return m_FreeRanges.size(); }
+
+  private:
+    std::map<TUint64, TUint64> m_FreeRanges = {}; // offset -> size
+    TUint64                    m_Capacity = 0u;
+    TUint64                    m_Used = 0u;
+  };
+
+  // vertex and index range of one arena page, offsets are in elements so they
+  // can be passed straight to vkCmdDrawIndexed as vertexOffset and firstIndex
+  class GeometryAllocation: public HandledObject {
+  public:
+    GeometryAllocation(TUint32 page, TUint64 first_vertex, TUint64 vertex_count, TUint64 first_index, TUint64 index_count);
+    ~GeometryAllocation();
+
+  public:
+    Handle<VertexBuffer> GetVertexBuffer() const;
+    Handle<IndexBuffer>  GetIndexBuffer() const;
+    TUint64              GetVertexByteOffset() const;
+    TUint64              GetIndexByteOffset() const;
+
+    inline TUint32 GetPage() const { return m_Page; }
+    inline TUint64 GetFirstVertex() const { return m_FirstVertex; }
+    inline TUint64 GetVertexCount() const { return m_VertexCount; }
+    inline TUint64 GetFirstIndex() const { return m_FirstIndex; }
+    inline TUint64 GetIndexCount() const { return m_IndexCount; }
+
+  private:
+    TUint32 m_Page = 0u;
+    TUint64 m_FirstVertex = 0u;
+    TUint64 m_VertexCount = 0u;
+    TUint64 m_FirstIndex = 0u;
+    TUint64 m_IndexCount = 0u;
+  };
+
+  // sub-allocates mesh geometry out of a few large vertex and index buffers
+  // instead of giving every submesh its own device memory. main thread only
+  class GeometryArena: public Singleton<GeometryArena> {
+    friend class Singleton<GeometryArena>;
+    friend class GeometryAllocation;
+
+  private:
+    GeometryArena(TUint32 vertex_stride, TUint64 page_vertices = DEFAULT_ARENA_PAGE_VERTICES, TUint64 page_indices = DEFAULT_ARENA_PAGE_INDICES);
+    ~GeometryArena();
+
+  public:
+    // copies go through the upload ring, a new page is added when no page has room
+    Handle<GeometryAllocation> Allocate(const void *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count);
+
+    // released ranges are reused once frames_in_flight frames have passed
+    void NextFrame(TUint32 frames_in_flight);
+
+  public:
+    inline TUint32              GetVertexStride() const { return m_VertexStride; }
+    inline TUint32              GetPageCount() const { return static_cast<TUint32>(m_Pages.size()); }
+    inline Handle<VertexBuffer> GetVertexBuffer(TUint32 page) const { return m_Pages[page]->Vertices; }
+    inline Handle<IndexBuffer>  GetIndexBuffer(TUint32 page) const { return m_Pages[page]->Indices; }
+    TUint64                     GetUsedBytes() const;
+    TUint64                     GetCapacityBytes() const;
+
+  private:
+    struct Page {
+      Handle<VertexBuffer> Vertices = nullptr;
+      Handle<IndexBuffer>  Indices = nullptr;
+      RangeAllocator       VertexRanges = {};
+      RangeAllocator       IndexRanges = {};
+    };
+
+    struct RetiredRange {
+      TUint32 Page = 0u;
+      TUint64 FirstVertex = 0u;
+      TUint64 VertexCount = 0u;
+      TUint64 FirstIndex = 0u;
+      TUint64 IndexCount = 0u;
+      TUint64 Frame = 0u;
+    };
+
+  private:
+    void AddPage(TUint64 vertex_count, TUint64 index_count);
+    void Release(const GeometryAllocation &allocation);
+
+  private:
+    TUint32                       m_VertexStride = 0u;
+    TUint64                       m_PageVertices = 0u;
+    TUint64                       m_PageIndices = 0u;
+    Vector<std::unique_ptr<Page>> m_Pages = {};
+    Vector<RetiredRange>          m_Retired = {};
+    TUint64                       m_Frame = 0u;
+  };
+
+} // namespace mau
@@ -1,7 +1,12 @@
 #include "vulkan-bindless.h"
 
+#include <algorithm>
+#include <engine/profiler.h>
+
 #include "vulkan-state.h"
 #include "vulkan-buffers.h"
+#include "vulkan-commands.h"
+#include "vulkan-image.h"
 
 namespace mau {
 
@@ -27,16 +32,123 @@ namespace mau {
     return VK_DESCRIPTOR_TYPE_MAX_ENUM;
   }
 
-  VulkanBindless::VulkanBindless() {
-    // [type, count]
-    const std::tuple<BindlessDescriptorType, TUint32> descriptor_types[] = {
-        {               BindlessDescriptorType::UNIFORM, m_DescriptorCount},
-        {               BindlessDescriptorType::TEXTURE, m_DescriptorCount},
-        {              BindlessDescriptorType::MATERIAL,                 1},
-        {         BindlessDescriptorType::STORAGE_IMAGE, m_DescriptorCount},
-        {BindlessDescriptorType::ACCELERATION_STRUCTURE, m_DescriptorCount},
-        {        BindlessDescriptorType::RT_OBJECT_DESC,                 1},
+  static const char *get_descriptor_name(BindlessDescriptorType type) {
+    switch (type) {
+    case mau::BindlessDescriptorType::UNIFORM:
+      return "uniform buffer";
+    case mau::BindlessDescriptorType::TEXTURE:
+      return "texture";
+    case mau::BindlessDescriptorType::MATERIAL:
+      return "material";
+    case mau::BindlessDescriptorType::STORAGE_IMAGE:
+      return "storage image";
+    case mau::BindlessDescriptorType::ACCELERATION_STRUCTURE:
+      return "acceleration structure";
+    case mau::BindlessDescriptorType::RT_OBJECT_DESC:
+      return "rt object";
+    default:
+      break;
+    }
+    return "unknown";
+  }
+
+  // a limit of 0 was not queried, the extension is not enabled
+  static TUint32 clamp_to_limit(TUint32 count, TUint32 limit) { return limit > 0u ? std::min(count, limit) : count; }
+
+  // every array is bound to all stages, the per stage limits apply next to the per set ones
+  static TUint32 get_descriptor_limit(BindlessDescriptorType type, TUint32 requested) {
+    const VkPhysicalDeviceLimits                             &limits = VulkanState::Ref().GetPhysicalDeviceProperties().limits;
+    const VkPhysicalDeviceAccelerationStructurePropertiesKHR accel_properties = VulkanState::Ref().GetAccelerationStructureProperties();
+
+    TUint32 count = std::min(requested, BINDLESS_INDEX_MASK);
+    switch (type) {
+    case BindlessDescriptorType::UNIFORM:
+      // the material and rt object arrays are uniform buffers as well
+      count = clamp_to_limit(count, std::min(limits.maxPerStageDescriptorUniformBuffers, limits.maxDescriptorSetUniformBuffers) - 2u);
+      break;
+    case BindlessDescriptorType::TEXTURE:
+      count = clamp_to_limit(count, std::min(limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages));
+      count = clamp_to_limit(count, std::min(limits.maxPerStageDescriptorSamplers, limits.maxDescriptorSetSamplers));
+      break;
+    case BindlessDescriptorType::STORAGE_IMAGE:
+      count = clamp_to_limit(count, std::min(limits.maxPerStageDescriptorStorageImages, limits.maxDescriptorSetStorageImages));
+      break;
+    case BindlessDescriptorType::ACCELERATION_STRUCTURE:
+      count = clamp_to_limit(count, std::min(accel_properties.maxPerStageDescriptorAccelerationStructures, accel_properties.maxDescriptorSetAccelerationStructures));
+      break;
+    default:
+      break;
+    }
+
+    return count;
+  }
+
+  BindlessSlotAllocator::BindlessSlotAllocator(TUint32 capacity): m_Capacity(std::min(capacity, BINDLESS_INDEX_MASK)) {}
+
+  TUint32 BindlessSlotAllocator::Allocate() {
+    TUint32 slot = 0u;
+    if (!m_FreeSlots.empty()) {
+      slot = m_FreeSlots.back();
+      m_FreeSlots.pop_back();
+    } else if (m_NextSlot < m_Capacity) {
+      slot = m_NextSlot++;
+      m_Generations.push_back(0u);
+      m_Live.push_back(false);
+    } else {
+      return BINDLESS_INVALID_HANDLE;
+    }
+
+    m_Live[slot] = true;
+    m_UsedCount++;
+    return slot | (m_Generations[slot] << BINDLESS_INDEX_BITS);
+  }
+
+  bool BindlessSlotAllocator::Release(TUint32 handle, TUint64 frame) {
+    if (!IsValid(handle))
+      return false;
+
+    const TUint32 slot = get_bindless_index(handle);
+    m_Live[slot] = false;
+    m_Generations[slot] = (m_Generations[slot] + 1u) & (UINT32_MAX >> BINDLESS_INDEX_BITS);
+    m_UsedCount--;
+    m_Retiring.push_back(std::make_pair(slot, frame));
+    return true;
+  }
+
+  TUint32 BindlessSlotAllocator::Retire(TUint64 completed_frame) {
+    const size_t retiring_count = m_Retiring.size();
+    std::erase_if(m_Retiring, [&](const std::pair<TUint32, TUint64> &retiring) -> bool {
+      if (retiring.second > completed_frame)
+        return false;
+
+      m_FreeSlots.push_back(retiring.first);
+      return true;
+    });
+
+    return static_cast<TUint32>(retiring_count - m_Retiring.size());
+  }
+
+  bool BindlessSlotAllocator::IsValid(TUint32 handle) const {
+    const TUint32 slot = get_bindless_index(handle);
+    return handle != BINDLESS_INVALID_HANDLE && slot < m_NextSlot && m_Live[slot] && get_bindless_generation(handle) == m_Generations[slot];
+  }
+
+  VulkanBindless::VulkanBindless(TUint32 descriptor_count) {
+    const TUint32 uniform_count = get_descriptor_limit(BindlessDescriptorType::UNIFORM, descriptor_count);
+    const TUint32 texture_count = get_descriptor_limit(BindlessDescriptorType::TEXTURE, descriptor_count);
+    const TUint32 image_count = get_descriptor_limit(BindlessDescriptorType::STORAGE_IMAGE, descriptor_count);
+    const TUint32 accel_count = get_descriptor_limit(BindlessDescriptorType::ACCELERATION_STRUCTURE, descriptor_count);
+
+    // [type, descriptor count, slot count]
+    const std::tuple<BindlessDescriptorType, TUint32, TUint32> descriptor_types[] = {
+        {               BindlessDescriptorType::UNIFORM, uniform_count,        uniform_count},
+        {               BindlessDescriptorType::TEXTURE, texture_count,        texture_count},
+        {              BindlessDescriptorType::MATERIAL,            1u, BINDLESS_MAX_OBJECTS},
+        {         BindlessDescriptorType::STORAGE_IMAGE,   image_count,          image_count},
+        {BindlessDescriptorType::ACCELERATION_STRUCTURE,   accel_count,          accel_count},
+        {        BindlessDescriptorType::RT_OBJECT_DESC,            1u, BINDLESS_MAX_OBJECTS},
     };
+    static_assert(ARRAY_SIZE(descriptor_types) == TYPE_COUNT);
 
     // create descriptor pool
     VkDescriptorPoolSize pool_sizes[ARRAY_SIZE(descriptor_types)] = {};
@@ -47,11 +159,10 @@ namespace mau {
           .descriptorCount = std::get<1>(descriptor_types[i]),
       };
     }
-
     VkDescriptorPoolCreateInfo pool_create_info = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .pNext = nullptr,
-        .flags = 0u,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
         .maxSets = static_cast<uint32_t>(ARRAY_SIZE(descriptor_types)),
         .poolSizeCount = static_cast<uint32_t>(ARRAY_SIZE(pool_sizes)),
         .pPoolSizes = pool_sizes,
@@ -72,7 +183,8 @@ namespace mau {
           .pImmutableSamplers = nullptr,
       };
 
-      VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+      // written every frame while the sets are bound by the frames still in flight
+      VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
 
       VkDescriptorSetLayoutBindingFlagsCreateInfo flag_info = {
           .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
@@ -84,7 +196,7 @@ namespace mau {
       VkDescriptorSetLayoutCreateInfo set_layout_info = {
           .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
           .pNext = reinterpret_cast<const void *>(&flag_info),
-          .flags = 0u,
+          .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
           .bindingCount = 1u,
           .pBindings = &binding,
       };
@@ -103,6 +215,9 @@ namespace mau {
 
       VK_CALL(vkAllocateDescriptorSets(VulkanState::Ref().GetDevice(), &alloc_info, &descriptor_set));
 
+      // materials and rt objects are entries of a single uniform buffer, everything else one descriptor per slot
+      m_Slots[static_cast<TUint32>(type)] = BindlessSlotAllocator(std::get<2>(descriptor_types[i]));
+
       m_DescriptorIndexMap.insert(std::make_pair(type, static_cast<TUint32>(i)));
       m_DescriptorLayouts.push_back(descriptor_layout);
       m_DescriptorSets.push_back(descriptor_set);
@@ -110,9 +225,24 @@ namespace mau {
 
     SetupMaterialBuffer();
     SetupRTObjectBuffer();
+
+    const TUint32 white_pixel = 0xffffffffu;
+    m_PlaceholderTexture = make_handle<Texture>(1u, 1u, &white_pixel);
+
+    LOG_INFO("bindless capacity [uniform buffers: %u, textures: %u, storage images: %u, acceleration structures: %u]", GetCapacity(BindlessDescriptorType::UNIFORM),
+             GetCapacity(BindlessDescriptorType::TEXTURE), GetCapacity(BindlessDescriptorType::STORAGE_IMAGE), GetCapacity(BindlessDescriptorType::ACCELERATION_STRUCTURE));
   }
 
   VulkanBindless::~VulkanBindless() {
+    // deferred materials defer their textures in turn
+    while (!m_Deferred.empty()) {
+      Vector<std::pair<Handle<HandledObject>, TUint64>> deferred = std::move(m_Deferred);
+      m_Deferred.clear();
+    }
+
+    m_PendingTextures.clear();
+    m_PlaceholderTexture = nullptr;
+
     for (const auto &layout : m_DescriptorLayouts) {
       vkDestroyDescriptorSetLayout(VulkanState::Ref().GetDevice(), layout, nullptr);
     }
@@ -120,130 +250,323 @@ namespace mau {
   }
 
   TextureHandle VulkanBindless::AddTexture(const Handle<Texture> &texture) {
-    const TUint32         sampler_set_index = m_DescriptorIndexMap[BindlessDescriptorType::TEXTURE];
-    const VkDescriptorSet sampler_set = m_DescriptorSets[sampler_set_index];
-    ASSERT(sampler_set);
+    std::lock_guard lock(m_Mutex);
+    const TextureHandle handle = Allocate(BindlessDescriptorType::TEXTURE);
+
+    if (texture->IsResident()) {
+      QueueWrite({.Type = BindlessDescriptorType::TEXTURE, .Index = get_bindless_index(handle), .Image = texture->GetDescriptorInfo()});
+    } else {
+      QueueWrite({.Type = BindlessDescriptorType::TEXTURE, .Index = get_bindless_index(handle), .Image = m_PlaceholderTexture->GetDescriptorInfo()});
+      m_PendingTextures.push_back(std::make_pair(texture, handle));
+    }
 
-    TextureHandle handle = m_CurrentTextureIndex++;
+    return handle;
+  }
 
-    VkDescriptorImageInfo image_descriptor_info = texture->GetDescriptorInfo();
-    VkWriteDescriptorSet  write_descriptor_set = {};
-    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_descriptor_set.pNext = nullptr;
-    write_descriptor_set.dstSet = sampler_set;
-    write_descriptor_set.dstBinding = 0u;
-    write_descriptor_set.dstArrayElement = handle;
-    write_descriptor_set.descriptorCount = 1u;
-    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write_descriptor_set.pImageInfo = &image_descriptor_info;
+  TUint32 VulkanBindless::UpdatePendingTextures() {
+    std::lock_guard                                   lock(m_Mutex);
+    Vector<std::pair<Handle<Texture>, TextureHandle>> pending_textures = {};
+    TUint32                                           update_count = 0u;
+
+    BindlessSlotAllocator &slots = m_Slots[static_cast<TUint32>(BindlessDescriptorType::TEXTURE)];
+
+    for (const auto &[texture, handle] : m_PendingTextures) {
+      // without a free slot the texture stays on the placeholder and is tried again later
+      const TextureHandle moved = texture->IsResident() ? slots.Allocate() : BINDLESS_INVALID_HANDLE;
+      if (moved == BINDLESS_INVALID_HANDLE) {
+        pending_textures.push_back(std::make_pair(texture, handle));
+        continue;
+      }
+
+      // no frame in flight knows the fresh slot, the frames that read the placeholder one retire it
+      QueueWrite({.Type = BindlessDescriptorType::TEXTURE, .Index = get_bindless_index(moved), .Image = texture->GetDescriptorInfo()});
+      slots.Release(handle, m_Frame + 1u);
+      m_MovedTextures[handle] = moved;
+
+      const TUint32 index = get_bindless_index(handle);
+      for (TUint32 slot = 0; slot < static_cast<TUint32>(m_Materials.size()); slot++) {
+        GPUMaterial &material = m_Materials[slot];
+        if (material.Diffuse != index && material.Normal != index)
+          continue;
+
+        if (material.Diffuse == index)
+          material.Diffuse = get_bindless_index(moved);
+        if (material.Normal == index)
+          material.Normal = get_bindless_index(moved);
+        if (std::find(m_MaterialUpdates.begin(), m_MaterialUpdates.end(), slot) == m_MaterialUpdates.end())
+          m_MaterialUpdates.push_back(slot);
+      }
+      update_count++;
+    }
 
-    vkUpdateDescriptorSets(VulkanState::Ref().GetDevice(), 1u, &write_descriptor_set, 0u, nullptr);
+    m_PendingTextures.swap(pending_textures);
+    return update_count;
+  }
 
+  BufferHandle VulkanBindless::AddBuffer(const Handle<UniformBuffer> &buffer) {
+    std::lock_guard    lock(m_Mutex);
+    const BufferHandle handle = Allocate(BindlessDescriptorType::UNIFORM);
+    QueueWrite({.Type = BindlessDescriptorType::UNIFORM, .Index = get_bindless_index(handle), .Buffer = buffer->GetDescriptorInfo()});
     return handle;
   }
 
-  BufferHandle VulkanBindless::AddBuffer(const Handle<UniformBuffer> &buffer) { return AddBufferInternal(buffer, BindlessDescriptorType::UNIFORM, m_CurrentBufferIndex++); }
-
   MaterialHandle VulkanBindless::AddMaterial(const GPUMaterial &material) {
-    MaterialHandle handle = m_CurrentMaterialIndex++;
-    m_MaterialBuffer->UpdateIndex(material, handle);
+    std::lock_guard      lock(m_Mutex);
+    const MaterialHandle handle = Allocate(BindlessDescriptorType::MATERIAL);
+    m_MaterialBuffer->UpdateIndex(material, get_bindless_index(handle));
+    m_Materials[get_bindless_index(handle)] = material;
     return handle;
   }
 
   ImageHandle VulkanBindless::AddStorageImage(const Handle<ImageView> &image_view) {
-    const TUint32         storage_image_set_index = m_DescriptorIndexMap[BindlessDescriptorType::STORAGE_IMAGE];
-    const VkDescriptorSet storage_image_set = m_DescriptorSets[storage_image_set_index];
-    ASSERT(storage_image_set);
-
-    ImageHandle handle = m_CurrentImageIndex++;
+    std::lock_guard   lock(m_Mutex);
+    const ImageHandle handle = Allocate(BindlessDescriptorType::STORAGE_IMAGE);
 
-    VkDescriptorImageInfo image_descriptor_info = {
+    const VkDescriptorImageInfo image_descriptor_info = {
         .sampler = VK_NULL_HANDLE,
         .imageView = image_view->GetImageView(),
         .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
     };
-
-    VkWriteDescriptorSet write_descriptor_set = {};
-    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_descriptor_set.pNext = nullptr;
-    write_descriptor_set.dstSet = storage_image_set;
-    write_descriptor_set.dstBinding = 0u;
-    write_descriptor_set.dstArrayElement = handle;
-    write_descriptor_set.descriptorCount = 1u;
-    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    write_descriptor_set.pImageInfo = &image_descriptor_info;
-
-    vkUpdateDescriptorSets(VulkanState::Ref().GetDevice(), 1u, &write_descriptor_set, 0u, nullptr);
+    QueueWrite({.Type = BindlessDescriptorType::STORAGE_IMAGE, .Index = get_bindless_index(handle), .Image = image_descriptor_info});
 
     return handle;
   }
 
-  AccelerationStructureHandle VulkanBindless::AddAccelerationStructure(const Handle<AccelerationBuffer> &accel_struct) {
-    const TUint32         accel_struct_set_index = m_DescriptorIndexMap[BindlessDescriptorType::ACCELERATION_STRUCTURE];
-    const VkDescriptorSet accel_struct_set = m_DescriptorSets[accel_struct_set_index];
-    ASSERT(accel_struct_set);
-
-    AccelerationStructureHandle handle = m_CurrentAccelStructIndex++;
+  TextureHandle VulkanBindless::AddSampledImage(const Handle<ImageView> &image_view, const Handle<Sampler> &sampler) {
+    std::lock_guard     lock(m_Mutex);
+    const TextureHandle handle = Allocate(BindlessDescriptorType::TEXTURE);
 
-    VkAccelerationStructureKHR                   tlas = accel_struct->GetTLAS();
-    VkWriteDescriptorSetAccelerationStructureKHR accel_struct_descriptor_info = {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
-        .pNext = nullptr,
-        .accelerationStructureCount = 1u,
-        .pAccelerationStructures = &tlas,
+    const VkDescriptorImageInfo image_descriptor_info = {
+        .sampler = sampler->Get(),
+        .imageView = image_view->GetImageView(),
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
     };
+    QueueWrite({.Type = BindlessDescriptorType::TEXTURE, .Index = get_bindless_index(handle), .Image = image_descriptor_info});
 
-    VkWriteDescriptorSet write_descriptor_set = {};
-    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_descriptor_set.pNext = &accel_struct_descriptor_info;
-    write_descriptor_set.dstSet = accel_struct_set;
-    write_descriptor_set.dstBinding = 0u;
-    write_descriptor_set.dstArrayElement = handle;
-    write_descriptor_set.descriptorCount = 1u;
-    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-
-    vkUpdateDescriptorSets(VulkanState::Ref().GetDevice(), 1u, &write_descriptor_set, 0u, nullptr);
+    return handle;
+  }
 
+  AccelerationStructureHandle VulkanBindless::AddAccelerationStructure(const Handle<TopLevelAS> &accel_struct) {
+    std::lock_guard                   lock(m_Mutex);
+    const AccelerationStructureHandle handle = Allocate(BindlessDescriptorType::ACCELERATION_STRUCTURE);
+    QueueWrite({.Type = BindlessDescriptorType::ACCELERATION_STRUCTURE, .Index = get_bindless_index(handle), .AccelerationStructure = accel_struct->GetTLAS()});
     return handle;
   }
 
   RTObjectHandle VulkanBindless::AddRTObject(const RTObjectDesc &desc) {
-    RTObjectHandle handle = m_CurrentRTObjectDescIndex++;
-    m_RTObjectDesc->UpdateIndex(desc, handle);
+    std::lock_guard      lock(m_Mutex);
+    const RTObjectHandle handle = Allocate(BindlessDescriptorType::RT_OBJECT_DESC);
+    m_RTObjectDesc->UpdateIndex(desc, get_bindless_index(handle));
     return handle;
   }
 
-  BufferHandle VulkanBindless::AddBufferInternal(const Handle<UniformBuffer> &buffer, BindlessDescriptorType type, TUint32 array_index) {
-    const TUint32         buffer_set_index = m_DescriptorIndexMap[type];
-    const VkDescriptorSet buffer_set = m_DescriptorSets[buffer_set_index];
-    ASSERT(buffer_set);
+  void VulkanBindless::Release(BindlessDescriptorType type, TUint32 handle) {
+    if (handle == BINDLESS_INVALID_HANDLE)
+      return;
 
-    BufferHandle handle = array_index;
+    std::lock_guard lock(m_Mutex);
 
-    VkDescriptorBufferInfo buffer_descriptor_info = buffer->GetDescriptorInfo();
-    VkWriteDescriptorSet   write_descriptor_set = {};
-    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_descriptor_set.pNext = nullptr;
-    write_descriptor_set.dstSet = buffer_set;
-    write_descriptor_set.dstBinding = 0u;
-    write_descriptor_set.dstArrayElement = handle;
-    write_descriptor_set.descriptorCount = 1u;
-    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    write_descriptor_set.pBufferInfo = &buffer_descriptor_info;
+    // the texture moved out of its placeholder slot, which is released already
+    if (type == BindlessDescriptorType::TEXTURE) {
+      const auto it = m_MovedTextures.find(handle);
+      if (it != m_MovedTextures.end()) {
+        handle = it->second;
+        m_MovedTextures.erase(it);
+      }
+    }
 
-    vkUpdateDescriptorSets(VulkanState::Ref().GetDevice(), 1u, &write_descriptor_set, 0u, nullptr);
+    // with a render thread the next frame may already be recorded, it is the last one that can read the slot
+    if (!m_Slots[static_cast<TUint32>(type)].Release(handle, m_Frame + 1u)) {
+      LOG_WARN("released stale %s handle %08x", get_descriptor_name(type), handle);
+      return;
+    }
+
+    if (type == BindlessDescriptorType::TEXTURE)
+      std::erase_if(m_PendingTextures, [handle](const auto &pending) -> bool { return pending.second == handle; });
+    if (type == BindlessDescriptorType::MATERIAL) {
+      m_Materials[get_bindless_index(handle)] = {};
+      std::erase(m_MaterialUpdates, get_bindless_index(handle));
+    }
+  }
+
+  void VulkanBindless::Defer(Handle<HandledObject> resource) {
+    if (!resource)
+      return;
+
+    std::lock_guard lock(m_Mutex);
+    m_Deferred.push_back(std::make_pair(resource, m_Frame + 1u));
+  }
+
+  TUint32 VulkanBindless::ReleaseDeferred() {
+    Vector<Handle<HandledObject>> released = {};
+    {
+      std::lock_guard lock(m_Mutex);
+      if (m_RetiredFrame == UINT64_MAX)
+        return 0u;
+
+      std::erase_if(m_Deferred, [&](const std::pair<Handle<HandledObject>, TUint64> &deferred) -> bool {
+        if (deferred.second > m_RetiredFrame)
+          return false;
+
+        released.push_back(deferred.first);
+        return true;
+      });
+    }
+
+    // outside the lock, a released material defers its textures
+    return static_cast<TUint32>(released.size());
+  }
+
+  bool VulkanBindless::IsValid(BindlessDescriptorType type, TUint32 handle) {
+    std::lock_guard lock(m_Mutex);
+    return m_Slots[static_cast<TUint32>(type)].IsValid(handle);
+  }
+
+  TUint32 VulkanBindless::Update(TUint64 frame, TUint32 frames_in_flight) {
+    MAU_PROFILE_SCOPE("VulkanBindless::Update");
+    std::lock_guard lock(m_Mutex);
+    m_Frame = frame;
+
+    // the fence of frame - frames_in_flight was waited for, everything released up to it is free again
+    if (frame >= frames_in_flight) {
+      m_RetiredFrame = frame - frames_in_flight;
+      for (BindlessSlotAllocator &slots : m_Slots) {
+        slots.Retire(m_RetiredFrame);
+      }
+    }
+
+    const TUint32 write_count = static_cast<TUint32>(m_PendingWrites.size());
+    FlushWrites();
+    return write_count;
+  }
+
+  void VulkanBindless::RecordMaterialUpdates(const Handle<CommandBuffer> &cmd) {
+    std::lock_guard lock(m_Mutex);
+    if (m_MaterialUpdates.empty())
+      return;
+
+    MAU_PROFILE_SCOPE("VulkanBindless::RecordMaterialUpdates");
+
+    // the reads of the frames before are done before the buffer is written, this frame reads what was written
+    const VkMemoryBarrier read_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = 0u,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(cmd->Get(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 1u, &read_barrier, 0u, nullptr, 0u, nullptr);
+
+    for (TUint32 slot : m_MaterialUpdates) {
+      vkCmdUpdateBuffer(cmd->Get(), m_MaterialBuffer->Get(), static_cast<VkDeviceSize>(slot) * sizeof(GPUMaterial), sizeof(GPUMaterial), &m_Materials[slot]);
+    }
+
+    const VkMemoryBarrier write_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT,
+    };
+    vkCmdPipelineBarrier(cmd->Get(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 1u, &write_barrier, 0u, nullptr, 0u, nullptr);
+
+    m_MaterialUpdates.clear();
+  }
+
+  TUint32 VulkanBindless::Allocate(BindlessDescriptorType type) {
+    const TUint32 handle = m_Slots[static_cast<TUint32>(type)].Allocate();
+    if (handle == BINDLESS_INVALID_HANDLE)
+      throw GraphicsException("out of bindless " + String(get_descriptor_name(type)) + " slots, capacity " + std::to_string(m_Slots[static_cast<TUint32>(type)].GetCapacity()));
 
     return handle;
   }
 
+  void VulkanBindless::QueueWrite(const DescriptorWrite &write) { m_PendingWrites.push_back(write); }
+
+  void VulkanBindless::FlushWrites() {
+    if (m_PendingWrites.empty())
+      return;
+
+    MAU_PROFILE_SCOPE("VulkanBindless::FlushWrites");
+
+    // the last write to a slot wins, consecutive slots of one array become a single write
+    std::stable_sort(m_PendingWrites.begin(), m_PendingWrites.end(), [](const DescriptorWrite &a, const DescriptorWrite &b) -> bool {
+      return a.Type != b.Type ? a.Type < b.Type : a.Index < b.Index;
+    });
+
+    // reserved up front, the writes point into these arrays
+    const size_t                                         pending_count = m_PendingWrites.size();
+    Vector<VkDescriptorImageInfo>                        image_infos = {};
+    Vector<VkDescriptorBufferInfo>                       buffer_infos = {};
+    Vector<VkAccelerationStructureKHR>                   accel_structs = {};
+    Vector<VkWriteDescriptorSetAccelerationStructureKHR> accel_writes = {};
+    Vector<VkWriteDescriptorSet>                         writes = {};
+    image_infos.reserve(pending_count);
+    buffer_infos.reserve(pending_count);
+    accel_structs.reserve(pending_count);
+    accel_writes.reserve(pending_count);
+    writes.reserve(pending_count);
+
+    BindlessDescriptorType run_type = BindlessDescriptorType::UNIFORM;
+    for (size_t i = 0; i < pending_count; i++) {
+      const DescriptorWrite &pending = m_PendingWrites[i];
+      if (i + 1u < pending_count && m_PendingWrites[i + 1u].Type == pending.Type && m_PendingWrites[i + 1u].Index == pending.Index)
+        continue;
+
+      const bool extends_run = !writes.empty() && run_type == pending.Type && writes.back().dstArrayElement + writes.back().descriptorCount == pending.Index;
+      if (!extends_run) {
+        run_type = pending.Type;
+        writes.push_back({
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = m_DescriptorSets[m_DescriptorIndexMap[pending.Type]],
+            .dstBinding = 0u,
+            .dstArrayElement = pending.Index,
+            .descriptorCount = 0u,
+            .descriptorType = get_descriptor_type(pending.Type),
+            .pImageInfo = image_infos.data() + image_infos.size(),
+            .pBufferInfo = buffer_infos.data() + buffer_infos.size(),
+            .pTexelBufferView = nullptr,
+        });
+
+        if (pending.Type == BindlessDescriptorType::ACCELERATION_STRUCTURE) {
+          accel_writes.push_back({
+              .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
+              .pNext = nullptr,
+              .accelerationStructureCount = 0u,
+              .pAccelerationStructures = accel_structs.data() + accel_structs.size(),
+          });
+          writes.back().pNext = &accel_writes.back();
+        }
+      }
+
+      writes.back().descriptorCount++;
+      switch (pending.Type) {
+      case BindlessDescriptorType::TEXTURE:
+      case BindlessDescriptorType::STORAGE_IMAGE:
+        image_infos.push_back(pending.Image);
+        break;
+      case BindlessDescriptorType::ACCELERATION_STRUCTURE:
+        accel_structs.push_back(pending.AccelerationStructure);
+        accel_writes.back().accelerationStructureCount++;
+        break;
+      default:
+        buffer_infos.push_back(pending.Buffer);
+        break;
+      }
+    }
+
+    vkUpdateDescriptorSets(VulkanState::Ref().GetDevice(), static_cast<TUint32>(writes.size()), writes.data(), 0u, nullptr);
+    m_PendingWrites.clear();
+  }
+
   void VulkanBindless::SetupMaterialBuffer() {
-    m_MaterialBuffer = make_handle<StructuredUniformBuffer<GPUMaterial>>(m_DescriptorCount);
-    AddBufferInternal(m_MaterialBuffer, BindlessDescriptorType::MATERIAL, 0);
+    m_MaterialBuffer = make_handle<StructuredUniformBuffer<GPUMaterial>>(BINDLESS_MAX_OBJECTS);
+    m_Materials.resize(BINDLESS_MAX_OBJECTS);
+    QueueWrite({.Type = BindlessDescriptorType::MATERIAL, .Index = 0u, .Buffer = m_MaterialBuffer->GetDescriptorInfo()});
   }
 
   void VulkanBindless::SetupRTObjectBuffer() {
-    m_RTObjectDesc = make_handle<StructuredUniformBuffer<RTObjectDesc>>(m_DescriptorCount);
-    AddBufferInternal(m_RTObjectDesc, BindlessDescriptorType::RT_OBJECT_DESC, 0);
+    m_RTObjectDesc = make_handle<StructuredUniformBuffer<RTObjectDesc>>(BINDLESS_MAX_OBJECTS);
+    QueueWrite({.Type = BindlessDescriptorType::RT_OBJECT_DESC, .Index = 0u, .Buffer = m_RTObjectDesc->GetDescriptorInfo()});
   }
 
 } // namespace mau
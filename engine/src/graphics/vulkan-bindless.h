@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <engine/types.h>
 #include <engine/utils/singleton.h>
 
@@ -8,9 +9,11 @@
 namespace mau {
 
   class Texture;
+  class CommandBuffer;
   class UniformBuffer;
-  class AccelerationBuffer;
+  class TopLevelAS;
   class ImageView;
+  class Sampler;
 
   template <typename T> class StructuredUniformBuffer;
 
@@ -23,11 +26,59 @@ namespace mau {
     RT_OBJECT_DESC = 5,
   };
 
+  // handles carry the descriptor array index in the low bits and the generation of the slot in the high bits. shaders
+  // only ever see the index, see get_bindless_index
+  constexpr TUint32 BINDLESS_INDEX_BITS = 20u;
+  constexpr TUint32 BINDLESS_INDEX_MASK = (1u << BINDLESS_INDEX_BITS) - 1u;
+  constexpr TUint32 BINDLESS_INVALID_HANDLE = UINT32_MAX;
+  // materials and rt object descriptions live in uniform arrays of MAX_MODELS entries, see common/limits.glsl
+  constexpr TUint32 BINDLESS_MAX_OBJECTS = 1024u;
+
+  // the value shaders index with, invalid handles stay UINT32_MAX
+  inline TUint32 get_bindless_index(TUint32 handle) { return handle == BINDLESS_INVALID_HANDLE ? BINDLESS_INVALID_HANDLE : handle & BINDLESS_INDEX_MASK; }
+  inline TUint32 get_bindless_generation(TUint32 handle) { return handle >> BINDLESS_INDEX_BITS; }
+
+  // slots of one descriptor array. a released slot is reused only after the frame that released it retired, its
+  // generation is bumped on release so handles to the previous owner are detected as stale
+  class BindlessSlotAllocator {
+  public:
+    BindlessSlotAllocator(TUint32 capacity = 0u);
+    ~BindlessSlotAllocator() = default;
+
+  public:
+    // BINDLESS_INVALID_HANDLE when every slot is taken
+    TUint32 Allocate();
+    // false for stale or invalid handles
+    bool Release(TUint32 handle, TUint64 frame);
+    // frees the slots released by frames up to completed_frame, returns how many
+    TUint32 Retire(TUint64 completed_frame);
+
+    bool IsValid(TUint32 handle) const;
+
+    inline TUint32 GetCapacity() const { return m_Capacity; }
+    inline TUint32 GetUsedCount() const { return m_UsedCount; }
+    inline TUint32 GetRetiringCount() const { return static_cast<TUint32>(m_Retiring.size()); }
+
+  private:
+    TUint32                             m_Capacity = 0u;
+    TUint32                             m_UsedCount = 0u;
+    TUint32                             m_NextSlot = 0u; // slots above were never handed out
+    Vector<TUint32>                     m_Generations = {};
+    Vector<bool>                        m_Live = {};
+    Vector<TUint32>                     m_FreeSlots = {};
+    Vector<std::pair<TUint32, TUint64>> m_Retiring = {}; // [slot, frame that released it]
+  };
+
+  // slots of every bindless array. Add* hands out a slot and queues its descriptor write, Update issues the queued
+  // writes in one vkUpdateDescriptorSets before a frame is recorded. the sets are update after bind, so the writes land
+  // while older frames that bound them are still pending. Release* returns a slot once no frame in flight can read it
+  // anymore. safe to call from any thread
   class VulkanBindless: public Singleton<VulkanBindless> {
     friend class Singleton<VulkanBindless>;
 
   private:
-    VulkanBindless();
+    // descriptors per array, clamped to the device limits
+    VulkanBindless(TUint32 descriptor_count = 1024u);
     ~VulkanBindless();
 
   public:
@@ -35,34 +86,79 @@ namespace mau {
     BufferHandle                AddBuffer(const Handle<UniformBuffer> &buffer);
     MaterialHandle              AddMaterial(const GPUMaterial &material);
     ImageHandle                 AddStorageImage(const Handle<ImageView> &image_view);
-    AccelerationStructureHandle AddAccelerationStructure(const Handle<AccelerationBuffer> &accel_struct);
+    // an image the render graph keeps in shader read only layout, it takes a slot of the texture array
+    TextureHandle               AddSampledImage(const Handle<ImageView> &image_view, const Handle<Sampler> &sampler);
+    AccelerationStructureHandle AddAccelerationStructure(const Handle<TopLevelAS> &accel_struct);
     RTObjectHandle              AddRTObject(const RTObjectDesc &desc);
 
+    // the resource behind a released slot has to stay alive until the current frame retired, Defer keeps it
+    void Release(BindlessDescriptorType type, TUint32 handle);
+    void Defer(Handle<HandledObject> resource);
+    bool IsValid(BindlessDescriptorType type, TUint32 handle);
+
+    // main thread, drops the deferred resources of retired frames. handles are only ever released on the thread that
+    // shares them
+    TUint32 ReleaseDeferred();
+
+    // moves resident textures out of their placeholder slots into fresh ones, slots that frames in flight may read are
+    // never written. the placeholder slot is released and the materials naming it are patched by the next frame, a
+    // released old handle releases the slot that replaced it
+    TUint32 UpdatePendingTextures();
+
+    // render thread, after the fence of frame - frames_in_flight was waited for and before frame is recorded. recycles
+    // retired slots and flushes the queued descriptor writes, returns the number of writes
+    TUint32 Update(TUint64 frame, TUint32 frames_in_flight);
+    // render thread, first thing in the frame's command buffer. the material writes wait for every earlier command, so
+    // frames in flight keep reading the entries they were recorded with
+    void RecordMaterialUpdates(const Handle<CommandBuffer> &cmd);
+
   public:
     inline const std::vector<VkDescriptorSetLayout> &GetDescriptorLayout() const { return m_DescriptorLayouts; }
     inline const std::vector<VkDescriptorSet>       &GetDescriptorSet() const { return m_DescriptorSets; }
+    inline TUint32                                   GetCapacity(BindlessDescriptorType type) const { return m_Slots[static_cast<TUint32>(type)].GetCapacity(); }
 
   private:
-    BufferHandle AddBufferInternal(const Handle<UniformBuffer> &buffer, BindlessDescriptorType type, TUint32 array_index);
-    void         SetupMaterialBuffer();
-    void         SetupRTObjectBuffer();
+    // one pending descriptor write, the info structs are kept by value until the flush
+    struct DescriptorWrite {
+      BindlessDescriptorType     Type = BindlessDescriptorType::UNIFORM;
+      TUint32                    Index = 0u;
+      VkDescriptorImageInfo      Image = {};
+      VkDescriptorBufferInfo     Buffer = {};
+      VkAccelerationStructureKHR AccelerationStructure = VK_NULL_HANDLE;
+    };
 
   private:
-    const TUint32 m_DescriptorCount = 1024u;
-    TUint32       m_CurrentTextureIndex = 0u;
-    TUint32       m_CurrentBufferIndex = 0u;
-    TUint32       m_CurrentMaterialIndex = 0u;
-    TUint32       m_CurrentImageIndex = 0u;
-    TUint32       m_CurrentAccelStructIndex = 0u;
-    TUint32       m_CurrentRTObjectDescIndex = 0u;
+    TUint32 Allocate(BindlessDescriptorType type);
+    void    QueueWrite(const DescriptorWrite &write);
+    void    FlushWrites();
+    void    SetupMaterialBuffer();
+    void    SetupRTObjectBuffer();
+
+  private:
+    static constexpr TUint32 TYPE_COUNT = 6u;
+
+    std::mutex            m_Mutex = {};
+    TUint64               m_Frame = 0u;
+    TUint64               m_RetiredFrame = UINT64_MAX; // frames up to it finished, none yet
+    BindlessSlotAllocator m_Slots[TYPE_COUNT] = {};
+
+    Vector<std::pair<Handle<HandledObject>, TUint64>> m_Deferred = {}; // [resource, frame that released it]
 
     VkDescriptorPool                                    m_DescriptorPool = VK_NULL_HANDLE;
     std::vector<VkDescriptorSetLayout>                  m_DescriptorLayouts = {};
     std::vector<VkDescriptorSet>                        m_DescriptorSets = {};
     std::unordered_map<BindlessDescriptorType, TUint32> m_DescriptorIndexMap = {};
+    Vector<DescriptorWrite>                             m_PendingWrites = {};
 
     Handle<StructuredUniformBuffer<GPUMaterial>>  m_MaterialBuffer = nullptr;
     Handle<StructuredUniformBuffer<RTObjectDesc>> m_RTObjectDesc = nullptr;
+
+    // streamed textures read the placeholder until they are resident
+    Handle<Texture>                                   m_PlaceholderTexture = nullptr;
+    Vector<std::pair<Handle<Texture>, TextureHandle>> m_PendingTextures = {};
+    UnorderedMap<TextureHandle, TextureHandle>        m_MovedTextures = {};   // [placeholder handle], slot it moved to
+    Vector<GPUMaterial>                               m_Materials = {};       // [material slot], what the buffer holds
+    Vector<TUint32>                                   m_MaterialUpdates = {}; // material slots the next frame writes
   };
 
 } // namespace mau
@@ -1,36 +1,15 @@
 #include "vulkan-buffers.h"
 
+#include <algorithm>
+#include <engine/profiler.h>
+
 #include "vulkan-state.h"
 #include "vulkan-features.h"
+#include "vulkan-upload.h"
 
 namespace mau {
 
-  void UploadUsingStaging(Buffer *dst, const void *data) {
-    ASSERT(dst && data);
-    Buffer staging_buffer(dst->GetSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-
-    void *buffer_mem = staging_buffer.Map();
-    memcpy(buffer_mem, data, dst->GetSize());
-    staging_buffer.UnMap();
-
-    Handle<CommandBuffer> cmd = VulkanState::Ref().GetCommandPool(VK_QUEUE_TRANSFER_BIT)->AllocateCommandBuffers(1)[0];
-    cmd->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-    VkBufferCopy copy_region = {};
-    copy_region.srcOffset = 0u;
-    copy_region.dstOffset = 0u;
-    copy_region.size = dst->GetSize();
-    vkCmdCopyBuffer(cmd->Get(), staging_buffer.Get(), dst->Get(), 1u, &copy_region);
-
-    cmd->End();
-
-    Handle<VulkanQueue> transfer_queue = VulkanState::Ref().GetDeviceHandle()->GetTransferQueue();
-
-    transfer_queue->Submit(cmd);
-    transfer_queue->WaitIdle();
-  }
-
-  Buffer::Buffer(TUint64 buffer_size, VkBufferUsageFlags usage, VmaAllocationCreateFlags memory_flags): m_Size(buffer_size) {
+  Buffer::Buffer(TUint64 buffer_size, VkBufferUsageFlags usage, VmaAllocationCreateFlags memory_flags, TUint64 min_alignment): m_Size(buffer_size) {
     VmaAllocationCreateInfo alloc_info = {};
     alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
     alloc_info.flags = memory_flags;
@@ -55,7 +34,22 @@ namespace mau {
     create_info.queueFamilyIndexCount = 0u;
     create_info.pQueueFamilyIndices = nullptr;
 
-    VK_CALL(vmaCreateBuffer(VulkanState::Ref().GetVulkanMemoryAllocator(), &create_info, &alloc_info, &m_Buffer, &m_Allocation, &m_AllocationInfo));
+    // uploads are copied on the transfer queue, share instead of transferring ownership
+    const VulkanDevice &device = *VulkanState::Ref().GetDeviceHandle();
+    const TUint32       queue_families[] = {device.GetGraphicsQueueIndex(), device.GetTransferQueueIndex()};
+
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && queue_families[0] != queue_families[1]) {
+      create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      create_info.queueFamilyIndexCount = ARRAY_SIZE(queue_families);
+      create_info.pQueueFamilyIndices = queue_families;
+    }
+
+    // buffers are sub-allocated from vma blocks unless dedicated memory is asked for
+    if (min_alignment > 0u) {
+      VK_CALL(vmaCreateBufferWithAlignment(VulkanState::Ref().GetVulkanMemoryAllocator(), &create_info, &alloc_info, min_alignment, &m_Buffer, &m_Allocation, &m_AllocationInfo));
+    } else {
+      VK_CALL(vmaCreateBuffer(VulkanState::Ref().GetVulkanMemoryAllocator(), &create_info, &alloc_info, &m_Buffer, &m_Allocation, &m_AllocationInfo));
+    }
   }
 
   Buffer::~Buffer() {
@@ -78,6 +72,10 @@ namespace mau {
     }
   }
 
+  void Buffer::FlushMapped(TUint64 offset, TUint64 size) { VK_CALL(vmaFlushAllocation(VulkanState::Ref().GetVulkanMemoryAllocator(), m_Allocation, offset, size)); }
+
+  void Buffer::InvalidateMapped(TUint64 offset, TUint64 size) { VK_CALL(vmaInvalidateAllocation(VulkanState::Ref().GetVulkanMemoryAllocator(), m_Allocation, offset, size)); }
+
   VkDeviceAddress Buffer::GetDeviceAddress() {
     if (!VulkanFeatures::IsBufferDeviceAddressEnabled()) {
       LOG_ERROR("calling get buffer device address when feature is not enabled");
@@ -99,28 +97,28 @@ namespace mau {
   VkDeviceMemory Buffer::GetDeviceMemory() { return m_AllocationInfo.deviceMemory; }
 
   VertexBuffer::VertexBuffer(TUint64 buffer_size, const void *data)
-      : Buffer(buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-               VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) {
+      : Buffer(buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR) {
 
     if (data) {
-      UploadUsingStaging(this, data);
+      VulkanState::Ref().GetUploadRing()->EnqueueBuffer(m_Buffer, data, buffer_size);
     }
   }
 
   VertexBuffer::~VertexBuffer() { }
 
   IndexBuffer::IndexBuffer(TUint64 buffer_size, const void *data)
-      : Buffer(buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-               VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) {
+      : Buffer(buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR) {
 
     if (data) {
-      UploadUsingStaging(this, data);
+      VulkanState::Ref().GetUploadRing()->EnqueueBuffer(m_Buffer, data, buffer_size);
     }
   }
 
   IndexBuffer::~IndexBuffer() { }
 
-  UniformBuffer::UniformBuffer(TUint64 buffer_size, const void *data): Buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT) {
+  // transfer dst so entries frames in flight still read can be replaced in order with the queue, see VulkanBindless
+  UniformBuffer::UniformBuffer(TUint64 buffer_size, const void *data)
+      : Buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT) {
 
     Map();
     if (data) {
@@ -177,11 +175,11 @@ namespace mau {
     const TUint32 max_primitive_count = create_info.IndexCount / 3u;
 
     VkDeviceOrHostAddressConstKHR vertex_buffer_address = {
-        .deviceAddress = create_info.Vertices->GetDeviceAddress(),
+        .deviceAddress = create_info.Vertices->GetDeviceAddress() + create_info.VertexOffset,
     };
 
     VkDeviceOrHostAddressConstKHR index_buffer_address = {
-        .deviceAddress = create_info.Indices->GetDeviceAddress(),
+        .deviceAddress = create_info.Indices->GetDeviceAddress() + create_info.IndexOffset,
     };
 
     VkAccelerationStructureGeometryTrianglesDataKHR triangles = {
@@ -236,10 +234,11 @@ namespace mau {
 
     vkGetAccelerationStructureBuildSizesKHR(VulkanState::Ref().GetDevice(), VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &blas_build_info, &max_primitive_count, &blas_size_info);
 
-    Buffer          scratch_buffer(blas_size_info.buildScratchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT);
+    const TUint64   scratch_alignment = VulkanState::Ref().GetAccelerationStructureProperties().minAccelerationStructureScratchOffsetAlignment;
+    Buffer          scratch_buffer(blas_size_info.buildScratchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0u, scratch_alignment);
     VkDeviceAddress scrach_address = scratch_buffer.GetDeviceAddress();
 
-    m_BLASBuffer = make_handle<Buffer>(blas_size_info.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT);
+    m_BLASBuffer = make_handle<Buffer>(blas_size_info.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR);
 
     VkAccelerationStructureCreateInfoKHR blas_create_info = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
@@ -254,6 +253,13 @@ namespace mau {
 
     VK_CALL(vkCreateAccelerationStructureKHR(VulkanState::Ref().GetDevice(), &blas_create_info, nullptr, &m_BLAS));
 
+    VkAccelerationStructureDeviceAddressInfoKHR blas_address_info = {
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
+        .pNext = nullptr,
+        .accelerationStructure = m_BLAS,
+    };
+    m_DeviceAddress = vkGetAccelerationStructureDeviceAddressKHR(VulkanState::Ref().GetDevice(), &blas_address_info);
+
     blas_build_info.dstAccelerationStructure = m_BLAS;
     blas_build_info.scratchData.deviceAddress = scrach_address;
 
@@ -264,148 +270,163 @@ namespace mau {
     vkCmdBuildAccelerationStructuresKHR(cmd->Get(), 1u, &blas_build_info, range_info);
     cmd->End();
 
-    Handle<VulkanQueue> graphics_queue = VulkanState::Ref().GetDeviceHandle()->GetGraphicsQueue();
-    graphics_queue->Submit(cmd);
-    graphics_queue->WaitIdle();
-  }
-
-  AccelerationBuffer::AccelerationBuffer(const Vector<Handle<BottomLevelAS>> &blases) {
-    m_BLASes = blases;
-
-    // build top level accel
-    BuildTLAS();
-  }
+    // vertex and index data may still be in flight on the transfer queue
+    TimelinePoint uploads = VulkanState::Ref().GetUploadRing()->GetPendingPoint(VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR);
 
-  AccelerationBuffer::~AccelerationBuffer() {
-    vkDestroyAccelerationStructureKHR(VulkanState::Ref().GetDevice(), m_TLAS, nullptr);
-    m_TLASBuffer = nullptr;
+    const Handle<VulkanQueue> &graphics_queue = VulkanState::Ref().GetDeviceHandle()->GetGraphicsQueue();
+    graphics_queue->Submit(cmd, uploads, {});
+    graphics_queue->WaitIdle();
   }
 
-  void AccelerationBuffer::BuildTLAS(Handle<CommandBuffer> in_cmd, bool update, glm::mat4 transform) {
-    const TUint32 max_primitive_count = static_cast<TUint32>(m_BLASes.size());
-
-    if (m_InstanceBuffer == nullptr) {
-      m_InstanceBuffer = make_handle<Buffer>(sizeof(VkAccelerationStructureInstanceKHR) * max_primitive_count, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-                                             VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    }
-
-    VkTransformMatrixKHR transform_matrix = {
-        transform[0][0], transform[1][0], transform[2][0], transform[3][0], transform[0][1], transform[1][1],
-        transform[2][1], transform[3][1], transform[0][2], transform[1][2], transform[2][2], transform[3][2],
-    };
-
-    Vector<VkAccelerationStructureInstanceKHR> accel_instances = {};
-
-    for (TUint32 i = 0; i < max_primitive_count; i++) {
-      Handle<BottomLevelAS> blas = m_BLASes[i];
-
-      VkAccelerationStructureDeviceAddressInfoKHR blas_address_info = {
-          .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
-          .pNext = nullptr,
-          .accelerationStructure = blas->GetBLAS(),
-      };
-
-      VkDeviceAddress blas_address = vkGetAccelerationStructureDeviceAddressKHR(VulkanState::Ref().GetDevice(), &blas_address_info);
+  // a refit keeps the bvh of the first build and gets slower to trace as instances move away from it
+  constexpr TUint32 TLAS_MAX_REFITS = 128u;
 
-      VkAccelerationStructureInstanceKHR tlas_instance = {
-          .transform = transform_matrix,
-          .instanceCustomIndex = blas->GetCustomIndex(),
-          .mask = 0xff,
-          .instanceShaderBindingTableRecordOffset = 0u,
-          .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
-          .accelerationStructureReference = blas_address,
-      };
-
-      accel_instances.push_back(tlas_instance);
-    }
-
-    void *instance_buffer_mem = m_InstanceBuffer->Map();
-    memcpy(instance_buffer_mem, accel_instances.data(), accel_instances.size() * sizeof(accel_instances[0]));
-    m_InstanceBuffer->UnMap();
-
-    VkDeviceOrHostAddressConstKHR instance_buffer_address = {
-        .deviceAddress = m_InstanceBuffer->GetDeviceAddress(),
-    };
-
-    VkAccelerationStructureGeometryInstancesDataKHR instances = {
+  static VkAccelerationStructureGeometryKHR tlas_geometry(VkDeviceAddress instances) {
+    VkAccelerationStructureGeometryInstancesDataKHR instances_data = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
         .pNext = nullptr,
         .arrayOfPointers = VK_FALSE,
-        .data = instance_buffer_address,
-    };
-
-    VkAccelerationStructureGeometryDataKHR geometry_data = {
-        .instances = instances,
+        .data = {.deviceAddress = instances},
     };
 
     VkAccelerationStructureGeometryKHR geometry = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
         .pNext = nullptr,
         .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
-        .geometry = geometry_data,
+        .geometry = {.instances = instances_data},
         .flags = VK_GEOMETRY_OPAQUE_BIT_KHR,
     };
+    return geometry;
+  }
+
+  static void memory_barrier(Handle<CommandBuffer> cmd, VkPipelineStageFlags src_stages, VkAccessFlags src_access, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access) {
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+    };
+    vkCmdPipelineBarrier(cmd->Get(), src_stages, dst_stages, 0u, 1u, &barrier, 0u, nullptr, 0u, nullptr);
+  }
+
+  TopLevelAS::TopLevelAS(TUint32 capacity, TUint32 staging_count): m_Capacity(std::max(capacity, 1u)) {
+    const TUint64 instances_size = sizeof(VkAccelerationStructureInstanceKHR) * static_cast<TUint64>(m_Capacity);
+
+    for (TUint32 i = 0; i < std::max(staging_count, 1u); i++) {
+      Handle<Buffer> staging = make_handle<Buffer>(instances_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+      staging->Map();
+      m_StagingBuffers.push_back(staging);
+    }
+
+    m_InstanceBuffer = make_handle<Buffer>(instances_size, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    const VkAccelerationStructureGeometryKHR geometry = tlas_geometry(m_InstanceBuffer->GetDeviceAddress());
 
     VkAccelerationStructureBuildGeometryInfoKHR tlas_build_info = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
         .pNext = nullptr,
         .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-        .flags = VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
-        .mode = update ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-        .srcAccelerationStructure = VK_NULL_HANDLE,
-        .dstAccelerationStructure = VK_NULL_HANDLE,
+        .flags = VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
+        .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
         .geometryCount = 1u,
         .pGeometries = &geometry,
-        .ppGeometries = nullptr,
-        .scratchData = {.hostAddress = nullptr},
     };
 
     VkAccelerationStructureBuildSizesInfoKHR tlas_size_info = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
     };
 
-    vkGetAccelerationStructureBuildSizesKHR(VulkanState::Ref().GetDevice(), VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &tlas_build_info, &max_primitive_count, &tlas_size_info);
+    // sized for the capacity, builds with fewer instances fit
+    vkGetAccelerationStructureBuildSizesKHR(VulkanState::Ref().GetDevice(), VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &tlas_build_info, &m_Capacity, &tlas_size_info);
 
-    if (m_TLASScratchBuffer == nullptr || m_TLASScratchBuffer->GetSize() != tlas_size_info.buildScratchSize) {
-      m_TLASScratchBuffer = make_handle<Buffer>(tlas_size_info.buildScratchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT);
-    }
+    const TUint64 scratch_alignment = VulkanState::Ref().GetAccelerationStructureProperties().minAccelerationStructureScratchOffsetAlignment;
+    const TUint64 scratch_size = std::max(tlas_size_info.buildScratchSize, tlas_size_info.updateScratchSize);
+    m_ScratchBuffer = make_handle<Buffer>(scratch_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 0u, scratch_alignment);
+
+    m_TLASBuffer = make_handle<Buffer>(tlas_size_info.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR);
+    VkAccelerationStructureCreateInfoKHR tlas_create_info = {
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
+        .pNext = nullptr,
+        .createFlags = 0u,
+        .buffer = m_TLASBuffer->Get(),
+        .offset = 0u,
+        .size = tlas_size_info.accelerationStructureSize,
+        .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+        .deviceAddress = 0u,
+    };
 
-    VkDeviceAddress scrach_address = m_TLASScratchBuffer->GetDeviceAddress();
-
-    if (update == false) {
-      m_TLASBuffer = make_handle<Buffer>(tlas_size_info.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT);
-      VkAccelerationStructureCreateInfoKHR tlas_create_info = {
-          .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
-          .pNext = nullptr,
-          .createFlags = 0u,
-          .buffer = m_TLASBuffer->Get(),
-          .offset = 0u,
-          .size = tlas_size_info.accelerationStructureSize,
-          .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-          .deviceAddress = 0u,
-      };
-
-      VK_CALL(vkCreateAccelerationStructureKHR(VulkanState::Ref().GetDevice(), &tlas_create_info, nullptr, &m_TLAS));
+    VK_CALL(vkCreateAccelerationStructureKHR(VulkanState::Ref().GetDevice(), &tlas_create_info, nullptr, &m_TLAS));
+  }
+
+  TopLevelAS::~TopLevelAS() {
+    vkDestroyAccelerationStructureKHR(VulkanState::Ref().GetDevice(), m_TLAS, nullptr);
+    m_TLASBuffer = nullptr;
+  }
+
+  void TopLevelAS::Record(Handle<CommandBuffer> cmd, TUint32 staging_index, const TLASInstanceTable &table, const TLASInstanceChanges &changes) {
+    MAU_PROFILE_SCOPE("TopLevelAS::Record");
+
+    const TUint32 count = table.GetCount();
+    ASSERT(Fits(count));
+
+    const bool rebuild = changes.Rebuild || count != m_BuiltCount || m_RefitCount >= TLAS_MAX_REFITS;
+    // the barrier after the last build still makes it visible to the trace
+    if (!rebuild && changes.Ranges.empty())
+      return;
+
+    if (!changes.Ranges.empty()) {
+      // the staging buffer of this frame mirrors the table, only changed records are written and copied
+      Handle<Buffer> staging = m_StagingBuffers[staging_index % m_StagingBuffers.size()];
+      char          *mapped = reinterpret_cast<char *>(staging->Map());
+
+      const TUint64        record_size = sizeof(VkAccelerationStructureInstanceKHR);
+      Vector<VkBufferCopy> regions = {};
+      regions.reserve(changes.Ranges.size());
+      for (const TLASInstanceRange &range : changes.Ranges) {
+        const TUint64 offset = range.First * record_size;
+        const TUint64 size = range.Count * record_size;
+        memcpy(mapped + offset, table.GetInstances() + range.First, size);
+        staging->FlushMapped(offset, size);
+        regions.push_back({.srcOffset = offset, .dstOffset = offset, .size = size});
+      }
+
+      // the previous build may still read the records that are overwritten
+      memory_barrier(cmd, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, 0u, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+      vkCmdCopyBuffer(cmd->Get(), staging->Get(), m_InstanceBuffer->Get(), static_cast<TUint32>(regions.size()), regions.data());
     }
 
-    tlas_build_info.srcAccelerationStructure = update ? m_TLAS : VK_NULL_HANDLE;
-    tlas_build_info.dstAccelerationStructure = m_TLAS;
-    tlas_build_info.scratchData.deviceAddress = scrach_address;
+    // instances were copied, the last build wrote the scratch memory and the last trace read the tlas that is replaced
+    memory_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                   VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                   VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
 
-    VkAccelerationStructureBuildRangeInfoKHR  build_offset = {max_primitive_count, 0u, 0u, 0u};
-    VkAccelerationStructureBuildRangeInfoKHR *range_info[] = {&build_offset};
+    const VkAccelerationStructureGeometryKHR geometry = tlas_geometry(m_InstanceBuffer->GetDeviceAddress());
 
-    Handle<CommandBuffer> cmd = VulkanState::Ref().GetCommandPool(VK_QUEUE_GRAPHICS_BIT)->AllocateCommandBuffers(1)[0];
+    // refits are in place, src and dst are the same tlas
+    VkAccelerationStructureBuildGeometryInfoKHR tlas_build_info = {
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+        .pNext = nullptr,
+        .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+        .flags = VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
+        .mode = rebuild ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR,
+        .srcAccelerationStructure = rebuild ? VK_NULL_HANDLE : m_TLAS,
+        .dstAccelerationStructure = m_TLAS,
+        .geometryCount = 1u,
+        .pGeometries = &geometry,
+        .ppGeometries = nullptr,
+        .scratchData = {.deviceAddress = m_ScratchBuffer->GetDeviceAddress()},
+    };
 
-    cmd->Begin();
+    VkAccelerationStructureBuildRangeInfoKHR  build_offset = {count, 0u, 0u, 0u};
+    VkAccelerationStructureBuildRangeInfoKHR *range_info[] = {&build_offset};
     vkCmdBuildAccelerationStructuresKHR(cmd->Get(), 1u, &tlas_build_info, range_info);
-    cmd->End();
 
-    Handle<VulkanQueue> graphics_queue = VulkanState::Ref().GetDeviceHandle()->GetGraphicsQueue();
-    graphics_queue->Submit(cmd);
-    graphics_queue->WaitIdle();
-  }
+    // the trace has to wait for the build
+    memory_barrier(cmd, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                   VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
 
-  void AccelerationBuffer::UpdateTransform(const glm::mat4 &transform, Handle<CommandBuffer> cmd) { BuildTLAS(cmd, true, transform); }
+    m_RefitCount = rebuild ? 0u : m_RefitCount + 1u;
+    m_BuiltCount = count;
+  }
 
 } // namespace mau
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include "common.h"
+#include "tlas-instance-table.h"
 
 namespace mau {
 
@@ -9,12 +10,15 @@ namespace mau {
 
   class Buffer: public HandledObject {
   public:
-    Buffer(TUint64 buffer_size, VkBufferUsageFlags usage, VmaAllocationCreateFlags memory_flags = 0u);
+    Buffer(TUint64 buffer_size, VkBufferUsageFlags usage, VmaAllocationCreateFlags memory_flags = 0u, TUint64 min_alignment = 0u);
     virtual ~Buffer();
 
   public:
     void           *Map();
     void            UnMap();
+    void            FlushMapped(TUint64 offset, TUint64 size);
+    // before the host reads what the device wrote into non coherent memory
+    void            InvalidateMapped(TUint64 offset, TUint64 size);
     VkDeviceAddress GetDeviceAddress();
     VkDeviceMemory  GetDeviceMemory();
 
@@ -59,9 +63,12 @@ namespace mau {
 
   // acceleration structure for ray tracing
 
+  // vertices and indices may be ranges of shared buffers, offsets are in bytes
   struct AccelerationBufferCreateInfo {
-    Handle<VertexBuffer> Vertices = nullptr;
-    Handle<IndexBuffer>  Indices = nullptr;
+    Handle<Buffer>       Vertices = nullptr;
+    Handle<Buffer>       Indices = nullptr;
+    TUint64              VertexOffset = 0u;
+    TUint64              IndexOffset = 0u;
     TUint32              VertexSize = 0u;
     TUint32              PositionOffset = 0u;
     TUint32              VertexCount = 0u;
@@ -77,38 +84,47 @@ namespace mau {
   public:
     inline VkAccelerationStructureKHR GetBLAS() const { return m_BLAS; }
     inline TUint32                    GetCustomIndex() const { return m_CustomIndex; }
+    inline VkDeviceAddress            GetDeviceAddress() const { return m_DeviceAddress; }
 
   private:
     void BuildBLAS(const AccelerationBufferCreateInfo &create_info);
 
   private:
-    Handle<VertexBuffer>       m_VertexBuffer = nullptr;
-    Handle<IndexBuffer>        m_IndexBufffer = nullptr;
+    Handle<Buffer>             m_VertexBuffer = nullptr;
+    Handle<Buffer>             m_IndexBufffer = nullptr;
     Handle<Buffer>             m_BLASBuffer = nullptr;
     VkAccelerationStructureKHR m_BLAS = VK_NULL_HANDLE;
+    VkDeviceAddress            m_DeviceAddress = 0u;
     TUint32                    m_CustomIndex = 0u;
   };
 
-  class AccelerationBuffer: public HandledObject {
+  // the scene tlas, built from a TLASInstanceTable inside the frame command buffer. only changed instance records are
+  // copied from a staging buffer of the frame, transform changes refit the tlas and structural ones rebuild it
+  class TopLevelAS: public HandledObject {
   public:
-    AccelerationBuffer(const Vector<Handle<BottomLevelAS>> &blases);
-    ~AccelerationBuffer();
+    // capacity is the most instances it can hold, one staging buffer per frame that can be recorded at once
+    TopLevelAS(TUint32 capacity, TUint32 staging_count);
+    ~TopLevelAS();
 
   public:
-    void UpdateTransform(const glm::mat4 &transform, Handle<CommandBuffer> cmd);
+    // copies the changes into the staging buffer, records the upload, the build and the barriers in front of the
+    // trace. the table must fit the capacity
+    void Record(Handle<CommandBuffer> cmd, TUint32 staging_index, const TLASInstanceTable &table, const TLASInstanceChanges &changes);
 
-  public:
     inline VkAccelerationStructureKHR GetTLAS() const { return m_TLAS; }
+    inline TUint32                    GetCapacity() const { return m_Capacity; }
+    inline bool                       Fits(TUint32 count) const { return count <= m_Capacity; }
 
   private:
-    void BuildTLAS(Handle<CommandBuffer> cmd = nullptr, bool update = false, glm::mat4 transform = glm::mat4(1.0f));
-
-  private:
-    Vector<Handle<BottomLevelAS>> m_BLASes = {};
-    Handle<Buffer>                m_TLASBuffer = nullptr;
-    Handle<Buffer>                m_InstanceBuffer = nullptr;
-    Handle<Buffer>                m_TLASScratchBuffer = nullptr;
-    VkAccelerationStructureKHR    m_TLAS = VK_NULL_HANDLE;
+    Vector<Handle<Buffer>>     m_StagingBuffers = {};
+    Handle<Buffer>             m_InstanceBuffer = nullptr;
+    Handle<Buffer>             m_TLASBuffer = nullptr;
+    Handle<Buffer>             m_ScratchBuffer = nullptr;
+    VkAccelerationStructureKHR m_TLAS = VK_NULL_HANDLE;
+    TUint32                    m_Capacity = 0u;
+    // instances of the last build, a refit has to keep the count
+    TUint32                    m_BuiltCount = UINT32_MAX;
+    TUint32                    m_RefitCount = 0u;
   };
 
   // templated uniform buffer
@@ -12,12 +12,12 @@ namespace mau {
 
   CommandBuffer::~CommandBuffer() { vkFreeCommandBuffers(VulkanState::Ref().GetDevice(), m_CommandPool, 1, &m_CommandBuffer); }
 
-  void CommandBuffer::Begin(VkCommandBufferUsageFlags flags) {
+  void CommandBuffer::Begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo *inheritance) {
     VkCommandBufferBeginInfo begin_info = {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     begin_info.pNext = nullptr;
     begin_info.flags = flags;
-    begin_info.pInheritanceInfo = nullptr;
+    begin_info.pInheritanceInfo = inheritance;
 
     VK_CALL(vkBeginCommandBuffer(m_CommandBuffer, &begin_info));
   }
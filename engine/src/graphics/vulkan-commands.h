@@ -15,7 +15,8 @@ namespace mau {
     ~CommandBuffer();
 
   public:
-    void Begin(VkCommandBufferUsageFlags flags = 0u);
+    // secondary command buffers pass the renderpass they continue through inheritance
+    void Begin(VkCommandBufferUsageFlags flags = 0u, const VkCommandBufferInheritanceInfo *inheritance = nullptr);
     void End();
     void Reset();
 
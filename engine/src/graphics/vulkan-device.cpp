@@ -9,7 +9,6 @@ namespace mau {
 
   VulkanDevice::VulkanDevice(VkPhysicalDevice physical_device, VkSurfaceKHR surface): m_PhysicalDevice(physical_device), m_Surface(surface) {
     ASSERT(m_PhysicalDevice != VK_NULL_HANDLE);
-    ASSERT(m_Surface != VK_NULL_HANDLE);
 
     // get features
     vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &m_PhysicalDeviceFeatures);
@@ -17,12 +16,26 @@ namespace mau {
 
     m_EnabledDeviceFeatures.samplerAnisotropy = VK_TRUE;
     m_EnabledDeviceFeatures.shaderInt64 = VK_TRUE;
+    m_EnabledDeviceFeatures.textureCompressionBC = m_PhysicalDeviceFeatures.textureCompressionBC;
+    m_EnabledDeviceFeatures.multiDrawIndirect = m_PhysicalDeviceFeatures.multiDrawIndirect;
+    m_EnabledDeviceFeatures.drawIndirectFirstInstance = m_PhysicalDeviceFeatures.drawIndirectFirstInstance;
+
+    // gpu culling writes its draw counts on the device, without it the cpu keeps culling
+    VkPhysicalDeviceVulkan12Features supported_vulkan12_features = {};
+    supported_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supported_features = {};
+    supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported_features.pNext = &supported_vulkan12_features;
+    vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supported_features);
+    m_DrawIndirectCount = supported_vulkan12_features.drawIndirectCount == VK_TRUE;
 
     // TODO: check before enabling
     VkPhysicalDeviceAccelerationStructureFeaturesKHR accel_features = {};
     accel_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
     accel_features.pNext = nullptr;
     accel_features.accelerationStructure = VK_TRUE;
+    accel_features.descriptorBindingAccelerationStructureUpdateAfterBind = VK_TRUE;
 
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR rt_features = {};
     rt_features.pNext = &accel_features;
@@ -41,8 +54,12 @@ namespace mau {
     vulkan12_features.descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE;
     vulkan12_features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
     vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    vulkan12_features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+    vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
     vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
     vulkan12_features.scalarBlockLayout = VK_TRUE;
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+    vulkan12_features.drawIndirectCount = m_DrawIndirectCount ? VK_TRUE : VK_FALSE;
 
     // buffer device address
     vulkan12_features.bufferDeviceAddress = VK_TRUE;
@@ -76,13 +93,16 @@ namespace mau {
       m_TransferQueueIndex = (m_TransferQueueIndex == UINT32_MAX || m_TransferQueueIndex == m_GraphicsQueueIndex) && hasQueueFamily(queue_families[i], VK_QUEUE_TRANSFER_BIT) ? static_cast<TUint32>(i)
                                                                                                                                                                               : m_TransferQueueIndex;
 
+      if (m_Surface == VK_NULL_HANDLE)
+        continue;
+
       VkBool32 present_support = VK_FALSE;
       VK_CALL(vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice, i, m_Surface, &present_support));
       m_PresentQueueIndex = m_PresentQueueIndex == UINT32_MAX && present_support == VK_TRUE ? static_cast<TUint32>(i) : m_PresentQueueIndex;
     }
 
     // create devcice and queues
-    if (!EnableDeviceExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
+    if (m_Surface != VK_NULL_HANDLE && !EnableDeviceExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
       throw GraphicsException("failed to enable swapchain extension");
     }
 
@@ -94,7 +114,10 @@ namespace mau {
     EnableDeviceExtension(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
 #endif
 
-    std::set<TUint32> queue_indices = {m_GraphicsQueueIndex, m_TransferQueueIndex, m_PresentQueueIndex};
+    std::set<TUint32> queue_indices = {m_GraphicsQueueIndex, m_TransferQueueIndex};
+    if (m_PresentQueueIndex != UINT32_MAX) {
+      queue_indices.insert(m_PresentQueueIndex);
+    }
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_info(queue_indices.size());
     float                                queue_priority = 1.0f;
@@ -130,20 +153,28 @@ namespace mau {
     // get queue handles
     VkQueue graphics_queue = VK_NULL_HANDLE;
     VkQueue transfer_queue = VK_NULL_HANDLE;
-    VkQueue present_queue = VK_NULL_HANDLE;
     vkGetDeviceQueue(m_Device, m_GraphicsQueueIndex, 0, &graphics_queue);
     vkGetDeviceQueue(m_Device, m_TransferQueueIndex, 0, &transfer_queue);
-    vkGetDeviceQueue(m_Device, m_PresentQueueIndex, 0, &present_queue);
 
-    m_GraphicsQueue = make_handle<VulkanQueue>(graphics_queue, m_Device);
-    m_TransferQueue = make_handle<VulkanQueue>(transfer_queue, m_Device);
-    m_PresentQueue = make_handle<PresentQueue>(present_queue, m_Device);
+    m_GraphicsQueue = make_handle<VulkanQueue>(graphics_queue, m_Device, &m_QueueMutex);
+    m_TransferQueue = make_handle<VulkanQueue>(transfer_queue, m_Device, &m_QueueMutex);
+
+    if (m_PresentQueueIndex != UINT32_MAX) {
+      VkQueue present_queue = VK_NULL_HANDLE;
+      vkGetDeviceQueue(m_Device, m_PresentQueueIndex, 0, &present_queue);
+      m_PresentQueue = make_handle<PresentQueue>(present_queue, m_Device, &m_QueueMutex);
+    }
 
     LOG_INFO("vulkan logical device created");
   }
 
   VulkanDevice::~VulkanDevice() { vkDestroyDevice(m_Device, nullptr); }
 
+  bool VulkanDevice::WaitIdle() {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    return vkDeviceWaitIdle(m_Device) == VK_SUCCESS;
+  }
+
   bool VulkanDevice::EnableDeviceExtension(std::string_view extension_name) noexcept {
     if (m_Device != VK_NULL_HANDLE) {
       LOG_ERROR("cannot enable device extension [%s]: device already created", extension_name.data());
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include <string_view>
 #include <engine/enums.h>
@@ -14,19 +15,27 @@ namespace mau {
 
   class VulkanDevice: public HandledObject {
   public:
+    // without a surface there is no present queue and the swapchain extension is not required
     VulkanDevice(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
     ~VulkanDevice();
 
   public:
     bool EnableDeviceExtension(std::string_view extension_name) noexcept;
+    // waits with every queue locked, the render thread and the main thread both submit. false once the device is lost,
+    // shutting down after a failed frame still gets through it
+    bool WaitIdle();
 
-    inline VkDevice             GetDevice() const noexcept { return m_Device; }
-    inline TUint32              GetGraphicsQueueIndex() const noexcept { return m_GraphicsQueueIndex; }
-    inline TUint32              GetTransferQueueIndex() const noexcept { return m_TransferQueueIndex; }
-    inline TUint32              GetPresentQueueIndex() const noexcept { return m_PresentQueueIndex; }
-    inline Handle<VulkanQueue>  GetGraphicsQueue() const noexcept { return m_GraphicsQueue; }
-    inline Handle<VulkanQueue>  GetTransferQueue() const noexcept { return m_TransferQueue; }
-    inline Handle<PresentQueue> GetPresentQueue() const noexcept { return m_PresentQueue; }
+    inline VkDevice                    GetDevice() const noexcept { return m_Device; }
+    inline TUint32                     GetGraphicsQueueIndex() const noexcept { return m_GraphicsQueueIndex; }
+    inline TUint32                     GetTransferQueueIndex() const noexcept { return m_TransferQueueIndex; }
+    inline TUint32                     GetPresentQueueIndex() const noexcept { return m_PresentQueueIndex; }
+    inline const Handle<VulkanQueue>  &GetGraphicsQueue() const noexcept { return m_GraphicsQueue; }
+    inline const Handle<VulkanQueue>  &GetTransferQueue() const noexcept { return m_TransferQueue; }
+    inline const Handle<PresentQueue> &GetPresentQueue() const noexcept { return m_PresentQueue; }
+    inline bool                        IsPresentSupported() const noexcept { return m_PresentQueue != nullptr; }
+    inline bool                        IsTextureCompressionBCEnabled() const noexcept { return m_EnabledDeviceFeatures.textureCompressionBC == VK_TRUE; }
+    inline bool                        IsMultiDrawIndirectEnabled() const noexcept { return m_EnabledDeviceFeatures.multiDrawIndirect == VK_TRUE && m_EnabledDeviceFeatures.drawIndirectFirstInstance == VK_TRUE; }
+    inline bool                        IsDrawIndirectCountEnabled() const noexcept { return m_DrawIndirectCount && IsMultiDrawIndirectEnabled(); }
 
   private:
     VkPhysicalDevice         m_PhysicalDevice = VK_NULL_HANDLE;
@@ -34,6 +43,7 @@ namespace mau {
     VkDevice                 m_Device = VK_NULL_HANDLE;
     VkPhysicalDeviceFeatures m_EnabledDeviceFeatures = {};
     VkPhysicalDeviceFeatures m_PhysicalDeviceFeatures = {};
+    bool                     m_DrawIndirectCount = false;
 
     std::vector<VkLayerProperties>     m_AvailableDeviceLayers = {};
     std::vector<VkExtensionProperties> m_AvailableDeviceExtensions = {};
@@ -48,6 +58,9 @@ namespace mau {
     Handle<VulkanQueue>  m_GraphicsQueue = nullptr;
     Handle<VulkanQueue>  m_TransferQueue = nullptr;
     Handle<PresentQueue> m_PresentQueue = nullptr;
+
+    // queues can share a VkQueue, submits, presents and waits on any of them are serialized
+    std::mutex m_QueueMutex = {};
   };
 
 } // namespace mau
@@ -4,23 +4,44 @@
 
 #include "vulkan-state.h"
 #include "vulkan-buffers.h"
+#include "vulkan-upload.h"
 #include "../loader/image-loader.h"
 
 namespace mau {
 
-  void TransitionImageLayout(Handle<CommandBuffer> cmd, Handle<Image> image, VkImageLayout old_layout, VkImageLayout new_layout) {
+  static constexpr VkPipelineStageFlags SHADER_STAGES = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+  static VkAccessFlags layout_access(VkImageLayout layout, VkPipelineStageFlags stages) {
+    switch (layout) {
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+      return (stages & (VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)) ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_NONE;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+      return (stages & (VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)) ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_NONE;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+      return (stages & SHADER_STAGES) ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_NONE;
+    case VK_IMAGE_LAYOUT_GENERAL:
+      return (stages & SHADER_STAGES) ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_NONE;
+    default:
+      return VK_ACCESS_NONE;
+    }
+  }
+
+  void TransitionImageLayout(Handle<CommandBuffer> cmd, Handle<Image> image, VkImageLayout old_layout, VkImageLayout new_layout, VkPipelineStageFlags src_stages,
+                             VkPipelineStageFlags dst_stages) {
     VkImageSubresourceRange subresource = {};
     subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     subresource.baseMipLevel = 0u;
-    subresource.levelCount = 1u;
+    subresource.levelCount = image->GetMipLevels();
     subresource.baseArrayLayer = 0u;
     subresource.layerCount = 1u;
 
+    // only writes have to be made available, what was read before just has to finish
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.pNext = nullptr;
-    barrier.srcAccessMask = VK_ACCESS_NONE;
-    barrier.dstAccessMask = VK_ACCESS_NONE;
+    barrier.srcAccessMask = layout_access(old_layout, src_stages) & (VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    barrier.dstAccessMask = layout_access(new_layout, dst_stages);
     barrier.oldLayout = old_layout;
     barrier.newLayout = new_layout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -28,33 +49,10 @@ namespace mau {
     barrier.image = image->GetImage();
     barrier.subresourceRange = subresource;
 
-    switch (old_layout) {
-    case VK_IMAGE_LAYOUT_UNDEFINED:
-      break;
-    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-      break;
-    default:
-      break;
-    }
-
-    switch (new_layout) {
-    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-      break;
-    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-      if (barrier.srcAccessMask == VK_ACCESS_NONE) {
-        barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
-      }
-      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    default:
-      break;
-    }
-
-    vkCmdPipelineBarrier(cmd->Get(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+    vkCmdPipelineBarrier(cmd->Get(), src_stages, dst_stages, 0u, 0u, nullptr, 0u, nullptr, 1u, &barrier);
   }
 
-  void CopyBufferToImage(Handle<CommandBuffer> cmd, Buffer *buffer, Handle<Image> image, TUint32 width, TUint32 height) {
+  void CopyBufferToImage(Handle<CommandBuffer> cmd, VkBuffer buffer, TUint64 buffer_offset, Handle<Image> image, TUint32 width, TUint32 height, TUint32 mip_level) {
     VkExtent3D extent = {
         .width = width,
         .height = height,
@@ -69,13 +67,13 @@ namespace mau {
 
     VkImageSubresourceLayers subresource = {
         .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel = 0u,
+        .mipLevel = mip_level,
         .baseArrayLayer = 0u,
         .layerCount = 1u,
     };
 
     VkBufferImageCopy region = {
-        .bufferOffset = 0u,
+        .bufferOffset = buffer_offset,
         .bufferRowLength = 0u,
         .bufferImageHeight = 0u,
         .imageSubresource = subresource,
@@ -83,36 +81,12 @@ namespace mau {
         .imageExtent = extent,
     };
 
-    vkCmdCopyBufferToImage(cmd->Get(), buffer->Get(), image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-  }
-
-  void UploadUsingStaging(Handle<Image> image, const void *data, TUint32 width, TUint32 height, TUint32 channels) {
-    ASSERT(image && data);
-
-    TUint64 image_size = static_cast<TUint64>(width) * static_cast<TUint64>(height) * static_cast<TUint64>(channels);
-
-    Buffer staging_buffer(image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-
-    void *buffer_mem = staging_buffer.Map();
-    memcpy(buffer_mem, data, image_size);
-    staging_buffer.UnMap();
-
-    Handle<CommandBuffer> cmd = VulkanState::Ref().GetCommandPool(VK_QUEUE_TRANSFER_BIT)->AllocateCommandBuffers(1)[0];
-
-    cmd->Begin();
-    TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(cmd, &staging_buffer, image, width, height);
-    TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    cmd->End();
-
-    Handle<VulkanQueue> transfer_queue = VulkanState::Ref().GetDeviceHandle()->GetTransferQueue();
-    transfer_queue->Submit(cmd);
-    transfer_queue->WaitIdle();
+    vkCmdCopyBufferToImage(cmd->Get(), buffer, image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
   }
 
   Image::Image(TUint32 width, TUint32 height, TUint32 depth, TUint32 mip_levels, TUint32 array_layers, VkImageType type, VkSampleCountFlagBits samples, VkFormat format, VkImageTiling tiling,
                VkImageUsageFlags usage)
-      : m_Format(format), m_SampleCount(samples), m_Width(width), m_Height(height) {
+      : m_Format(format), m_SampleCount(samples), m_Width(width), m_Height(height), m_MipLevels(mip_levels) {
     VmaAllocationCreateInfo alloc_info = {};
     alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
     alloc_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
@@ -142,6 +116,17 @@ namespace mau {
     create_info.pQueueFamilyIndices = nullptr;
     create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+    // sampled images are uploaded on the transfer queue, attachments stay exclusive
+    const VulkanDevice &device = *VulkanState::Ref().GetDeviceHandle();
+    const TUint32       queue_families[] = {device.GetGraphicsQueueIndex(), device.GetTransferQueueIndex()};
+    const bool          is_attachment = usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+    if ((usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) && !is_attachment && queue_families[0] != queue_families[1]) {
+      create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      create_info.queueFamilyIndexCount = ARRAY_SIZE(queue_families);
+      create_info.pQueueFamilyIndices = queue_families;
+    }
+
     VK_CALL(vmaCreateImage(VulkanState::Ref().GetVulkanMemoryAllocator(), &create_info, &alloc_info, &m_Image, &m_Allocation, nullptr));
   }
 
@@ -150,20 +135,74 @@ namespace mau {
     ASSERT(m_Image != VK_NULL_HANDLE);
   }
 
+  Image::Image(const VkImageCreateInfo &create_info, Handle<ImageMemory> memory, TUint64 offset)
+      : m_Memory(memory), m_Format(create_info.format), m_SampleCount(create_info.samples), m_Width(create_info.extent.width), m_Height(create_info.extent.height),
+        m_MipLevels(create_info.mipLevels) {
+    ASSERT(memory != nullptr);
+    VK_CALL(vkCreateImage(VulkanState::Ref().GetDevice(), &create_info, nullptr, &m_Image));
+    VK_CALL(vmaBindImageMemory2(VulkanState::Ref().GetVulkanMemoryAllocator(), memory->GetAllocation(), offset, m_Image, nullptr));
+  }
+
   Image::~Image() {
     if (m_Allocation)
       vmaDestroyImage(VulkanState::Ref().GetVulkanMemoryAllocator(), m_Image, m_Allocation);
+    else if (m_Memory)
+      vkDestroyImage(VulkanState::Ref().GetDevice(), m_Image, nullptr);
+  }
+
+  // image memory
+  ImageMemory::ImageMemory(TUint64 size, TUint32 memory_type): m_Size(size), m_MemoryType(memory_type) {
+    const VkMemoryRequirements requirements = {
+        .size = size,
+        .alignment = 1u,
+        .memoryTypeBits = 1u << memory_type,
+    };
+
+    VmaAllocationCreateInfo alloc_info = {};
+    alloc_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    alloc_info.memoryTypeBits = 1u << memory_type;
+
+    VK_CALL(vmaAllocateMemory(VulkanState::Ref().GetVulkanMemoryAllocator(), &requirements, &alloc_info, &m_Allocation, nullptr));
+  }
+
+  ImageMemory::~ImageMemory() { vmaFreeMemory(VulkanState::Ref().GetVulkanMemoryAllocator(), m_Allocation); }
+
+  void GetImageMemoryRequirements(const VkImageCreateInfo &create_info, VkMemoryRequirements &requirements, TUint32 &memory_type) {
+    const VkDeviceImageMemoryRequirements info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+        .pNext = nullptr,
+        .pCreateInfo = &create_info,
+        .planeAspect = static_cast<VkImageAspectFlagBits>(0),
+    };
+
+    VkMemoryRequirements2 requirements2 = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = nullptr,
+    };
+    vkGetDeviceImageMemoryRequirements(VulkanState::Ref().GetDevice(), &info, &requirements2);
+    requirements = requirements2.memoryRequirements;
+
+    VmaAllocationCreateInfo alloc_info = {};
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    VK_CALL(vmaFindMemoryTypeIndex(VulkanState::Ref().GetVulkanMemoryAllocator(), requirements.memoryTypeBits, &alloc_info, &memory_type));
   }
 
   ImageView::ImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask) { CreateImageView(image, format, view_type, aspect_mask); }
 
-  ImageView::ImageView(Handle<Image> image, VkImageViewType view_type, VkImageAspectFlags aspect_mask) { CreateImageView(image->GetImage(), image->GetFormat(), view_type, aspect_mask); }
+  ImageView::ImageView(Handle<Image> image, VkImageViewType view_type, VkImageAspectFlags aspect_mask) {
+    CreateImageView(image->GetImage(), image->GetFormat(), view_type, aspect_mask, image->GetMipLevels());
+  }
+
+  ImageView::ImageView(Handle<Image> image, VkImageViewType view_type, VkImageAspectFlags aspect_mask, TUint32 mip_level) {
+    ASSERT(mip_level < image->GetMipLevels());
+    CreateImageView(image->GetImage(), image->GetFormat(), view_type, aspect_mask, 1u, mip_level);
+  }
 
   ImageView::ImageView(const ImageView &other) { m_ImageView = other.m_ImageView; }
 
   ImageView::~ImageView() { vkDestroyImageView(VulkanState::Ref().GetDevice(), m_ImageView, nullptr); }
 
-  void ImageView::CreateImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask) {
+  void ImageView::CreateImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask, TUint32 mip_levels, TUint32 base_mip_level) {
     ASSERT(image != VK_NULL_HANDLE);
 
     VkImageViewCreateInfo create_info = {};
@@ -178,8 +217,8 @@ namespace mau {
     create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
     create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
     create_info.subresourceRange.aspectMask = aspect_mask;
-    create_info.subresourceRange.baseMipLevel = 0u;
-    create_info.subresourceRange.levelCount = 1u;
+    create_info.subresourceRange.baseMipLevel = base_mip_level;
+    create_info.subresourceRange.levelCount = mip_levels;
     create_info.subresourceRange.baseArrayLayer = 0u;
     create_info.subresourceRange.layerCount = 1u;
 
@@ -237,7 +276,7 @@ namespace mau {
     create_info.compareEnable = VK_FALSE;
     create_info.compareOp = VK_COMPARE_OP_ALWAYS;
     create_info.minLod = 0.0f;
-    create_info.maxLod = 0.0f;
+    create_info.maxLod = VK_LOD_CLAMP_NONE;
     create_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     create_info.unnormalizedCoordinates = VK_FALSE;
 
@@ -247,17 +286,57 @@ namespace mau {
   Sampler::~Sampler() { vkDestroySampler(VulkanState::Ref().GetDevice(), m_Sampler, nullptr); }
 
   // texture
+  static VkFormat get_texture_format(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8_SRGB:
+      return VK_FORMAT_R8G8B8A8_SRGB;
+    case TextureFormat::RGBA8_UNORM:
+      return VK_FORMAT_R8G8B8A8_UNORM;
+    case TextureFormat::BC1_SRGB:
+      return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    case TextureFormat::BC3_SRGB:
+      return VK_FORMAT_BC3_SRGB_BLOCK;
+    case TextureFormat::BC5_UNORM:
+      return VK_FORMAT_BC5_UNORM_BLOCK;
+    default:
+      return VK_FORMAT_UNDEFINED;
+    }
+  }
+
   Texture::Texture(const String &image_path) {
     RawImage raw_image(image_path);
 
     if (raw_image.Data) {
-      m_Image = make_handle<Image>(raw_image.Width, raw_image.Height, 1u, 1u, 1u, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-                                   VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-      UploadUsingStaging(m_Image, raw_image.Data, raw_image.Width, raw_image.Height, 4u);
-      m_ImageView = make_handle<ImageView>(m_Image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+      Create(build_mip_chain(reinterpret_cast<const TUint8 *>(raw_image.Data), raw_image.Width, raw_image.Height, TextureKind::COLOR));
+      m_Resident = true;
     }
   }
 
+  Texture::Texture(TUint32 width, TUint32 height, const void *pixels) {
+    Create(width, height, pixels);
+    m_Resident = true;
+  }
+
+  Texture::Texture() { }
+
+  TUint64 Texture::Create(TUint32 width, TUint32 height, const void *pixels) {
+    return Create(TextureFormat::RGBA8_SRGB, width, height, pixels, get_level_size(TextureFormat::RGBA8_SRGB, width, height), {});
+  }
+
+  TUint64 Texture::Create(const TextureLevels &levels) { return Create(levels.Format, levels.Width, levels.Height, levels.Data.data(), levels.Data.size(), levels.Mips); }
+
+  TUint64 Texture::Create(TextureFormat format, TUint32 width, TUint32 height, const void *data, TUint64 size, const Vector<TextureMip> &mips) {
+    ASSERT(data);
+
+    const TUint32 mip_levels = mips.empty() ? 1u : static_cast<TUint32>(mips.size());
+
+    m_Image = make_handle<Image>(width, height, 1u, mip_levels, 1u, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, get_texture_format(format), VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    m_ImageView = make_handle<ImageView>(m_Image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    return VulkanState::Ref().GetUploadRing()->EnqueueImage(m_Image, data, size, mips);
+  }
+
   VkDescriptorImageInfo Texture::GetDescriptorInfo() const {
     VkDescriptorImageInfo descriptor_info = {
         .sampler = m_Sampler.Get(),
@@ -4,15 +4,38 @@
 #include <engine/types.h>
 #include "common.h"
 #include "vulkan-renderpass.h"
+#include "../loader/texture-loader.h"
 
 namespace mau {
 
+  // device memory of one memory type that images are placed in at an offset, several images can share a range
+  class ImageMemory: public HandledObject {
+  public:
+    ImageMemory(TUint64 size, TUint32 memory_type);
+    ~ImageMemory();
+
+  public:
+    inline VmaAllocation GetAllocation() const { return m_Allocation; }
+    inline TUint64       GetSize() const { return m_Size; }
+    inline TUint32       GetMemoryType() const { return m_MemoryType; }
+
+  private:
+    VmaAllocation m_Allocation = VK_NULL_HANDLE;
+    TUint64       m_Size = 0u;
+    TUint32       m_MemoryType = 0u;
+  };
+
+  // size, alignment and device local memory type an image needs, without creating it
+  void GetImageMemoryRequirements(const VkImageCreateInfo &create_info, VkMemoryRequirements &requirements, TUint32 &memory_type);
+
   // image
   class Image: public HandledObject {
   public:
     Image(TUint32 width, TUint32 height, TUint32 depth, TUint32 mip_levels, TUint32 array_layers, VkImageType type, VkSampleCountFlagBits samples, VkFormat format, VkImageTiling tiling,
           VkImageUsageFlags usage);
     Image(TUint32 width, TUint32 height, VkImage image, VkFormat format, VkSampleCountFlagBits samples);
+    // placed in memory at offset, the memory is kept alive as long as the image
+    Image(const VkImageCreateInfo &create_info, Handle<ImageMemory> memory, TUint64 offset);
     ~Image();
 
   public:
@@ -21,23 +44,31 @@ namespace mau {
     inline VkSampleCountFlagBits GetSamples() const { return m_SampleCount; }
     inline TUint32               GetWidth() const { return m_Width; }
     inline TUint32               GetHeight() const { return m_Height; }
+    inline TUint32               GetMipLevels() const { return m_MipLevels; }
 
   private:
     VkImage               m_Image = VK_NULL_HANDLE;
     VmaAllocation         m_Allocation = VK_NULL_HANDLE;
+    Handle<ImageMemory>   m_Memory = nullptr;
     VkFormat              m_Format = VK_FORMAT_UNDEFINED;
     VkSampleCountFlagBits m_SampleCount = VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM;
     TUint32               m_Width = 0u;
     TUint32               m_Height = 0u;
+    TUint32               m_MipLevels = 1u;
   };
 
-  void TransitionImageLayout(Handle<CommandBuffer> cmd, Handle<Image> image, VkImageLayout old_layout, VkImageLayout new_layout);
+  // transitions every mip level of the image, waiting for src stages and blocking dst stages. access masks follow from
+  // the layouts, as far as the stages can access them
+  void TransitionImageLayout(Handle<CommandBuffer> cmd, Handle<Image> image, VkImageLayout old_layout, VkImageLayout new_layout, VkPipelineStageFlags src_stages,
+                             VkPipelineStageFlags dst_stages);
+  void CopyBufferToImage(Handle<CommandBuffer> cmd, VkBuffer buffer, TUint64 buffer_offset, Handle<Image> image, TUint32 width, TUint32 height, TUint32 mip_level = 0u);
 
-  // image view
+  // image view, views created from an image cover all of its mip levels unless one level is asked for
   class ImageView: public HandledObject {
   public:
     ImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask);
     ImageView(Handle<Image> image, VkImageViewType view_type, VkImageAspectFlags aspect_mask);
+    ImageView(Handle<Image> image, VkImageViewType view_type, VkImageAspectFlags aspect_mask, TUint32 mip_level);
     ImageView(const ImageView &other);
     ~ImageView();
 
@@ -45,7 +76,7 @@ namespace mau {
     inline VkImageView GetImageView() const { return m_ImageView; }
 
   private:
-    void CreateImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask);
+    void CreateImageView(VkImage image, VkFormat format, VkImageViewType view_type, VkImageAspectFlags aspect_mask, TUint32 mip_levels = 1u, TUint32 base_mip_level = 0u);
 
   private:
     VkImageView m_ImageView = VK_NULL_HANDLE;
@@ -83,17 +114,29 @@ namespace mau {
 
   // texture 2d
   class Texture: public HandledObject {
+    friend class TextureStreamer;
+
   public:
     Texture(const String &image_path);
+    Texture(TUint32 width, TUint32 height, const void *pixels);
+    Texture(); // filled in later by the texture streamer
     ~Texture() = default;
 
   public:
     VkDescriptorImageInfo GetDescriptorInfo() const;
 
+    inline bool IsResident() const { return m_Resident; }
+
+  private:
+    TUint64 Create(TUint32 width, TUint32 height, const void *pixels);
+    TUint64 Create(const TextureLevels &levels);
+    TUint64 Create(TextureFormat format, TUint32 width, TUint32 height, const void *data, TUint64 size, const Vector<TextureMip> &mips);
+
   private:
     Handle<Image>     m_Image = nullptr;
     Handle<ImageView> m_ImageView = nullptr;
     Sampler           m_Sampler;
+    bool              m_Resident = false;
   };
 
 } // namespace mau
@@ -0,0 +1,158 @@
+#include "vulkan-pipeline-cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <engine/log.h>
+#include <engine/profiler.h>
+
+#include "vulkan-state.h"
+
+namespace mau {
+
+  // 64 bit FNV-1a, catches truncated and corrupted blobs before the driver sees them
+  static TUint64 hash_bytes(const TUint8 *data, TUint64 size) {
+    TUint64 hash = 0xcbf29ce484222325ull;
+    for (TUint64 i = 0; i < size; i++) {
+      hash ^= data[i];
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  static PipelineCacheFileHeader device_header() {
+    const VkPhysicalDeviceProperties properties = VulkanState::Ref().GetPhysicalDeviceProperties();
+
+    PipelineCacheFileHeader header = {};
+    header.VendorID = properties.vendorID;
+    header.DeviceID = properties.deviceID;
+    header.DriverVersion = properties.driverVersion;
+    memcpy(header.UUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+  }
+
+  VulkanPipelineCache::VulkanPipelineCache(const String &path): m_Path(path) {
+    MAU_PROFILE_SCOPE("VulkanPipelineCache::VulkanPipelineCache");
+
+    Vector<TUint8> data = {};
+    if (!m_Path.empty() && !Load(data))
+      data.clear();
+
+    VkPipelineCacheCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0u,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+
+    VK_CALL(vkCreatePipelineCache(VulkanState::Ref().GetDevice(), &create_info, nullptr, &m_Cache));
+    m_LoadedSize = data.size();
+
+    if (IsWarm())
+      LOG_INFO("pipeline cache loaded from %s [%llu bytes]", m_Path.c_str(), static_cast<unsigned long long>(m_LoadedSize));
+  }
+
+  VulkanPipelineCache::~VulkanPipelineCache() {
+    if (!m_Cache)
+      return;
+
+    Save();
+    vkDestroyPipelineCache(VulkanState::Ref().GetDevice(), m_Cache, nullptr);
+  }
+
+  bool VulkanPipelineCache::Load(Vector<TUint8> &data) const {
+    std::ifstream file(m_Path, std::ios::binary);
+    if (!file.is_open()) {
+      LOG_INFO("no pipeline cache at %s, pipelines are compiled from scratch", m_Path.c_str());
+      return false;
+    }
+
+    PipelineCacheFileHeader header = {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file.good() || header.Magic != PIPELINE_CACHE_MAGIC || header.Version != PIPELINE_CACHE_VERSION) {
+      LOG_WARN("ignoring pipeline cache %s, not a pipeline cache of this build", m_Path.c_str());
+      return false;
+    }
+
+    const PipelineCacheFileHeader device = device_header();
+    if (header.VendorID != device.VendorID || header.DeviceID != device.DeviceID || header.DriverVersion != device.DriverVersion ||
+        memcmp(header.UUID, device.UUID, VK_UUID_SIZE) != 0) {
+      LOG_WARN("ignoring pipeline cache %s, it was made by another device or driver", m_Path.c_str());
+      return false;
+    }
+
+    // the size comes from the file, a truncated or corrupt one must not decide how much is allocated
+    std::error_code error = {};
+    const TUint64   file_size = std::filesystem::file_size(m_Path, error);
+    if (error || file_size < sizeof(header) || header.DataSize != file_size - sizeof(header)) {
+      LOG_WARN("ignoring pipeline cache %s, the file is damaged", m_Path.c_str());
+      return false;
+    }
+
+    data.resize(header.DataSize);
+    file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file.good() || hash_bytes(data.data(), data.size()) != header.DataHash) {
+      LOG_WARN("ignoring pipeline cache %s, the file is damaged", m_Path.c_str());
+      return false;
+    }
+
+    // the driver's own header has to agree as well
+    VkPipelineCacheHeaderVersionOne blob_header = {};
+    if (data.size() >= sizeof(blob_header))
+      memcpy(&blob_header, data.data(), sizeof(blob_header));
+
+    if (blob_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || blob_header.vendorID != device.VendorID || blob_header.deviceID != device.DeviceID ||
+        memcmp(blob_header.pipelineCacheUUID, device.UUID, VK_UUID_SIZE) != 0) {
+      LOG_WARN("ignoring pipeline cache %s, the driver data does not match the device", m_Path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  bool VulkanPipelineCache::Save() const {
+    if (m_Path.empty())
+      return false;
+
+    MAU_PROFILE_SCOPE("VulkanPipelineCache::Save");
+
+    size_t size = 0u;
+    VK_CALL(vkGetPipelineCacheData(VulkanState::Ref().GetDevice(), m_Cache, &size, nullptr));
+    Vector<TUint8> data(size);
+    VK_CALL(vkGetPipelineCacheData(VulkanState::Ref().GetDevice(), m_Cache, &size, data.data()));
+    data.resize(size);
+
+    PipelineCacheFileHeader header = device_header();
+    header.DataSize = data.size();
+    header.DataHash = hash_bytes(data.data(), data.size());
+
+    // written next to the old file and swapped in, a crash while saving leaves the old cache
+    const String temp_path = m_Path + ".tmp";
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) {
+        LOG_ERROR("failed to open %s for writing", temp_path.c_str());
+        return false;
+      }
+
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+      if (!file.good()) {
+        LOG_ERROR("failed to write pipeline cache %s", temp_path.c_str());
+        return false;
+      }
+    }
+
+    std::error_code error = {};
+    std::filesystem::rename(temp_path, m_Path, error);
+    if (error) {
+      LOG_ERROR("failed to replace pipeline cache %s: %s", m_Path.c_str(), error.message().c_str());
+      return false;
+    }
+
+    LOG_INFO("pipeline cache saved to %s [%llu bytes]", m_Path.c_str(), static_cast<unsigned long long>(data.size()));
+    return true;
+  }
+
+} // namespace mau
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <engine/types.h>
+#include <engine/utils/singleton.h>
+
+#include "common.h"
+
+namespace mau {
+
+  // cache file layout: header, then the blob returned by vkGetPipelineCacheData
+  constexpr TUint32 PIPELINE_CACHE_MAGIC = 0x4550504du; // "MPPE"
+  constexpr TUint32 PIPELINE_CACHE_VERSION = 1u;
+
+  struct PipelineCacheFileHeader {
+    TUint32 Magic = PIPELINE_CACHE_MAGIC;
+    TUint32 Version = PIPELINE_CACHE_VERSION;
+    TUint32 VendorID = 0u;
+    TUint32 DeviceID = 0u;
+    TUint32 DriverVersion = 0u;
+    TUint8  UUID[VK_UUID_SIZE] = {};
+    TUint64 DataSize = 0u;
+    TUint64 DataHash = 0u;
+  };
+
+  // one VkPipelineCache shared by every pipeline. it is read from disk when created and written back when destroyed,
+  // a file made by another device, driver or build is ignored. the cache is internally synchronized, pipelines can be
+  // created on any thread
+  class VulkanPipelineCache: public Singleton<VulkanPipelineCache> {
+    friend class Singleton<VulkanPipelineCache>;
+
+  private:
+    // an empty path keeps the cache in memory
+    VulkanPipelineCache(const String &path = "");
+    ~VulkanPipelineCache();
+
+  public:
+    bool Save() const;
+
+    inline VkPipelineCache GetCache() const { return m_Cache; }
+    inline const String   &GetPath() const { return m_Path; }
+    // true when the cache started from a valid file
+    inline bool    IsWarm() const { return m_LoadedSize > 0u; }
+    inline TUint64 GetLoadedSize() const { return m_LoadedSize; }
+
+  private:
+    bool Load(Vector<TUint8> &data) const;
+
+  private:
+    VkPipelineCache m_Cache = VK_NULL_HANDLE;
+    String          m_Path = "";
+    TUint64         m_LoadedSize = 0u;
+  };
+
+  // the shared cache when there is one, pipelines created before it exists are not cached
+  inline VkPipelineCache GetPipelineCache() { return VulkanPipelineCache::Get() ? VulkanPipelineCache::Ref().GetCache() : VK_NULL_HANDLE; }
+
+} // namespace mau
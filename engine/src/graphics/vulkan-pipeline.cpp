@@ -1,6 +1,11 @@
 #include "vulkan-pipeline.h"
 
+#include <chrono>
+#include <engine/core/job-system.h>
+#include <engine/profiler.h>
+
 #include "vulkan-state.h"
+#include "vulkan-pipeline-cache.h"
 
 namespace mau {
 
@@ -28,8 +33,25 @@ namespace mau {
   }
 
   Pipeline::Pipeline(Handle<VertexShader> vertex_shader, Handle<FragmentShader> fragment_shader, Handle<Renderpass> renderpass, const InputLayout &input_layout, Handle<PushConstantBase> push_constant,
-                     const std::vector<VkDescriptorSetLayout> &descriptor_layouts, const VkSampleCountFlagBits &sample_count) {
-    VkPipelineShaderStageCreateInfo shader_stages[] = {vertex_shader->GetShaderStageInfo(), fragment_shader->GetShaderStageInfo()};
+                     const std::vector<VkDescriptorSetLayout> &descriptor_layouts, const VkSampleCountFlagBits &sample_count)
+      : Pipeline(PipelineCreateInfo{
+            .Vertex = vertex_shader,
+            .Fragment = fragment_shader,
+            .Pass = renderpass,
+            .Layout = input_layout,
+            .PushConstant = push_constant,
+            .DescriptorLayouts = descriptor_layouts,
+            .Samples = sample_count,
+        }) { }
+
+  Pipeline::Pipeline(const PipelineCreateInfo &create_info) {
+    MAU_PROFILE_SCOPE("Pipeline::Pipeline");
+
+    const InputLayout                   &input_layout = create_info.Layout;
+    const Vector<VkDescriptorSetLayout> &descriptor_layouts = create_info.DescriptorLayouts;
+    const bool                           push_constant = create_info.PushConstant;
+
+    VkPipelineShaderStageCreateInfo shader_stages[] = {create_info.Vertex->GetShaderStageInfo(), create_info.Fragment->GetShaderStageInfo()};
 
     // vertex input
     VkPipelineVertexInputStateCreateInfo vertex_input_state = {};
@@ -89,7 +111,7 @@ namespace mau {
     multisample_state.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisample_state.pNext = nullptr;
     multisample_state.flags = 0u;
-    multisample_state.rasterizationSamples = sample_count;
+    multisample_state.rasterizationSamples = create_info.Samples;
     multisample_state.sampleShadingEnable = VK_FALSE;
     multisample_state.minSampleShading = 1.0f;
     multisample_state.pSampleMask = nullptr;
@@ -133,7 +155,7 @@ namespace mau {
 
     VkPushConstantRange push_constant_range = {};
     if (push_constant) {
-      push_constant_range = push_constant->GetRange();
+      push_constant_range = create_info.PushConstant->GetRange();
     }
 
     // create pipeline layout
@@ -148,28 +170,28 @@ namespace mau {
 
     VK_CALL(vkCreatePipelineLayout(VulkanState::Ref().GetDevice(), &layout_create_info, nullptr, &m_PipelineLayout));
 
-    VkGraphicsPipelineCreateInfo create_info = {};
-    create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    create_info.pNext = nullptr;
-    create_info.flags = 0u;
-    create_info.stageCount = ARRAY_SIZE(shader_stages);
-    create_info.pStages = shader_stages;
-    create_info.pVertexInputState = &vertex_input_state;
-    create_info.pInputAssemblyState = &input_assembly_state;
-    create_info.pTessellationState = nullptr;
-    create_info.pViewportState = &viewport_state;
-    create_info.pRasterizationState = &raster_state;
-    create_info.pMultisampleState = &multisample_state;
-    create_info.pDepthStencilState = &depth_stencil_state;
-    create_info.pColorBlendState = &color_blend_state;
-    create_info.pDynamicState = &dynamic_state;
-    create_info.layout = m_PipelineLayout;
-    create_info.renderPass = renderpass->Get();
-    create_info.subpass = 0;
-    create_info.basePipelineHandle = VK_NULL_HANDLE;
-    create_info.basePipelineIndex = -1;
-
-    VK_CALL(vkCreateGraphicsPipelines(VulkanState::Ref().GetDevice(), VK_NULL_HANDLE, 1, &create_info, nullptr, &m_Pipeline));
+    VkGraphicsPipelineCreateInfo pipeline_create_info = {};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_create_info.pNext = nullptr;
+    pipeline_create_info.flags = 0u;
+    pipeline_create_info.stageCount = ARRAY_SIZE(shader_stages);
+    pipeline_create_info.pStages = shader_stages;
+    pipeline_create_info.pVertexInputState = &vertex_input_state;
+    pipeline_create_info.pInputAssemblyState = &input_assembly_state;
+    pipeline_create_info.pTessellationState = nullptr;
+    pipeline_create_info.pViewportState = &viewport_state;
+    pipeline_create_info.pRasterizationState = &raster_state;
+    pipeline_create_info.pMultisampleState = &multisample_state;
+    pipeline_create_info.pDepthStencilState = &depth_stencil_state;
+    pipeline_create_info.pColorBlendState = &color_blend_state;
+    pipeline_create_info.pDynamicState = &dynamic_state;
+    pipeline_create_info.layout = m_PipelineLayout;
+    pipeline_create_info.renderPass = create_info.Pass->Get();
+    pipeline_create_info.subpass = 0;
+    pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+    pipeline_create_info.basePipelineIndex = -1;
+
+    VK_CALL(vkCreateGraphicsPipelines(VulkanState::Ref().GetDevice(), GetPipelineCache(), 1, &pipeline_create_info, nullptr, &m_Pipeline));
   }
 
   Pipeline::~Pipeline() {
@@ -182,6 +204,7 @@ namespace mau {
   bool validate_create_info(const RTPipelineCreateInfo &create_info) { return create_info.ClosestHit && create_info.Miss && create_info.RayGen; }
 
   RTPipeline::RTPipeline(const RTPipelineCreateInfo &create_info) {
+    MAU_PROFILE_SCOPE("RTPipeline::RTPipeline");
     ASSERT(validate_create_info(create_info));
 
     VkPipelineShaderStageCreateInfo shader_stages[3] = {
@@ -241,7 +264,7 @@ namespace mau {
         .basePipelineIndex = 0u,
     };
 
-    VK_CALL(vkCreateRayTracingPipelinesKHR(VulkanState::Ref().GetDevice(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &m_Pipeline));
+    VK_CALL(vkCreateRayTracingPipelinesKHR(VulkanState::Ref().GetDevice(), VK_NULL_HANDLE, GetPipelineCache(), 1, &pipeline_create_info, nullptr, &m_Pipeline));
 
     CreateShaderBindingTable();
   }
@@ -336,4 +359,101 @@ namespace mau {
     m_SBTBuffer->UnMap();
   }
 
+  ComputePipeline::ComputePipeline(const ComputePipelineCreateInfo &create_info) {
+    MAU_PROFILE_SCOPE("ComputePipeline::ComputePipeline");
+    ASSERT(create_info.Compute);
+
+    VkPushConstantRange push_constant_range = {};
+    if (create_info.PushConstant) {
+      push_constant_range = create_info.PushConstant->GetRange();
+    }
+
+    VkPipelineLayoutCreateInfo layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0u,
+        .setLayoutCount = static_cast<uint32_t>(create_info.DescriptorLayouts.size()),
+        .pSetLayouts = create_info.DescriptorLayouts.data(),
+        .pushConstantRangeCount = create_info.PushConstant ? 1u : 0u,
+        .pPushConstantRanges = create_info.PushConstant ? &push_constant_range : nullptr,
+    };
+
+    VK_CALL(vkCreatePipelineLayout(VulkanState::Ref().GetDevice(), &layout_create_info, nullptr, &m_PipelineLayout));
+
+    VkComputePipelineCreateInfo pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0u,
+        .stage = create_info.Compute->GetShaderStageInfo(),
+        .layout = m_PipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    VK_CALL(vkCreateComputePipelines(VulkanState::Ref().GetDevice(), GetPipelineCache(), 1, &pipeline_create_info, nullptr, &m_Pipeline));
+  }
+
+  ComputePipeline::~ComputePipeline() {
+    if (m_PipelineLayout)
+      vkDestroyPipelineLayout(VulkanState::Ref().GetDevice(), m_PipelineLayout, nullptr);
+    if (m_Pipeline)
+      vkDestroyPipeline(VulkanState::Ref().GetDevice(), m_Pipeline, nullptr);
+  }
+
+  void PipelineCompileQueue::Add(Handle<Pipeline> &target, const PipelineCreateInfo &create_info) {
+    m_Requests.push_back({.Graphics = create_info, .GraphicsTarget = &target});
+  }
+
+  void PipelineCompileQueue::Add(Handle<RTPipeline> &target, const RTPipelineCreateInfo &create_info) {
+    m_Requests.push_back({.RayTracing = create_info, .RayTracingTarget = &target});
+  }
+
+  void PipelineCompileQueue::Add(Handle<ComputePipeline> &target, const ComputePipelineCreateInfo &create_info) {
+    m_Requests.push_back({.Compute = create_info, .ComputeTarget = &target});
+  }
+
+  TFloat64 PipelineCompileQueue::Compile() {
+    MAU_PROFILE_SCOPE("PipelineCompileQueue::Compile");
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // the driver compiles each pipeline on the thread that creates it, one job per pipeline
+    JobCounter counter = {};
+    for (Request &request : m_Requests) {
+      JobSystem::Ref().Schedule(
+          [&request]() -> void {
+            try {
+              if (request.GraphicsTarget) {
+                MAU_ALLOC(request.GraphicsResult, Pipeline, request.Graphics);
+              } else if (request.ComputeTarget) {
+                MAU_ALLOC(request.ComputeResult, ComputePipeline, request.Compute);
+              } else {
+                MAU_ALLOC(request.RayTracingResult, RTPipeline, request.RayTracing);
+              }
+            } catch (...) {
+              request.Error = std::current_exception();
+            }
+          },
+          &counter);
+    }
+    JobSystem::Ref().Wait(counter);
+
+    std::exception_ptr error = nullptr;
+    for (Request &request : m_Requests) {
+      if (request.GraphicsResult)
+        *request.GraphicsTarget = request.GraphicsResult;
+      if (request.RayTracingResult)
+        *request.RayTracingTarget = request.RayTracingResult;
+      if (request.ComputeResult)
+        *request.ComputeTarget = request.ComputeResult;
+      if (request.Error && !error)
+        error = request.Error;
+    }
+    m_Requests.clear();
+
+    if (error)
+      std::rethrow_exception(error);
+
+    return std::chrono::duration<TFloat64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  }
+
 } // namespace mau
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <exception>
 #include <memory>
 #include "common.h"
 #include "vulkan-shaders.h"
@@ -17,6 +18,12 @@ namespace mau {
     Vector<VkDescriptorSetLayout> DescriptorLayouts;
   };
 
+  struct ComputePipelineCreateInfo {
+    Handle<ComputeShader>         Compute;
+    Handle<PushConstantBase>      PushConstant;
+    Vector<VkDescriptorSetLayout> DescriptorLayouts;
+  };
+
   struct RTSBTRegion {
     VkStridedDeviceAddressRegionKHR RayGen;
     VkStridedDeviceAddressRegionKHR RayMiss;
@@ -41,10 +48,22 @@ namespace mau {
     std::vector<VkVertexInputAttributeDescription> m_AttributeDesc = {};
   };
 
+  struct PipelineCreateInfo {
+    Handle<VertexShader>          Vertex;
+    Handle<FragmentShader>        Fragment;
+    Handle<Renderpass>            Pass;
+    InputLayout                   Layout;
+    Handle<PushConstantBase>      PushConstant;
+    Vector<VkDescriptorSetLayout> DescriptorLayouts;
+    VkSampleCountFlagBits         Samples = VK_SAMPLE_COUNT_1_BIT;
+  };
+
   class Pipeline: public HandledObject {
   public:
     Pipeline(Handle<VertexShader> vertex_shader, Handle<FragmentShader> fragment_shader, Handle<Renderpass> renderpass, const InputLayout &input_layout,
              Handle<PushConstantBase> push_constant = nullptr, const std::vector<VkDescriptorSetLayout> &descriptor_layouts = {}, const VkSampleCountFlagBits &sample_count = VK_SAMPLE_COUNT_1_BIT);
+    // only reads the handles in create_info, so pipelines sharing shaders can be created on several threads
+    Pipeline(const PipelineCreateInfo &create_info);
     ~Pipeline();
 
   public:
@@ -81,4 +100,55 @@ namespace mau {
     VkStridedDeviceAddressRegionKHR m_RayCallRegion = {};
   };
 
+  class ComputePipeline: public HandledObject {
+  public:
+    ComputePipeline(const ComputePipelineCreateInfo &create_info);
+    ~ComputePipeline();
+
+  public:
+    inline VkPipeline       Get() const { return m_Pipeline; }
+    inline VkPipelineLayout GetLayout() const { return m_PipelineLayout; }
+
+  private:
+    VkPipeline       m_Pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+  };
+
+  // pipelines created on the job system. the create infos are copied when a pipeline is added and the pipelines are
+  // handed out when Compile returns, so no handle is touched by two threads at once
+  class PipelineCompileQueue {
+  public:
+    PipelineCompileQueue() = default;
+    ~PipelineCompileQueue() = default;
+
+  public:
+    // target is assigned by Compile
+    void Add(Handle<Pipeline> &target, const PipelineCreateInfo &create_info);
+    void Add(Handle<RTPipeline> &target, const RTPipelineCreateInfo &create_info);
+    void Add(Handle<ComputePipeline> &target, const ComputePipelineCreateInfo &create_info);
+
+    // creates everything added since the last call and returns the milliseconds it took. the first exception thrown
+    // while creating a pipeline is rethrown here
+    TFloat64 Compile();
+
+    inline TUint32 GetCount() const { return static_cast<TUint32>(m_Requests.size()); }
+
+  private:
+    struct Request {
+      PipelineCreateInfo        Graphics = {};
+      RTPipelineCreateInfo      RayTracing = {};
+      ComputePipelineCreateInfo Compute = {};
+      Handle<Pipeline>         *GraphicsTarget = nullptr;
+      Handle<RTPipeline>       *RayTracingTarget = nullptr;
+      Handle<ComputePipeline>  *ComputeTarget = nullptr;
+      Pipeline                 *GraphicsResult = nullptr;
+      RTPipeline               *RayTracingResult = nullptr;
+      ComputePipeline          *ComputeResult = nullptr;
+      std::exception_ptr        Error = nullptr;
+    };
+
+  private:
+    Vector<Request> m_Requests = {};
+  };
+
 } // namespace mau
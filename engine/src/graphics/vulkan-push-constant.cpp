@@ -37,6 +37,8 @@ namespace mau {
 
   void PushConstantBase::Bind(Handle<CommandBuffer> cmd, Handle<RTPipeline> pipeline) const { vkCmdPushConstants(cmd->Get(), pipeline->GetLayout(), VK_SHADER_STAGE_ALL, 0u, m_Size, m_Data); }
 
+  void PushConstantBase::Bind(Handle<CommandBuffer> cmd, Handle<ComputePipeline> pipeline) const { vkCmdPushConstants(cmd->Get(), pipeline->GetLayout(), VK_SHADER_STAGE_ALL, 0u, m_Size, m_Data); }
+
   void PushConstantBase::SetData(const void *const data, TUint64 size) {
     if (m_Size == 0 || m_Data == nullptr || data == nullptr) {
       LOG_ERROR("cannot set push constant data, 0 size or invalid data");
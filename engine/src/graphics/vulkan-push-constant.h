@@ -9,6 +9,7 @@ namespace mau {
   class CommandBuffer;
   class Pipeline;
   class RTPipeline;
+  class ComputePipeline;
 
   class PushConstantBase: public HandledObject {
   public:
@@ -19,6 +20,7 @@ namespace mau {
     VkPushConstantRange GetRange() const;
     void                Bind(Handle<CommandBuffer> cmd, Handle<Pipeline> pipeline) const;
     void                Bind(Handle<CommandBuffer> cmd, Handle<RTPipeline> pipeline) const;
+    void                Bind(Handle<CommandBuffer> cmd, Handle<ComputePipeline> pipeline) const;
 
   protected:
     void SetData(const void *const data, TUint64 size);
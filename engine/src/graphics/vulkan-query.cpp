@@ -0,0 +1,62 @@
+#include "vulkan-query.h"
+
+#include "vulkan-state.h"
+
+namespace mau {
+
+  TimestampQueryPool::TimestampQueryPool(TUint32 slot_count): m_SlotCount(slot_count) {
+    const VkPhysicalDeviceLimits &limits = VulkanState::Ref().GetPhysicalDeviceProperties().limits;
+    if (limits.timestampComputeAndGraphics != VK_TRUE) {
+      LOG_WARN("device has no timestamps on the graphics queue, gpu timings are unavailable");
+      return;
+    }
+
+    // nanoseconds per tick
+    m_TimestampPeriod = static_cast<TFloat64>(limits.timestampPeriod);
+
+    VkQueryPoolCreateInfo create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    create_info.pNext = nullptr;
+    create_info.flags = 0u;
+    create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    create_info.queryCount = slot_count * 2u;
+    create_info.pipelineStatistics = 0u;
+
+    VK_CALL(vkCreateQueryPool(VulkanState::Ref().GetDevice(), &create_info, nullptr, &m_QueryPool));
+  }
+
+  TimestampQueryPool::~TimestampQueryPool() {
+    if (m_QueryPool)
+      vkDestroyQueryPool(VulkanState::Ref().GetDevice(), m_QueryPool, nullptr);
+  }
+
+  void TimestampQueryPool::Begin(Handle<CommandBuffer> cmd, TUint32 slot) {
+    if (!m_QueryPool)
+      return;
+
+    vkCmdResetQueryPool(cmd->Get(), m_QueryPool, slot * 2u, 2u);
+    vkCmdWriteTimestamp(cmd->Get(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, slot * 2u);
+  }
+
+  void TimestampQueryPool::End(Handle<CommandBuffer> cmd, TUint32 slot) {
+    if (!m_QueryPool)
+      return;
+
+    vkCmdWriteTimestamp(cmd->Get(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, slot * 2u + 1u);
+  }
+
+  bool TimestampQueryPool::GetElapsedMs(TUint32 slot, TFloat64 &elapsed_ms) const {
+    if (!m_QueryPool)
+      return false;
+
+    // never waits. slots are reset on the gpu by Begin, only read slots that were submitted at least once
+    TUint64        timestamps[2] = {};
+    const VkResult result = vkGetQueryPoolResults(VulkanState::Ref().GetDevice(), m_QueryPool, slot * 2u, 2u, sizeof(timestamps), timestamps, sizeof(TUint64), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+      return false;
+
+    elapsed_ms = static_cast<TFloat64>(timestamps[1] - timestamps[0]) * m_TimestampPeriod * 1e-6;
+    return true;
+  }
+
+} // namespace mau
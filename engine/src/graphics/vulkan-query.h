@@ -0,0 +1,34 @@
+#pragma once
+
+#include <engine/types.h>
+#include "common.h"
+#include "vulkan-commands.h"
+
+namespace mau {
+
+  // a begin and an end timestamp per slot. a slot's result can be read once the command buffer that wrote it finished,
+  // devices without timestamp support on the graphics queue get no pool and every read fails
+  class TimestampQueryPool: public HandledObject {
+  public:
+    TimestampQueryPool(TUint32 slot_count);
+    ~TimestampQueryPool();
+
+  public:
+    // resets the slot, has to be recorded outside of a renderpass
+    void Begin(Handle<CommandBuffer> cmd, TUint32 slot);
+    void End(Handle<CommandBuffer> cmd, TUint32 slot);
+
+    // milliseconds between the slot's begin and end, false when there is no finished result
+    bool GetElapsedMs(TUint32 slot, TFloat64 &elapsed_ms) const;
+
+  public:
+    inline bool    IsSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+    inline TUint32 GetSlotCount() const { return m_SlotCount; }
+
+  private:
+    VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+    TUint32     m_SlotCount = 0u;
+    TFloat64    m_TimestampPeriod = 0.0;
+  };
+
+} // namespace mau
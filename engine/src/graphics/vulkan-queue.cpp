@@ -4,39 +4,98 @@
 
 namespace mau {
 
-  VulkanQueue::VulkanQueue(VkQueue queue, VkDevice device): m_Queue(queue), m_Device(device) {
+  VulkanQueue::VulkanQueue(VkQueue queue, VkDevice device, std::mutex *mutex): m_Queue(queue), m_Device(device), m_Mutex(mutex) {
     ASSERT(queue != VK_NULL_HANDLE);
     ASSERT(device != VK_NULL_HANDLE);
+    ASSERT(mutex != nullptr);
   }
 
   VulkanQueue::~VulkanQueue() { }
 
-  void VulkanQueue::Submit(Handle<CommandBuffer> cmd, VkPipelineStageFlags wait_stages, Handle<Semaphore> wait_semaphore, Handle<Semaphore> signal_semaphore, Handle<Fence> signal_fence) {
+  void VulkanQueue::Submit(Handle<CommandBuffer> cmd, VkPipelineStageFlags wait_stages, Handle<Semaphore> wait_semaphore, Handle<Semaphore> signal_semaphore, Handle<Fence> signal_fence,
+                           const TimelinePoint &wait_timeline) {
     MAU_PROFILE_SCOPR_COLOR("VulkanQueue::Submit", tracy::Color::Cyan);
     ASSERT(cmd != nullptr);
 
+    // binary and timeline waits can be mixed, values of binary semaphores are ignored
+    VkSemaphore          wait_semaphores[2] = {};
+    VkPipelineStageFlags wait_stage_masks[2] = {};
+    TUint64              wait_values[2] = {};
+    TUint32              wait_count = 0u;
+
+    if (wait_semaphore) {
+      wait_semaphores[wait_count] = wait_semaphore->Get();
+      wait_stage_masks[wait_count] = wait_stages;
+      wait_count++;
+    }
+
+    if (wait_timeline.Semaphore) {
+      wait_semaphores[wait_count] = wait_timeline.Semaphore->Get();
+      wait_stage_masks[wait_count] = wait_timeline.Stages;
+      wait_values[wait_count] = wait_timeline.Value;
+      wait_count++;
+    }
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.pNext = nullptr;
+    timeline_info.waitSemaphoreValueCount = wait_count;
+    timeline_info.pWaitSemaphoreValues = wait_values;
+    timeline_info.signalSemaphoreValueCount = 0u;
+    timeline_info.pSignalSemaphoreValues = nullptr;
+
     VkSubmitInfo submit_info = {};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.pNext = nullptr;
-    submit_info.waitSemaphoreCount = wait_semaphore ? 1 : 0;
-    submit_info.pWaitSemaphores = wait_semaphore ? wait_semaphore->Ref() : nullptr;
-    submit_info.pWaitDstStageMask = &wait_stages;
+    submit_info.pNext = wait_timeline.Semaphore ? &timeline_info : nullptr;
+    submit_info.waitSemaphoreCount = wait_count;
+    submit_info.pWaitSemaphores = wait_semaphores;
+    submit_info.pWaitDstStageMask = wait_stage_masks;
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = cmd->Ref();
     submit_info.signalSemaphoreCount = signal_semaphore ? 1 : 0;
     submit_info.pSignalSemaphores = signal_semaphore ? signal_semaphore->Ref() : nullptr;
+    std::lock_guard<std::mutex> lock(*m_Mutex);
     VK_CALL(vkQueueSubmit(m_Queue, 1, &submit_info, signal_fence ? signal_fence->Get() : VK_NULL_HANDLE));
   }
 
+  void VulkanQueue::Submit(Handle<CommandBuffer> cmd, const TimelinePoint &wait_timeline, const TimelinePoint &signal_timeline) {
+    MAU_PROFILE_SCOPR_COLOR("VulkanQueue::Submit", tracy::Color::Cyan);
+    ASSERT(cmd != nullptr);
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.pNext = nullptr;
+    timeline_info.waitSemaphoreValueCount = wait_timeline.Semaphore ? 1 : 0;
+    timeline_info.pWaitSemaphoreValues = &wait_timeline.Value;
+    timeline_info.signalSemaphoreValueCount = signal_timeline.Semaphore ? 1 : 0;
+    timeline_info.pSignalSemaphoreValues = &signal_timeline.Value;
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = wait_timeline.Semaphore ? 1 : 0;
+    submit_info.pWaitSemaphores = wait_timeline.Semaphore ? wait_timeline.Semaphore->Ref() : nullptr;
+    submit_info.pWaitDstStageMask = &wait_timeline.Stages;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = cmd->Ref();
+    submit_info.signalSemaphoreCount = signal_timeline.Semaphore ? 1 : 0;
+    submit_info.pSignalSemaphores = signal_timeline.Semaphore ? signal_timeline.Semaphore->Ref() : nullptr;
+    std::lock_guard<std::mutex> lock(*m_Mutex);
+    VK_CALL(vkQueueSubmit(m_Queue, 1, &submit_info, VK_NULL_HANDLE));
+  }
+
   void VulkanQueue::Submit(Handle<CommandBuffer> cmd) { Submit(cmd, 0u, nullptr, nullptr, nullptr); }
 
-  void VulkanQueue::WaitIdle() { VK_CALL(vkQueueWaitIdle(m_Queue)); }
+  void VulkanQueue::WaitIdle() {
+    std::lock_guard<std::mutex> lock(*m_Mutex);
+    VK_CALL(vkQueueWaitIdle(m_Queue));
+  }
 
-  PresentQueue::PresentQueue(VkQueue queue, VkDevice device): VulkanQueue(queue, device) { }
+  PresentQueue::PresentQueue(VkQueue queue, VkDevice device, std::mutex *mutex): VulkanQueue(queue, device, mutex) { }
 
   PresentQueue::~PresentQueue() { }
 
-  void PresentQueue::Present(TUint32 image_index, Handle<VulkanSwapchain> swapchain, Handle<Semaphore> wait_semaphore) {
+  void PresentQueue::Present(TUint32 image_index, const Handle<VulkanSwapchain> &swapchain, Handle<Semaphore> wait_semaphore) {
     MAU_PROFILE_SCOPR_COLOR("PresentQueue::Present", tracy::Color::Cyan);
     VkPresentInfoKHR present_info = {};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -48,7 +107,11 @@ namespace mau {
     present_info.pImageIndices = &image_index;
     present_info.pResults = nullptr;
 
-    VkResult result = vkQueuePresentKHR(m_Queue, &present_info);
+    VkResult result = VK_SUCCESS;
+    {
+      std::lock_guard<std::mutex> lock(*m_Mutex);
+      result = vkQueuePresentKHR(m_Queue, &present_info);
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
       return;
     } else {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include "common.h"
 #include "vulkan-sync.h"
 #include "vulkan-commands.h"
@@ -11,13 +12,16 @@ namespace mau {
     template <class T, typename... Args> friend Handle<T> make_handle(Args... args);
 
   protected:
-    VulkanQueue(VkQueue queue, VkDevice device);
+    // mutex is the device's, every queue made from the same device locks it
+    VulkanQueue(VkQueue queue, VkDevice device, std::mutex *mutex);
 
   public:
     virtual ~VulkanQueue();
 
   public:
-    void Submit(Handle<CommandBuffer> cmd, VkPipelineStageFlags wait_stages, Handle<Semaphore> wait_semaphore, Handle<Semaphore> signal_semaphore, Handle<Fence> signal_fence);
+    void Submit(Handle<CommandBuffer> cmd, VkPipelineStageFlags wait_stages, Handle<Semaphore> wait_semaphore, Handle<Semaphore> signal_semaphore, Handle<Fence> signal_fence,
+                const TimelinePoint &wait_timeline = {});
+    void Submit(Handle<CommandBuffer> cmd, const TimelinePoint &wait_timeline, const TimelinePoint &signal_timeline);
     void Submit(Handle<CommandBuffer> cmd);
     void WaitIdle();
 
@@ -25,19 +29,20 @@ namespace mau {
     const VkQueue *const Ref() const { return &m_Queue; }
 
   protected:
-    VkQueue  m_Queue = VK_NULL_HANDLE;
-    VkDevice m_Device = VK_NULL_HANDLE;
+    VkQueue     m_Queue = VK_NULL_HANDLE;
+    VkDevice    m_Device = VK_NULL_HANDLE;
+    std::mutex *m_Mutex = nullptr;
   };
 
   class PresentQueue final: public VulkanQueue {
     template <class T, typename... Args> friend Handle<T> make_handle(Args... args);
-    PresentQueue(VkQueue queue, VkDevice device);
+    PresentQueue(VkQueue queue, VkDevice device, std::mutex *mutex);
 
   public:
     ~PresentQueue();
 
   public:
-    void Present(TUint32 image_index, Handle<VulkanSwapchain> swapchain, Handle<Semaphore> wait_semaphore);
+    void Present(TUint32 image_index, const Handle<VulkanSwapchain> &swapchain, Handle<Semaphore> wait_semaphore);
   };
 
 } // namespace mau
@@ -108,7 +108,7 @@ namespace mau {
     VK_CALL(vkCreateRenderPass(VulkanState::Ref().GetDevice(), &create_info, nullptr, &m_Renderpass));
   }
 
-  void Renderpass::Begin(Handle<CommandBuffer> cmd, Handle<Framebuffer> framebuffer, VkRect2D area) {
+  void Renderpass::Begin(Handle<CommandBuffer> cmd, Handle<Framebuffer> framebuffer, VkRect2D area, VkSubpassContents contents) {
     ASSERT(m_Renderpass != VK_NULL_HANDLE);
 
     VkRenderPassBeginInfo renderpass_begin_info = {};
@@ -120,7 +120,7 @@ namespace mau {
     renderpass_begin_info.clearValueCount = static_cast<uint32_t>(m_ClearValues.size());
     renderpass_begin_info.pClearValues = m_ClearValues.data();
 
-    vkCmdBeginRenderPass(cmd->Get(), &renderpass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd->Get(), &renderpass_begin_info, contents);
   }
 
   void Renderpass::End(Handle<CommandBuffer> cmd) { vkCmdEndRenderPass(cmd->Get()); }
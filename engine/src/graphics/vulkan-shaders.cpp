@@ -1,77 +1,75 @@
 #include "vulkan-shaders.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <engine/log.h>
 #include <engine/types.h>
 #include <engine/engine.h>
+#include <engine/profiler.h>
+#include <engine/core/job-system.h>
 #include "vulkan-state.h"
+#include "shader-cache.h"
 
 namespace mau {
 
-  std::string read_file(std::string_view file_path) {
-    std::ifstream file(file_path.data());
-    if (!file) {
-      LOG_ERROR("failed to open file: %s", file_path.data());
-      return "";
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-  }
+  // compile options that end up in the spir-v, part of the cache key
+  static constexpr shaderc_spirv_version SHADER_SPIRV_VERSION = shaderc_spirv_version_1_4;
 
+  // serves includes from the files read_shader_source already loaded
   class IncluderInterface: public shaderc::CompileOptions::IncluderInterface {
   public:
-    IncluderInterface() = default;
+    IncluderInterface(const ShaderSource &source): m_Source(source) { }
     ~IncluderInterface() = default;
 
   public:
     virtual shaderc_include_result *GetInclude(const char *requested_source, shaderc_include_type type, const char *requesting_source, size_t include_depth) override {
-
-      String include_path = GetAssetFolderPath() + "shaders/" + requested_source;
-      char  *include_path_str = nullptr;
-      MAU_ALLOC_ARRAY(include_path_str, char, include_path.size() + 1);
-      memcpy(include_path_str, (include_path + "\0").c_str(), include_path.size() + 1);
-
-      String file_content = read_file(include_path);
-      char  *file_content_str = nullptr;
-      MAU_ALLOC_ARRAY(file_content_str, char, file_content.size() + 1);
-      memcpy(file_content_str, (file_content + "\0").c_str(), file_content.size() + 1);
-
       shaderc_include_result *result = nullptr;
       MAU_ALLOC(result, shaderc_include_result);
-      result->source_name = include_path_str;
-      result->source_name_length = include_path.size();
-      result->content = file_content_str;
-      result->content_length = file_content.size();
       result->user_data = nullptr;
 
+      auto include = m_Source.Includes.find(requested_source);
+      if (include == m_Source.Includes.end()) {
+        // an empty name reports the content as the error
+        static const char missing[] = "include not found";
+        result->source_name = "";
+        result->source_name_length = 0u;
+        result->content = missing;
+        result->content_length = sizeof(missing) - 1u;
+        return result;
+      }
+
+      result->source_name = include->first.c_str();
+      result->source_name_length = include->first.size();
+      result->content = include->second.c_str();
+      result->content_length = include->second.size();
       return result;
     }
 
     virtual void ReleaseInclude(shaderc_include_result *data) override {
       if (data) {
-        MAU_FREE_ARRAY(data->source_name);
-        MAU_FREE_ARRAY(data->content);
         MAU_FREE(data);
       }
     }
+
+  private:
+    const ShaderSource &m_Source;
   };
 
-  std::vector<TUint32> compile_shader(shaderc::Compiler &compiler, shaderc_shader_kind kind, std::string_view file_path) {
-    std::string raw = read_file(file_path);
-    if (raw.empty())
-      return std::vector<TUint32>();
+  // created on the first cache miss, a warm cache never starts the compiler. compiling is thread safe
+  static shaderc::Compiler &get_compiler() {
+    static shaderc::Compiler compiler;
+    return compiler;
+  }
+
+  std::vector<TUint32> compile_shader(const ShaderSource &source, shaderc_shader_kind kind) {
+    MAU_PROFILE_SCOPE("compile_shader");
 
     shaderc::CompileOptions options;
-    options.SetTargetSpirv(shaderc_spirv_version_1_4);
-    auto includer = std::unique_ptr<shaderc::CompileOptions::IncluderInterface>(new IncluderInterface());
-    options.SetIncluder(std::move(includer));
+    options.SetTargetSpirv(SHADER_SPIRV_VERSION);
+    options.SetIncluder(std::make_unique<IncluderInterface>(source));
 
-    shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(raw, kind, file_path.data(), options);
+    shaderc::SpvCompilationResult result = get_compiler().CompileGlslToSpv(source.Code, kind, source.Path.c_str(), options);
 
     if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
       LOG_ERROR("%s", result.GetErrorMessage().c_str());
@@ -81,10 +79,29 @@ namespace mau {
     return std::vector<TUint32>(result.begin(), result.end());
   }
 
-  Shader::Shader(std::string_view shader_path, shaderc_shader_kind kind, VkShaderStageFlagBits stage): m_Stage(stage) {
-    static shaderc::Compiler compiler;
+  Shader::Shader(std::string_view shader_path, shaderc_shader_kind kind, VkShaderStageFlagBits stage): m_Stage(stage), m_Path(shader_path) {
+    MAU_PROFILE_SCOPE("Shader::Shader");
+
+    ShaderSource source = {};
+    m_Dependencies.push_back(get_shader_dependency_path(m_Path));
+    if (!read_shader_source(m_Path, source))
+      return;
+
+    for (const auto &include : source.Includes) {
+      m_Dependencies.push_back(get_shader_dependency_path(GetAssetFolderPath() + "shaders/" + include.first));
+    }
+
+    // unchanged shaders load their spir-v, everything else is compiled and stored for the next run
+    const TUint64        key = get_shader_key(source, static_cast<TUint32>(kind), static_cast<TUint32>(SHADER_SPIRV_VERSION));
+    std::vector<TUint32> shader_code = {};
+    m_Cached = ShaderCache::Get() && ShaderCache::Ref().Load(key, shader_code);
+
+    if (!m_Cached) {
+      shader_code = compile_shader(source, kind);
+      if (ShaderCache::Get())
+        ShaderCache::Ref().Store(key, shader_code);
+    }
 
-    std::vector<TUint32> shader_code = compile_shader(compiler, kind, shader_path);
     if (!shader_code.size())
       return;
 
@@ -126,4 +143,46 @@ namespace mau {
 
   RTMissShader::RTMissShader(std::string_view shader_path): Shader(shader_path, shaderc_glsl_miss_shader, VK_SHADER_STAGE_MISS_BIT_KHR) { }
 
+  ComputeShader::ComputeShader(std::string_view shader_path): Shader(shader_path, shaderc_glsl_compute_shader, VK_SHADER_STAGE_COMPUTE_BIT) { }
+
+  TFloat64 ShaderCompileQueue::Compile() {
+    MAU_PROFILE_SCOPE("ShaderCompileQueue::Compile");
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    JobCounter counter = {};
+    for (Request &request : m_Requests) {
+      JobSystem::Ref().Schedule(
+          [&request]() -> void {
+            try {
+              request.Result = request.Create();
+            } catch (...) {
+              request.Error = std::current_exception();
+            }
+          },
+          &counter);
+    }
+    JobSystem::Ref().Wait(counter);
+
+    TUint32            cached = 0u;
+    std::exception_ptr error = nullptr;
+    for (Request &request : m_Requests) {
+      if (request.Result) {
+        cached += request.Result->IsCached() ? 1u : 0u;
+        request.Assign(request.Result);
+      }
+      if (request.Error && !error)
+        error = request.Error;
+    }
+
+    const TUint32 count = static_cast<TUint32>(m_Requests.size());
+    m_Requests.clear();
+
+    if (error)
+      std::rethrow_exception(error);
+
+    const TFloat64 ms = std::chrono::duration<TFloat64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO("loaded %u shaders in %.2f ms [from cache: %u, compiled: %u]", count, ms, cached, count - cached);
+    return ms;
+  }
+
 } // namespace mau
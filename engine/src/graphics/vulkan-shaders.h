@@ -1,5 +1,7 @@
 #pragma once
 
+#include <exception>
+#include <functional>
 #include <string_view>
 #include <engine/enums.h>
 #include <shaderc/shaderc.hpp>
@@ -14,10 +16,20 @@ namespace mau {
 
   public:
     VkPipelineShaderStageCreateInfo GetShaderStageInfo() const;
+    // the spir-v came from the shader cache instead of the compiler
+    inline bool IsCached() const { return m_Cached; }
+    // false when the shader failed to read or compile
+    inline bool          IsValid() const { return m_Module != VK_NULL_HANDLE; }
+    inline const String &GetPath() const { return m_Path; }
+    // normalized paths of the shader and every file it includes
+    inline const Vector<String> &GetDependencies() const { return m_Dependencies; }
 
   private:
     VkShaderModule        m_Module = VK_NULL_HANDLE;
     VkShaderStageFlagBits m_Stage = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+    bool                  m_Cached = false;
+    String                m_Path = "";
+    Vector<String>        m_Dependencies = {};
   };
 
   class VertexShader: public Shader {
@@ -50,4 +62,44 @@ namespace mau {
     ~RTMissShader() = default;
   };
 
+  class ComputeShader: public Shader {
+  public:
+    ComputeShader(std::string_view shader_path);
+    ~ComputeShader() = default;
+  };
+
+  // shaders loaded on the job system, so cache misses compile in parallel. shaders are handed out when Compile returns
+  class ShaderCompileQueue {
+  public:
+    ShaderCompileQueue() = default;
+    ~ShaderCompileQueue() = default;
+
+  public:
+    // T is one of the shader types above, target is assigned by Compile
+    template <typename T> void Add(Handle<T> &target, const String &path) {
+      m_Requests.push_back({
+          .Create = [path]() -> Shader * {
+            T *shader = nullptr;
+            MAU_ALLOC(shader, T, path);
+            return shader;
+          },
+          .Assign = [&target](Shader *shader) -> void { target = static_cast<T *>(shader); },
+      });
+    }
+
+    // returns the milliseconds it took, the first exception thrown while loading a shader is rethrown here
+    TFloat64 Compile();
+
+  private:
+    struct Request {
+      std::function<Shader *()>     Create = nullptr;
+      std::function<void(Shader *)> Assign = nullptr;
+      Shader                       *Result = nullptr;
+      std::exception_ptr            Error = nullptr;
+    };
+
+  private:
+    Vector<Request> m_Requests = {};
+  };
+
 } // namespace mau
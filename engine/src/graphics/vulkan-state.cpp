@@ -98,7 +98,7 @@ namespace mau {
     }
   }
 
-  VulkanState::VulkanState(bool enable_validation): m_Validation(enable_validation) {
+  VulkanState::VulkanState(bool enable_validation, bool headless): m_Validation(enable_validation) {
     // get available instance layers
     uint32_t instance_layer_count = 0;
     VK_CALL(vkEnumerateInstanceLayerProperties(&instance_layer_count, nullptr));
@@ -116,6 +116,9 @@ namespace mau {
       EnableInstanceLayer("VK_LAYER_KHRONOS_validation");
       EnableInstanceExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
+    if (headless)
+      return;
+
     // add surface extensions
     uint32_t           glfw_extension_count = 0u;
     const char *const *extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
@@ -128,6 +131,8 @@ namespace mau {
 
   VulkanState::~VulkanState() {
     ShutdownTracy();
+    m_UploadRing = nullptr;
+    m_ThreadCommandPools.clear();
     m_CommandPools.clear();
     m_Swapchain = nullptr;
     vmaDestroyAllocator(m_Allocator);
@@ -139,7 +144,7 @@ namespace mau {
     vkDestroyInstance(m_Instance, nullptr);
   }
 
-  void VulkanState::Init(std::string_view app_name, void *window) {
+  void VulkanState::Init(std::string_view app_name, void *window, VkExtent2D offscreen_extent) {
     VkApplicationInfo app_info = {};
     app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     app_info.pNext = NULL;
@@ -185,10 +190,11 @@ namespace mau {
     }
 
     // create window surface
-    ASSERT(window != nullptr);
-    GLFWwindow *glfw_window = reinterpret_cast<GLFWwindow *>(window);
-    VK_CALL_REASON(glfwCreateWindowSurface(m_Instance, glfw_window, nullptr, &m_Surface), "failed to create surface");
-    LOG_INFO("vulkan surface created");
+    if (window) {
+      GLFWwindow *glfw_window = reinterpret_cast<GLFWwindow *>(window);
+      VK_CALL_REASON(glfwCreateWindowSurface(m_Instance, glfw_window, nullptr, &m_Surface), "failed to create surface");
+      LOG_INFO("vulkan surface created");
+    }
 
     // pick physical device
     PickPhysicalDevice();
@@ -200,12 +206,19 @@ namespace mau {
     CreateVulkanMemoryAllocator();
 
     // create swapchain
-    m_Swapchain = make_handle<VulkanSwapchain>(m_Device->GetDevice(), m_PhysicalDevice, m_Surface);
+    if (m_Surface) {
+      m_Swapchain = make_handle<VulkanSwapchain>(m_Device->GetDevice(), m_PhysicalDevice, m_Surface);
+    } else {
+      m_Swapchain = make_handle<VulkanSwapchain>(m_Device->GetDevice(), m_PhysicalDevice, offscreen_extent);
+    }
 
     // pre-create command pools
     CreateCommandPool(VK_QUEUE_GRAPHICS_BIT);
     CreateCommandPool(VK_QUEUE_TRANSFER_BIT);
 
+    // staging ring for resource uploads
+    m_UploadRing = make_handle<UploadRing>();
+
     // init tracy
     InitTracy();
 
@@ -293,6 +306,13 @@ namespace mau {
     return nullptr;
   }
 
+  void VulkanState::CreateThreadCommandPools(TUint32 thread_count) {
+    // reset per command buffer, every thread keeps one secondary per frame in flight
+    while (m_ThreadCommandPools.size() < thread_count) {
+      m_ThreadCommandPools.push_back(make_handle<CommandPool>(m_Device->GetDevice(), m_Device->GetGraphicsQueueIndex(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+    }
+  }
+
   void VulkanState::PickPhysicalDevice() {
     uint32_t physical_device_count = 0u;
     VK_CALL(vkEnumeratePhysicalDevices(m_Instance, &physical_device_count, nullptr));
@@ -324,7 +344,9 @@ namespace mau {
     m_SelectedPhysicalDeviceIndex = static_cast<TUint32>(selected_physical_device);
     m_PhysicalDevice = available_physical_devices[static_cast<size_t>(selected_physical_device)];
 
+    m_AccelerationStructureProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR;
     m_RTPipelineProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR;
+    m_RTPipelineProperties.pNext = &m_AccelerationStructureProperties;
     VkPhysicalDeviceProperties2 selected_physical_device_properties2 = {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
         .pNext = &m_RTPipelineProperties,
@@ -12,6 +12,7 @@
 #include "vulkan-device.h"
 #include "vulkan-swapchain.h"
 #include "vulkan-commands.h"
+#include "vulkan-upload.h"
 
 #define MAU_GPU_ZONE(cmd, name) TracyVkZone(VulkanState::Ref().GetTracyCtx(), cmd, name)
 #define MAU_GPU_COLLECT(cmd) TracyVkCollect(VulkanState::Ref().GetTracyCtx(), cmd)
@@ -22,26 +23,38 @@ namespace mau {
     friend class Singleton<VulkanState>;
 
   private:
-    VulkanState(bool enable_validation = false);
+    // headless skips the window system instance extensions
+    VulkanState(bool enable_validation = false, bool headless = false);
     ~VulkanState();
 
   public:
-    void Init(std::string_view app_name, void *window);
+    // without a window nothing is presented and the swapchain is replaced by offscreen images of offscreen_extent
+    void Init(std::string_view app_name, void *window, VkExtent2D offscreen_extent = {});
     bool EnableInstanceLayer(std::string_view layer_name) noexcept;
     bool EnableInstanceExtension(std::string_view extension_name) noexcept;
     void SetValidationSeverity(VulkanValidationLogSeverity severity, bool enabled) noexcept;
     void SetValidationSeverity(TUint32 flags) noexcept;
 
     Handle<CommandPool> GetCommandPool(VkQueueFlagBits queue_type);
+
+    // graphics pools for threads recording secondary command buffers, a pool is only used by one thread at a time
+    void                       CreateThreadCommandPools(TUint32 thread_count);
+    inline Handle<CommandPool> GetThreadCommandPool(TUint32 thread_index) const { return m_ThreadCommandPools[thread_index]; }
+    inline TUint32             GetThreadCommandPoolCount() const { return static_cast<TUint32>(m_ThreadCommandPools.size()); }
+
     inline VmaAllocator GetVulkanMemoryAllocator() const { return m_Allocator; }
     inline VkInstance   GetInstance() const { return m_Instance; }
 
-    inline VkDevice             GetDevice() const { return m_Device->GetDevice(); }
-    inline Handle<VulkanDevice> GetDeviceHandle() const { return m_Device; }
-    inline VkPhysicalDevice     GetPhysicalDevice() const { return m_PhysicalDevice; }
+    // the device, swapchain and upload ring handles are used by the render thread and the main thread, they are handed
+    // out by reference so neither copies them and races on the refcount
+    inline VkDevice                    GetDevice() const { return m_Device->GetDevice(); }
+    inline const Handle<VulkanDevice> &GetDeviceHandle() const { return m_Device; }
+    inline VkPhysicalDevice            GetPhysicalDevice() const { return m_PhysicalDevice; }
 
+    // no surface, the swapchain images are offscreen and nothing is presented
+    inline bool                                 IsHeadless() const { return m_Surface == VK_NULL_HANDLE; }
     inline VkSwapchainKHR                       GetSwapchain() const { return m_Swapchain->GetSwapchain(); }
-    inline Handle<VulkanSwapchain>              GetSwapchainHandle() const { return m_Swapchain; }
+    inline const Handle<VulkanSwapchain>       &GetSwapchainHandle() const { return m_Swapchain; }
     inline VkFormat                             GetSwapchainColorFormat() const { return m_Swapchain->GetColorFormat(); }
     inline VkFormat                             GetSwapchainDepthFormat() const { return m_Swapchain->GetDepthFormat(); }
     inline VkExtent2D                           GetSwapchainExtent() const { return m_Swapchain->GetExtent(); }
@@ -49,7 +62,10 @@ namespace mau {
     inline const std::vector<Handle<ImageView>> GetSwapchainDepthImageViews() const { return m_Swapchain->GetDepthImageViews(); }
     inline VkPhysicalDeviceProperties           GetPhysicalDeviceProperties() const { return m_PhysicalDeviceProperties; }
 
-    inline VkPhysicalDeviceRayTracingPipelinePropertiesKHR GetRTPipelineProperties() const { return m_RTPipelineProperties; }
+    inline VkPhysicalDeviceRayTracingPipelinePropertiesKHR    GetRTPipelineProperties() const { return m_RTPipelineProperties; }
+    inline VkPhysicalDeviceAccelerationStructurePropertiesKHR GetAccelerationStructureProperties() const { return m_AccelerationStructureProperties; }
+
+    inline const Handle<UploadRing> &GetUploadRing() const { return m_UploadRing; }
 
     inline TracyVkCtx GetTracyCtx() const { return m_TracyContext; }
 
@@ -80,7 +96,8 @@ namespace mau {
     VkPhysicalDeviceProperties m_PhysicalDeviceProperties = {};
 
     // extension properties
-    VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_RTPipelineProperties = {};
+    VkPhysicalDeviceRayTracingPipelinePropertiesKHR    m_RTPipelineProperties = {};
+    VkPhysicalDeviceAccelerationStructurePropertiesKHR m_AccelerationStructureProperties = {};
 
     // custom wrappers
     Handle<VulkanDevice>    m_Device = nullptr;
@@ -91,6 +108,10 @@ namespace mau {
 
     // command pools
     std::unordered_map<VkQueueFlagBits, Handle<CommandPool>> m_CommandPools = {};
+    std::vector<Handle<CommandPool>>                         m_ThreadCommandPools = {};
+
+    // batched staging uploads on the transfer queue
+    Handle<UploadRing> m_UploadRing = nullptr;
 
     // tracy profiler context
     TracyVkCtx            m_TracyContext = nullptr;
@@ -1,6 +1,7 @@
 #include "vulkan-swapchain.h"
 
 #include <engine/assert.h>
+#include "vulkan-state.h"
 
 namespace mau {
 
@@ -12,14 +13,32 @@ namespace mau {
     CreateSwapchain();
   }
 
+  VulkanSwapchain::VulkanSwapchain(VkDevice device, VkPhysicalDevice physical_device, VkExtent2D extent, TUint32 image_count): m_Device(device), m_PhysicalDevice(physical_device) {
+    ASSERT(m_Device != VK_NULL_HANDLE);
+    ASSERT(m_PhysicalDevice != VK_NULL_HANDLE);
+    ASSERT(extent.width > 0u && extent.height > 0u && image_count > 0u);
+
+    m_Extent = extent;
+    m_ImageCount = image_count;
+
+    CreateOffscreenImages();
+  }
+
   VulkanSwapchain::~VulkanSwapchain() { DestroySwapchain(); }
 
   TUint32 VulkanSwapchain::GetNextImageIndex(Handle<Semaphore> signal) {
     TUint32 image_index = 0u;
 
+    // offscreen images are ready as soon as the frame that last used them finished, signal is never waited on
+    if (IsOffscreen()) {
+      image_index = m_NextOffscreenImage;
+      m_NextOffscreenImage = (m_NextOffscreenImage + 1u) % m_ImageCount;
+      return image_index;
+    }
+
     VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, signal->Get(), VK_NULL_HANDLE, &image_index);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-      vkDeviceWaitIdle(m_Device);
+      VulkanState::Ref().GetDeviceHandle()->WaitIdle();
       DestroySwapchain();
       CreateSwapchain();
       VK_CALL(vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, signal->Get(), VK_NULL_HANDLE, &image_index));
@@ -104,7 +123,44 @@ namespace mau {
       m_SwapchainImageViews.push_back(make_handle<ImageView>(image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT));
     }
 
-    // create depth images
+    CreateDepthImages();
+
+    // execute callbacks
+    for (const auto &callback : m_SwapchainCreateCallback) {
+      callback();
+    }
+
+    LOG_INFO("vulkan swachain created");
+  }
+
+  void VulkanSwapchain::CreateOffscreenImages() {
+    // only the image count is read from the capabilities, by imgui
+    m_SurfaceCapabilities = {};
+    m_SurfaceCapabilities.minImageCount = m_ImageCount;
+    m_SurfaceCapabilities.maxImageCount = m_ImageCount;
+    m_SurfaceCapabilities.currentExtent = m_Extent;
+    m_SurfaceCapabilities.minImageExtent = m_Extent;
+    m_SurfaceCapabilities.maxImageExtent = m_Extent;
+
+    m_Format = {.format = VK_FORMAT_R8G8B8A8_UNORM, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+
+    // transfer src and sampled so a finished frame can be read back or shown elsewhere
+    const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    m_SwapchainImages.reserve(static_cast<size_t>(m_ImageCount));
+    m_SwapchainImageViews.reserve(static_cast<size_t>(m_ImageCount));
+    for (TUint32 i = 0; i < m_ImageCount; i++) {
+      Handle<Image> image = make_handle<Image>(m_Extent.width, m_Extent.height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, m_Format.format, VK_IMAGE_TILING_OPTIMAL, usage);
+      m_SwapchainImages.push_back(image);
+      m_SwapchainImageViews.push_back(make_handle<ImageView>(image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT));
+    }
+
+    CreateDepthImages();
+
+    LOG_INFO("offscreen images created [%u, %u] x %u", m_Extent.width, m_Extent.height, m_ImageCount);
+  }
+
+  void VulkanSwapchain::CreateDepthImages() {
     m_DepthFormat = GetDepthFormat(VK_IMAGE_TILING_OPTIMAL);
     m_DepthImages.reserve(m_SwapchainImages.size());
     m_DepthImageViews.reserve(m_SwapchainImages.size());
@@ -115,13 +171,6 @@ namespace mau {
       m_DepthImages.push_back(depth_image);
       m_DepthImageViews.push_back(depth_image_view);
     }
-
-    // execute callbacks
-    for (const auto &callback : m_SwapchainCreateCallback) {
-      callback();
-    }
-
-    LOG_INFO("vulkan swachain created");
   }
 
   VkFormat VulkanSwapchain::GetDepthFormat(VkImageTiling tiling) {
@@ -150,8 +199,10 @@ namespace mau {
     m_SurfaceFormats.clear();
     m_PresentModes.clear();
 
-    vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
-    m_Swapchain = VK_NULL_HANDLE;
+    if (m_Swapchain != VK_NULL_HANDLE) {
+      vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
+      m_Swapchain = VK_NULL_HANDLE;
+    }
   }
 
 } // namespace mau
@@ -9,9 +9,14 @@
 
 namespace mau {
 
+  // images cycled through when there is no surface to present to
+  constexpr TUint32 OFFSCREEN_IMAGE_COUNT = 3u;
+
   class VulkanSwapchain: public HandledObject {
   public:
     VulkanSwapchain(VkDevice device, VkPhysicalDevice physical_device, VkSurfaceKHR surface);
+    // offscreen, same interface backed by plain images that are never presented
+    VulkanSwapchain(VkDevice device, VkPhysicalDevice physical_device, VkExtent2D extent, TUint32 image_count = OFFSCREEN_IMAGE_COUNT);
     ~VulkanSwapchain();
 
   public:
@@ -29,9 +34,12 @@ namespace mau {
     inline const std::vector<Handle<ImageView>> &GetDepthImageViews() const { return m_DepthImageViews; }
     inline const std::vector<Handle<Image>>     &GetImages() const { return m_SwapchainImages; }
     inline const std::vector<Handle<Image>>     &GetDepthImages() const { return m_DepthImages; }
+    inline bool                                  IsOffscreen() const { return m_Surface == VK_NULL_HANDLE; }
 
   private:
     void     CreateSwapchain();
+    void     CreateOffscreenImages();
+    void     CreateDepthImages();
     VkFormat GetDepthFormat(VkImageTiling tiling);
     void     DestroySwapchain();
 
@@ -49,6 +57,7 @@ namespace mau {
     const VkPresentModeKHR m_PrefferedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
 
     TUint32                        m_ImageCount = 0u;
+    TUint32                        m_NextOffscreenImage = 0u;
     VkExtent2D                     m_Extent = {};
     VkSurfaceFormatKHR             m_Format = {};
     VkFormat                       m_DepthFormat = VK_FORMAT_UNDEFINED;
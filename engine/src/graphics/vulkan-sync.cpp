@@ -33,4 +33,41 @@ namespace mau {
     VK_CALL(vkWaitForFences(VulkanState::Ref().GetDevice(), 1, &m_Fence, VK_TRUE, UINT64_MAX));
   }
 
+  TimelineSemaphore::TimelineSemaphore(TUint64 initial_value) {
+    VkSemaphoreTypeCreateInfo type_info = {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.pNext = nullptr;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = initial_value;
+
+    VkSemaphoreCreateInfo create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    create_info.pNext = &type_info;
+    create_info.flags = 0u;
+
+    VK_CALL(vkCreateSemaphore(VulkanState::Ref().GetDevice(), &create_info, nullptr, &m_Semaphore));
+  }
+
+  TimelineSemaphore::~TimelineSemaphore() { vkDestroySemaphore(VulkanState::Ref().GetDevice(), m_Semaphore, nullptr); }
+
+  TUint64 TimelineSemaphore::GetValue() const {
+    TUint64 value = 0u;
+    VK_CALL(vkGetSemaphoreCounterValue(VulkanState::Ref().GetDevice(), m_Semaphore, &value));
+    return value;
+  }
+
+  void TimelineSemaphore::Wait(TUint64 value) const {
+    MAU_PROFILE_SCOPR_COLOR("TimelineSemaphore::Wait", tracy::Color::Cyan);
+
+    VkSemaphoreWaitInfo wait_info = {};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.pNext = nullptr;
+    wait_info.flags = 0u;
+    wait_info.semaphoreCount = 1u;
+    wait_info.pSemaphores = &m_Semaphore;
+    wait_info.pValues = &value;
+
+    VK_CALL(vkWaitSemaphores(VulkanState::Ref().GetDevice(), &wait_info, UINT64_MAX));
+  }
+
 } // namespace mau
@@ -35,4 +35,29 @@ namespace mau {
     VkFence m_Fence = VK_NULL_HANDLE;
   };
 
+  class TimelineSemaphore: public HandledObject {
+  public:
+    TimelineSemaphore(TUint64 initial_value = 0u);
+    ~TimelineSemaphore();
+
+  public:
+    TUint64 GetValue() const;
+    void    Wait(TUint64 value) const;
+
+  public:
+    inline VkSemaphore        Get() const { return m_Semaphore; }
+    inline const VkSemaphore *Ref() const { return &m_Semaphore; }
+
+  private:
+    VkSemaphore m_Semaphore = VK_NULL_HANDLE;
+  };
+
+  // a value on a timeline semaphore, used as a submit wait or signal. points are passed between threads, the semaphore
+  // is borrowed from an owner that outlives them
+  struct TimelinePoint {
+    TimelineSemaphore   *Semaphore = nullptr;
+    TUint64              Value = 0u;
+    VkPipelineStageFlags Stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  };
+
 } // namespace mau
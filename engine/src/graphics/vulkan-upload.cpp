@@ -0,0 +1,225 @@
+#include "vulkan-upload.h"
+
+#include <cstring>
+#include <engine/assert.h>
+#include <engine/profiler.h>
+
+#include "vulkan-state.h"
+
+namespace mau {
+
+  static TUint64 align_up(TUint64 value, TUint64 alignment) { return (value + alignment - 1u) & ~(alignment - 1u); }
+
+  UploadRing::UploadRing(TUint64 capacity): m_Capacity(align_up(capacity, UPLOAD_RING_ALIGNMENT)) {
+    ASSERT(m_Capacity > 0u);
+
+    m_FlushThreshold = m_Capacity / 4u;
+    m_Staging = make_handle<Buffer>(m_Capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    m_Memory = reinterpret_cast<TUint8 *>(m_Staging->Map());
+    m_Timeline = make_handle<TimelineSemaphore>();
+
+    LOG_INFO("upload ring created [size: %llu MiB]", static_cast<unsigned long long>(m_Capacity >> 20u));
+  }
+
+  UploadRing::~UploadRing() {
+    WaitIdle();
+    m_RetiredImages.clear();
+    m_FreeCommandBuffers.clear();
+    m_Staging = nullptr;
+    m_Timeline = nullptr;
+  }
+
+  TUint64 UploadRing::EnqueueBuffer(VkBuffer dst, const void *data, TUint64 size, TUint64 dst_offset) {
+    MAU_PROFILE_SCOPE("UploadRing::EnqueueBuffer");
+    ASSERT(dst != VK_NULL_HANDLE && data);
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+    Handle<Buffer> staging = nullptr;
+    VkBuffer       src = m_Staging->Get();
+    TUint64        src_offset = 0u;
+
+    if (Allocate(size, src_offset)) {
+      memcpy(m_Memory + src_offset, data, size);
+      m_Staging->FlushMapped(src_offset, size);
+    } else {
+      // too large for the ring, stage it on its own and keep it alive with the batch
+      staging = make_handle<Buffer>(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+      memcpy(staging->Map(), data, size);
+      staging->FlushMapped(0u, size);
+      staging->UnMap();
+      src = staging->Get();
+    }
+
+    Handle<CommandBuffer> cmd = BeginBatch();
+    if (staging)
+      m_Open.Staging.push_back(staging);
+
+    VkBufferCopy copy_region = {};
+    copy_region.srcOffset = src_offset;
+    copy_region.dstOffset = dst_offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(cmd->Get(), src, dst, 1u, &copy_region);
+
+    m_OpenBytes += size;
+    return m_OpenBytes >= m_FlushThreshold ? Flush() : m_SubmittedValue + 1u;
+  }
+
+  TUint64 UploadRing::EnqueueImage(Handle<Image> image, const void *data, TUint64 size, const Vector<TextureMip> &mips) {
+    MAU_PROFILE_SCOPE("UploadRing::EnqueueImage");
+    ASSERT(image && data);
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+    Handle<Buffer> staging = nullptr;
+    VkBuffer       src = m_Staging->Get();
+    TUint64        src_offset = 0u;
+
+    if (Allocate(size, src_offset)) {
+      memcpy(m_Memory + src_offset, data, size);
+      m_Staging->FlushMapped(src_offset, size);
+    } else {
+      staging = make_handle<Buffer>(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+      memcpy(staging->Map(), data, size);
+      staging->FlushMapped(0u, size);
+      staging->UnMap();
+      src = staging->Get();
+    }
+
+    Handle<CommandBuffer> cmd = BeginBatch();
+    if (staging)
+      m_Open.Staging.push_back(staging);
+    m_Open.Images.push_back(image);
+
+    TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    if (mips.empty()) {
+      CopyBufferToImage(cmd, src, src_offset, image, image->GetWidth(), image->GetHeight());
+    } else {
+      for (size_t i = 0; i < mips.size(); i++) {
+        CopyBufferToImage(cmd, src, src_offset + mips[i].Offset, image, mips[i].Width, mips[i].Height, static_cast<TUint32>(i));
+      }
+    }
+    // the transfer queue cannot name the shader stages, frames wait on the upload timeline before sampling
+    TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    m_OpenBytes += size;
+    return m_OpenBytes >= m_FlushThreshold ? Flush() : m_SubmittedValue + 1u;
+  }
+
+  TUint64 UploadRing::Flush() {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (!m_Open.Cmd)
+      return m_SubmittedValue;
+
+    MAU_PROFILE_SCOPE("UploadRing::Flush");
+
+    m_Open.Cmd->End();
+    m_Open.Value = ++m_SubmittedValue;
+    m_Open.RingEnd = m_Head;
+
+    TimelinePoint signal = {
+        .Semaphore = &*m_Timeline,
+        .Value = m_Open.Value,
+    };
+
+    const Handle<VulkanQueue> &transfer_queue = VulkanState::Ref().GetDeviceHandle()->GetTransferQueue();
+    transfer_queue->Submit(m_Open.Cmd, {}, signal);
+
+    // handles ignore assignment from null, so the open batch is cleared by hand
+    m_InFlight.push_back(m_Open);
+    m_Open.Cmd = nullptr;
+    m_Open.Staging.clear();
+    m_Open.Images.clear();
+    m_OpenBytes = 0u;
+
+    Reclaim();
+    return m_SubmittedValue;
+  }
+
+  void UploadRing::Retire() {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    Reclaim();
+    m_RetiredImages.clear();
+  }
+
+  void UploadRing::Wait(TUint64 value) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (value > m_SubmittedValue)
+      Flush();
+
+    m_Timeline->Wait(value);
+    Reclaim();
+  }
+
+  void UploadRing::WaitIdle() { Wait(Flush()); }
+
+  TimelinePoint UploadRing::GetPendingPoint(VkPipelineStageFlags stages) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+    TimelinePoint point = {
+        .Semaphore = &*m_Timeline,
+        .Value = Flush(),
+        .Stages = stages,
+    };
+
+    return point;
+  }
+
+  Handle<CommandBuffer> UploadRing::BeginBatch() {
+    if (m_Open.Cmd)
+      return m_Open.Cmd;
+
+    if (m_FreeCommandBuffers.empty()) {
+      m_Open.Cmd = VulkanState::Ref().GetCommandPool(VK_QUEUE_TRANSFER_BIT)->AllocateCommandBuffers(1)[0];
+    } else {
+      m_Open.Cmd = m_FreeCommandBuffers.back();
+      m_FreeCommandBuffers.pop_back();
+      m_Open.Cmd->Reset();
+    }
+
+    m_Open.Cmd->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    return m_Open.Cmd;
+  }
+
+  bool UploadRing::Allocate(TUint64 size, TUint64 &offset) {
+    if (size > m_Capacity / 2u)
+      return false;
+
+    // copies never wrap, skip the end of the ring if the block does not fit
+    TUint64 head = align_up(m_Head, UPLOAD_RING_ALIGNMENT);
+    if (head % m_Capacity + size > m_Capacity)
+      head += m_Capacity - head % m_Capacity;
+
+    while (head + size - m_Tail > m_Capacity) {
+      // the open batch may be holding the space that is needed
+      if (m_InFlight.empty())
+        Flush();
+      WaitOldest();
+    }
+
+    offset = head % m_Capacity;
+    m_Head = head + size;
+    return true;
+  }
+
+  void UploadRing::WaitOldest() {
+    MAU_PROFILE_SCOPR_COLOR("UploadRing::WaitOldest", tracy::Color::Cyan);
+    ASSERT(!m_InFlight.empty());
+
+    m_Timeline->Wait(m_InFlight.front().Value);
+    Reclaim();
+  }
+
+  void UploadRing::Reclaim() {
+    if (m_InFlight.empty())
+      return;
+
+    const TUint64 completed = m_Timeline->GetValue();
+    while (!m_InFlight.empty() && m_InFlight.front().Value <= completed) {
+      Batch &batch = m_InFlight.front();
+      m_Tail = batch.RingEnd;
+      m_FreeCommandBuffers.push_back(batch.Cmd);
+      m_RetiredImages.insert(m_RetiredImages.end(), batch.Images.begin(), batch.Images.end());
+      m_InFlight.pop_front();
+    }
+  }
+
+} // namespace mau
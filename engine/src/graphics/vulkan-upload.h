@@ -0,0 +1,85 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <engine/types.h>
+#include "common.h"
+#include "vulkan-sync.h"
+#include "vulkan-commands.h"
+#include "vulkan-buffers.h"
+#include "vulkan-image.h"
+
+namespace mau {
+
+  constexpr TUint64 DEFAULT_UPLOAD_RING_SIZE = 64ull * 1024ull * 1024ull;
+  constexpr TUint64 UPLOAD_RING_ALIGNMENT = 16ull;
+
+  // persistent staging ring, copies are recorded into one open transfer
+  // command buffer and submitted in batches that signal a timeline value.
+  // locked, the main thread enqueues while the render thread flushes for its
+  // submit. images kept alive by batches are only released by Retire
+  class UploadRing: public HandledObject {
+  public:
+    UploadRing(TUint64 capacity = DEFAULT_UPLOAD_RING_SIZE);
+    ~UploadRing();
+
+  public:
+    // dst must stay alive until the returned batch value is reached
+    TUint64 EnqueueBuffer(VkBuffer dst, const void *data, TUint64 size, TUint64 dst_offset = 0u);
+    // mips index into data, empty copies data as the single top level
+    TUint64 EnqueueImage(Handle<Image> image, const void *data, TUint64 size, const Vector<TextureMip> &mips = {});
+
+    TUint64 Flush();
+    // main thread only, drops the images of completed batches
+    void    Retire();
+    void    Wait(TUint64 value);
+    void    WaitIdle();
+
+    // everything enqueued so far, flushes the open batch
+    TimelinePoint GetPendingPoint(VkPipelineStageFlags stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+  public:
+    inline const Handle<TimelineSemaphore> &GetTimeline() const { return m_Timeline; }
+    inline TUint64                          GetSubmittedValue() const { return m_SubmittedValue; }
+    inline TUint64                          GetCapacity() const { return m_Capacity; }
+    inline TUint64                          GetUsedBytes() const { return m_Head - m_Tail; }
+
+  private:
+    struct Batch {
+      Handle<CommandBuffer>  Cmd = nullptr;
+      TUint64                Value = 0u;
+      TUint64                RingEnd = 0u;
+      Vector<Handle<Buffer>> Staging = {};
+      Vector<Handle<Image>>  Images = {};
+    };
+
+  private:
+    Handle<CommandBuffer> BeginBatch();
+    bool                  Allocate(TUint64 size, TUint64 &offset);
+    void                  WaitOldest();
+    // recycles the space and command buffers of completed batches, their images wait for Retire
+    void                  Reclaim();
+
+  private:
+    Handle<Buffer>            m_Staging = nullptr;
+    Handle<TimelineSemaphore> m_Timeline = nullptr;
+    TUint8                   *m_Memory = nullptr;
+    TUint64                   m_Capacity = 0u;
+    TUint64                   m_FlushThreshold = 0u;
+
+    // monotonic byte positions, the ring offset is position % capacity
+    TUint64 m_Head = 0u;
+    TUint64 m_Tail = 0u;
+
+    Batch                         m_Open = {};
+    TUint64                       m_OpenBytes = 0u;
+    TUint64                       m_SubmittedValue = 0u;
+    std::deque<Batch>             m_InFlight = {};
+    Vector<Handle<CommandBuffer>> m_FreeCommandBuffers = {};
+    Vector<Handle<Image>>         m_RetiredImages = {};
+
+    // public calls nest, an enqueue can flush and an allocation can wait
+    std::recursive_mutex m_Mutex = {};
+  };
+
+} // namespace mau
@@ -0,0 +1,64 @@
+#include "image-writer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <engine/log.h>
+
+namespace mau {
+
+  bool write_pfm(const String &path, TUint32 width, TUint32 height, const TFloat32 *pixels) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", path.c_str());
+      return false;
+    }
+
+    // a negative scale marks little endian data, rows are stored bottom to top
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+    Vector<TFloat32> row(static_cast<size_t>(width) * 3u);
+    for (TUint32 y = height; y-- > 0u;) {
+      const TFloat32 *source = pixels + static_cast<size_t>(y) * width * 4u;
+      for (TUint32 x = 0u; x < width; x++) {
+        row[x * 3u + 0u] = source[x * 4u + 0u];
+        row[x * 3u + 1u] = source[x * 4u + 1u];
+        row[x * 3u + 2u] = source[x * 4u + 2u];
+      }
+      file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(TFloat32)));
+    }
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write %s", path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  bool write_ppm(const String &path, TUint32 width, TUint32 height, const TFloat32 *pixels) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", path.c_str());
+      return false;
+    }
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    Vector<TUint8> row(static_cast<size_t>(width) * 3u);
+    for (TUint32 y = 0u; y < height; y++) {
+      const TFloat32 *source = pixels + static_cast<size_t>(y) * width * 4u;
+      for (TUint32 x = 0u; x < width * 3u; x++) {
+        row[x] = static_cast<TUint8>(std::clamp(source[(x / 3u) * 4u + x % 3u], 0.0f, 1.0f) * 255.0f + 0.5f);
+      }
+      file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write %s", path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+} // namespace mau
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // pixels are rgba floats, row 0 at the top. alpha is dropped, both formats only store rgb
+
+  // portable float map, keeps the linear values as they are
+  bool write_pfm(const String &path, TUint32 width, TUint32 height, const TFloat32 *pixels);
+
+  // binary portable pixmap, values are clamped to [0, 1] and stored as 8 bit
+  bool write_ppm(const String &path, TUint32 width, TUint32 height, const TFloat32 *pixels);
+
+} // namespace mau
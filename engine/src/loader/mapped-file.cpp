@@ -0,0 +1,94 @@
+#include "mapped-file.h"
+
+#include <engine/log.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mau {
+
+#if defined(_WIN32)
+
+  MappedFile::MappedFile(const String &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+      LOG_ERROR("failed to create file mapping: %s", path.c_str());
+      CloseHandle(file);
+      return;
+    }
+
+    m_Data = reinterpret_cast<const TUint8 *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_Data == nullptr) {
+      LOG_ERROR("failed to map file: %s", path.c_str());
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return;
+    }
+
+    m_Size = static_cast<TUint64>(size.QuadPart);
+    m_File = file;
+    m_Mapping = mapping;
+  }
+
+  MappedFile::~MappedFile() {
+    if (m_Data)
+      UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+      CloseHandle(m_Mapping);
+    if (m_File)
+      CloseHandle(m_File);
+  }
+
+#else
+
+  MappedFile::MappedFile(const String &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      close(fd);
+      return;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+      LOG_ERROR("failed to map file: %s", path.c_str());
+      return;
+    }
+
+    // the blocks are read front to back into staging buffers, start paging them in now
+    madvise(data, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+    m_Data = reinterpret_cast<const TUint8 *>(data);
+    m_Size = static_cast<TUint64>(info.st_size);
+  }
+
+  MappedFile::~MappedFile() {
+    if (m_Data)
+      munmap(const_cast<TUint8 *>(m_Data), static_cast<size_t>(m_Size));
+  }
+
+#endif
+
+} // namespace mau
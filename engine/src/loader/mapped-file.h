@@ -0,0 +1,31 @@
+#pragma once
+
+#include <engine/types.h>
+
+namespace mau {
+
+  // read-only memory mapping of a whole file
+  class MappedFile {
+  public:
+    MappedFile(const String &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+  public:
+    inline bool          IsValid() const { return m_Data != nullptr; }
+    inline const TUint8 *GetData() const { return m_Data; }
+    inline TUint64       GetSize() const { return m_Size; }
+
+  private:
+    const TUint8 *m_Data = nullptr;
+    TUint64       m_Size = 0u;
+
+#if defined(_WIN32)
+    void *m_File = nullptr;
+    void *m_Mapping = nullptr;
+#endif
+  };
+
+} // namespace mau
@@ -0,0 +1,376 @@
+#include "mesh-cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include <engine/loader/cooker.h>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+namespace mau {
+
+  static TUint64 align_offset(TUint64 offset) { return (offset + COOKED_MESH_ALIGNMENT - 1u) & ~(COOKED_MESH_ALIGNMENT - 1u); }
+
+  // remembers every file an import opened, the buffers next to a gltf for example
+  class RecordingIOSystem: public Assimp::DefaultIOSystem {
+  public:
+    Assimp::IOStream *Open(const char *file, const char *mode = "rb") override {
+      Assimp::IOStream *stream = Assimp::DefaultIOSystem::Open(file, mode);
+      if (stream != nullptr)
+        Opened.push_back(file);
+      return stream;
+    }
+
+  public:
+    Vector<String> Opened = {};
+  };
+
+  TUint64 hash_file(const String &path) {
+    MappedFile file(path);
+    if (!file.IsValid())
+      return 0u;
+
+    TUint64       hash = 0xcbf29ce484222325ull;
+    const TUint8 *data = file.GetData();
+    for (TUint64 i = 0; i < file.GetSize(); i++) {
+      hash ^= data[i];
+      hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+  }
+
+  CookedMesh::CookedMesh(const String &cooked_path, const String &source_path) {
+    MAU_PROFILE_SCOPE("CookedMesh::CookedMesh");
+
+    CookedMeshHeader header = {};
+    if (!Map(cooked_path, header))
+      return;
+
+    if (std::filesystem::exists(source_path) && !IsCurrent(source_path, header)) {
+      LOG_INFO("cooked mesh %s is out of date", cooked_path.c_str());
+      m_SubMeshes.clear();
+      return;
+    }
+
+    m_Valid = true;
+  }
+
+  bool CookedMesh::Map(const String &cooked_path, CookedMeshHeader &header) {
+    m_File = std::make_unique<MappedFile>(cooked_path);
+    if (!m_File->IsValid())
+      return false;
+
+    const TUint8 *data = m_File->GetData();
+    const TUint64 size = m_File->GetSize();
+
+    if (size < sizeof(CookedMeshHeader)) {
+      LOG_WARN("cooked mesh %s is truncated", cooked_path.c_str());
+      return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+
+    if (header.Magic != COOKED_MESH_MAGIC || header.Version != COOKED_MESH_VERSION || header.VertexSize != sizeof(Vertex)) {
+      LOG_WARN("cooked mesh %s has an incompatible format", cooked_path.c_str());
+      return false;
+    }
+
+    if (header.ImportFlags != get_mesh_import_flags()) {
+      LOG_INFO("cooked mesh %s is out of date", cooked_path.c_str());
+      return false;
+    }
+
+    const TUint64 table_offset = sizeof(CookedMeshHeader);
+    const TUint64 strings_offset = table_offset + header.SubMeshCount * sizeof(CookedSubMesh) + header.DependencyCount * sizeof(CookedDependency);
+
+    if (strings_offset + header.StringTableSize > size) {
+      LOG_WARN("cooked mesh %s is truncated", cooked_path.c_str());
+      return false;
+    }
+
+    const char *strings = reinterpret_cast<const char *>(data + strings_offset);
+
+    for (TUint32 i = 0; i < header.SubMeshCount; i++) {
+      CookedSubMesh submesh = {};
+      memcpy(&submesh, data + table_offset + i * sizeof(CookedSubMesh), sizeof(submesh));
+
+      const bool in_bounds = submesh.VertexOffset + submesh.VertexCount * sizeof(Vertex) <= size && submesh.IndexOffset + submesh.IndexCount * sizeof(TUint32) <= size &&
+                             submesh.DiffuseMapOffset + submesh.DiffuseMapLength <= header.StringTableSize && submesh.NormalMapOffset + submesh.NormalMapLength <= header.StringTableSize;
+      const bool aligned = submesh.VertexOffset % COOKED_MESH_ALIGNMENT == 0u && submesh.IndexOffset % COOKED_MESH_ALIGNMENT == 0u;
+
+      bool lods_valid = submesh.Lods.Count > 0u && submesh.Lods.Count <= MAX_MESH_LODS;
+      for (TUint32 level = 0; lods_valid && level < submesh.Lods.Count; level++) {
+        lods_valid = static_cast<TUint64>(submesh.Lods.Levels[level].FirstIndex) + submesh.Lods.Levels[level].IndexCount <= submesh.IndexCount;
+      }
+
+      if (!in_bounds || !aligned || !lods_valid) {
+        LOG_WARN("cooked mesh %s has a corrupt submesh table", cooked_path.c_str());
+        m_SubMeshes.clear();
+        return false;
+      }
+
+      CookedSubMeshView view = {
+          .Vertices = reinterpret_cast<const Vertex *>(data + submesh.VertexOffset),
+          .VertexCount = submesh.VertexCount,
+          .Indices = reinterpret_cast<const TUint32 *>(data + submesh.IndexOffset),
+          .IndexCount = submesh.IndexCount,
+          .Lods = submesh.Lods,
+          .Paths =
+              {
+                  .DiffuseMap = String(strings + submesh.DiffuseMapOffset, submesh.DiffuseMapLength),
+                  .NormalMap = String(strings + submesh.NormalMapOffset, submesh.NormalMapLength),
+              },
+      };
+      m_SubMeshes.push_back(view);
+    }
+
+    return true;
+  }
+
+  bool CookedMesh::IsCurrent(const String &source_path, const CookedMeshHeader &header) const {
+    const TUint8 *data = m_File->GetData();
+    const TUint64 dependencies_offset = sizeof(CookedMeshHeader) + header.SubMeshCount * sizeof(CookedSubMesh);
+    const char   *strings = reinterpret_cast<const char *>(data + dependencies_offset + header.DependencyCount * sizeof(CookedDependency));
+
+    // the cooker always records the source itself
+    if (header.DependencyCount == 0u)
+      return false;
+
+    const std::filesystem::path directory = std::filesystem::path(source_path).parent_path();
+    bool                        source_changed = false;
+
+    for (TUint32 i = 0; i < header.DependencyCount; i++) {
+      CookedDependency dependency = {};
+      memcpy(&dependency, data + dependencies_offset + i * sizeof(CookedDependency), sizeof(dependency));
+
+      if (dependency.PathOffset + dependency.PathLength > header.StringTableSize)
+        return false;
+
+      const std::filesystem::path path = directory / String(strings + dependency.PathOffset, dependency.PathLength);
+      if (get_source_stamp(path.string()) == dependency.Stamp)
+        continue;
+
+      // only the source itself is hashed, any other dependency that changed needs a new import
+      if (i != 0u)
+        return false;
+      source_changed = true;
+    }
+
+    // a source that was only touched, by a checkout for example, still has the contents the mesh was cooked from
+    if (source_changed) {
+      if (hash_file(source_path) != header.SourceHash)
+        return false;
+      LOG_INFO("mesh source %s was touched but not changed, recook it to skip hashing it on every load", source_path.c_str());
+    }
+
+    return true;
+  }
+
+  SourceStamp get_source_stamp(const String &path) {
+    std::error_code error = {};
+    const TUint64   size = std::filesystem::file_size(path, error);
+    if (error)
+      return {};
+
+    const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path, error);
+    if (error)
+      return {};
+
+    return {.Size = size, .WriteTime = static_cast<TUint64>(write_time.time_since_epoch().count())};
+  }
+
+  String GetCookedMeshPath(const String &source_path) { return source_path + ".mcooked"; }
+
+  bool CookMesh(const String &source_path, const String &cooked_path) {
+    MAU_PROFILE_SCOPE("CookMesh");
+
+    const String  output_path = cooked_path.empty() ? GetCookedMeshPath(source_path) : cooked_path;
+    const TUint64 source_hash = hash_file(source_path);
+
+    if (source_hash == 0u) {
+      LOG_ERROR("failed to read mesh source %s", source_path.c_str());
+      return false;
+    }
+
+    // the importer owns the io system
+    Assimp::Importer   importer;
+    RecordingIOSystem *io = new RecordingIOSystem();
+    importer.SetIOHandler(io);
+
+    const aiScene *scene = importer.ReadFile(source_path, get_mesh_import_flags());
+    if (scene == nullptr) {
+      LOG_ERROR("failed to load mesh %s [reason: %s]", source_path.c_str(), importer.GetErrorString());
+      return false;
+    }
+
+    const Vector<MeshBucket> buckets = gather_mesh_buckets(scene);
+
+    CookedMeshHeader header = {
+        .SourceHash = source_hash,
+        .ImportFlags = get_mesh_import_flags(),
+        .SubMeshCount = static_cast<TUint32>(buckets.size()),
+    };
+
+    // lay out the string table first, the blocks follow it
+    Vector<CookedSubMesh> table(buckets.size());
+    String                strings = {};
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+      const MaterialPaths paths = get_material_paths(scene, buckets[i].material_index);
+
+      table[i].DiffuseMapOffset = static_cast<TUint32>(strings.size());
+      table[i].DiffuseMapLength = static_cast<TUint32>(paths.DiffuseMap.size());
+      strings += paths.DiffuseMap;
+
+      table[i].NormalMapOffset = static_cast<TUint32>(strings.size());
+      table[i].NormalMapLength = static_cast<TUint32>(paths.NormalMap.size());
+      strings += paths.NormalMap;
+    }
+
+    // the source, every other file the import opened and every texture, stamped relative to the source's directory
+    const std::filesystem::path source_directory = std::filesystem::path(source_path).parent_path();
+    Vector<String>              dependency_paths = {std::filesystem::path(source_path).filename().generic_string()};
+    auto                        add_dependency = [&dependency_paths](const String &path) -> void {
+      if (!path.empty() && std::find(dependency_paths.begin(), dependency_paths.end(), path) == dependency_paths.end())
+        dependency_paths.push_back(path);
+    };
+
+    for (const String &opened : io->Opened) {
+      add_dependency(std::filesystem::proximate(opened, source_directory.empty() ? std::filesystem::path(".") : source_directory).generic_string());
+    }
+    for (const MeshBucket &bucket : buckets) {
+      const MaterialPaths paths = get_material_paths(scene, bucket.material_index);
+      add_dependency(paths.DiffuseMap);
+      add_dependency(paths.NormalMap);
+    }
+
+    Vector<CookedDependency> dependencies(dependency_paths.size());
+    for (size_t i = 0; i < dependency_paths.size(); i++) {
+      dependencies[i].PathOffset = static_cast<TUint32>(strings.size());
+      dependencies[i].PathLength = static_cast<TUint32>(dependency_paths[i].size());
+      dependencies[i].Stamp = get_source_stamp((source_directory / dependency_paths[i]).string());
+      strings += dependency_paths[i];
+    }
+
+    header.StringTableSize = static_cast<TUint32>(strings.size());
+    header.DependencyCount = static_cast<TUint32>(dependencies.size());
+
+    // the levels of detail decide the size of the index blocks, so every bucket is converted before the layout
+    Vector<Vector<Vertex>>  vertices(buckets.size());
+    Vector<Vector<TUint32>> indices(buckets.size());
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+      vertices[i].resize(buckets[i].vertex_count);
+      indices[i].resize(buckets[i].index_count);
+      convert_mesh_bucket(buckets[i], vertices[i].data(), indices[i].data());
+      table[i].Lods = build_mesh_lods(vertices[i].data(), vertices[i].size(), indices[i]);
+    }
+
+    TUint64 offset = sizeof(CookedMeshHeader) + table.size() * sizeof(CookedSubMesh) + dependencies.size() * sizeof(CookedDependency) + strings.size();
+    for (size_t i = 0; i < buckets.size(); i++) {
+      table[i].VertexOffset = align_offset(offset);
+      table[i].VertexCount = vertices[i].size();
+      offset = table[i].VertexOffset + vertices[i].size() * sizeof(Vertex);
+
+      table[i].IndexOffset = align_offset(offset);
+      table[i].IndexCount = indices[i].size();
+      offset = table[i].IndexOffset + indices[i].size() * sizeof(TUint32);
+    }
+
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", output_path.c_str());
+      return false;
+    }
+
+    auto write_at = [&file](TUint64 at, const void *data, TUint64 size) -> void {
+      static const char padding[COOKED_MESH_ALIGNMENT] = {};
+      const TUint64     current = static_cast<TUint64>(file.tellp());
+      file.write(padding, static_cast<std::streamsize>(at - current));
+      file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(CookedSubMesh)));
+    file.write(reinterpret_cast<const char *>(dependencies.data()), static_cast<std::streamsize>(dependencies.size() * sizeof(CookedDependency)));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+      write_at(table[i].VertexOffset, vertices[i].data(), vertices[i].size() * sizeof(Vertex));
+      write_at(table[i].IndexOffset, indices[i].data(), indices[i].size() * sizeof(TUint32));
+    }
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write cooked mesh %s", output_path.c_str());
+      return false;
+    }
+
+    LOG_INFO("cooked mesh %s -> %s [submeshes: %u, dependencies: %u, size: %llu bytes]", source_path.c_str(), output_path.c_str(), header.SubMeshCount, header.DependencyCount,
+             static_cast<unsigned long long>(offset));
+
+    // referenced textures are cooked next to their sources, paths are relative to the mesh
+    const String                      directory = std::filesystem::path(source_path).parent_path().string();
+    UnorderedMap<String, TextureKind> textures = {};
+
+    for (const MeshBucket &bucket : buckets) {
+      const MaterialPaths paths = get_material_paths(scene, bucket.material_index);
+      if (!paths.DiffuseMap.empty())
+        textures.insert(std::make_pair(directory + "/" + paths.DiffuseMap, TextureKind::COLOR));
+      if (!paths.NormalMap.empty())
+        textures.insert(std::make_pair(directory + "/" + paths.NormalMap, TextureKind::NORMAL));
+    }
+
+    for (const auto &[texture_path, kind] : textures) {
+      if (!CookTexture(texture_path, kind))
+        LOG_WARN("mesh %s references texture %s that failed to cook", source_path.c_str(), texture_path.c_str());
+    }
+
+    return true;
+  }
+
+  bool load_mesh_geometry(const String &path, Vector<MeshGeometry> &submeshes) {
+    MAU_PROFILE_SCOPE("load_mesh_geometry");
+    submeshes.clear();
+
+    const String cooked_path = GetCookedMeshPath(path);
+    if (std::filesystem::exists(cooked_path)) {
+      CookedMesh cooked(cooked_path, path);
+      if (cooked.IsValid()) {
+        for (const CookedSubMeshView &view : cooked.GetSubMeshes()) {
+          // the simplified levels are for drawing only
+          const TUint32 *full_detail = view.Indices + view.Lods.Levels[0].FirstIndex;
+          submeshes.push_back({
+              .Vertices = Vector<Vertex>(view.Vertices, view.Vertices + view.VertexCount),
+              .Indices = Vector<TUint32>(full_detail, full_detail + view.Lods.Levels[0].IndexCount),
+              .Paths = view.Paths,
+          });
+        }
+        return true;
+      }
+    }
+
+    Assimp::Importer importer;
+    const aiScene   *scene = importer.ReadFile(path, get_mesh_import_flags());
+
+    if (scene == nullptr) {
+      LOG_ERROR("failed to load mesh %s [reason: %s]", path.c_str(), importer.GetErrorString());
+      return false;
+    }
+
+    for (const MeshBucket &bucket : gather_mesh_buckets(scene)) {
+      MeshGeometry &geometry = submeshes.emplace_back();
+      geometry.Vertices.resize(bucket.vertex_count);
+      geometry.Indices.resize(bucket.index_count);
+      geometry.Paths = get_material_paths(scene, bucket.material_index);
+      convert_mesh_bucket(bucket, geometry.Vertices.data(), geometry.Indices.data());
+    }
+
+    return true;
+  }
+
+} // namespace mau
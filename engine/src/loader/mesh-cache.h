@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+#include <engine/types.h>
+
+#include "mapped-file.h"
+#include "mesh-loader.h"
+#include "mesh-lod.h"
+
+namespace mau {
+
+  // cooked mesh layout: header, submesh table, dependency table, string table, then 16 byte aligned vertex and index
+  // blocks. the index block of a submesh holds all of its levels of detail
+  constexpr TUint32 COOKED_MESH_MAGIC = 0x4853454du; // "MESH"
+  constexpr TUint32 COOKED_MESH_VERSION = 3u;
+
+  // size and last write time of a file, both 0 when it doesn't exist. two stats, cheap enough for every load
+  struct SourceStamp {
+    TUint64 Size = 0u;
+    TUint64 WriteTime = 0u;
+
+    bool operator==(const SourceStamp &other) const = default;
+  };
+  constexpr TUint64 COOKED_MESH_ALIGNMENT = 16u;
+
+  struct CookedMeshHeader {
+    TUint32 Magic = COOKED_MESH_MAGIC;
+    TUint32 Version = COOKED_MESH_VERSION;
+    TUint64 SourceHash = 0u;
+    TUint32 ImportFlags = 0u;
+    TUint32 VertexSize = sizeof(Vertex);
+    TUint32 SubMeshCount = 0u;
+    TUint32 StringTableSize = 0u;
+    TUint32 DependencyCount = 0u;
+    TUint32 Padding = 0u;
+  };
+
+  struct CookedSubMesh {
+    TUint64 VertexOffset = 0u;
+    TUint64 VertexCount = 0u;
+    TUint64 IndexOffset = 0u;
+    TUint64 IndexCount = 0u;
+    TUint32 DiffuseMapOffset = 0u;
+    TUint32 DiffuseMapLength = 0u;
+    TUint32 NormalMapOffset = 0u;
+    TUint32 NormalMapLength = 0u;
+    // ranges of the index block
+    MeshLodChain Lods = {};
+    TUint32      Padding = 0u;
+  };
+
+  // a file the import read, the source itself first and then its buffers and textures. the path is relative to the
+  // source's directory and lives in the string table
+  struct CookedDependency {
+    TUint32     PathOffset = 0u;
+    TUint32     PathLength = 0u;
+    SourceStamp Stamp = {};
+  };
+
+  struct CookedSubMeshView {
+    const Vertex  *Vertices = nullptr;
+    TUint64        VertexCount = 0u;
+    const TUint32 *Indices = nullptr;
+    TUint64        IndexCount = 0u;
+    MeshLodChain   Lods = {};
+    MaterialPaths  Paths = {};
+  };
+
+  // memory mapped cooked mesh, the views point into the mapping and live as long as this object. it is out of date
+  // once any dependency's stamp changed, except for a source whose contents still hash to the cooked source hash.
+  // without the source next to it the cooked file is trusted as is
+  class CookedMesh {
+  public:
+    CookedMesh(const String &cooked_path, const String &source_path);
+    ~CookedMesh() = default;
+
+  public:
+    inline bool                             IsValid() const { return m_Valid; }
+    inline const Vector<CookedSubMeshView> &GetSubMeshes() const { return m_SubMeshes; }
+
+  private:
+    // checks the header and fills the views, the header is returned for the freshness checks
+    bool Map(const String &cooked_path, CookedMeshHeader &header);
+    bool IsCurrent(const String &source_path, const CookedMeshHeader &header) const;
+
+  private:
+    std::unique_ptr<MappedFile> m_File = nullptr;
+    Vector<CookedSubMeshView>   m_SubMeshes = {};
+    bool                        m_Valid = false;
+  };
+
+  // cpu copy of a submesh at full detail, for code working on the geometry itself rather than drawing it
+  struct MeshGeometry {
+    Vector<Vertex>  Vertices = {};
+    Vector<TUint32> Indices = {};
+    MaterialPaths   Paths = {};
+  };
+
+  // 64 bit FNV-1a of the file contents, 0 if the file can't be read
+  TUint64 hash_file(const String &path);
+
+  SourceStamp get_source_stamp(const String &path);
+
+  // reads a mesh without touching the gpu, from the cooked file when it is current and through assimp otherwise
+  bool load_mesh_geometry(const String &path, Vector<MeshGeometry> &submeshes);
+
+} // namespace mau
@@ -0,0 +1,94 @@
+#include "mesh-loader.h"
+
+#include <algorithm>
+#include <functional>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  TUint32 get_mesh_import_flags() { return aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_RemoveRedundantMaterials; }
+
+  Vector<MeshBucket> gather_mesh_buckets(const aiScene *scene) {
+    MAU_PROFILE_SCOPE("Mesh::GatherBuckets");
+
+    Vector<MeshBucket>            buckets = {};
+    UnorderedMap<TUint32, size_t> bucket_lookup = {};
+
+    std::function<void(const aiNode *)> gather_node = [&](const aiNode *node) -> void {
+      for (TUint32 i = 0; i < node->mNumMeshes; i++) {
+        const aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+
+        auto it = bucket_lookup.find(mesh->mMaterialIndex);
+        if (it == bucket_lookup.end()) {
+          it = bucket_lookup.insert(std::make_pair(mesh->mMaterialIndex, buckets.size())).first;
+          buckets.emplace_back().material_index = mesh->mMaterialIndex;
+        }
+
+        MeshBucket &bucket = buckets[it->second];
+        bucket.meshes.push_back(mesh);
+        bucket.vertex_count += mesh->mNumVertices;
+        for (TUint32 j = 0; j < mesh->mNumFaces; j++) {
+          bucket.index_count += mesh->mFaces[j].mNumIndices;
+        }
+      }
+
+      for (TUint32 i = 0; i < node->mNumChildren; i++) {
+        gather_node(node->mChildren[i]);
+      }
+    };
+
+    gather_node(scene->mRootNode);
+
+    // biggest buckets first so the workers finish at roughly the same time
+    std::sort(buckets.begin(), buckets.end(), [](const MeshBucket &a, const MeshBucket &b) -> bool { return a.vertex_count > b.vertex_count; });
+    return buckets;
+  }
+
+  void convert_mesh_bucket(const MeshBucket &bucket, Vertex *vertices, TUint32 *indices) {
+    MAU_PROFILE_SCOPE("Mesh::ConvertBucket");
+
+    TUint32 vertex_offset = 0u;
+
+    for (const aiMesh *mesh : bucket.meshes) {
+      const aiVector3D *tex_coords = mesh->mTextureCoords[0];
+
+      for (TUint32 i = 0; i < mesh->mNumVertices; i++) {
+        Vertex &vert = *vertices++;
+        vert.pos = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        vert.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        vert.tex = tex_coords ? glm::vec2(tex_coords[i].x, 1.0f - tex_coords[i].y) : glm::vec2(0.0f);
+      }
+
+      for (TUint32 i = 0; i < mesh->mNumFaces; i++) {
+        const aiFace &face = mesh->mFaces[i];
+        for (TUint32 j = 0; j < face.mNumIndices; j++) {
+          *indices++ = vertex_offset + face.mIndices[j];
+        }
+      }
+
+      vertex_offset += mesh->mNumVertices;
+    }
+  }
+
+  MaterialPaths get_material_paths(const aiScene *scene, TUint32 material_index) {
+    aiMaterial   *ai_material = scene->mMaterials[material_index];
+    MaterialPaths paths = {};
+
+    if (ai_material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+      aiString texture_path;
+      ai_material->GetTexture(aiTextureType_DIFFUSE, 0, &texture_path);
+      paths.DiffuseMap = texture_path.C_Str();
+    }
+
+    if (ai_material->GetTextureCount(aiTextureType_NORMALS) > 0) {
+      aiString texture_path;
+      ai_material->GetTexture(aiTextureType_NORMALS, 0, &texture_path);
+      paths.NormalMap = texture_path.C_Str();
+    }
+
+    return paths;
+  }
+
+} // namespace mau
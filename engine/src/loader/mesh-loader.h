@@ -0,0 +1,40 @@
+#pragma once
+
+#include <engine/types.h>
+#include <glm/glm.hpp>
+
+struct aiMesh;
+struct aiScene;
+
+namespace mau {
+
+  struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    glm::vec2 tex;
+  };
+
+  // all the aiMeshes sharing a material, converted into a single submesh
+  struct MeshBucket {
+    TUint32                material_index = 0u;
+    Vector<const aiMesh *> meshes = {};
+    TUint64                vertex_count = 0u;
+    TUint64                index_count = 0u;
+  };
+
+  struct MaterialPaths {
+    String DiffuseMap;
+    String NormalMap;
+  };
+
+  // flags used by every import, part of the cooked mesh key
+  TUint32 get_mesh_import_flags();
+
+  // buckets are sorted biggest first
+  Vector<MeshBucket> gather_mesh_buckets(const aiScene *scene);
+  void               convert_mesh_bucket(const MeshBucket &bucket, Vertex *vertices, TUint32 *indices);
+
+  // texture paths are relative to the mesh file
+  MaterialPaths get_material_paths(const aiScene *scene, TUint32 material_index);
+
+} // namespace mau
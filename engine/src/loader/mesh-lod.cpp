@@ -0,0 +1,317 @@
+#include "mesh-lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  // a remaining triangle may turn by at most about 75 degrees in a collapse
+  constexpr TFloat32 LOD_MIN_NORMAL_DOT = 0.25f;
+
+  // symmetric plane quadric, summed area weighted so that evaluating it divided by the weight is the mean squared
+  // distance to the planes of the triangles it was built from. only orders the collapses, a mean is no bound
+  struct LodQuadric {
+    TFloat64 A2 = 0.0, B2 = 0.0, C2 = 0.0, AB = 0.0, AC = 0.0, BC = 0.0, AD = 0.0, BD = 0.0, CD = 0.0, D2 = 0.0;
+    TFloat64 Weight = 0.0;
+  };
+
+  // moves From onto To
+  struct LodCollapse {
+    TUint32  From = 0u;
+    TUint32  To = 0u;
+    TFloat32 Cost = 0.0f;
+  };
+
+  static void add_plane(LodQuadric &quadric, const glm::dvec3 &normal, TFloat64 distance, TFloat64 weight) {
+    quadric.A2 += weight * normal.x * normal.x;
+    quadric.B2 += weight * normal.y * normal.y;
+    quadric.C2 += weight * normal.z * normal.z;
+    quadric.AB += weight * normal.x * normal.y;
+    quadric.AC += weight * normal.x * normal.z;
+    quadric.BC += weight * normal.y * normal.z;
+    quadric.AD += weight * normal.x * distance;
+    quadric.BD += weight * normal.y * distance;
+    quadric.CD += weight * normal.z * distance;
+    quadric.D2 += weight * distance * distance;
+    quadric.Weight += weight;
+  }
+
+  static void add_quadric(LodQuadric &quadric, const LodQuadric &other) {
+    quadric.A2 += other.A2;
+    quadric.B2 += other.B2;
+    quadric.C2 += other.C2;
+    quadric.AB += other.AB;
+    quadric.AC += other.AC;
+    quadric.BC += other.BC;
+    quadric.AD += other.AD;
+    quadric.BD += other.BD;
+    quadric.CD += other.CD;
+    quadric.D2 += other.D2;
+    quadric.Weight += other.Weight;
+  }
+
+  // mean squared distance of position to the planes of both quadrics
+  static TFloat32 collapse_cost(const LodQuadric &a, const LodQuadric &b, const glm::vec3 &position) {
+    LodQuadric quadric = a;
+    add_quadric(quadric, b);
+
+    const TFloat64 x = position.x, y = position.y, z = position.z;
+    const TFloat64 error = quadric.A2 * x * x + quadric.B2 * y * y + quadric.C2 * z * z + 2.0 * (quadric.AB * x * y + quadric.AC * x * z + quadric.BC * y * z) +
+                           2.0 * (quadric.AD * x + quadric.BD * y + quadric.CD * z) + quadric.D2;
+    return static_cast<TFloat32>(std::max(error / std::max(quadric.Weight, 1e-20), 0.0));
+  }
+
+  // maps every vertex onto the lowest vertex with the same position, vertices sharing a position are uv or normal seams
+  static Vector<TUint32> weld_positions(const Vertex *vertices, TUint64 vertex_count, Vector<TUint8> &seams) {
+    Vector<TUint32> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [vertices](TUint32 a, TUint32 b) -> bool {
+      const glm::vec3 &pa = vertices[a].pos, &pb = vertices[b].pos;
+      if (pa.x != pb.x) return pa.x < pb.x;
+      if (pa.y != pb.y) return pa.y < pb.y;
+      if (pa.z != pb.z) return pa.z < pb.z;
+      return a < b;
+    });
+
+    Vector<TUint32> remap(vertex_count);
+    seams.assign(vertex_count, 0u);
+    for (TUint64 first = 0; first < vertex_count;) {
+      TUint64 last = first + 1u;
+      while (last < vertex_count && vertices[order[last]].pos == vertices[order[first]].pos) {
+        last++;
+      }
+      for (TUint64 i = first; i < last; i++) {
+        remap[order[i]] = order[first];
+        seams[order[i]] = last - first > 1u ? 1u : 0u;
+      }
+      first = last;
+    }
+    return remap;
+  }
+
+  // moving from onto to must not flip or squash any of the triangles around from that stay
+  static bool can_collapse(const Vertex *vertices, const TUint32 *indices, const TUint32 *triangles, TUint32 triangle_count, TUint32 from, TUint32 to) {
+    const glm::vec3 &target = vertices[to].pos;
+
+    for (TUint32 i = 0; i < triangle_count; i++) {
+      const TUint32 *triangle = indices + static_cast<TUint64>(triangles[i]) * 3u;
+      if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        continue;
+
+      glm::vec3 before[3], after[3];
+      for (TUint32 k = 0; k < 3u; k++) {
+        before[k] = vertices[triangle[k]].pos;
+        after[k] = triangle[k] == from ? target : before[k];
+      }
+
+      const glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+      const glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+      if (glm::dot(normal_before, normal_after) <= LOD_MIN_NORMAL_DOT * glm::length(normal_before) * glm::length(normal_after))
+        return false;
+    }
+    return true;
+  }
+
+  TFloat32 simplify_mesh(const Vertex *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count, TUint64 target_index_count, Vector<TUint32> &result) {
+    MAU_PROFILE_SCOPE("Mesh::Simplify");
+
+    Vector<TUint8>        locked = {};
+    const Vector<TUint32> remap = weld_positions(vertices, vertex_count, locked);
+
+    // triangles that are already degenerate in welded space go first
+    result.clear();
+    result.reserve(index_count);
+    for (TUint64 t = 0; t + 2u < index_count; t += 3u) {
+      const TUint32 a = remap[indices[t]], b = remap[indices[t + 1u]], c = remap[indices[t + 2u]];
+      if (a != b && b != c && c != a)
+        result.insert(result.end(), indices + t, indices + t + 3u);
+    }
+    if (result.size() <= target_index_count)
+      return 0.0f;
+
+    // welded edges without exactly two triangles are open borders or non manifold, their vertices stay
+    Vector<TUint64> edges = {};
+    edges.reserve(result.size());
+    for (TUint64 t = 0; t < result.size(); t += 3u) {
+      for (TUint32 k = 0; k < 3u; k++) {
+        const TUint64 a = remap[result[t + k]], b = remap[result[t + (k + 1u) % 3u]];
+        edges.push_back(std::min(a, b) << 32u | std::max(a, b));
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (TUint64 first = 0; first < edges.size();) {
+      TUint64 last = first + 1u;
+      while (last < edges.size() && edges[last] == edges[first]) {
+        last++;
+      }
+      // welded vertices of a seam are locked already, every other vertex is its own weld
+      if (last - first != 2u) {
+        locked[edges[first] >> 32u] = 1u;
+        locked[edges[first] & 0xffffffffu] = 1u;
+      }
+      first = last;
+    }
+
+    // one quadric per welded vertex from the planes of the triangles around it. the planes themselves are kept in a
+    // list per welded vertex, a collapse appends the list of from to the one of to
+    Vector<LodQuadric> quadrics(vertex_count);
+    Vector<glm::dvec4> planes = {};
+    Vector<TUint32>    plane_heads(vertex_count, UINT32_MAX), plane_tails(vertex_count, UINT32_MAX);
+    Vector<TUint32>    plane_indices = {}, plane_next = {};
+    for (TUint64 t = 0; t < result.size(); t += 3u) {
+      const glm::dvec3 p0 = vertices[result[t]].pos, p1 = vertices[result[t + 1u]].pos, p2 = vertices[result[t + 2u]].pos;
+      const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const TFloat64   length = glm::length(normal);
+      if (length <= 0.0)
+        continue;
+
+      planes.push_back(glm::dvec4(normal / length, -glm::dot(normal / length, p0)));
+      for (TUint32 k = 0; k < 3u; k++) {
+        const TUint32 vertex = remap[result[t + k]];
+        add_plane(quadrics[vertex], normal / length, -glm::dot(normal / length, p0), length * 0.5);
+
+        const TUint32 entry = static_cast<TUint32>(plane_indices.size());
+        plane_indices.push_back(static_cast<TUint32>(planes.size() - 1u));
+        plane_next.push_back(plane_heads[vertex]);
+        if (plane_heads[vertex] == UINT32_MAX)
+          plane_tails[vertex] = entry;
+        plane_heads[vertex] = entry;
+      }
+    }
+
+    Vector<TUint32>     offsets = {}, cursors = {}, triangles = {};
+    Vector<LodCollapse> collapses = {};
+    Vector<TUint8>      touched = {}, removed = {};
+    TFloat64            max_error = 0.0;
+
+    // every pass collapses cheapest first, a vertex takes part in one collapse at most so the triangle lists stay valid
+    while (result.size() > target_index_count) {
+      const TUint64 triangle_count = result.size() / 3u;
+
+      offsets.assign(vertex_count + 1u, 0u);
+      for (TUint32 index : result) {
+        offsets[index + 1u]++;
+      }
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+      cursors.assign(offsets.begin(), offsets.end() - 1);
+      triangles.resize(result.size());
+      for (TUint64 i = 0; i < result.size(); i++) {
+        triangles[cursors[result[i]]++] = static_cast<TUint32>(i / 3u);
+      }
+
+      collapses.clear();
+      for (TUint64 t = 0; t < result.size(); t += 3u) {
+        for (TUint32 k = 0; k < 3u; k++) {
+          const TUint32 a = result[t + k], b = result[t + (k + 1u) % 3u];
+          if (!locked[a])
+            collapses.push_back({.From = a, .To = b, .Cost = collapse_cost(quadrics[remap[a]], quadrics[remap[b]], vertices[b].pos)});
+          if (!locked[b])
+            collapses.push_back({.From = b, .To = a, .Cost = collapse_cost(quadrics[remap[b]], quadrics[remap[a]], vertices[a].pos)});
+        }
+      }
+      std::sort(collapses.begin(), collapses.end(), [](const LodCollapse &a, const LodCollapse &b) -> bool {
+        if (a.Cost != b.Cost) return a.Cost < b.Cost;
+        return a.From != b.From ? a.From < b.From : a.To < b.To;
+      });
+
+      touched.assign(vertex_count, 0u);
+      removed.assign(triangle_count, 0u);
+      TUint64 remaining = triangle_count;
+      TUint32 collapsed = 0u;
+
+      for (const LodCollapse &collapse : collapses) {
+        if (remaining * 3u <= target_index_count)
+          break;
+        if (touched[collapse.From] || touched[collapse.To])
+          continue;
+
+        const TUint32 *around = triangles.data() + offsets[collapse.From];
+        const TUint32  around_count = offsets[collapse.From + 1u] - offsets[collapse.From];
+        if (!can_collapse(vertices, result.data(), around, around_count, collapse.From, collapse.To))
+          continue;
+
+        for (TUint32 i = 0; i < around_count; i++) {
+          TUint32 *triangle = result.data() + static_cast<TUint64>(around[i]) * 3u;
+          for (TUint32 k = 0; k < 3u; k++) {
+            touched[triangle[k]] = 1u;
+          }
+
+          if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To) {
+            removed[around[i]] = 1u;
+            remaining--;
+            continue;
+          }
+          for (TUint32 k = 0; k < 3u; k++) {
+            if (triangle[k] == collapse.From)
+              triangle[k] = collapse.To;
+          }
+        }
+
+        touched[collapse.To] = 1u;
+        add_quadric(quadrics[remap[collapse.To]], quadrics[remap[collapse.From]]);
+
+        // to stays where it is, only the planes of from and of the vertices collapsed into it get a new distance
+        const TUint32    from = remap[collapse.From], to = remap[collapse.To];
+        const glm::dvec3 target = vertices[collapse.To].pos;
+        for (TUint32 entry = plane_heads[from]; entry != UINT32_MAX; entry = plane_next[entry]) {
+          const glm::dvec4 &plane = planes[plane_indices[entry]];
+          max_error = std::max(max_error, std::abs(glm::dot(glm::dvec3(plane), target) + plane.w));
+        }
+        if (plane_heads[from] != UINT32_MAX) {
+          if (plane_heads[to] == UINT32_MAX)
+            plane_heads[to] = plane_heads[from];
+          else
+            plane_next[plane_tails[to]] = plane_heads[from];
+          plane_tails[to] = plane_tails[from];
+          plane_heads[from] = plane_tails[from] = UINT32_MAX;
+        }
+        collapsed++;
+      }
+
+      if (collapsed == 0u)
+        break;
+
+      TUint64 write = 0u;
+      for (TUint64 t = 0; t < triangle_count; t++) {
+        if (removed[t])
+          continue;
+        for (TUint32 k = 0; k < 3u; k++) {
+          result[write++] = result[t * 3u + k];
+        }
+      }
+      result.resize(write);
+    }
+
+    return static_cast<TFloat32>(max_error);
+  }
+
+  MeshLodChain build_mesh_lods(const Vertex *vertices, TUint64 vertex_count, Vector<TUint32> &indices) {
+    MAU_PROFILE_SCOPE("Mesh::BuildLods");
+
+    MeshLodChain chain = {};
+    chain.Levels[0] = {.FirstIndex = 0u, .IndexCount = static_cast<TUint32>(indices.size()), .Error = 0.0f};
+    chain.Count = 1u;
+
+    Vector<TUint32> level = {};
+    while (chain.Count < MAX_MESH_LODS) {
+      const MeshLod source = chain.Levels[chain.Count - 1u];
+      const TUint64 target_index_count = static_cast<TUint64>(source.IndexCount) / 6u * 3u;
+      if (target_index_count < MIN_LOD_TRIANGLES * 3u)
+        break;
+
+      const TFloat32 error = simplify_mesh(vertices, vertex_count, indices.data() + source.FirstIndex, source.IndexCount, target_index_count, level);
+
+      // stuck on locked vertices, a level that barely shrinks only costs memory
+      if (level.empty() || static_cast<TFloat32>(level.size()) > static_cast<TFloat32>(source.IndexCount) * MIN_LOD_REDUCTION)
+        break;
+
+      chain.Levels[chain.Count] = {.FirstIndex = static_cast<TUint32>(indices.size()), .IndexCount = static_cast<TUint32>(level.size()), .Error = source.Error + error};
+      chain.Count++;
+      indices.insert(indices.end(), level.begin(), level.end());
+    }
+    return chain;
+  }
+
+} // namespace mau
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <engine/types.h>
+#include "loader/mesh-loader.h"
+
+namespace mau {
+
+  // levels per submesh, the full detail one included
+  constexpr TUint32 MAX_MESH_LODS = 4u;
+
+  // submeshes with fewer triangles keep their full detail only
+  constexpr TUint32 MIN_LOD_TRIANGLES = 64u;
+
+  // a simplified level is dropped when it keeps more than this share of the level before it
+  constexpr TFloat32 MIN_LOD_REDUCTION = 0.75f;
+
+  // a range of the submesh's indices, all levels share its vertices. Error bounds in local units how far any vertex
+  // moved off the planes of the full detail triangles it was a corner of
+  struct MeshLod {
+    TUint32  FirstIndex = 0u;
+    TUint32  IndexCount = 0u;
+    TFloat32 Error = 0.0f;
+  };
+
+  // level 0 is the full detail one, the errors grow with the level
+  struct MeshLodChain {
+    MeshLod Levels[MAX_MESH_LODS] = {};
+    TUint32 Count = 0u;
+  };
+
+  // quadric error metric edge collapse. vertices only move onto one of their neighbours, so the result indexes the
+  // same vertices, and vertices on open borders or uv seams stay where they are. collapses run cheapest first until
+  // target_index_count is reached or nothing can collapse without flipping a triangle. returns the largest distance
+  // of a moved vertex to the planes of the source triangles around it and around the vertices merged into it
+  TFloat32 simplify_mesh(const Vertex *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count, TUint64 target_index_count, Vector<TUint32> &result);
+
+  // appends the simplified levels behind the full detail indices, each one aiming at half the triangles of the level
+  // before it. every level is simplified from the one before, its error adds up the errors of all steps
+  MeshLodChain build_mesh_lods(const Vertex *vertices, TUint64 vertex_count, Vector<TUint32> &indices);
+
+} // namespace mau
@@ -0,0 +1,132 @@
+#include "texture-cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include <engine/loader/cooker.h>
+#include "image-loader.h"
+
+namespace mau {
+
+  static TUint64 align_offset(TUint64 offset) { return (offset + TEXTURE_MIP_ALIGNMENT - 1u) & ~(TEXTURE_MIP_ALIGNMENT - 1u); }
+
+  CookedTexture::CookedTexture(const String &cooked_path, const String &source_path, TextureKind kind) {
+    MAU_PROFILE_SCOPE("CookedTexture::CookedTexture");
+
+    m_File = std::make_unique<MappedFile>(cooked_path);
+    if (!m_File->IsValid())
+      return;
+
+    const TUint8 *data = m_File->GetData();
+    const TUint64 size = m_File->GetSize();
+
+    if (size < sizeof(CookedTextureHeader)) {
+      LOG_WARN("cooked texture %s is truncated", cooked_path.c_str());
+      return;
+    }
+
+    CookedTextureHeader header = {};
+    memcpy(&header, data, sizeof(header));
+
+    if (header.Magic != COOKED_TEXTURE_MAGIC || header.Version != COOKED_TEXTURE_VERSION || !is_valid_texture_format(header.Format)) {
+      LOG_WARN("cooked texture %s has an incompatible format", cooked_path.c_str());
+      return;
+    }
+
+    if (header.Kind != static_cast<TUint32>(kind) || (std::filesystem::exists(source_path) && header.Source != get_source_stamp(source_path))) {
+      LOG_INFO("cooked texture %s is out of date", cooked_path.c_str());
+      return;
+    }
+
+    const TUint64 table_offset = sizeof(CookedTextureHeader);
+    const bool    table_fits = header.MipCount > 0u && header.MipCount <= get_mip_count(header.Width, header.Height) &&
+                            table_offset + header.MipCount * sizeof(TextureMip) <= header.DataOffset;
+
+    if (!table_fits || header.DataOffset % TEXTURE_MIP_ALIGNMENT != 0u || header.DataOffset + header.DataSize > size) {
+      LOG_WARN("cooked texture %s is truncated", cooked_path.c_str());
+      return;
+    }
+
+    const TextureFormat format = static_cast<TextureFormat>(header.Format);
+
+    for (TUint32 i = 0; i < header.MipCount; i++) {
+      TextureMip mip = {};
+      memcpy(&mip, data + table_offset + i * sizeof(TextureMip), sizeof(mip));
+
+      const bool valid = mip.Offset % TEXTURE_MIP_ALIGNMENT == 0u && mip.Offset + mip.Size <= header.DataSize && mip.Size == get_level_size(format, mip.Width, mip.Height);
+      if (!valid) {
+        LOG_WARN("cooked texture %s has a corrupt mip table", cooked_path.c_str());
+        m_Mips.clear();
+        return;
+      }
+
+      m_Mips.push_back(mip);
+    }
+
+    m_Format = format;
+    m_Width = header.Width;
+    m_Height = header.Height;
+    m_Data = data + header.DataOffset;
+    m_DataSize = header.DataSize;
+    m_Valid = true;
+  }
+
+  String GetCookedTexturePath(const String &source_path) { return source_path + ".mtex"; }
+
+  bool CookTexture(const String &source_path, TextureKind kind, const String &cooked_path) {
+    MAU_PROFILE_SCOPE("CookTexture");
+
+    const String  output_path = cooked_path.empty() ? GetCookedTexturePath(source_path) : cooked_path;
+    const TUint64 source_hash = hash_file(source_path);
+
+    if (source_hash == 0u) {
+      LOG_ERROR("failed to read texture source %s", source_path.c_str());
+      return false;
+    }
+
+    RawImage image(source_path);
+    if (!image.Data)
+      return false;
+
+    const TextureLevels levels = build_mip_chain(reinterpret_cast<const TUint8 *>(image.Data), image.Width, image.Height, kind);
+    const TextureLevels compressed = compress_mip_chain(levels, kind);
+
+    CookedTextureHeader header = {
+        .SourceHash = source_hash,
+        .Source = get_source_stamp(source_path),
+        .Format = static_cast<TUint32>(compressed.Format),
+        .Kind = static_cast<TUint32>(kind),
+        .Width = compressed.Width,
+        .Height = compressed.Height,
+        .MipCount = static_cast<TUint32>(compressed.Mips.size()),
+        .DataOffset = align_offset(sizeof(CookedTextureHeader) + compressed.Mips.size() * sizeof(TextureMip)),
+        .DataSize = compressed.Data.size(),
+    };
+
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open %s for writing", output_path.c_str());
+      return false;
+    }
+
+    static const char padding[TEXTURE_MIP_ALIGNMENT] = {};
+    const TUint64     table_end = sizeof(CookedTextureHeader) + compressed.Mips.size() * sizeof(TextureMip);
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(compressed.Mips.data()), static_cast<std::streamsize>(compressed.Mips.size() * sizeof(TextureMip)));
+    file.write(padding, static_cast<std::streamsize>(header.DataOffset - table_end));
+    file.write(reinterpret_cast<const char *>(compressed.Data.data()), static_cast<std::streamsize>(compressed.Data.size()));
+
+    if (!file.good()) {
+      LOG_ERROR("failed to write cooked texture %s", output_path.c_str());
+      return false;
+    }
+
+    LOG_INFO("cooked texture %s -> %s [%ux%u, mips: %u, size: %llu bytes]", source_path.c_str(), output_path.c_str(), header.Width, header.Height, header.MipCount,
+             static_cast<unsigned long long>(header.DataOffset + header.DataSize));
+    return true;
+  }
+
+} // namespace mau
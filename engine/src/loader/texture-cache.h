@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <engine/types.h>
+
+#include "mapped-file.h"
+#include "mesh-cache.h"
+#include "texture-loader.h"
+
+namespace mau {
+
+  // cooked texture layout: header, mip table, then the packed mip chain starting at an aligned offset
+  constexpr TUint32 COOKED_TEXTURE_MAGIC = 0x5845544du; // "MTEX"
+  constexpr TUint32 COOKED_TEXTURE_VERSION = 2u;
+
+  struct CookedTextureHeader {
+    TUint32     Magic = COOKED_TEXTURE_MAGIC;
+    TUint32     Version = COOKED_TEXTURE_VERSION;
+    TUint64     SourceHash = 0u;
+    // checked on load, the hash only tells cooked files apart
+    SourceStamp Source = {};
+    TUint32     Format = 0u;
+    TUint32     Kind = 0u;
+    TUint32     Width = 0u;
+    TUint32     Height = 0u;
+    TUint32     MipCount = 0u;
+    TUint32     Padding = 0u;
+    TUint64     DataOffset = 0u;
+    TUint64     DataSize = 0u;
+  };
+
+  // memory mapped cooked texture, the mip data points into the mapping and lives as long as this object. it is out of
+  // date once the source's stamp changed, without the source next to it the cooked file is trusted as is
+  class CookedTexture {
+  public:
+    CookedTexture(const String &cooked_path, const String &source_path, TextureKind kind);
+    ~CookedTexture() = default;
+
+  public:
+    inline bool                      IsValid() const { return m_Valid; }
+    inline TextureFormat             GetFormat() const { return m_Format; }
+    inline TUint32                   GetWidth() const { return m_Width; }
+    inline TUint32                   GetHeight() const { return m_Height; }
+    inline const TUint8             *GetData() const { return m_Data; }
+    inline TUint64                   GetDataSize() const { return m_DataSize; }
+    inline const Vector<TextureMip> &GetMips() const { return m_Mips; }
+
+  private:
+    std::unique_ptr<MappedFile> m_File = nullptr;
+    TextureFormat               m_Format = TextureFormat::RGBA8_SRGB;
+    TUint32                     m_Width = 0u;
+    TUint32                     m_Height = 0u;
+    const TUint8               *m_Data = nullptr;
+    TUint64                     m_DataSize = 0u;
+    Vector<TextureMip>          m_Mips = {};
+    bool                        m_Valid = false;
+  };
+
+} // namespace mau
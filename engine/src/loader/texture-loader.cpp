@@ -0,0 +1,352 @@
+#include "texture-loader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <engine/assert.h>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  static TUint64 align_level(TUint64 offset) { return (offset + TEXTURE_MIP_ALIGNMENT - 1u) & ~(TEXTURE_MIP_ALIGNMENT - 1u); }
+
+  TUint32 get_mip_count(TUint32 width, TUint32 height) {
+    TUint32 count = 1u;
+    for (TUint32 size = std::max(width, height); size > 1u; size >>= 1u) {
+      count++;
+    }
+    return count;
+  }
+
+  bool is_block_compressed(TextureFormat format) { return format == TextureFormat::BC1_SRGB || format == TextureFormat::BC3_SRGB || format == TextureFormat::BC5_UNORM; }
+
+  bool is_valid_texture_format(TUint32 format) { return format <= static_cast<TUint32>(TextureFormat::BC5_UNORM); }
+
+  TUint64 get_level_size(TextureFormat format, TUint32 width, TUint32 height) {
+    if (!is_block_compressed(format))
+      return static_cast<TUint64>(width) * static_cast<TUint64>(height) * 4u;
+
+    const TUint64 block_count = static_cast<TUint64>((width + 3u) / 4u) * static_cast<TUint64>((height + 3u) / 4u);
+    return block_count * (format == TextureFormat::BC1_SRGB ? 8u : 16u);
+  }
+
+  static Vector<TextureMip> layout_mip_chain(TextureFormat format, TUint32 width, TUint32 height, TUint64 &total_size) {
+    Vector<TextureMip> mips = {};
+    TUint64            offset = 0u;
+
+    for (TUint32 i = 0; i < get_mip_count(width, height); i++) {
+      TextureMip mip = {};
+      mip.Offset = offset;
+      mip.Width = std::max(1u, width >> i);
+      mip.Height = std::max(1u, height >> i);
+      mip.Size = get_level_size(format, mip.Width, mip.Height);
+      mips.push_back(mip);
+
+      offset = align_level(mip.Offset + mip.Size);
+    }
+
+    total_size = offset;
+    return mips;
+  }
+
+  // mip generation
+
+  static TFloat32 srgb_to_linear(TUint8 value) {
+    static const Vector<TFloat32> table = []() -> Vector<TFloat32> {
+      Vector<TFloat32> values(256u);
+      for (TUint32 i = 0; i < 256u; i++) {
+        const TFloat32 s = static_cast<TFloat32>(i) / 255.0f;
+        values[i] = s <= 0.04045f ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+      }
+      return values;
+    }();
+
+    return table[value];
+  }
+
+  static TUint8 linear_to_srgb(TFloat32 value) {
+    value = std::clamp(value, 0.0f, 1.0f);
+    const TFloat32 s = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<TUint8>(s * 255.0f + 0.5f);
+  }
+
+  static TUint8 to_unorm8(TFloat32 value) { return static_cast<TUint8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
+
+  static void downsample_color(const TUint8 *texels[4], TUint8 *out) {
+    for (TUint32 c = 0; c < 3u; c++) {
+      const TFloat32 sum = srgb_to_linear(texels[0][c]) + srgb_to_linear(texels[1][c]) + srgb_to_linear(texels[2][c]) + srgb_to_linear(texels[3][c]);
+      out[c] = linear_to_srgb(sum * 0.25f);
+    }
+    out[3] = static_cast<TUint8>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2u) / 4u);
+  }
+
+  static void downsample_normal(const TUint8 *texels[4], TUint8 *out) {
+    TFloat32 normal[3] = {};
+    for (TUint32 i = 0; i < 4u; i++) {
+      for (TUint32 c = 0; c < 3u; c++) {
+        normal[c] += static_cast<TFloat32>(texels[i][c]) / 255.0f * 2.0f - 1.0f;
+      }
+    }
+
+    const TFloat32 length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (length < 1e-6f) {
+      normal[0] = 0.0f;
+      normal[1] = 0.0f;
+      normal[2] = 1.0f;
+    } else {
+      for (TUint32 c = 0; c < 3u; c++) {
+        normal[c] /= length;
+      }
+    }
+
+    for (TUint32 c = 0; c < 3u; c++) {
+      out[c] = to_unorm8(normal[c] * 0.5f + 0.5f);
+    }
+    out[3] = static_cast<TUint8>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2u) / 4u);
+  }
+
+  TextureLevels build_mip_chain(const TUint8 *pixels, TUint32 width, TUint32 height, TextureKind kind) {
+    MAU_PROFILE_SCOPE("build_mip_chain");
+    ASSERT(pixels && width > 0u && height > 0u);
+
+    TextureLevels levels = {};
+    levels.Format = kind == TextureKind::NORMAL ? TextureFormat::RGBA8_UNORM : TextureFormat::RGBA8_SRGB;
+    levels.Width = width;
+    levels.Height = height;
+
+    TUint64 total_size = 0u;
+    levels.Mips = layout_mip_chain(levels.Format, width, height, total_size);
+    levels.Data.resize(total_size);
+    memcpy(levels.Data.data(), pixels, levels.Mips[0].Size);
+
+    for (size_t i = 1; i < levels.Mips.size(); i++) {
+      const TextureMip &src_mip = levels.Mips[i - 1u];
+      const TextureMip &dst_mip = levels.Mips[i];
+      const TUint8     *src = levels.Data.data() + src_mip.Offset;
+      TUint8           *dst = levels.Data.data() + dst_mip.Offset;
+
+      for (TUint32 y = 0; y < dst_mip.Height; y++) {
+        for (TUint32 x = 0; x < dst_mip.Width; x++) {
+          // odd sizes repeat the edge texel
+          const TUint32 x0 = std::min(x * 2u, src_mip.Width - 1u);
+          const TUint32 x1 = std::min(x * 2u + 1u, src_mip.Width - 1u);
+          const TUint32 y0 = std::min(y * 2u, src_mip.Height - 1u);
+          const TUint32 y1 = std::min(y * 2u + 1u, src_mip.Height - 1u);
+
+          const TUint8 *texels[4] = {
+              src + (static_cast<TUint64>(y0) * src_mip.Width + x0) * 4u,
+              src + (static_cast<TUint64>(y0) * src_mip.Width + x1) * 4u,
+              src + (static_cast<TUint64>(y1) * src_mip.Width + x0) * 4u,
+              src + (static_cast<TUint64>(y1) * src_mip.Width + x1) * 4u,
+          };
+
+          TUint8 *out = dst + (static_cast<TUint64>(y) * dst_mip.Width + x) * 4u;
+          if (kind == TextureKind::NORMAL) {
+            downsample_normal(texels, out);
+          } else {
+            downsample_color(texels, out);
+          }
+        }
+      }
+    }
+
+    return levels;
+  }
+
+  // block compression
+
+  static TUint16 pack_565(const TFloat32 color[3]) {
+    const TUint32 r = static_cast<TUint32>(std::clamp(color[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    const TUint32 g = static_cast<TUint32>(std::clamp(color[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+    const TUint32 b = static_cast<TUint32>(std::clamp(color[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    return static_cast<TUint16>((r << 11u) | (g << 5u) | b);
+  }
+
+  static void unpack_565(TUint16 packed, TFloat32 color[3]) {
+    const TUint32 r = (packed >> 11u) & 31u;
+    const TUint32 g = (packed >> 5u) & 63u;
+    const TUint32 b = packed & 31u;
+    color[0] = static_cast<TFloat32>((r << 3u) | (r >> 2u));
+    color[1] = static_cast<TFloat32>((g << 2u) | (g >> 4u));
+    color[2] = static_cast<TFloat32>((b << 3u) | (b >> 2u));
+  }
+
+  static void write_le(TUint8 *out, TUint64 value, TUint32 byte_count) {
+    for (TUint32 i = 0; i < byte_count; i++) {
+      out[i] = static_cast<TUint8>(value >> (8u * i));
+    }
+  }
+
+  // endpoints are the texels furthest apart along the principal axis of the block
+  static void encode_bc1_block(const TUint8 block[16][4], TUint8 *out) {
+    TFloat32 mean[3] = {};
+    for (TUint32 i = 0; i < 16u; i++) {
+      for (TUint32 c = 0; c < 3u; c++) {
+        mean[c] += static_cast<TFloat32>(block[i][c]) / 16.0f;
+      }
+    }
+
+    TFloat32 covariance[3][3] = {};
+    for (TUint32 i = 0; i < 16u; i++) {
+      const TFloat32 d[3] = {block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2]};
+      for (TUint32 r = 0; r < 3u; r++) {
+        for (TUint32 c = 0; c < 3u; c++) {
+          covariance[r][c] += d[r] * d[c];
+        }
+      }
+    }
+
+    TFloat32 axis[3] = {1.0f, 1.0f, 1.0f};
+    for (TUint32 iteration = 0; iteration < 8u; iteration++) {
+      TFloat32 next[3] = {};
+      for (TUint32 r = 0; r < 3u; r++) {
+        next[r] = covariance[r][0] * axis[0] + covariance[r][1] * axis[1] + covariance[r][2] * axis[2];
+      }
+
+      const TFloat32 scale = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+      if (scale < 1e-6f)
+        break;
+
+      for (TUint32 c = 0; c < 3u; c++) {
+        axis[c] = next[c] / scale;
+      }
+    }
+
+    TUint32  min_index = 0u, max_index = 0u;
+    TFloat32 min_t = 0.0f, max_t = 0.0f;
+    for (TUint32 i = 0; i < 16u; i++) {
+      const TFloat32 t = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+      if (i == 0u || t < min_t) {
+        min_t = t;
+        min_index = i;
+      }
+      if (i == 0u || t > max_t) {
+        max_t = t;
+        max_index = i;
+      }
+    }
+
+    const TFloat32 high[3] = {static_cast<TFloat32>(block[max_index][0]), static_cast<TFloat32>(block[max_index][1]), static_cast<TFloat32>(block[max_index][2])};
+    const TFloat32 low[3] = {static_cast<TFloat32>(block[min_index][0]), static_cast<TFloat32>(block[min_index][1]), static_cast<TFloat32>(block[min_index][2])};
+
+    // color0 > color1 selects the four color mode
+    TUint16 color0 = pack_565(high);
+    TUint16 color1 = pack_565(low);
+    if (color0 < color1)
+      std::swap(color0, color1);
+
+    TUint32 indices = 0u;
+    if (color0 != color1) {
+      TFloat32 c0[3] = {}, c1[3] = {};
+      unpack_565(color0, c0);
+      unpack_565(color1, c1);
+
+      const TFloat32 d[3] = {c0[0] - c1[0], c0[1] - c1[1], c0[2] - c1[2]};
+      const TFloat32 length_sq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+      // palette order is c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+      const TUint32 remap[4] = {1u, 3u, 2u, 0u};
+      for (TUint32 i = 0; i < 16u; i++) {
+        const TFloat32 t = ((block[i][0] - c1[0]) * d[0] + (block[i][1] - c1[1]) * d[1] + (block[i][2] - c1[2]) * d[2]) / length_sq;
+        const TUint32  step = static_cast<TUint32>(std::clamp(t * 3.0f + 0.5f, 0.0f, 3.0f));
+        indices |= remap[step] << (2u * i);
+      }
+    }
+
+    write_le(out, color0, 2u);
+    write_le(out + 2u, color1, 2u);
+    write_le(out + 4u, indices, 4u);
+  }
+
+  static void encode_bc4_block(const TUint8 values[16], TUint8 *out) {
+    const TUint8 high = *std::max_element(values, values + 16);
+    const TUint8 low = *std::min_element(values, values + 16);
+
+    // high > low selects the eight value mode, palette order is high, low, then 6/7 .. 1/7 of high
+    TUint64 indices = 0u;
+    if (high != low) {
+      const TUint32 remap[8] = {0u, 2u, 3u, 4u, 5u, 6u, 7u, 1u};
+      for (TUint32 i = 0; i < 16u; i++) {
+        const TFloat32 t = static_cast<TFloat32>(high - values[i]) * 7.0f / static_cast<TFloat32>(high - low);
+        const TUint32  step = static_cast<TUint32>(std::clamp(t + 0.5f, 0.0f, 7.0f));
+        indices |= static_cast<TUint64>(remap[step]) << (3u * i);
+      }
+    }
+
+    out[0] = high;
+    out[1] = low;
+    write_le(out + 2u, indices, 6u);
+  }
+
+  TextureLevels compress_mip_chain(const TextureLevels &levels, TextureKind kind) {
+    MAU_PROFILE_SCOPE("compress_mip_chain");
+    ASSERT(!is_block_compressed(levels.Format) && !levels.Mips.empty());
+
+    TextureLevels compressed = {};
+    compressed.Width = levels.Width;
+    compressed.Height = levels.Height;
+    compressed.Format = TextureFormat::BC1_SRGB;
+
+    if (kind == TextureKind::NORMAL) {
+      compressed.Format = TextureFormat::BC5_UNORM;
+    } else {
+      for (TUint64 i = 0; i < levels.Mips[0].Size; i += 4u) {
+        if (levels.Data[i + 3u] != 255u) {
+          compressed.Format = TextureFormat::BC3_SRGB;
+          break;
+        }
+      }
+    }
+
+    TUint64 total_size = 0u;
+    compressed.Mips = layout_mip_chain(compressed.Format, levels.Width, levels.Height, total_size);
+    compressed.Data.resize(total_size);
+
+    const TUint64 block_size = compressed.Format == TextureFormat::BC1_SRGB ? 8u : 16u;
+
+    for (size_t m = 0; m < levels.Mips.size(); m++) {
+      const TextureMip &src_mip = levels.Mips[m];
+      const TUint8     *src = levels.Data.data() + src_mip.Offset;
+      TUint8           *dst = compressed.Data.data() + compressed.Mips[m].Offset;
+
+      const TUint32 blocks_x = (src_mip.Width + 3u) / 4u;
+      const TUint32 blocks_y = (src_mip.Height + 3u) / 4u;
+
+      for (TUint32 by = 0; by < blocks_y; by++) {
+        for (TUint32 bx = 0; bx < blocks_x; bx++) {
+          // blocks past the edge of small levels repeat the edge texels
+          TUint8 block[16][4] = {};
+          for (TUint32 i = 0; i < 16u; i++) {
+            const TUint32 x = std::min(bx * 4u + i % 4u, src_mip.Width - 1u);
+            const TUint32 y = std::min(by * 4u + i / 4u, src_mip.Height - 1u);
+            memcpy(block[i], src + (static_cast<TUint64>(y) * src_mip.Width + x) * 4u, 4u);
+          }
+
+          TUint8 *out = dst + (static_cast<TUint64>(by) * blocks_x + bx) * block_size;
+
+          if (compressed.Format == TextureFormat::BC5_UNORM) {
+            TUint8 red[16] = {}, green[16] = {};
+            for (TUint32 i = 0; i < 16u; i++) {
+              red[i] = block[i][0];
+              green[i] = block[i][1];
+            }
+            encode_bc4_block(red, out);
+            encode_bc4_block(green, out + 8u);
+          } else if (compressed.Format == TextureFormat::BC3_SRGB) {
+            TUint8 alpha[16] = {};
+            for (TUint32 i = 0; i < 16u; i++) {
+              alpha[i] = block[i][3];
+            }
+            encode_bc4_block(alpha, out);
+            encode_bc1_block(block, out + 8u);
+          } else {
+            encode_bc1_block(block, out);
+          }
+        }
+      }
+    }
+
+    return compressed;
+  }
+
+} // namespace mau
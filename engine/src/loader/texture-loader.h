@@ -0,0 +1,46 @@
+#pragma once
+
+#include <engine/types.h>
+#include <engine/loader/cooker.h>
+
+namespace mau {
+
+  enum class TextureFormat : TUint32 {
+    RGBA8_SRGB = 0,
+    RGBA8_UNORM = 1,
+    BC1_SRGB = 2,
+    BC3_SRGB = 3,
+    BC5_UNORM = 4,
+  };
+
+  // one level of a packed mip chain, offsets are relative to the start of the chain
+  struct TextureMip {
+    TUint64 Offset = 0u;
+    TUint64 Size = 0u;
+    TUint32 Width = 0u;
+    TUint32 Height = 0u;
+  };
+
+  struct TextureLevels {
+    TextureFormat      Format = TextureFormat::RGBA8_SRGB;
+    TUint32            Width = 0u;
+    TUint32            Height = 0u;
+    Vector<TextureMip> Mips = {};
+    Vector<TUint8>     Data = {};
+  };
+
+  // every level is aligned so that block copies never straddle it
+  constexpr TUint64 TEXTURE_MIP_ALIGNMENT = 16u;
+
+  TUint32 get_mip_count(TUint32 width, TUint32 height);
+  bool    is_block_compressed(TextureFormat format);
+  bool    is_valid_texture_format(TUint32 format);
+  TUint64 get_level_size(TextureFormat format, TUint32 width, TUint32 height);
+
+  // box filtered rgba8 chain down to 1x1, color is averaged in linear space and normals are renormalized
+  TextureLevels build_mip_chain(const TUint8 *pixels, TUint32 width, TUint32 height, TextureKind kind);
+
+  // bc1 for opaque color, bc3 when any texel has alpha, bc5 for normal maps
+  TextureLevels compress_mip_chain(const TextureLevels &levels, TextureKind kind);
+
+} // namespace mau
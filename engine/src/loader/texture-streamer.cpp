@@ -0,0 +1,146 @@
+#include "texture-streamer.h"
+
+#include <algorithm>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include <engine/loader/cooker.h>
+#include "graphics/vulkan-state.h"
+#include "loader/image-loader.h"
+
+namespace mau {
+
+  // shown for images that fail to decode, same as the bindless placeholder
+  static const TUint32 FALLBACK_PIXEL = 0xffffffffu;
+
+  // decodes share the job system's workers instead of a pool of their own, which would oversubscribe the cores while a
+  // scene loads. they are background jobs so a frame waiting for its own jobs never runs one
+  TextureStreamer::TextureStreamer() {
+    m_BlockCompression = VulkanState::Ref().GetDeviceHandle()->IsTextureCompressionBCEnabled();
+
+    LOG_INFO("texture streamer started [decode threads: %u, block compression: %s]", JobSystem::Ref().GetWorkerCount(), m_BlockCompression ? "yes" : "no");
+  }
+
+  TextureStreamer::~TextureStreamer() {
+    // the jobs write into m_Results
+    JobSystem::Ref().Wait(m_DecodeJobs);
+
+    m_Decoding.clear();
+    m_Uploading.clear();
+  }
+
+  Handle<Texture> TextureStreamer::Load(const String &image_path, TextureKind kind) {
+    Handle<Texture> texture = make_handle<Texture>();
+    const TUint64   id = m_NextId++;
+
+    m_Decoding.insert(std::make_pair(id, texture));
+
+    const DecodeRequest request = {id, image_path, kind};
+    JobSystem::Ref().ScheduleBackground(
+        [this, request]() -> void {
+          DecodeResult result = Decode(request);
+
+          std::lock_guard<std::mutex> lock(m_Mutex);
+          m_Results.push_back(std::move(result));
+        },
+        &m_DecodeJobs);
+
+    return texture;
+  }
+
+  TUint32 TextureStreamer::Update() {
+    MAU_PROFILE_SCOPE("TextureStreamer::Update");
+
+    Vector<DecodeResult> results = {};
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      results.swap(m_Results);
+    }
+
+    UploadRing &upload_ring = *VulkanState::Ref().GetUploadRing();
+
+    for (DecodeResult &result : results) {
+      auto it = m_Decoding.find(result.Id);
+      ASSERT(it != m_Decoding.end());
+
+      Handle<Texture> texture = it->second;
+      m_Decoding.erase(it);
+
+      TUint64 value = 0u;
+      if (result.Cooked) {
+        const CookedTexture &cooked = *result.Cooked;
+        value = texture->Create(cooked.GetFormat(), cooked.GetWidth(), cooked.GetHeight(), cooked.GetData(), cooked.GetDataSize(), cooked.GetMips());
+      } else if (!result.Levels.Data.empty()) {
+        value = texture->Create(result.Levels);
+      } else {
+        value = texture->Create(1u, 1u, &FALLBACK_PIXEL);
+      }
+
+      m_Uploading.push_back({texture, value});
+    }
+
+    if (!results.empty()) {
+      upload_ring.Flush();
+    }
+
+    if (m_Uploading.empty()) {
+      return 0u;
+    }
+
+    // only textures whose copies have finished are swapped in
+    const TUint64         completed = upload_ring.GetTimeline()->GetValue();
+    Vector<PendingUpload> uploading = {};
+    TUint32               resident_count = 0u;
+
+    for (PendingUpload &upload : m_Uploading) {
+      if (upload.Value <= completed) {
+        upload.Target->m_Resident = true;
+        resident_count++;
+      } else {
+        uploading.push_back(upload);
+      }
+    }
+
+    m_Uploading.swap(uploading);
+    upload_ring.Retire();
+    return resident_count;
+  }
+
+  void TextureStreamer::WaitIdle() {
+    MAU_PROFILE_SCOPE("TextureStreamer::WaitIdle");
+
+    while (GetPendingCount() > 0u) {
+      if (!m_Decoding.empty()) {
+        JobSystem::Ref().Wait(m_DecodeJobs);
+      }
+
+      Update();
+
+      if (m_Decoding.empty() && !m_Uploading.empty()) {
+        VulkanState::Ref().GetUploadRing()->WaitIdle();
+      }
+    }
+  }
+
+  TextureStreamer::DecodeResult TextureStreamer::Decode(const DecodeRequest &request) const {
+    MAU_PROFILE_SCOPE("TextureStreamer::Decode");
+
+    DecodeResult result = {};
+    result.Id = request.Id;
+
+    if (m_BlockCompression) {
+      auto cooked = std::make_unique<CookedTexture>(GetCookedTexturePath(request.Path), request.Path, request.Kind);
+      if (cooked->IsValid()) {
+        result.Cooked = std::move(cooked);
+        return result;
+      }
+    }
+
+    RawImage image(request.Path);
+    if (image.Data) {
+      result.Levels = build_mip_chain(reinterpret_cast<const TUint8 *>(image.Data), image.Width, image.Height, request.Kind);
+    }
+
+    return result;
+  }
+
+} // namespace mau
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <engine/types.h>
+#include <engine/core/job-system.h>
+#include <engine/utils/singleton.h>
+#include "graphics/vulkan-image.h"
+#include "loader/texture-cache.h"
+
+namespace mau {
+
+  // decodes textures as background jobs of the job system and uploads them through the upload ring,
+  // streamed textures sit behind the bindless placeholder until they are resident.
+  // cooked block compressed mip chains are preferred, otherwise the mips are built by the job
+  class TextureStreamer: public Singleton<TextureStreamer> {
+    friend class Singleton<TextureStreamer>;
+
+  private:
+    TextureStreamer();
+    ~TextureStreamer();
+
+  public:
+    Handle<Texture> Load(const String &image_path, TextureKind kind = TextureKind::COLOR);
+
+    // main thread, uploads decoded images and returns the number of textures that became resident
+    TUint32 Update();
+    void    WaitIdle();
+
+  public:
+    inline TUint32 GetPendingCount() const { return static_cast<TUint32>(m_Decoding.size() + m_Uploading.size()); }
+
+  private:
+    struct DecodeRequest {
+      TUint64     Id = 0u;
+      String      Path = "";
+      TextureKind Kind = TextureKind::COLOR;
+    };
+
+    // either a mapped cooked chain or levels built from the source image, neither when decoding failed
+    struct DecodeResult {
+      TUint64                        Id = 0u;
+      std::unique_ptr<CookedTexture> Cooked = nullptr;
+      TextureLevels                  Levels = {};
+    };
+
+    struct PendingUpload {
+      Handle<Texture> Target = nullptr;
+      TUint64         Value = 0u;
+    };
+
+  private:
+    DecodeResult Decode(const DecodeRequest &request) const;
+
+  private:
+    // read by the decode jobs, fixed at construction
+    bool m_BlockCompression = false;
+
+    // shared with the decode jobs, handles never cross this boundary
+    std::mutex           m_Mutex;
+    Vector<DecodeResult> m_Results = {};
+    JobCounter           m_DecodeJobs = {};
+
+    // main thread only
+    TUint64                                m_NextId = 0u;
+    UnorderedMap<TUint64, Handle<Texture>> m_Decoding = {};
+    Vector<PendingUpload>                  m_Uploading = {};
+  };
+
+} // namespace mau
@@ -101,34 +101,24 @@ namespace mau {
         optixDenoiserSetup(m_Denoiser, m_CuStream, m_ImageSize.x, m_ImageSize.y, m_StateBuffer, m_DenoiserSizes.stateSizeInBytes, m_ScratchBuffer, m_DenoiserSizes.withoutOverlapScratchSizeInBytes));
   }
 
-  void Denoiser::ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal, VkImageLayout layout) {
+  void Denoiser::ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal) {
     VkBufferImageCopy copy_region = {
         .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1u},
         .imageExtent = {.width = m_ImageSize.x, .height = m_ImageSize.y, .depth = 1u},
     };
 
-    TransitionImageLayout(cmd, color, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     vkCmdCopyImageToBuffer(cmd->Get(), color->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ColorBuffer->Get(), 1u, &copy_region);
-    TransitionImageLayout(cmd, color, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, layout);
-
-    TransitionImageLayout(cmd, albedo, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     vkCmdCopyImageToBuffer(cmd->Get(), albedo->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_AlbedoBuffer->Get(), 1u, &copy_region);
-    TransitionImageLayout(cmd, albedo, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
-
-    TransitionImageLayout(cmd, normal, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     vkCmdCopyImageToBuffer(cmd->Get(), normal->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_NormalBuffer->Get(), 1u, &copy_region);
-    TransitionImageLayout(cmd, normal, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
   }
 
-  void Denoiser::BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output, VkImageLayout layout) {
+  void Denoiser::BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output) {
     VkBufferImageCopy copy_region = {
         .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1u},
         .imageExtent = {.width = m_ImageSize.x, .height = m_ImageSize.y, .depth = 1u},
     };
 
-    TransitionImageLayout(cmd, output, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     vkCmdCopyBufferToImage(cmd->Get(), m_OutputBuffer->Get(), output->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &copy_region);
-    TransitionImageLayout(cmd, output, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout);
   }
 
   void Denoiser::Denoise(Handle<CommandBuffer> &cmd) {
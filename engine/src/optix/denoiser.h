@@ -26,8 +26,9 @@ namespace mau {
 
   public:
     void AllocateBuffers(TUint32 width, TUint32 height);
-    void ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal, VkImageLayout layout);
-    void BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output, VkImageLayout layout);
+    // the images are in transfer layouts, the render graph moves them there
+    void ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal);
+    void BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output);
     void Denoise(Handle<CommandBuffer> &cmd);
 
   private:
@@ -81,8 +82,8 @@ namespace mau {
 
   public:
     void AllocateBuffers(TUint32 width, TUint32 height) { }
-    void ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal, VkImageLayout layout) { }
-    void BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output, VkImageLayout layout) { }
+    void ImageToBuffers(Handle<CommandBuffer> &cmd, const Handle<Image> &color, const Handle<Image> &albedo, const Handle<Image> &normal) { }
+    void BufferToImage(Handle<CommandBuffer> &cmd, const Handle<Image> &output) { }
     void Denoise(Handle<CommandBuffer> &cmd) { }
 
   private:
@@ -0,0 +1,371 @@
+#include "cpu-path-tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <mutex>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include <engine/core/job-system.h>
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  // same values as the shaders, see rt/basic.rgen and common/limits.glsl
+  constexpr TUint32  CPU_PT_MAX_RAY_RECURSION = 3u;
+  constexpr TFloat32 CPU_PT_T_MIN = 0.001f;
+  constexpr TFloat32 CPU_PT_T_MAX = 10000.0f;
+  constexpr TFloat32 CPU_PT_SHADOW_SPREAD = 0.05f;
+  const glm::vec3    CPU_PT_DEBUG_COLOR = glm::vec3(1.0f, 1.0f, 0.0f);
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  // common/random.glsl, a pcg hash stepping the state in place
+  static inline TFloat32 rand(TUint32 &state) {
+    state = state * 747796407u + 2891336453u;
+    TUint32 result = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    result = (result >> 22u) ^ result;
+    return static_cast<TFloat32>(result) / 4294967295.0f;
+  }
+
+  static inline TFloat32 rand(TUint32 &state, TFloat32 min_val, TFloat32 max_val) { return min_val + (max_val - min_val) * rand(state); }
+
+  // components in glsl order, function arguments would leave it unspecified
+  static inline glm::vec3 rand_vec3(TUint32 &state, TFloat32 min_val, TFloat32 max_val) {
+    const TFloat32 x = rand(state, min_val, max_val);
+    const TFloat32 y = rand(state, min_val, max_val);
+    const TFloat32 z = rand(state, min_val, max_val);
+    return glm::vec3(x, y, z);
+  }
+
+  static inline glm::vec3 rand_in_unit_sphere(TUint32 &state) {
+    while (true) {
+      const glm::vec3 p = rand_vec3(state, -1.0f, 1.0f);
+      if (glm::dot(p, p) < 1.0f)
+        return p;
+    }
+  }
+
+  static inline glm::vec3 rand_unit_vector(TUint32 &state) { return glm::normalize(rand_vec3(state, -1.0f, 1.0f)); }
+
+  // rt/basic.rmiss
+  static inline glm::vec3 sky_color(const glm::vec3 &direction) {
+    const TFloat32 a = 0.5f * (direction.y + 1.0f);
+    return glm::mix(glm::vec3(1.0f), glm::vec3(0.5f, 0.7f, 1.0f), a);
+  }
+
+  static inline TFloat32 luminance(const glm::vec3 &color) { return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)); }
+
+  static const TFloat32 *srgb_to_linear_table() {
+    static const auto table = []() {
+      std::array<TFloat32, 256> values = {};
+      for (TUint32 i = 0u; i < 256u; i++) {
+        const TFloat32 c = static_cast<TFloat32>(i) / 255.0f;
+        values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+      }
+      return values;
+    }();
+    return table.data();
+  }
+
+  CpuTexture::CpuTexture(const String &path) { m_Image = std::make_unique<RawImage>(path); }
+
+  glm::vec3 CpuTexture::Sample(glm::vec2 uv) const {
+    const TFloat32 *to_linear = srgb_to_linear_table();
+    const TUint8   *texels = static_cast<const TUint8 *>(m_Image->Data);
+    const TInt32    width = static_cast<TInt32>(m_Image->Width);
+    const TInt32    height = static_cast<TInt32>(m_Image->Height);
+
+    // texel centers sit at half coordinates
+    const TFloat32 x = uv.x * static_cast<TFloat32>(width) - 0.5f;
+    const TFloat32 y = uv.y * static_cast<TFloat32>(height) - 0.5f;
+    const TFloat32 x_floor = std::floor(x);
+    const TFloat32 y_floor = std::floor(y);
+    const TFloat32 fx = x - x_floor;
+    const TFloat32 fy = y - y_floor;
+
+    auto wrap = [](TFloat32 value, TInt32 size) -> TInt32 {
+      const TInt32 index = static_cast<TInt32>(std::fmod(value, static_cast<TFloat32>(size)));
+      return index < 0 ? index + size : index;
+    };
+
+    const TInt32 x0 = wrap(x_floor, width), x1 = (x0 + 1) % width;
+    const TInt32 y0 = wrap(y_floor, height), y1 = (y0 + 1) % height;
+
+    auto texel = [&](TInt32 tx, TInt32 ty) -> glm::vec3 {
+      const TUint8 *t = texels + (static_cast<size_t>(ty) * width + tx) * 4u;
+      return glm::vec3(to_linear[t[0]], to_linear[t[1]], to_linear[t[2]]);
+    };
+
+    return glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), fx), glm::mix(texel(x0, y1), texel(x1, y1), fx), fy);
+  }
+
+  bool CpuScene::Load(const String &mesh_path, const glm::mat4 &model) {
+    MAU_PROFILE_SCOPE("CpuScene::Load");
+    const Clock::time_point start = Clock::now();
+
+    if (!load_mesh_geometry(mesh_path, m_SubMeshes))
+      return false;
+
+    // textures shared between submeshes are loaded once
+    const String                  directory = std::filesystem::path(mesh_path).parent_path().string();
+    UnorderedMap<String, TUint32> texture_indices = {};
+    Vector<String>                texture_paths = {};
+    Vector<TUint32>               diffuse_indices(m_SubMeshes.size(), UINT32_MAX);
+
+    for (size_t i = 0; i < m_SubMeshes.size(); i++) {
+      if (m_SubMeshes[i].Paths.DiffuseMap.empty())
+        continue;
+
+      const String path = directory + "/" + m_SubMeshes[i].Paths.DiffuseMap;
+      const auto [it, inserted] = texture_indices.insert(std::make_pair(path, static_cast<TUint32>(texture_paths.size())));
+      if (inserted) {
+        texture_paths.push_back(path);
+      }
+      diffuse_indices[i] = it->second;
+    }
+
+    m_Textures.resize(texture_paths.size());
+    JobSystem::Ref().ParallelFor(static_cast<TUint32>(texture_paths.size()), 1u, [&](TUint32 begin, TUint32 end) {
+      for (TUint32 i = begin; i < end; i++) {
+        m_Textures[i] = std::make_unique<CpuTexture>(texture_paths[i]);
+      }
+    });
+
+    // a diffuse map that fails to load is drawn like a material without one
+    m_Diffuse.assign(m_SubMeshes.size(), nullptr);
+    for (size_t i = 0; i < m_SubMeshes.size(); i++) {
+      if (diffuse_indices[i] != UINT32_MAX && m_Textures[diffuse_indices[i]]->IsValid()) {
+        m_Diffuse[i] = m_Textures[diffuse_indices[i]].get();
+      }
+    }
+
+    Vector<BvhGeometry> geometries = {};
+    for (const MeshGeometry &submesh : m_SubMeshes) {
+      geometries.push_back({
+          .Positions = submesh.Vertices.empty() ? nullptr : &submesh.Vertices[0].pos,
+          .PositionStride = sizeof(Vertex),
+          .VertexCount = submesh.Vertices.size(),
+          .Indices = submesh.Indices.data(),
+          .IndexCount = submesh.Indices.size(),
+          .Transform = model,
+      });
+    }
+
+    // what rt/basic.rchit multiplies normals with, the inverse transpose of the model matrix
+    m_NormalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+    m_Bvh.Build(geometries);
+    m_LoadMs = elapsed_ms(start);
+
+    LOG_INFO("cpu scene loaded %s [triangles: %u, textures: %u, bvh: %.1f ms, total: %.1f ms]", mesh_path.c_str(), GetTriangleCount(), static_cast<TUint32>(m_Textures.size()),
+             m_Bvh.GetStats().BuildMs, m_LoadMs);
+    return true;
+  }
+
+  CpuPathTracer::CpuPathTracer(const CpuScene &scene, const CpuPathTracerSettings &settings): m_Scene(scene), m_Settings(settings) {
+    m_Settings.TileSize = std::max(m_Settings.TileSize, 1u);
+    m_Settings.PassSamples = std::max(m_Settings.PassSamples, 1u);
+    m_Settings.MaxSamples = std::max(m_Settings.MaxSamples, 1u);
+    m_Settings.MinSamples = std::clamp(m_Settings.MinSamples, 1u, m_Settings.MaxSamples);
+
+    for (TUint32 y = 0u; y < m_Settings.Height; y += m_Settings.TileSize) {
+      for (TUint32 x = 0u; x < m_Settings.Width; x += m_Settings.TileSize) {
+        m_Tiles.push_back({
+            .X = x,
+            .Y = y,
+            .Width = std::min(m_Settings.TileSize, m_Settings.Width - x),
+            .Height = std::min(m_Settings.TileSize, m_Settings.Height - y),
+        });
+      }
+    }
+
+    const size_t pixel_count = static_cast<size_t>(m_Settings.Width) * m_Settings.Height;
+    m_Accumulation.assign(pixel_count * 4u, 0.0f);
+    m_LuminanceSquares.assign(pixel_count, 0.0f);
+
+    m_Stats.TileCount = static_cast<TUint32>(m_Tiles.size());
+    m_Stats.ActiveTiles = m_Stats.TileCount;
+
+    SetCamera(Camera());
+  }
+
+  void CpuPathTracer::SetCamera(const Camera &camera) {
+    m_ViewInverse = glm::inverse(camera.GetView());
+    m_ProjInverse = glm::inverse(camera.GetProj(glm::vec2(static_cast<TFloat32>(m_Settings.Width), static_cast<TFloat32>(m_Settings.Height))));
+  }
+
+  glm::vec3 CpuPathTracer::TracePath(TUint32 x, TUint32 y, TUint32 frame, TUint64 &rays) const {
+    const TUint32 width = m_Settings.Width;
+    const TUint32 height = m_Settings.Height;
+
+    TUint32 seed = ((y * width + x) + frame * width * height) % UINT32_MAX;
+    rand(seed);
+
+    const TFloat32  jitter_x = rand(seed) - 0.5f;
+    const TFloat32  jitter_y = rand(seed) - 0.5f;
+    const glm::vec2 pixel_center = glm::vec2(static_cast<TFloat32>(x), static_cast<TFloat32>(y)) + glm::vec2(0.5f) + glm::vec2(jitter_x, jitter_y);
+    const glm::vec2 in_uv = pixel_center / glm::vec2(static_cast<TFloat32>(width), static_cast<TFloat32>(height));
+    const glm::vec2 d = in_uv * 2.0f - 1.0f;
+
+    glm::vec3       origin = glm::vec3(m_ViewInverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    const glm::vec4 target = m_ProjInverse * glm::vec4(d.x, -d.y, 1.0f, 1.0f);
+    glm::vec3       direction = glm::vec3(m_ViewInverse * glm::vec4(glm::normalize(glm::vec3(target)), 0.0f));
+
+    const glm::vec3 inverse_light_dir = glm::vec3(m_Settings.LightDirection);
+    const glm::vec3 light_col = glm::vec3(m_Settings.LightColor);
+    const TFloat32  light_intensity = m_Settings.LightColor.w;
+
+    const CpuBvh &bvh = m_Scene.GetBvh();
+
+    glm::vec3 color = glm::vec3(1.0f);
+    TFloat32  factor = 1.0f;
+
+    for (TUint32 i = 0u; i < CPU_PT_MAX_RAY_RECURSION; i++) {
+      BvhHit hit = {};
+      rays++;
+
+      if (!bvh.Intersect({.Origin = origin, .TMin = CPU_PT_T_MIN, .Direction = direction, .TMax = CPU_PT_T_MAX}, hit)) {
+        color *= sky_color(direction) * factor;
+        break;
+      }
+
+      if (hit.T > 0.001f) {
+        // rt/basic.rchit, barycentric interpolation of the hit triangle
+        const MeshGeometry &submesh = m_Scene.GetSubMeshes()[hit.Geometry];
+        const Vertex       &v0 = submesh.Vertices[submesh.Indices[3u * hit.Primitive + 0u]];
+        const Vertex       &v1 = submesh.Vertices[submesh.Indices[3u * hit.Primitive + 1u]];
+        const Vertex       &v2 = submesh.Vertices[submesh.Indices[3u * hit.Primitive + 2u]];
+        const glm::vec3     bary = glm::vec3(1.0f - hit.U - hit.V, hit.U, hit.V);
+
+        const glm::vec3 normal = glm::normalize(m_Scene.GetNormalMatrix() * (v0.normal * bary.x + v1.normal * bary.y + v2.normal * bary.z));
+        const glm::vec2 tex_coord = v0.tex * bary.x + v1.tex * bary.y + v2.tex * bary.z;
+
+        const CpuTexture *diffuse = m_Scene.GetDiffuse(hit.Geometry);
+        const glm::vec3   hit_color = diffuse != nullptr ? diffuse->Sample(tex_coord) : CPU_PT_DEBUG_COLOR;
+
+        origin = origin + direction * hit.T + normal * 0.001f;
+        direction = normal + rand_unit_vector(seed);
+        color *= hit_color * factor;
+
+        const glm::vec3 shadow_ray_dir = glm::normalize(inverse_light_dir + rand_in_unit_sphere(seed) * CPU_PT_SHADOW_SPREAD);
+        rays++;
+        if (!bvh.Occluded({.Origin = origin, .TMin = CPU_PT_T_MIN, .Direction = shadow_ray_dir, .TMax = CPU_PT_T_MAX})) {
+          color *= light_col * light_intensity;
+        }
+      }
+
+      factor *= 0.5f;
+    }
+
+    return color;
+  }
+
+  void CpuPathTracer::RenderTile(Tile &tile, TUint64 &rays) {
+    MAU_PROFILE_SCOPE("CpuPathTracer::RenderTile");
+
+    const TUint32 sample_count = std::min(m_Settings.PassSamples, m_Settings.MaxSamples - tile.Samples);
+
+    for (TUint32 y = tile.Y; y < tile.Y + tile.Height; y++) {
+      for (TUint32 x = tile.X; x < tile.X + tile.Width; x++) {
+        const size_t pixel = static_cast<size_t>(y) * m_Settings.Width + x;
+        TFloat32    *accum = &m_Accumulation[pixel * 4u];
+
+        for (TUint32 s = 0u; s < sample_count; s++) {
+          const glm::vec3 color = TracePath(x, y, tile.Samples + s, rays);
+          accum[0] += color.r;
+          accum[1] += color.g;
+          accum[2] += color.b;
+          accum[3] += 1.0f;
+
+          const TFloat32 l = luminance(color);
+          m_LuminanceSquares[pixel] += l * l;
+        }
+      }
+    }
+
+    tile.Samples += sample_count;
+    tile.Noise = EstimateNoise(tile);
+    tile.Done = tile.Samples >= m_Settings.MaxSamples || (tile.Samples >= m_Settings.MinSamples && tile.Noise <= m_Settings.NoiseThreshold);
+  }
+
+  // standard error of the mean luminance relative to it, averaged over the tile. the square root keeps
+  // dark pixels from dominating, their relative error is large but barely visible
+  TFloat32 CpuPathTracer::EstimateNoise(const Tile &tile) const {
+    if (tile.Samples < 2u)
+      return BVH_INFINITY;
+
+    const TFloat32 n = static_cast<TFloat32>(tile.Samples);
+
+    TFloat32 noise = 0.0f;
+    for (TUint32 y = tile.Y; y < tile.Y + tile.Height; y++) {
+      for (TUint32 x = tile.X; x < tile.X + tile.Width; x++) {
+        const size_t    pixel = static_cast<size_t>(y) * m_Settings.Width + x;
+        const TFloat32 *accum = &m_Accumulation[pixel * 4u];
+
+        const TFloat32 mean = luminance(glm::vec3(accum[0], accum[1], accum[2])) / n;
+        const TFloat32 variance = std::max(m_LuminanceSquares[pixel] / n - mean * mean, 0.0f) * n / (n - 1.0f);
+        noise += std::sqrt(variance / n) / std::sqrt(std::max(mean, 1e-3f));
+      }
+    }
+
+    return noise / static_cast<TFloat32>(tile.Width * tile.Height);
+  }
+
+  bool CpuPathTracer::RenderPass() {
+    MAU_PROFILE_SCOPE("CpuPathTracer::RenderPass");
+
+    Vector<Tile *> active = {};
+    for (Tile &tile : m_Tiles) {
+      if (!tile.Done) {
+        active.push_back(&tile);
+      }
+    }
+
+    if (active.empty())
+      return false;
+
+    std::mutex mutex = {};
+    TUint64    pass_rays = 0u;
+    TUint64    pass_samples = 0u;
+
+    // tiles own their pixels, only the counters are shared
+    JobSystem::Ref().ParallelFor(static_cast<TUint32>(active.size()), 1u, [&](TUint32 begin, TUint32 end) {
+      TUint64 rays = 0u, samples = 0u;
+      for (TUint32 i = begin; i < end; i++) {
+        const TUint32 before = active[i]->Samples;
+        RenderTile(*active[i], rays);
+        samples += static_cast<TUint64>(active[i]->Samples - before) * active[i]->Width * active[i]->Height;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      pass_rays += rays;
+      pass_samples += samples;
+    });
+
+    m_Stats.Passes++;
+    m_Stats.Rays += pass_rays;
+    m_Stats.Samples += pass_samples;
+    m_Stats.ActiveTiles = static_cast<TUint32>(std::count_if(m_Tiles.begin(), m_Tiles.end(), [](const Tile &tile) -> bool { return !tile.Done; }));
+    return true;
+  }
+
+  void CpuPathTracer::Resolve(Vector<TFloat32> &linear, Vector<TFloat32> &display) const {
+    linear.resize(m_Accumulation.size());
+    display.resize(m_Accumulation.size());
+
+    for (size_t i = 0; i < m_Accumulation.size(); i += 4u) {
+      const TFloat32 weight = m_Accumulation[i + 3u] > 0.0f ? m_Accumulation[i + 3u] : 1.0f;
+      for (size_t c = 0; c < 3u; c++) {
+        linear[i + c] = m_Accumulation[i + c] / weight;
+        display[i + c] = std::sqrt(linear[i + c]);
+      }
+      linear[i + 3u] = 1.0f;
+      display[i + 3u] = 1.0f;
+    }
+  }
+
+} // namespace mau
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <glm/glm.hpp>
+#include <engine/types.h>
+
+#include "core/simd.h"
+#include "loader/image-loader.h"
+#include "loader/mesh-cache.h"
+#include "scene/bvh.h"
+#include "scene/camera.h"
+
+namespace mau {
+
+  // the node width that matches the vector registers the engine is built for
+#ifdef MAU_SIMD_AVX
+  using CpuBvh = Bvh8;
+#else
+  using CpuBvh = Bvh4;
+#endif
+
+  // srgb rgba8 texture sampled like the gpu sampler does at mip 0: decoded to linear, bilinear, repeating
+  class CpuTexture {
+  public:
+    CpuTexture(const String &path);
+    ~CpuTexture() = default;
+
+  public:
+    glm::vec3 Sample(glm::vec2 uv) const;
+
+  public:
+    inline bool IsValid() const { return m_Image->Data != nullptr; }
+
+  private:
+    std::unique_ptr<RawImage> m_Image = nullptr;
+  };
+
+  // geometry and diffuse maps of one mesh, the cpu side of what the raytracing pipeline reads. the model matrix is baked
+  // into the bvh, submesh vertices stay in model space and their normals are turned with GetNormalMatrix
+  class CpuScene {
+  public:
+    CpuScene() = default;
+    ~CpuScene() = default;
+
+  public:
+    bool Load(const String &mesh_path, const glm::mat4 &model = glm::mat4(1.0f));
+
+  public:
+    inline const CpuBvh               &GetBvh() const { return m_Bvh; }
+    inline const Vector<MeshGeometry> &GetSubMeshes() const { return m_SubMeshes; }
+    // null when the submesh has no diffuse map
+    inline const CpuTexture *GetDiffuse(TUint32 submesh) const { return m_Diffuse[submesh]; }
+    inline TUint32           GetTriangleCount() const { return m_Bvh.GetStats().TriangleCount; }
+    inline TFloat64          GetLoadMs() const { return m_LoadMs; }
+    inline const glm::mat3  &GetNormalMatrix() const { return m_NormalMatrix; }
+
+  private:
+    Vector<MeshGeometry>                m_SubMeshes = {};
+    Vector<std::unique_ptr<CpuTexture>> m_Textures = {};
+    Vector<const CpuTexture *>          m_Diffuse = {};
+    CpuBvh                              m_Bvh = {};
+    glm::mat3                           m_NormalMatrix = glm::mat3(1.0f);
+    TFloat64                            m_LoadMs = 0.0;
+  };
+
+  struct CpuPathTracerSettings {
+    TUint32   Width = 1280u;
+    TUint32   Height = 720u;
+    TUint32   TileSize = 16u;
+    // every tile takes at least MinSamples and at most MaxSamples, in between it stops once its noise is low enough
+    TUint32   MinSamples = 16u;
+    TUint32   MaxSamples = 256u;
+    TUint32   PassSamples = 4u;
+    TFloat32  NoiseThreshold = 0.02f;
+    glm::vec4 LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 24.0f);
+    glm::vec4 LightDirection = glm::vec4(-0.138f, 0.924f, -0.356f, 0.0f);
+  };
+
+  struct CpuPathTracerStats {
+    TUint32 Passes = 0u;
+    TUint32 TileCount = 0u;
+    TUint32 ActiveTiles = 0u;
+    TUint64 Samples = 0u;
+    TUint64 Rays = 0u;
+  };
+
+  // basic.rgen, basic.rchit and basic.rmiss on the cpu. sample n of a pixel uses the random sequence of frame n, so
+  // a tile with n samples matches n accumulated gpu frames. tiles render in parallel on the job system and
+  // accumulate into an rgba float image where alpha counts the samples, like the gpu accumulation image
+  class CpuPathTracer {
+  public:
+    CpuPathTracer(const CpuScene &scene, const CpuPathTracerSettings &settings);
+    ~CpuPathTracer() = default;
+
+  public:
+    void SetCamera(const Camera &camera);
+
+    // adds PassSamples to every tile that has not converged yet, false once all of them have
+    bool RenderPass();
+
+    // accumulated color divided by the sample count, then gamma corrected like the gpu output image
+    void Resolve(Vector<TFloat32> &linear, Vector<TFloat32> &display) const;
+
+  public:
+    inline bool                      IsConverged() const { return m_Stats.ActiveTiles == 0u; }
+    inline const CpuPathTracerStats &GetStats() const { return m_Stats; }
+    inline const Vector<TFloat32>   &GetAccumulation() const { return m_Accumulation; }
+
+  private:
+    struct Tile {
+      TUint32  X = 0u;
+      TUint32  Y = 0u;
+      TUint32  Width = 0u;
+      TUint32  Height = 0u;
+      TUint32  Samples = 0u;
+      TFloat32 Noise = BVH_INFINITY;
+      bool     Done = false;
+    };
+
+  private:
+    glm::vec3 TracePath(TUint32 x, TUint32 y, TUint32 frame, TUint64 &rays) const;
+    void      RenderTile(Tile &tile, TUint64 &rays);
+    TFloat32  EstimateNoise(const Tile &tile) const;
+
+  private:
+    const CpuScene       &m_Scene;
+    CpuPathTracerSettings m_Settings = {};
+    CpuPathTracerStats    m_Stats = {};
+
+    glm::mat4 m_ViewInverse = glm::mat4(1.0f);
+    glm::mat4 m_ProjInverse = glm::mat4(1.0f);
+
+    Vector<Tile>     m_Tiles = {};
+    Vector<TFloat32> m_Accumulation = {};
+    // sum of squared luminance per pixel, for the noise estimate
+    Vector<TFloat32> m_LuminanceSquares = {};
+  };
+
+} // namespace mau
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include "context/imgui-context.h"
+#include "graphics/vulkan-arena.h"
+#include "graphics/vulkan-buffers.h"
+#include "scene/camera.h"
+#include "scene/mesh.h"
+
+namespace mau {
+
+  // bounds are the submesh's local ones, the render thread culls them against the camera. the key is the draw's tlas
+  // instance key, it keeps a draw's level of detail across frames. Lods points into the submesh like Geometry does
+  struct SnapshotDraw {
+    glm::mat4                 Model = glm::mat4(1.0f);
+    const GeometryAllocation *Geometry = nullptr;
+    TUint32                   Material = UINT32_MAX;
+    BoundingBox               Bounds = {};
+    BoundingSphere            Sphere = {};
+    TUint64                   Key = 0u;
+    const MeshLodChain       *Lods = nullptr;
+  };
+
+  // an instance of the scene tlas, one per submesh with a blas
+  struct SnapshotInstance {
+    TUint64         Key = 0u;
+    glm::mat4       Model = glm::mat4(1.0f);
+    VkDeviceAddress BLAS = 0u;
+    TUint32         CustomIndex = 0u;
+  };
+
+  // written by the render thread, read back on the main thread once the frame is submitted. all in milliseconds
+  struct FrameStats {
+    // UINT64_MAX until a frame was rendered
+    TUint64  Frame = UINT64_MAX;
+    TUint32  DrawCount = 0u;
+    TUint32  BatchCount = 0u;
+    // draws of the snapshot left out by frustum culling, DrawCount is what remained
+    TUint32  CulledCount = 0u;
+    TFloat64 CullMs = 0.0;
+    // draws an earlier frame tested on the gpu and kept, read back once it finished. UINT64_MAX if none
+    TUint64  GpuCullFrame = UINT64_MAX;
+    TUint32  GpuTestedCount = 0u;
+    TUint32  GpuVisibleCount = 0u;
+    // triangles of the snapshot draws at full detail and at their selected levels of detail, before any culling
+    TUint64  TriangleCount = 0u;
+    TUint64  LodTriangleCount = 0u;
+    TFloat64 LodMs = 0.0;
+    // instances in the scene tlas and the records copied to the gpu this frame
+    TUint32  TLASInstanceCount = 0u;
+    TUint32  TLASCopiedCount = 0u;
+    TFloat64 FenceWaitMs = 0.0;
+    TFloat64 RecordMs = 0.0;
+    TFloat64 SubmitMs = 0.0;
+    TFloat64 RenderMs = 0.0;
+    // main thread, scene and ui capture
+    TFloat64 CaptureMs = 0.0;
+    // gpu time of an earlier frame whose timestamps were read back while this one was rendered, UINT64_MAX if none
+    TUint64  GpuFrame = UINT64_MAX;
+    TFloat64 GpuMs = 0.0;
+  };
+
+  // everything the render thread needs to draw a frame, captured on the main thread at the end of its update.
+  // the scene is only referenced through raw pointers, Meshes keeps them alive and is only touched by the main thread
+  struct FrameSnapshot {
+    Camera    ViewCamera = {};
+    TUint32   ViewportWidth = 0u;
+    TUint32   ViewportHeight = 0u;
+    glm::vec4 DirLightColor = glm::vec4(0.0f);
+    glm::vec4 DirLightDirection = glm::vec4(0.0f);
+    bool      ClearAccum = false;
+    bool      HasScene = false;
+    bool      EnableDenoiser = false;
+    bool      EnableIndirectDraw = false;
+    bool      EnableParallelRecording = false;
+    bool      EnableFrustumCulling = false;
+    bool      EnableGpuCulling = false;
+    bool      EnableOcclusionCulling = false;
+    bool      EnableLod = false;
+    TFloat32  LodErrorPixels = 1.0f;
+
+    Vector<SnapshotDraw>     Draws = {};
+    Vector<SnapshotInstance> Instances = {};
+    Vector<Handle<Mesh>>     Meshes = {};
+    ImGuiDrawSnapshot        ImGui = {};
+
+    FrameStats Stats = {};
+  };
+
+} // namespace mau
@@ -0,0 +1,201 @@
+#include "frustum-culler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <engine/profiler.h>
+#include <engine/core/job-system.h>
+
+#include "core/simd.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  // visibility words per job, 1024 items
+  constexpr TUint32 CULL_JOB_WORDS = 32u;
+
+  // floats per item in a group: the upper 4x3 of the model matrix by column, box center and extent, sphere center and radius
+  constexpr TUint32 CULL_LANE_FLOATS = 22u;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  template <typename T> static inline const T &get_item(const T *items, TUint32 stride, TUint32 index) {
+    return *reinterpret_cast<const T *>(reinterpret_cast<const TUint8 *>(items) + static_cast<TUint64>(index) * stride);
+  }
+
+  Frustum make_frustum(const glm::mat4 &view_proj) {
+    const glm::vec4 x = glm::vec4(view_proj[0][0], view_proj[1][0], view_proj[2][0], view_proj[3][0]);
+    const glm::vec4 y = glm::vec4(view_proj[0][1], view_proj[1][1], view_proj[2][1], view_proj[3][1]);
+    const glm::vec4 z = glm::vec4(view_proj[0][2], view_proj[1][2], view_proj[2][2], view_proj[3][2]);
+    const glm::vec4 w = glm::vec4(view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]);
+
+    // the projection is glm's default with a depth of -w to w, the planes are the rows of the clip space inequalities
+    Frustum frustum = {.Planes = {w + x, w - x, w + y, w - y, w + z, w - z}};
+    for (glm::vec4 &plane : frustum.Planes) {
+      plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+  }
+
+  bool is_visible(const Frustum &frustum, const glm::mat4 &model, const BoundingBox &box, const BoundingSphere &sphere) {
+    if (box.IsEmpty() || sphere.IsEmpty())
+      return true;
+
+    // the same operations in the same order as the wide test, both have to agree on items touching a plane. the box
+    // is re-fitted around the transformed one, the sphere grows with the largest axis scale and is compared squared
+    const glm::vec3 c = box.GetCenter(), e = box.GetExtent();
+    const glm::vec3 x = glm::vec3(model[0]), y = glm::vec3(model[1]), z = glm::vec3(model[2]), w = glm::vec3(model[3]);
+
+    const glm::vec3 center = x * c.x + y * c.y + z * c.z + w;
+    const glm::vec3 extent = glm::abs(x) * e.x + glm::abs(y) * e.y + glm::abs(z) * e.z;
+    const glm::vec3 sphere_center = x * sphere.Center.x + y * sphere.Center.y + z * sphere.Center.z + w;
+    const TFloat32  scale_squared = std::max(std::max(x.x * x.x + x.y * x.y + x.z * x.z, y.x * y.x + y.y * y.y + y.z * y.z), z.x * z.x + z.y * z.y + z.z * z.z);
+    const TFloat32  radius_squared = sphere.Radius * sphere.Radius * scale_squared;
+
+    for (const glm::vec4 &plane : frustum.Planes) {
+      const TFloat32 sphere_distance = plane.x * sphere_center.x + plane.y * sphere_center.y + plane.z * sphere_center.z + plane.w;
+      const TFloat32 box_distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+      const TFloat32 box_radius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+
+      if ((sphere_distance < 0.0f && sphere_distance * sphere_distance > radius_squared) || box_distance + box_radius < 0.0f)
+        return false;
+    }
+    return true;
+  }
+
+  FrustumCuller::FrustumCuller(TUint32 width): m_Width(width == 4u ? 4u : 8u) {}
+
+  const CullStats &FrustumCuller::Cull(const Frustum &frustum, const CullInput &input, Vector<TUint32> &visible, bool parallel) {
+    MAU_PROFILE_SCOPE("FrustumCuller::Cull");
+    const Clock::time_point start = Clock::now();
+
+    const TUint32 word_count = (input.Count + CULL_WORD_SIZE - 1u) / CULL_WORD_SIZE;
+    m_Words.resize(word_count);
+
+    std::atomic<TUint32> job_count = 0u;
+    auto                 cull = [this, &frustum, &input, &job_count](TUint32 begin, TUint32 end) -> void {
+      if (m_Width == 4u)
+        CullWords<4u>(frustum, input, begin, end);
+      else
+        CullWords<8u>(frustum, input, begin, end);
+      job_count++;
+    };
+
+    if (parallel && JobSystem::Get() && word_count > CULL_JOB_WORDS)
+      JobSystem::Ref().ParallelFor(word_count, CULL_JOB_WORDS, cull);
+    else if (word_count > 0u)
+      cull(0u, word_count);
+
+    // compacted in input order
+    visible.clear();
+    for (TUint32 word = 0; word < word_count; word++) {
+      for (TUint32 bits = m_Words[word]; bits != 0u; bits &= bits - 1u) {
+        visible.push_back(word * CULL_WORD_SIZE + static_cast<TUint32>(std::countr_zero(bits)));
+      }
+    }
+
+    m_Stats = {
+        .TestedCount = input.Count,
+        .VisibleCount = static_cast<TUint32>(visible.size()),
+        .CulledCount = input.Count - static_cast<TUint32>(visible.size()),
+        .JobCount = job_count.load(),
+        .CullMs = elapsed_ms(start),
+    };
+    return m_Stats;
+  }
+
+  template <TUint32 Width> void FrustumCuller::CullWords(const Frustum &frustum, const CullInput &input, TUint32 first_word, TUint32 last_word) {
+    using Float = SimdFloat<Width>;
+    using Mask = SimdMask<Width>;
+
+    // plane components broadcast once per range
+    Float plane_x[6], plane_y[6], plane_z[6], plane_w[6], abs_x[6], abs_y[6], abs_z[6];
+    for (TUint32 p = 0; p < 6u; p++) {
+      const glm::vec4 &plane = frustum.Planes[p];
+      plane_x[p] = Float::Broadcast(plane.x);
+      plane_y[p] = Float::Broadcast(plane.y);
+      plane_z[p] = Float::Broadcast(plane.z);
+      plane_w[p] = Float::Broadcast(plane.w);
+      abs_x[p] = Float::Broadcast(std::abs(plane.x));
+      abs_y[p] = Float::Broadcast(std::abs(plane.y));
+      abs_z[p] = Float::Broadcast(std::abs(plane.z));
+    }
+    const Float zero = Float::Broadcast(0.0f);
+
+    for (TUint32 word = first_word; word < last_word; word++) {
+      TUint32 word_bits = 0u;
+
+      for (TUint32 group = 0; group < CULL_WORD_SIZE; group += Width) {
+        const TUint32 first = word * CULL_WORD_SIZE + group;
+        if (first >= input.Count)
+          break;
+
+        // the group as structure of arrays, missing lanes stay zero and are masked out below
+        TFloat32 lane_data[CULL_LANE_FLOATS][Width] = {};
+        TUint32  lanes = 0u;
+        TUint32  always = 0u;
+
+        const TUint32 count = std::min(Width, input.Count - first);
+        for (TUint32 lane = 0; lane < count; lane++) {
+          const BoundingBox    &box = get_item(input.Boxes, input.Stride, first + lane);
+          const BoundingSphere &sphere = get_item(input.Spheres, input.Stride, first + lane);
+          const glm::mat4      &model = get_item(input.Models, input.Stride, first + lane);
+          lanes |= 1u << lane;
+
+          if (box.IsEmpty() || sphere.IsEmpty()) {
+            always |= 1u << lane;
+            continue;
+          }
+
+          const glm::vec3 center = box.GetCenter(), extent = box.GetExtent();
+          for (TUint32 column = 0; column < 4u; column++) {
+            for (TUint32 row = 0; row < 3u; row++) {
+              lane_data[column * 3u + row][lane] = model[column][row];
+            }
+          }
+          for (TUint32 axis = 0; axis < 3u; axis++) {
+            lane_data[12u + axis][lane] = center[axis];
+            lane_data[15u + axis][lane] = extent[axis];
+            lane_data[18u + axis][lane] = sphere.Center[axis];
+          }
+          lane_data[21u][lane] = sphere.Radius;
+        }
+
+        Float data[CULL_LANE_FLOATS];
+        for (TUint32 i = 0; i < CULL_LANE_FLOATS; i++) {
+          data[i] = Float::Load(lane_data[i]);
+        }
+
+        const Float *x = &data[0], *y = &data[3], *z = &data[6], *w = &data[9];
+        const Float *c = &data[12], *e = &data[15], *sc = &data[18];
+
+        // world bounds in the same order as is_visible
+        Float center[3], extent[3], sphere_center[3];
+        for (TUint32 axis = 0; axis < 3u; axis++) {
+          center[axis] = x[axis] * c[0] + y[axis] * c[1] + z[axis] * c[2] + w[axis];
+          extent[axis] = Max(x[axis], zero - x[axis]) * e[0] + Max(y[axis], zero - y[axis]) * e[1] + Max(z[axis], zero - z[axis]) * e[2];
+          sphere_center[axis] = x[axis] * sc[0] + y[axis] * sc[1] + z[axis] * sc[2] + w[axis];
+        }
+        const Float scale_squared = Max(Max(x[0] * x[0] + x[1] * x[1] + x[2] * x[2], y[0] * y[0] + y[1] * y[1] + y[2] * y[2]), z[0] * z[0] + z[1] * z[1] + z[2] * z[2]);
+        const Float radius_squared = data[21] * data[21] * scale_squared;
+
+        // outside as soon as the sphere or the box is behind any plane
+        Mask outside = zero < zero;
+        for (TUint32 p = 0; p < 6u; p++) {
+          const Float sphere_distance = plane_x[p] * sphere_center[0] + plane_y[p] * sphere_center[1] + plane_z[p] * sphere_center[2] + plane_w[p];
+          const Float box_distance = plane_x[p] * center[0] + plane_y[p] * center[1] + plane_z[p] * center[2] + plane_w[p];
+          const Float box_radius = abs_x[p] * extent[0] + abs_y[p] * extent[1] + abs_z[p] * extent[2];
+          outside = outside | ((sphere_distance < zero) & (sphere_distance * sphere_distance > radius_squared)) | (box_distance + box_radius < zero);
+        }
+
+        word_bits |= (((~outside.GetBits()) & lanes) | always) << group;
+      }
+
+      m_Words[word] = word_bits;
+    }
+  }
+
+} // namespace mau
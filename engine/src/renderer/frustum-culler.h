@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include <engine/utils/handle.h>
+#include "scene/bounds.h"
+
+namespace mau {
+
+  // items per visibility word, jobs always own whole words
+  constexpr TUint32 CULL_WORD_SIZE = 32u;
+
+  // left, right, bottom, top, near, far. normals point inwards and are normalized so distances are in world units
+  struct Frustum {
+    glm::vec4 Planes[6] = {};
+  };
+
+  Frustum make_frustum(const glm::mat4 &view_proj);
+
+  // local bounds and model matrices of the items to test, read with a byte stride so that arrays of draws can be
+  // passed as they are, e.g. Models = &draws[0].Model with Stride = sizeof(SnapshotDraw)
+  struct CullInput {
+    const glm::mat4      *Models = nullptr;
+    const BoundingBox    *Boxes = nullptr;
+    const BoundingSphere *Spheres = nullptr;
+    TUint32               Stride = 0u;
+    TUint32               Count = 0u;
+  };
+
+  struct CullStats {
+    TUint32  TestedCount = 0u;
+    TUint32  VisibleCount = 0u;
+    TUint32  CulledCount = 0u;
+    TUint32  JobCount = 0u;
+    TFloat64 CullMs = 0.0;
+  };
+
+  // one item without simd, the reference the wide tests have to agree with. an item is visible unless its world
+  // space sphere or box lies completely behind one of the planes, items with empty bounds are always visible
+  bool is_visible(const Frustum &frustum, const glm::mat4 &model, const BoundingBox &box, const BoundingSphere &sphere);
+
+  // tests Width items at once with the lanes of core/simd.h, ranges of visibility words run as jobs on the job system.
+  // the visible list keeps the input order so draws batch the same way as without culling
+  class FrustumCuller: public HandledObject {
+  public:
+    FrustumCuller(TUint32 width = 8u);
+    ~FrustumCuller() = default;
+
+  public:
+    // fills visible with the indices of the visible items, parallel needs the job system
+    const CullStats &Cull(const Frustum &frustum, const CullInput &input, Vector<TUint32> &visible, bool parallel = true);
+
+    inline TUint32          GetWidth() const { return m_Width; }
+    inline const CullStats &GetStats() const { return m_Stats; }
+
+  private:
+    template <TUint32 Width> void CullWords(const Frustum &frustum, const CullInput &input, TUint32 first_word, TUint32 last_word);
+
+  private:
+    TUint32         m_Width = 8u;
+    Vector<TUint32> m_Words = {}; // [item / CULL_WORD_SIZE], bit per item
+    CullStats       m_Stats = {};
+  };
+
+} // namespace mau
@@ -0,0 +1,257 @@
+#include "gpu-culler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include "graphics/vulkan-state.h"
+#include "renderer/frustum-culler.h"
+
+namespace mau {
+
+  // compute writes of one dispatch made visible to the next command
+  static void compute_barrier(Handle<CommandBuffer> cmd, VkAccessFlags dst_access, VkPipelineStageFlags dst_stages) {
+    const VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = dst_access,
+    };
+    vkCmdPipelineBarrier(cmd->Get(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dst_stages, 0u, 1u, &barrier, 0u, nullptr, 0u, nullptr);
+  }
+
+  GpuCuller::GpuCuller(TUint32 frame_count) {
+    ASSERT(frame_count > 0u);
+    m_Frames.resize(static_cast<size_t>(frame_count));
+    m_DepthTextures.assign(static_cast<size_t>(frame_count), BINDLESS_INVALID_HANDLE);
+    m_Sampler = make_handle<Sampler>();
+    m_CullConstants = make_handle<PushConstant<CullShaderData>>(CullShaderData{});
+    m_PyramidConstants = make_handle<PushConstant<DepthPyramidShaderData>>(DepthPyramidShaderData{});
+
+    // the render graph gets the resources once, later growth swaps the buffers inside them
+    std::vector<Handle<Resource>> commands = {}, counts = {};
+    for (FrameBuffers &frame : m_Frames) {
+      Reserve(frame, MIN_GPU_CULL_DRAW_CAPACITY, MIN_GPU_CULL_BATCH_CAPACITY);
+      frame.CullData = make_handle<Buffer>(sizeof(GPUCullData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+      commands.push_back(frame.Commands);
+      counts.push_back(frame.Counts);
+    }
+    m_CommandsSink.AssignResources(commands);
+    m_CountsSink.AssignResources(counts);
+  }
+
+  GpuCuller::~GpuCuller() {
+    if (!VulkanBindless::Get())
+      return;
+
+    ReleasePyramid();
+    for (TextureHandle handle : m_DepthTextures) {
+      VulkanBindless::Ref().Release(BindlessDescriptorType::TEXTURE, handle);
+    }
+  }
+
+  void GpuCuller::CreatePyramid(TUint32 width, TUint32 height) {
+    ReleasePyramid();
+
+    m_DepthWidth = std::max(width, 1u);
+    m_DepthHeight = std::max(height, 1u);
+
+    // every level halves the one above rounding down, down to a single texel
+    const TUint32 pyramid_width = std::max(m_DepthWidth / 2u, 1u);
+    const TUint32 pyramid_height = std::max(m_DepthHeight / 2u, 1u);
+    const TUint32 levels = static_cast<TUint32>(std::bit_width(std::max(pyramid_width, pyramid_height)));
+
+    m_Pyramid = make_handle<Image>(pyramid_width, pyramid_height, 1, levels, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+                                   VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    Handle<ImageView> pyramid_view = make_handle<ImageView>(m_Pyramid, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    for (TUint32 level = 0; level < levels; level++) {
+      m_PyramidLevelViews.push_back(make_handle<ImageView>(m_Pyramid, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, level));
+      m_PyramidLevelHandles.push_back(VulkanBindless::Ref().AddStorageImage(m_PyramidLevelViews.back()));
+    }
+    m_PyramidTexture = VulkanBindless::Ref().AddSampledImage(pyramid_view, m_Sampler);
+
+    std::vector<Handle<Resource>> pyramids(m_Frames.size(), make_handle<ImageResource>(m_Pyramid, pyramid_view));
+    m_PyramidSink.AssignResources(pyramids);
+  }
+
+  void GpuCuller::BindDepth(const Vector<Handle<ImageView>> &depth_views, VkSampleCountFlagBits samples) {
+    ASSERT(depth_views.size() == m_DepthTextures.size());
+    m_DepthSamples = samples;
+
+    for (TUint32 i = 0; i < m_DepthTextures.size(); i++) {
+      VulkanBindless::Ref().Release(BindlessDescriptorType::TEXTURE, m_DepthTextures[i]);
+      m_DepthTextures[i] = VulkanBindless::Ref().AddSampledImage(depth_views[i], m_Sampler);
+    }
+  }
+
+  void GpuCuller::Prepare(TUint32 frame_index, TUint64 frame, const IndirectDrawList &draw_list, const glm::mat4 &view_proj, bool occlusion) {
+    MAU_PROFILE_SCOPE("GpuCuller::Prepare");
+    ASSERT(frame_index < m_Frames.size());
+    FrameBuffers &buffers = m_Frames[frame_index];
+
+    // the counts of the last frame that culled into these buffers, frames finish in order so the newest one wins
+    if (buffers.CountedFrame != UINT64_MAX && (m_Stats.Frame == UINT64_MAX || buffers.CountedFrame > m_Stats.Frame)) {
+      Handle<Buffer> counts = buffers.Counts->GetBuffer();
+      const TUint32 *count_data = reinterpret_cast<const TUint32 *>(counts->Map());
+
+      TUint32 visible = 0u;
+      if (buffers.CountedBatches > 0u) {
+        counts->InvalidateMapped(0u, sizeof(TUint32) * buffers.CountedBatches);
+        for (TUint32 batch = 0; batch < buffers.CountedBatches; batch++) {
+          visible += count_data[batch];
+        }
+      }
+      m_Stats = {.Frame = buffers.CountedFrame, .TestedCount = buffers.CountedDraws, .VisibleCount = visible};
+    }
+
+    const TUint32 draw_count = draw_list.GetDrawCount();
+    const TUint32 batch_count = draw_list.GetBatchCount();
+    Reserve(buffers, draw_count, batch_count);
+
+    // the cull pass appends to the counts, every frame starts from zero
+    Handle<Buffer> counts = buffers.Counts->GetBuffer();
+    if (batch_count > 0u) {
+      memset(counts->Map(), 0, sizeof(TUint32) * batch_count);
+      counts->FlushMapped(0u, sizeof(TUint32) * batch_count);
+    }
+
+    const Frustum frustum = make_frustum(view_proj);
+    GPUCullData   data = {
+          .PyramidViewProj = m_PyramidViewProj,
+          .PyramidWidth = m_Pyramid ? m_Pyramid->GetWidth() : 1u,
+          .PyramidHeight = m_Pyramid ? m_Pyramid->GetHeight() : 1u,
+          .PyramidLevels = m_Pyramid ? m_Pyramid->GetMipLevels() : 1u,
+          .PyramidTexture = get_bindless_index(m_PyramidTexture),
+          .DrawCount = draw_count,
+          .Occlusion = occlusion && m_PyramidBuilt && m_Pyramid ? 1u : 0u,
+          .Padding = {0u, 0u},
+    };
+    std::copy(std::begin(frustum.Planes), std::end(frustum.Planes), data.Planes);
+
+    memcpy(buffers.CullData->Map(), &data, sizeof(GPUCullData));
+    buffers.CullData->FlushMapped(0u, sizeof(GPUCullData));
+
+    buffers.CountedFrame = frame;
+    buffers.CountedDraws = draw_count;
+    buffers.CountedBatches = batch_count;
+    buffers.DrawData = draw_count > 0u ? draw_list.GetDrawDataAddress(frame_index) : 0u;
+    buffers.Bounds = draw_count > 0u ? draw_list.GetBoundsAddress(frame_index) : 0u;
+    buffers.SourceCommands = draw_count > 0u ? draw_list.GetCommandsAddress(frame_index) : 0u;
+  }
+
+  void GpuCuller::RecordCull(Handle<CommandBuffer> cmd, TUint32 frame_index, Handle<ComputePipeline> pipeline) {
+    ASSERT(frame_index < m_Frames.size());
+    FrameBuffers &buffers = m_Frames[frame_index];
+    if (buffers.CountedDraws == 0u)
+      return;
+
+    MAU_GPU_ZONE(cmd->Get(), "GpuCuller::RecordCull");
+    vkCmdBindPipeline(cmd->Get(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Get());
+
+    const Vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
+    vkCmdBindDescriptorSets(cmd->Get(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetLayout(), 0u, static_cast<TUint32>(sets.size()), sets.data(), 0u, nullptr);
+
+    m_CullConstants->Update({
+        .cull_data_address = buffers.CullData->GetDeviceAddress(),
+        .draw_data_address = buffers.DrawData,
+        .bounds_address = buffers.Bounds,
+        .commands_address = buffers.SourceCommands,
+        .culled_commands_address = buffers.Commands->GetBuffer()->GetDeviceAddress(),
+        .counts_address = buffers.Counts->GetBuffer()->GetDeviceAddress(),
+    });
+    m_CullConstants->Bind(cmd, pipeline);
+
+    vkCmdDispatch(cmd->Get(), (buffers.CountedDraws + GPU_CULL_GROUP_SIZE - 1u) / GPU_CULL_GROUP_SIZE, 1u, 1u);
+
+    // the counts are read back for the stats once the frame finished
+    compute_barrier(cmd, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+  }
+
+  void GpuCuller::RecordPyramid(Handle<CommandBuffer> cmd, TUint32 frame_index, Handle<ComputePipeline> pipeline, const glm::mat4 &view_proj) {
+    ASSERT(frame_index < m_DepthTextures.size());
+    if (!m_Pyramid || m_DepthTextures[frame_index] == BINDLESS_INVALID_HANDLE)
+      return;
+
+    MAU_GPU_ZONE(cmd->Get(), "GpuCuller::RecordPyramid");
+    vkCmdBindPipeline(cmd->Get(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Get());
+
+    const Vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
+    vkCmdBindDescriptorSets(cmd->Get(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetLayout(), 0u, static_cast<TUint32>(sets.size()), sets.data(), 0u, nullptr);
+
+    TUint32 source_width = m_DepthWidth;
+    TUint32 source_height = m_DepthHeight;
+    for (TUint32 level = 0; level < m_PyramidLevelHandles.size(); level++) {
+      const TUint32 width = std::max(m_Pyramid->GetWidth() >> level, 1u);
+      const TUint32 height = std::max(m_Pyramid->GetHeight() >> level, 1u);
+
+      // every level reads the one written by the dispatch before
+      if (level > 0u)
+        compute_barrier(cmd, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+      m_PyramidConstants->Update({
+          .source_index = get_bindless_index(level == 0u ? m_DepthTextures[frame_index] : m_PyramidLevelHandles[level - 1u]),
+          .target_index = get_bindless_index(m_PyramidLevelHandles[level]),
+          .source_width = source_width,
+          .source_height = source_height,
+          .target_width = width,
+          .target_height = height,
+          .sample_count = level == 0u ? static_cast<TUint32>(m_DepthSamples) : 1u,
+          .from_depth = level == 0u ? 1u : 0u,
+      });
+      m_PyramidConstants->Bind(cmd, pipeline);
+
+      vkCmdDispatch(cmd->Get(), (width + DEPTH_PYRAMID_GROUP_SIZE - 1u) / DEPTH_PYRAMID_GROUP_SIZE, (height + DEPTH_PYRAMID_GROUP_SIZE - 1u) / DEPTH_PYRAMID_GROUP_SIZE, 1u);
+
+      source_width = width;
+      source_height = height;
+    }
+
+    m_PyramidViewProj = view_proj;
+    m_PyramidBuilt = true;
+  }
+
+  void GpuCuller::Reserve(FrameBuffers &frame, TUint32 draw_count, TUint32 batch_count) {
+    if (frame.Commands && frame.DrawCapacity >= draw_count && frame.BatchCapacity >= batch_count)
+      return;
+
+    TUint32 draw_capacity = std::max(frame.DrawCapacity, MIN_GPU_CULL_DRAW_CAPACITY);
+    while (draw_capacity < draw_count) {
+      draw_capacity *= 2u;
+    }
+    TUint32 batch_capacity = std::max(frame.BatchCapacity, MIN_GPU_CULL_BATCH_CAPACITY);
+    while (batch_capacity < batch_count) {
+      batch_capacity *= 2u;
+    }
+
+    // only the gpu touches the culled commands, the counts are cleared and read back by the cpu
+    Handle<Buffer> commands = make_handle<Buffer>(sizeof(VkDrawIndexedIndirectCommand) * draw_capacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    Handle<Buffer> counts = make_handle<Buffer>(sizeof(TUint32) * batch_capacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+    if (frame.Commands) {
+      frame.Commands->SetBuffer(commands);
+      frame.Counts->SetBuffer(counts);
+    } else {
+      frame.Commands = make_handle<BufferResource>(commands);
+      frame.Counts = make_handle<BufferResource>(counts);
+    }
+    frame.DrawCapacity = draw_capacity;
+    frame.BatchCapacity = batch_capacity;
+  }
+
+  void GpuCuller::ReleasePyramid() {
+    for (ImageHandle handle : m_PyramidLevelHandles) {
+      VulkanBindless::Ref().Release(BindlessDescriptorType::STORAGE_IMAGE, handle);
+    }
+    VulkanBindless::Ref().Release(BindlessDescriptorType::TEXTURE, m_PyramidTexture);
+
+    m_PyramidLevelHandles.clear();
+    m_PyramidLevelViews.clear();
+    m_PyramidTexture = BINDLESS_INVALID_HANDLE;
+    m_Pyramid = nullptr;
+    m_PyramidBuilt = false;
+  }
+
+} // namespace mau
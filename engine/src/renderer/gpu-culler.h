@@ -0,0 +1,152 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include "graphics/vulkan-bindless.h"
+#include "graphics/vulkan-buffers.h"
+#include "graphics/vulkan-commands.h"
+#include "graphics/vulkan-image.h"
+#include "graphics/vulkan-pipeline.h"
+#include "graphics/vulkan-push-constant.h"
+#include "renderer/indirect-draw-list.h"
+#include "renderer/rendergraph/sink.h"
+
+namespace mau {
+
+  // workgroup sizes of gpu_cull_compute.glsl and depth_pyramid_compute.glsl
+  constexpr TUint32 GPU_CULL_GROUP_SIZE = 64u;
+  constexpr TUint32 DEPTH_PYRAMID_GROUP_SIZE = 8u;
+
+  // minimum number of draws and batches the per frame buffers are created with
+  constexpr TUint32 MIN_GPU_CULL_DRAW_CAPACITY = 1024u;
+  constexpr TUint32 MIN_GPU_CULL_BATCH_CAPACITY = 64u;
+
+  // per frame input of gpu_cull_compute.glsl, scalar layout. the pyramid is tested with the camera it was built with
+  struct GPUCullData {
+    glm::vec4 Planes[6];
+    glm::mat4 PyramidViewProj;
+    TUint32   PyramidWidth;
+    TUint32   PyramidHeight;
+    TUint32   PyramidLevels;
+    TUint32   PyramidTexture;
+    TUint32   DrawCount;
+    TUint32   Occlusion;
+    TUint32   Padding[2];
+  };
+
+  struct CullShaderData {
+    TUint64 cull_data_address;
+    TUint64 draw_data_address;
+    TUint64 bounds_address;
+    TUint64 commands_address;
+    TUint64 culled_commands_address;
+    TUint64 counts_address;
+  };
+
+  // one dispatch per pyramid level, level 0 reads the multisampled depth
+  struct DepthPyramidShaderData {
+    TUint32 source_index;
+    TUint32 target_index;
+    TUint32 source_width;
+    TUint32 source_height;
+    TUint32 target_width;
+    TUint32 target_height;
+    TUint32 sample_count;
+    TUint32 from_depth;
+  };
+
+  // what the gpu kept of a frame's draws, read back once the frame finished
+  struct GpuCullStats {
+    // UINT64_MAX until counts were read back
+    TUint64 Frame = UINT64_MAX;
+    TUint32 TestedCount = 0u;
+    TUint32 VisibleCount = 0u;
+  };
+
+  // culls the draw list on the gpu. a compute pass tests every draw against the frustum and against a depth pyramid
+  // built from the previous frame's depth, and appends the visible indirect commands of every batch to the frame's
+  // culled command buffer together with one draw count per batch, drawn with vkCmdDrawIndexedIndirectCount.
+  // the culled commands and counts are render graph sinks, the pyramid is one image shared by all frames
+  class GpuCuller: public HandledObject {
+  public:
+    GpuCuller(TUint32 frame_count);
+    ~GpuCuller();
+
+  public:
+    // level 0 is half the viewport, the render thread must be idle
+    void CreatePyramid(TUint32 width, TUint32 height);
+    // the multisampled depth of every frame, again whenever the render graph created new transient images
+    void BindDepth(const Vector<Handle<ImageView>> &depth_views, VkSampleCountFlagBits samples);
+
+    // the buffers of frame_index must not be in use by the gpu. reads back the counts the frame wrote last time, then
+    // clears them and writes the culling input for the draw list just uploaded to frame_index
+    void Prepare(TUint32 frame_index, TUint64 frame, const IndirectDrawList &draw_list, const glm::mat4 &view_proj, bool occlusion);
+
+    void RecordCull(Handle<CommandBuffer> cmd, TUint32 frame_index, Handle<ComputePipeline> pipeline);
+    // from the depth the frame rendered with view_proj, the next frame tests against it
+    void RecordPyramid(Handle<CommandBuffer> cmd, TUint32 frame_index, Handle<ComputePipeline> pipeline, const glm::mat4 &view_proj);
+    // the next frames are culled without occlusion until the pyramid is built again
+    inline void InvalidatePyramid() { m_PyramidBuilt = false; }
+
+  public:
+    inline const Sink &GetCommandsSink() const { return m_CommandsSink; }
+    inline const Sink &GetCountsSink() const { return m_CountsSink; }
+    inline const Sink &GetPyramidSink() const { return m_PyramidSink; }
+    inline VkBuffer    GetCulledCommands(TUint32 frame_index) const { return m_Frames[frame_index].Commands->GetBuffer()->Get(); }
+    inline VkBuffer    GetCounts(TUint32 frame_index) const { return m_Frames[frame_index].Counts->GetBuffer()->Get(); }
+    inline bool        IsPyramidBuilt() const { return m_PyramidBuilt; }
+
+    inline Handle<PushConstant<CullShaderData>>         GetCullConstants() const { return m_CullConstants; }
+    inline Handle<PushConstant<DepthPyramidShaderData>> GetPyramidConstants() const { return m_PyramidConstants; }
+    inline const GpuCullStats                          &GetStats() const { return m_Stats; }
+
+  private:
+    // the resources are shared with the render graph, grown buffers are swapped into them
+    struct FrameBuffers {
+      Handle<BufferResource> Commands = nullptr;
+      Handle<BufferResource> Counts = nullptr;
+      Handle<Buffer>         CullData = nullptr;
+      TUint32                DrawCapacity = 0u;
+      TUint32                BatchCapacity = 0u;
+
+      // draw list of the last Prepare, its counts are read back next time
+      TUint64 CountedFrame = UINT64_MAX;
+      TUint32 CountedDraws = 0u;
+      TUint32 CountedBatches = 0u;
+
+      // the list the cull pass dispatches over
+      VkDeviceAddress DrawData = 0u;
+      VkDeviceAddress Bounds = 0u;
+      VkDeviceAddress SourceCommands = 0u;
+    };
+
+  private:
+    void Reserve(FrameBuffers &frame, TUint32 draw_count, TUint32 batch_count);
+    void ReleasePyramid();
+
+  private:
+    Vector<FrameBuffers> m_Frames = {};
+    Sink                 m_CommandsSink = Sink("gpu-cull-commands");
+    Sink                 m_CountsSink = Sink("gpu-cull-counts");
+    Sink                 m_PyramidSink = Sink("hiz-pyramid");
+    GpuCullStats         m_Stats = {};
+
+    Handle<PushConstant<CullShaderData>>         m_CullConstants = nullptr;
+    Handle<PushConstant<DepthPyramidShaderData>> m_PyramidConstants = nullptr;
+    Handle<Sampler>                              m_Sampler = nullptr;
+
+    // one mip chain for every frame, each level a storage slot of its own
+    Handle<Image>             m_Pyramid = nullptr;
+    Vector<Handle<ImageView>> m_PyramidLevelViews = {};
+    Vector<ImageHandle>       m_PyramidLevelHandles = {};
+    TextureHandle             m_PyramidTexture = BINDLESS_INVALID_HANDLE;
+    TUint32                   m_DepthWidth = 0u;
+    TUint32                   m_DepthHeight = 0u;
+    glm::mat4                 m_PyramidViewProj = glm::mat4(1.0f);
+    bool                      m_PyramidBuilt = false;
+
+    Vector<TextureHandle> m_DepthTextures = {}; // [frame]
+    VkSampleCountFlagBits m_DepthSamples = VK_SAMPLE_COUNT_1_BIT;
+  };
+
+} // namespace mau
@@ -0,0 +1,206 @@
+#include "indirect-draw-list.h"
+
+#include <algorithm>
+#include <cstring>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include "graphics/vulkan-state.h"
+
+namespace mau {
+
+  IndirectDrawList::IndirectDrawList(TUint32 frame_count) {
+    ASSERT(frame_count > 0u);
+    m_Frames.resize(static_cast<size_t>(frame_count));
+    m_MultiDrawIndirect = VulkanState::Ref().GetDeviceHandle()->IsMultiDrawIndirectEnabled();
+
+    if (!m_MultiDrawIndirect) {
+      LOG_WARN("multi draw indirect is not supported, falling back to one draw call per submesh");
+    }
+  }
+
+  IndirectDrawList::~IndirectDrawList() {
+    for (FrameBuffers &frame : m_Frames) {
+      frame.DrawData = nullptr;
+      frame.Commands = nullptr;
+      frame.Bounds = nullptr;
+    }
+  }
+
+  void IndirectDrawList::Clear() {
+    // keep the allocations around, the scene usually looks the same next frame
+    for (PageDraws &page : m_Pages) {
+      page.Draws.clear();
+      page.Commands.clear();
+      page.Bounds.clear();
+    }
+    m_Batches.clear();
+    m_DrawCount = 0u;
+  }
+
+  void IndirectDrawList::Add(const GeometryAllocation &geometry, const glm::mat4 &model, TUint32 material, const BoundingBox &bounds, const BoundingSphere &sphere, const MeshLod &lod) {
+    const TUint32 page_index = geometry.GetPage();
+    if (page_index >= m_Pages.size()) {
+      m_Pages.resize(static_cast<size_t>(page_index) + 1u);
+    }
+
+    PageDraws &page = m_Pages[page_index];
+    page.Draws.push_back({.Model = model, .Material = material});
+    page.Commands.push_back({
+        .indexCount = lod.IndexCount > 0u ? lod.IndexCount : static_cast<TUint32>(geometry.GetIndexCount()),
+        .instanceCount = 1u,
+        .firstIndex = static_cast<TUint32>(geometry.GetFirstIndex()) + lod.FirstIndex,
+        .vertexOffset = static_cast<TInt32>(geometry.GetFirstVertex()),
+        .firstInstance = 0u,
+    });
+    // batch and first draw are only known on upload
+    page.Bounds.push_back({
+        .Sphere = glm::vec4(sphere.Center, bounds.IsEmpty() || sphere.IsEmpty() ? -1.0f : sphere.Radius),
+        .Min = bounds.Min,
+        .Batch = 0u,
+        .Max = bounds.Max,
+        .BatchFirstDraw = 0u,
+    });
+    m_DrawCount++;
+  }
+
+  VkDeviceAddress IndirectDrawList::Upload(TUint32 frame_index) {
+    MAU_PROFILE_SCOPE("IndirectDrawList::Upload");
+    ASSERT(frame_index < m_Frames.size());
+
+    FrameBuffers &frame = m_Frames[frame_index];
+    Reserve(frame, m_DrawCount);
+
+    GPUDrawData                  *draw_data = reinterpret_cast<GPUDrawData *>(frame.DrawData->Map());
+    VkDrawIndexedIndirectCommand *commands = reinterpret_cast<VkDrawIndexedIndirectCommand *>(frame.Commands->Map());
+    GPUDrawBounds                *bounds = reinterpret_cast<GPUDrawBounds *>(frame.Bounds->Map());
+
+    m_Batches.clear();
+    TUint32 first_draw = 0u;
+
+    for (TUint32 page_index = 0u; page_index < m_Pages.size(); page_index++) {
+      const PageDraws &page = m_Pages[page_index];
+      const TUint32    draw_count = static_cast<TUint32>(page.Draws.size());
+      if (draw_count == 0u)
+        continue;
+
+      memcpy(draw_data + first_draw, page.Draws.data(), sizeof(GPUDrawData) * draw_count);
+
+      // the instance index selects the draw data, so every command gets its own first instance
+      for (TUint32 i = 0u; i < draw_count; i++) {
+        commands[first_draw + i] = page.Commands[i];
+        commands[first_draw + i].firstInstance = first_draw + i;
+        bounds[first_draw + i] = page.Bounds[i];
+        bounds[first_draw + i].Batch = static_cast<TUint32>(m_Batches.size());
+        bounds[first_draw + i].BatchFirstDraw = first_draw;
+      }
+
+      m_Batches.push_back({
+          .Page = page_index,
+          .FirstDraw = first_draw,
+          .DrawCount = draw_count,
+          .VertexBuffer = GeometryArena::Ref().GetVertexBuffer(page_index)->Get(),
+          .IndexBuffer = GeometryArena::Ref().GetIndexBuffer(page_index)->Get(),
+      });
+      first_draw += draw_count;
+    }
+
+    if (m_DrawCount > 0u) {
+      frame.DrawData->FlushMapped(0u, sizeof(GPUDrawData) * m_DrawCount);
+      frame.Commands->FlushMapped(0u, sizeof(VkDrawIndexedIndirectCommand) * m_DrawCount);
+      frame.Bounds->FlushMapped(0u, sizeof(GPUDrawBounds) * m_DrawCount);
+    }
+
+    return frame.DrawData->GetDeviceAddress();
+  }
+
+  void IndirectDrawList::RecordIndirect(Handle<CommandBuffer> cmd, TUint32 frame_index) const { RecordIndirect(cmd->Get(), frame_index, 0u, m_DrawCount); }
+
+  void IndirectDrawList::RecordDirect(Handle<CommandBuffer> cmd) const { RecordDirect(cmd->Get(), 0u, m_DrawCount); }
+
+  void IndirectDrawList::RecordIndirect(VkCommandBuffer cmd, TUint32 frame_index, TUint32 first_draw, TUint32 draw_count) const {
+    MAU_PROFILE_SCOPE("IndirectDrawList::RecordIndirect");
+    ASSERT(frame_index < m_Frames.size() && first_draw + draw_count <= m_DrawCount);
+
+    if (!m_MultiDrawIndirect) {
+      RecordDirect(cmd, first_draw, draw_count);
+      return;
+    }
+
+    const VkBuffer     commands = m_Frames[frame_index].Commands->Get();
+    const VkDeviceSize offsets[] = {0u};
+    const TUint32      stride = static_cast<TUint32>(sizeof(VkDrawIndexedIndirectCommand));
+    const TUint32      last_draw = first_draw + draw_count;
+
+    for (const Batch &batch : m_Batches) {
+      const TUint32 begin = std::max(first_draw, batch.FirstDraw);
+      const TUint32 end = std::min(last_draw, batch.FirstDraw + batch.DrawCount);
+      if (begin >= end)
+        continue;
+
+      vkCmdBindVertexBuffers(cmd, 0u, 1u, &batch.VertexBuffer, offsets);
+      vkCmdBindIndexBuffer(cmd, batch.IndexBuffer, 0u, VK_INDEX_TYPE_UINT32);
+
+      vkCmdDrawIndexedIndirect(cmd, commands, static_cast<VkDeviceSize>(begin) * stride, end - begin, stride);
+    }
+  }
+
+  void IndirectDrawList::RecordDirect(VkCommandBuffer cmd, TUint32 first_draw, TUint32 draw_count) const {
+    MAU_PROFILE_SCOPE("IndirectDrawList::RecordDirect");
+    ASSERT(first_draw + draw_count <= m_DrawCount);
+
+    const VkDeviceSize offsets[] = {0u};
+    const TUint32      last_draw = first_draw + draw_count;
+
+    for (const Batch &batch : m_Batches) {
+      const TUint32 begin = std::max(first_draw, batch.FirstDraw);
+      const TUint32 end = std::min(last_draw, batch.FirstDraw + batch.DrawCount);
+      if (begin >= end)
+        continue;
+
+      vkCmdBindVertexBuffers(cmd, 0u, 1u, &batch.VertexBuffer, offsets);
+      vkCmdBindIndexBuffer(cmd, batch.IndexBuffer, 0u, VK_INDEX_TYPE_UINT32);
+
+      const PageDraws &page = m_Pages[batch.Page];
+      for (TUint32 i = begin; i < end; i++) {
+        const VkDrawIndexedIndirectCommand &command = page.Commands[i - batch.FirstDraw];
+        vkCmdDrawIndexed(cmd, command.indexCount, 1u, command.firstIndex, command.vertexOffset, i);
+      }
+    }
+  }
+
+  void IndirectDrawList::RecordIndirectCount(Handle<CommandBuffer> cmd, VkBuffer commands, VkBuffer counts) const {
+    MAU_PROFILE_SCOPE("IndirectDrawList::RecordIndirectCount");
+
+    const VkDeviceSize offsets[] = {0u};
+    const TUint32      stride = static_cast<TUint32>(sizeof(VkDrawIndexedIndirectCommand));
+
+    for (TUint32 i = 0u; i < m_Batches.size(); i++) {
+      const Batch &batch = m_Batches[i];
+      vkCmdBindVertexBuffers(cmd->Get(), 0u, 1u, &batch.VertexBuffer, offsets);
+      vkCmdBindIndexBuffer(cmd->Get(), batch.IndexBuffer, 0u, VK_INDEX_TYPE_UINT32);
+
+      vkCmdDrawIndexedIndirectCount(cmd->Get(), commands, static_cast<VkDeviceSize>(batch.FirstDraw) * stride, counts, sizeof(TUint32) * i, batch.DrawCount, stride);
+    }
+  }
+
+  void IndirectDrawList::Reserve(FrameBuffers &frame, TUint32 draw_count) {
+    if (frame.DrawData && frame.Capacity >= draw_count)
+      return;
+
+    TUint32 capacity = std::max(frame.Capacity, MIN_INDIRECT_DRAW_CAPACITY);
+    while (capacity < draw_count) {
+      capacity *= 2u;
+    }
+
+    // written by the cpu every frame and read once by the gpu, no point in staging
+    frame.DrawData = nullptr;
+    frame.Commands = nullptr;
+    frame.Bounds = nullptr;
+    frame.DrawData = make_handle<Buffer>(sizeof(GPUDrawData) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    frame.Commands = make_handle<Buffer>(sizeof(VkDrawIndexedIndirectCommand) * capacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                         VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    frame.Bounds = make_handle<Buffer>(sizeof(GPUDrawBounds) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    frame.Capacity = capacity;
+  }
+
+} // namespace mau
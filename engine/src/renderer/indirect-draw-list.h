@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include "graphics/vulkan-arena.h"
+#include "graphics/vulkan-buffers.h"
+#include "graphics/vulkan-commands.h"
+#include "loader/mesh-lod.h"
+#include "scene/bounds.h"
+
+namespace mau {
+
+  // per draw data read by basic_vertex.glsl through gl_InstanceIndex, scalar layout
+  struct GPUDrawData {
+    glm::mat4 Model;
+    TUint32   Material;
+    TUint32   Padding[3];
+  };
+
+  // local bounds of a draw read by gpu_cull_compute.glsl, scalar layout. a negative radius marks a draw without bounds,
+  // the visible commands of a batch are compacted from its first draw on
+  struct GPUDrawBounds {
+    glm::vec4 Sphere;
+    glm::vec3 Min;
+    TUint32   Batch;
+    glm::vec3 Max;
+    TUint32   BatchFirstDraw;
+  };
+
+  // minimum number of draws the per frame buffers are created with
+  constexpr TUint32 MIN_INDIRECT_DRAW_CAPACITY = 1024u;
+
+  // collects the draws of a frame and writes them into host visible draw data and
+  // indirect command buffers. draws are grouped by geometry arena page so the whole
+  // scene is issued with one vkCmdDrawIndexedIndirect per page
+  class IndirectDrawList: public HandledObject {
+  public:
+    IndirectDrawList(TUint32 frame_count);
+    ~IndirectDrawList();
+
+  public:
+    void Clear();
+    // the bounds are only read when the draws are culled on the gpu, empty ones are always drawn. lod is a range of the
+    // allocation's indices, without indices the whole allocation is drawn
+    void Add(const GeometryAllocation &geometry, const glm::mat4 &model, TUint32 material, const BoundingBox &bounds = {}, const BoundingSphere &sphere = {},
+             const MeshLod &lod = {});
+
+    // the buffers of frame_index must not be in use by the gpu, returns the draw data address
+    VkDeviceAddress Upload(TUint32 frame_index);
+
+    // falls back to RecordDirect when multi draw indirect is not supported
+    void RecordIndirect(Handle<CommandBuffer> cmd, TUint32 frame_index) const;
+    void RecordDirect(Handle<CommandBuffer> cmd) const;
+
+    // draws [first_draw, first_draw + draw_count) in upload order, touches no handles so
+    // several threads can record ranges of the same list into their own command buffers
+    void RecordIndirect(VkCommandBuffer cmd, TUint32 frame_index, TUint32 first_draw, TUint32 draw_count) const;
+    void RecordDirect(VkCommandBuffer cmd, TUint32 first_draw, TUint32 draw_count) const;
+
+    // draws the commands a culling pass compacted into commands, every batch from its first draw on with the draw
+    // count at its index in counts. needs draw indirect count
+    void RecordIndirectCount(Handle<CommandBuffer> cmd, VkBuffer commands, VkBuffer counts) const;
+
+  public:
+    inline TUint32 GetDrawCount() const { return m_DrawCount; }
+    inline TUint32 GetBatchCount() const { return static_cast<TUint32>(m_Batches.size()); }
+    inline bool    IsMultiDrawIndirectEnabled() const { return m_MultiDrawIndirect; }
+
+    // buffers of the last upload to frame_index
+    inline VkDeviceAddress GetDrawDataAddress(TUint32 frame_index) const { return m_Frames[frame_index].DrawData->GetDeviceAddress(); }
+    inline VkDeviceAddress GetBoundsAddress(TUint32 frame_index) const { return m_Frames[frame_index].Bounds->GetDeviceAddress(); }
+    inline VkDeviceAddress GetCommandsAddress(TUint32 frame_index) const { return m_Frames[frame_index].Commands->GetDeviceAddress(); }
+
+  private:
+    struct PageDraws {
+      Vector<GPUDrawData>                  Draws = {};
+      Vector<VkDrawIndexedIndirectCommand> Commands = {};
+      Vector<GPUDrawBounds>                Bounds = {};
+    };
+
+    struct FrameBuffers {
+      Handle<Buffer> DrawData = nullptr;
+      Handle<Buffer> Commands = nullptr;
+      Handle<Buffer> Bounds = nullptr;
+      TUint32        Capacity = 0u;
+    };
+
+    // arena buffers are resolved on upload so recording never copies a handle
+    struct Batch {
+      TUint32  Page = 0u;
+      TUint32  FirstDraw = 0u;
+      TUint32  DrawCount = 0u;
+      VkBuffer VertexBuffer = VK_NULL_HANDLE;
+      VkBuffer IndexBuffer = VK_NULL_HANDLE;
+    };
+
+  private:
+    void Reserve(FrameBuffers &frame, TUint32 draw_count);
+
+  private:
+    Vector<PageDraws>    m_Pages = {};
+    Vector<FrameBuffers> m_Frames = {};
+    Vector<Batch>        m_Batches = {};
+    TUint32              m_DrawCount = 0u;
+    bool                 m_MultiDrawIndirect = false;
+  };
+
+} // namespace mau
@@ -0,0 +1,90 @@
+#include "lod-selector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include <engine/profiler.h>
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  template <typename T> static inline const T &get_item(const T *items, TUint32 stride, TUint32 index) {
+    return *reinterpret_cast<const T *>(reinterpret_cast<const TUint8 *>(items) + static_cast<TUint64>(index) * stride);
+  }
+
+  LodView make_lod_view(const glm::vec3 &position, const glm::mat4 &proj, TFloat32 viewport_height, TFloat32 error_pixels, bool enabled) {
+    return {
+        .Position = position,
+        .PixelScale = 0.5f * viewport_height * std::abs(proj[1][1]),
+        .NearDistance = proj[3][2] / (proj[2][2] - 1.0f),
+        .ErrorPixels = error_pixels,
+        .Enabled = enabled,
+    };
+  }
+
+  TFloat32 get_lod_error_scale(const LodView &view, const glm::mat4 &model, const BoundingSphere &sphere) {
+    const glm::vec3 x = glm::vec3(model[0]), y = glm::vec3(model[1]), z = glm::vec3(model[2]), w = glm::vec3(model[3]);
+
+    // errors grow with the largest axis scale like the culling spheres do
+    const glm::vec3 center = x * sphere.Center.x + y * sphere.Center.y + z * sphere.Center.z + w;
+    const TFloat32  scale = std::sqrt(std::max(std::max(glm::dot(x, x), glm::dot(y, y)), glm::dot(z, z)));
+    const TFloat32  distance = std::max(glm::length(center - view.Position) - sphere.Radius * scale, view.NearDistance);
+
+    return scale / distance * view.PixelScale;
+  }
+
+  const LodStats &LodSelector::Select(const LodView &view, const LodInput &input, Vector<TUint8> &levels) {
+    MAU_PROFILE_SCOPE("LodSelector::Select");
+    const Clock::time_point start = Clock::now();
+
+    const TFloat32 refine_pixels = view.ErrorPixels * (1.0f + LOD_HYSTERESIS);
+    const TFloat32 coarsen_pixels = view.ErrorPixels * (1.0f - LOD_HYSTERESIS);
+
+    LodStats stats = {};
+    levels.resize(input.Count);
+    m_NextLevels.clear();
+
+    for (TUint32 i = 0; i < input.Count; i++) {
+      const MeshLodChain   *lods = get_item(input.Lods, input.Stride, i);
+      const BoundingSphere &sphere = get_item(input.Spheres, input.Stride, i);
+      TUint32               level = 0u;
+
+      if (view.Enabled && lods != nullptr && lods->Count > 1u && !sphere.IsEmpty()) {
+        const TUint64 key = get_item(input.Keys, input.Stride, i);
+        const auto    it = m_Levels.find(key);
+        if (it != m_Levels.end())
+          level = std::min<TUint32>(it->second, lods->Count - 1u);
+
+        // refining first, a level it stops at is never coarsened again in the same frame
+        const TFloat32 scale = get_lod_error_scale(view, get_item(input.Models, input.Stride, i), sphere);
+        while (level > 0u && lods->Levels[level].Error * scale > refine_pixels) {
+          level--;
+        }
+        while (level + 1u < lods->Count && lods->Levels[level + 1u].Error * scale < coarsen_pixels) {
+          level++;
+        }
+
+        m_NextLevels[key] = static_cast<TUint8>(level);
+      }
+
+      levels[i] = static_cast<TUint8>(level);
+      if (lods != nullptr && lods->Count > 0u) {
+        stats.TriangleCount += lods->Levels[0].IndexCount / 3u;
+        stats.SelectedTriangleCount += lods->Levels[level].IndexCount / 3u;
+        stats.LevelCounts[level]++;
+      }
+    }
+
+    // keys missing from this input start over at full detail
+    std::swap(m_Levels, m_NextLevels);
+
+    stats.SelectMs = elapsed_ms(start);
+    m_Stats = stats;
+    return m_Stats;
+  }
+
+} // namespace mau
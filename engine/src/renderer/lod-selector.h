@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include <engine/utils/handle.h>
+#include "loader/mesh-lod.h"
+#include "scene/bounds.h"
+
+namespace mau {
+
+  // share of the threshold the projected error has to move past before a draw changes its level, keeps draws close to
+  // a switching distance from flipping between two levels every frame
+  constexpr TFloat32 LOD_HYSTERESIS = 0.25f;
+
+  // PixelScale turns an error at a distance into pixels, half the viewport height times the projection's y scale.
+  // disabled, every draw is drawn at full detail
+  struct LodView {
+    glm::vec3 Position = glm::vec3(0.0f);
+    TFloat32  PixelScale = 0.0f;
+    TFloat32  NearDistance = 0.0f;
+    TFloat32  ErrorPixels = 1.0f;
+    bool      Enabled = true;
+  };
+
+  // proj is glm's perspective, the near distance is read back from it
+  LodView make_lod_view(const glm::vec3 &position, const glm::mat4 &proj, TFloat32 viewport_height, TFloat32 error_pixels, bool enabled);
+
+  // pixels per local unit of error for an item, measured from the closest point of its world space sphere
+  TFloat32 get_lod_error_scale(const LodView &view, const glm::mat4 &model, const BoundingSphere &sphere);
+
+  // read with a byte stride like CullInput. a key names an item across frames, items without lods or bounds stay at
+  // full detail
+  struct LodInput {
+    const glm::mat4           *Models = nullptr;
+    const BoundingSphere      *Spheres = nullptr;
+    const MeshLodChain *const *Lods = nullptr;
+    const TUint64             *Keys = nullptr;
+    TUint32                    Stride = 0u;
+    TUint32                    Count = 0u;
+  };
+
+  struct LodStats {
+    // of every item at full detail and at its selected level
+    TUint64  TriangleCount = 0u;
+    TUint64  SelectedTriangleCount = 0u;
+    TUint32  LevelCounts[MAX_MESH_LODS] = {};
+    TFloat64 SelectMs = 0.0;
+  };
+
+  // picks the coarsest level whose error projects to at most ErrorPixels. an item refines once its level goes past the
+  // threshold by LOD_HYSTERESIS and coarsens once the next level is below it by as much, the last level of every key
+  // is kept for the next frame
+  class LodSelector: public HandledObject {
+  public:
+    LodSelector() = default;
+    ~LodSelector() = default;
+
+  public:
+    // fills levels with the level of every item
+    const LodStats &Select(const LodView &view, const LodInput &input, Vector<TUint8> &levels);
+
+    inline const LodStats &GetStats() const { return m_Stats; }
+
+  private:
+    UnorderedMap<TUint64, TUint8> m_Levels = {};     // [key], of the last selection
+    UnorderedMap<TUint64, TUint8> m_NextLevels = {}; // [key], swapped with m_Levels after every selection
+    LodStats                      m_Stats = {};
+  };
+
+} // namespace mau
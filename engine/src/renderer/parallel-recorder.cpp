@@ -0,0 +1,127 @@
+#include "parallel-recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <engine/log.h>
+#include <engine/profiler.h>
+#include "graphics/vulkan-state.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  ParallelDrawRecorder::ParallelDrawRecorder(TUint32 frame_count) {
+    ASSERT(frame_count > 0u);
+
+    const TUint32 thread_count = JobSystem::Ref().GetThreadCount() + 1u;
+
+    // pools are created up front, recording jobs must not touch VulkanState
+    VulkanState::Ref().CreateThreadCommandPools(thread_count);
+
+    m_CommandBuffers.resize(static_cast<size_t>(frame_count));
+    for (TUint32 thread_index = 0u; thread_index < thread_count; thread_index++) {
+      Handle<CommandPool>                pool = VulkanState::Ref().GetThreadCommandPool(thread_index);
+      std::vector<Handle<CommandBuffer>> buffers = pool->AllocateCommandBuffers(frame_count, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+      for (TUint32 frame = 0u; frame < frame_count; frame++) {
+        m_CommandBuffers[frame].push_back(buffers[frame]);
+      }
+
+      m_PlotNames.push_back("draw recording thread " + std::to_string(thread_index) + " (ms)");
+    }
+
+    m_ThreadTimes.resize(static_cast<size_t>(thread_count), 0.0);
+    m_Begun.resize(static_cast<size_t>(thread_count), 0u);
+
+    LOG_INFO("parallel draw recorder started [threads: %u]", thread_count);
+  }
+
+  ParallelDrawRecorder::~ParallelDrawRecorder() {
+    for (Vector<Handle<CommandBuffer>> &buffers : m_CommandBuffers) {
+      buffers.clear();
+    }
+  }
+
+  void ParallelDrawRecorder::Record(Handle<CommandBuffer> cmd, const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state) {
+    const Vector<VkCommandBuffer> &recorded = RecordSecondaries(draw_list, frame_index, state);
+    vkCmdExecuteCommands(cmd->Get(), static_cast<TUint32>(recorded.size()), recorded.data());
+  }
+
+  const Vector<VkCommandBuffer> &ParallelDrawRecorder::RecordSecondaries(const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state) {
+    MAU_PROFILE_SCOPE("ParallelDrawRecorder::RecordSecondaries");
+    ASSERT(frame_index < m_CommandBuffers.size());
+
+    std::fill(m_Begun.begin(), m_Begun.end(), static_cast<TUint8>(0u));
+    std::fill(m_ThreadTimes.begin(), m_ThreadTimes.end(), 0.0);
+
+    const TUint32 draw_count = draw_list.GetDrawCount();
+    const TUint32 chunk_count = GetChunkCount(draw_count);
+
+    // whichever thread runs a chunk appends it to its own secondary, the calling thread helps while waiting
+    JobCounter counter;
+    for (TUint32 chunk = 0u; chunk < chunk_count; chunk++) {
+      const TUint32 first_draw = static_cast<TUint32>(static_cast<TUint64>(draw_count) * chunk / chunk_count);
+      const TUint32 last_draw = static_cast<TUint32>(static_cast<TUint64>(draw_count) * (chunk + 1u) / chunk_count);
+
+      JobSystem::Ref().Schedule([this, &draw_list, frame_index, &state, first_draw, last_draw]() -> void { RecordChunk(draw_list, frame_index, state, first_draw, last_draw - first_draw); },
+                                &counter);
+    }
+
+    JobSystem::Ref().Wait(counter);
+
+    // secondaries are executed in thread order, draw order inside a subpass doesn't matter for the depth tested raster pass
+    m_Recorded.clear();
+    for (TUint32 thread_index = 0u; thread_index < m_Begun.size(); thread_index++) {
+      if (!m_Begun[thread_index])
+        continue;
+
+      const Handle<CommandBuffer> &cmd = m_CommandBuffers[frame_index][thread_index];
+      cmd->End();
+      m_Recorded.push_back(cmd->Get());
+      MAU_PROFILE_PLOT(m_PlotNames[thread_index].c_str(), m_ThreadTimes[thread_index]);
+    }
+
+    return m_Recorded;
+  }
+
+  TUint32 ParallelDrawRecorder::GetChunkCount(TUint32 draw_count) const {
+    const TUint32 useful = draw_count / MIN_DRAWS_PER_RECORDING_THREAD;
+    return std::clamp(useful, 1u, JobSystem::Ref().GetThreadCount());
+  }
+
+  void ParallelDrawRecorder::RecordChunk(const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state, TUint32 first_draw, TUint32 draw_count) {
+    MAU_PROFILE_SCOPE("ParallelDrawRecorder::RecordChunk");
+    const Clock::time_point start = Clock::now();
+
+    // threads outside the job system share the last slot, only the one waiting in RecordSecondaries helps with chunks
+    const TUint32 thread_index = std::min(JobSystem::GetThreadIndex(), static_cast<TUint32>(m_Begun.size()) - 1u);
+
+    const Handle<CommandBuffer> &cmd = m_CommandBuffers[frame_index][thread_index];
+    const VkCommandBuffer        raw_cmd = cmd->Get();
+
+    // only this thread ever touches its own slot and pool
+    if (!m_Begun[thread_index]) {
+      cmd->Reset();
+      cmd->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &state.Inheritance);
+
+      vkCmdSetViewport(raw_cmd, 0u, 1u, &state.Viewport);
+      vkCmdSetScissor(raw_cmd, 0u, 1u, &state.Scissor);
+      vkCmdBindPipeline(raw_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.Pipeline);
+      vkCmdPushConstants(raw_cmd, state.Layout, VK_SHADER_STAGE_ALL, 0u, state.PushConstantSize, state.PushConstants);
+      vkCmdBindDescriptorSets(raw_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.Layout, 0u, state.DescriptorSetCount, state.DescriptorSets, 0u, nullptr);
+
+      m_Begun[thread_index] = 1u;
+    }
+
+    if (state.Indirect) {
+      draw_list.RecordIndirect(raw_cmd, frame_index, first_draw, draw_count);
+    } else {
+      draw_list.RecordDirect(raw_cmd, first_draw, draw_count);
+    }
+
+    m_ThreadTimes[thread_index] += elapsed_ms(start);
+  }
+
+} // namespace mau
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <engine/types.h>
+#include <engine/core/job-system.h>
+#include "graphics/vulkan-commands.h"
+#include "renderer/indirect-draw-list.h"
+
+namespace mau {
+
+  // below this many draws per thread recording inline is cheaper than waking the workers
+  constexpr TUint32 MIN_DRAWS_PER_RECORDING_THREAD = 512u;
+
+  // secondary command buffers inherit nothing but the renderpass, every chunk sets this up again.
+  // raw vulkan handles only, the workers must never copy a Handle
+  struct SecondaryRecordState {
+    VkCommandBufferInheritanceInfo Inheritance = {};
+    VkPipeline                     Pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout               Layout = VK_NULL_HANDLE;
+    const VkDescriptorSet         *DescriptorSets = nullptr;
+    TUint32                        DescriptorSetCount = 0u;
+    const void                    *PushConstants = nullptr;
+    TUint32                        PushConstantSize = 0u;
+    VkViewport                     Viewport = {};
+    VkRect2D                       Scissor = {};
+    bool                           Indirect = false;
+  };
+
+  // splits a draw list into chunks recorded as jobs. every job system thread has one secondary
+  // command buffer per frame from its own pool, begun by the first chunk the thread picks up.
+  // one extra slot serves the thread outside the job system that calls Record, e.g. the render thread
+  class ParallelDrawRecorder: public HandledObject {
+  public:
+    ParallelDrawRecorder(TUint32 frame_count);
+    ~ParallelDrawRecorder();
+
+  public:
+    // cmd has to be inside the inherited renderpass, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    void Record(Handle<CommandBuffer> cmd, const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state);
+
+    // only records, the returned command buffers stay valid until frame_index is recorded again
+    const Vector<VkCommandBuffer> &RecordSecondaries(const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state);
+
+    // chunks worth recording separately for draw_count draws
+    TUint32 GetChunkCount(TUint32 draw_count) const;
+
+  public:
+    inline TUint32                 GetMaxThreadCount() const { return static_cast<TUint32>(m_ThreadTimes.size()); }
+    inline TUint32                 GetLastThreadCount() const { return static_cast<TUint32>(m_Recorded.size()); }
+    inline const Vector<TFloat64> &GetThreadTimes() const { return m_ThreadTimes; }
+
+  private:
+    void RecordChunk(const IndirectDrawList &draw_list, TUint32 frame_index, const SecondaryRecordState &state, TUint32 first_draw, TUint32 draw_count);
+
+  private:
+    Vector<Vector<Handle<CommandBuffer>>> m_CommandBuffers = {}; // [frame][thread]
+    Vector<VkCommandBuffer>               m_Recorded = {};
+    Vector<TFloat64>                      m_ThreadTimes = {};
+    Vector<TUint8>                        m_Begun = {};
+    Vector<String>                        m_PlotNames = {};
+  };
+
+} // namespace mau
@@ -1,5 +1,7 @@
 #include "renderer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <backends/imgui_impl_vulkan.h>
@@ -8,32 +10,54 @@
 
 #include "context/imgui-context.h"
 #include "glm/geometric.hpp"
+#include "graphics/vulkan-arena.h"
 #include "graphics/vulkan-bindless.h"
 #include "graphics/vulkan-features.h"
+#include "graphics/vulkan-pipeline-cache.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "renderer/rendergraph/passes/lambertian-pass.h"
 #include "renderer/rendergraph/passes/imgui-pass.h"
+#include "renderer/rendergraph/passes/raytracing-pass.h"
+#include "renderer/rendergraph/passes/denoiser-pass.h"
+#include "renderer/rendergraph/passes/gpu-cull-pass.h"
 #include "scene/internal-components.h"
 #include "context/imgui-context.h"
 #include "optix/denoiser.h"
+#include "loader/texture-streamer.h"
 
 namespace mau {
 
-  glm::mat4 getModelMatrix(const TransformComponent &transform) {
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), transform.Position);
-    model = glm::rotate(model, transform.Rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::rotate(model, transform.Rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, transform.Rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+  using Clock = std::chrono::high_resolution_clock;
 
-    return model;
+  // the slots are reused once the frames that may still write the old images retired
+  static void release_storage_images(std::vector<ImageHandle> &handles) {
+    for (ImageHandle handle : handles) {
+      VulkanBindless::Ref().Release(BindlessDescriptorType::STORAGE_IMAGE, handle);
+    }
+    handles.clear();
   }
 
-  Renderer::Renderer(void *window_ptr) {
-    Handle<CommandPool>     cmd_pool = VulkanState::Ref().GetCommandPool(VK_QUEUE_GRAPHICS_BIT);
-    Handle<VulkanSwapchain> swapchain = VulkanState::Ref().GetSwapchainHandle();
+  // instances the scene tlas starts with, it doubles when a scene needs more
+  constexpr TUint32 SCENE_TLAS_INITIAL_CAPACITY = 256u;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  // draws without levels of detail cover their whole allocation
+  static MeshLod get_draw_lod(const SnapshotDraw &draw, TUint8 level) { return draw.Lods ? draw.Lods->Levels[level] : MeshLod{}; }
+
+  Renderer::Renderer(void *window_ptr, TUint32 frames_in_flight): m_FramesInFlight(std::max(1u, frames_in_flight)) {
+    Handle<CommandPool>            cmd_pool = VulkanState::Ref().GetCommandPool(VK_QUEUE_GRAPHICS_BIT);
+    const Handle<VulkanSwapchain> &swapchain = VulkanState::Ref().GetSwapchainHandle();
     m_Extent = swapchain->GetExtent();
 
+    // headless renders the viewport at the size of the offscreen images, there is no window to fit
+    m_Headless = VulkanState::Ref().IsHeadless();
+    if (m_Headless) {
+      m_ImGuiViewportWidth = m_CurrentViewportWidth = m_Extent.width;
+      m_ImGuiViewportHeight = m_CurrentViewportHeight = m_Extent.height;
+    }
+
     Handle<Image> swapchain_image = swapchain->GetImages()[0];
     Handle<Image> depth_image = swapchain->GetDepthImages()[0];
 
@@ -53,30 +77,73 @@ namespace mau {
     VertexShaderData push_constant;
     push_constant.color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
     push_constant.mvp = m_Camera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight)));
-    push_constant.camera_buffer_index = m_CameraBufferHandle;
+    push_constant.camera_buffer_index = get_bindless_index(m_CameraBufferHandle);
     push_constant.current_frame = 0u;
-    push_constant.dir_light_color = glm::vec4(1.0f, 1.0f, 1.0f, 24.0f);
-    push_constant.dir_light_direction = glm::vec4(-0.138, 0.924, -0.356, 0.0f);
+    push_constant.dir_light_color = m_DirLightColor;
+    push_constant.dir_light_direction = m_DirLightDirection;
+    push_constant.draw_data_address = 0u;
     m_PushConstant = make_handle<PushConstant<VertexShaderData>>(push_constant);
 
-    // create rendergraph
-    CreateViewportBuffers(m_ImGuiViewportWidth, m_ImGuiViewportHeight);
-    std::vector<Sink> sinks = {sink_color, sink_depth};
+    // the gpu culler's buffers and depth pyramid are global sinks of the render graph
+    m_GpuCuller = make_handle<GpuCuller>(static_cast<TUint32>(swapchain->GetImages().size()));
+    m_GpuCullingSupported = VulkanState::Ref().GetDeviceHandle()->IsDrawIndirectCountEnabled();
+    if (!m_GpuCullingSupported) {
+      LOG_WARN("draw indirect count is not supported, draws are culled on the cpu");
+    }
 
+    // create rendergraph, the viewport targets are its transient images
     m_Rendergraph = make_handle<RenderGraph>();
-    Handle<LambertianPass> pass = make_handle<LambertianPass>();
-    Handle<ImGuiPass>      imgui_pass = make_handle<ImGuiPass>();
+    CreateViewportBuffers(m_ImGuiViewportWidth, m_ImGuiViewportHeight);
+
+    // with ray tracing the lambertian pass is culled, it is still built for the raster pipeline
+    Handle<LambertianPass> pass = make_handle<LambertianPass>(VulkanState::Ref().GetSwapchainDepthFormat());
+    m_Rendergraph->AddPass(make_handle<GpuCullPass>());
     m_Rendergraph->AddPass(pass);
+    m_Rendergraph->AddPass(make_handle<DepthPyramidPass>());
+
+    String viewport_source = "lambertian-color";
+    if (VulkanFeatures::IsRtEnabled()) {
+      m_Rendergraph->AddPass(make_handle<RayTracingPass>());
+      m_Rendergraph->AddPass(make_handle<DenoiserPass>());
+      m_Rendergraph->AddPass(make_handle<DenoiserOutputPass>());
+      viewport_source = "denoised-color";
+    }
+
+    Handle<ImGuiPass> imgui_pass = make_handle<ImGuiPass>(viewport_source);
     m_Rendergraph->AddPass(imgui_pass);
-    m_Rendergraph->Build(sinks);
+    m_Rendergraph->AddOutput("$present");
+    // nothing in the frame reads the pyramid, the next frame culls against it
+    if (!VulkanFeatures::IsRtEnabled())
+      m_Rendergraph->AddOutput("hiz-pyramid-next");
+    BuildRenderGraph();
 
     // init imgui
     ImGuiContext::Create(window_ptr, imgui_pass->GetRenderpass());
     CreateImguiTextures();
 
+    // shaders load in parallel, with a warm shader cache none of them is compiled
+    // the shaders are only referenced by the create infos, which the shader reloader keeps for rebuilding pipelines
+    Handle<VertexShader>       vertex_shader = nullptr;
+    Handle<FragmentShader>     fragment_shader = nullptr;
+    Handle<RTClosestHitShader> rt_closest_hit = nullptr;
+    Handle<RTRayGenShader>     rt_ray_gen = nullptr;
+    Handle<RTMissShader>       rt_miss = nullptr;
+    Handle<ComputeShader>      cull_compute = nullptr;
+    Handle<ComputeShader>      depth_pyramid_compute = nullptr;
+
+    ShaderCompileQueue shaders = {};
+    shaders.Add(vertex_shader, GetAssetFolderPath() + "shaders/basic_vertex.glsl");
+    shaders.Add(fragment_shader, GetAssetFolderPath() + "shaders/basic_fragment.glsl");
+    shaders.Add(cull_compute, GetAssetFolderPath() + "shaders/gpu_cull_compute.glsl");
+    shaders.Add(depth_pyramid_compute, GetAssetFolderPath() + "shaders/depth_pyramid_compute.glsl");
+    if (VulkanFeatures::IsRtEnabled()) {
+      shaders.Add(rt_closest_hit, GetAssetFolderPath() + "shaders/rt/basic.rchit");
+      shaders.Add(rt_ray_gen, GetAssetFolderPath() + "shaders/rt/basic.rgen");
+      shaders.Add(rt_miss, GetAssetFolderPath() + "shaders/rt/basic.rmiss");
+    }
+    m_ShaderLoadMs = shaders.Compile();
+
     // create pipeline
-    m_VertexShader = make_handle<VertexShader>(GetAssetFolderPath() + "shaders/basic_vertex.glsl");
-    m_FragmentShader = make_handle<FragmentShader>(GetAssetFolderPath() + "shaders/basic_fragment.glsl");
 
     InputLayout input_layout;
     input_layout.AddBindingDesc(0u, (sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec2)));
@@ -84,51 +151,124 @@ namespace mau {
     input_layout.AddAttributeDesc(1u, 0u, VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3));
     input_layout.AddAttributeDesc(2u, 0u, VK_FORMAT_R32G32_SFLOAT, sizeof(glm::vec3) + sizeof(glm::vec3));
 
-    m_Pipeline = make_handle<Pipeline>(m_VertexShader, m_FragmentShader, pass->GetRenderpass(), input_layout, m_PushConstant, VulkanBindless::Ref().GetDescriptorLayout(), VK_SAMPLE_COUNT_4_BIT);
+    m_RasterRenderpass = pass->GetRenderpass();
+
+    // pipelines compile in parallel, with a warm pipeline cache the driver skips most of the work
+    const PipelineCreateInfo pipeline_info = {
+        .Vertex = vertex_shader,
+        .Fragment = fragment_shader,
+        .Pass = pass->GetRenderpass(),
+        .Layout = input_layout,
+        .PushConstant = m_PushConstant,
+        .DescriptorLayouts = VulkanBindless::Ref().GetDescriptorLayout(),
+        .Samples = VK_SAMPLE_COUNT_4_BIT,
+    };
 
-    if (VulkanFeatures::IsRtEnabled()) {
-      m_RTCHit = make_handle<RTClosestHitShader>(GetAssetFolderPath() + "shaders/rt/basic.rchit");
-      m_RTGen = make_handle<RTRayGenShader>(GetAssetFolderPath() + "shaders/rt/basic.rgen");
-      m_RTMiss = make_handle<RTMissShader>(GetAssetFolderPath() + "shaders/rt/basic.rmiss");
-
-      RTPipelineCreateInfo rt_pipeline_info = {
-          .ClosestHit = m_RTCHit,
-          .RayGen = m_RTGen,
-          .Miss = m_RTMiss,
-          .PushConstant = m_PushConstant,
-          .DescriptorLayouts = VulkanBindless::Ref().GetDescriptorLayout(),
-      };
+    const RTPipelineCreateInfo rt_pipeline_info = {
+        .ClosestHit = rt_closest_hit,
+        .RayGen = rt_ray_gen,
+        .Miss = rt_miss,
+        .PushConstant = m_PushConstant,
+        .DescriptorLayouts = VulkanBindless::Ref().GetDescriptorLayout(),
+    };
 
-      m_RTPipeline = make_handle<RTPipeline>(rt_pipeline_info);
-    }
+    const ComputePipelineCreateInfo cull_pipeline_info = {
+        .Compute = cull_compute,
+        .PushConstant = m_GpuCuller->GetCullConstants(),
+        .DescriptorLayouts = VulkanBindless::Ref().GetDescriptorLayout(),
+    };
+
+    const ComputePipelineCreateInfo depth_pyramid_pipeline_info = {
+        .Compute = depth_pyramid_compute,
+        .PushConstant = m_GpuCuller->GetPyramidConstants(),
+        .DescriptorLayouts = VulkanBindless::Ref().GetDescriptorLayout(),
+    };
+
+    PipelineCompileQueue pipelines = {};
+    pipelines.Add(m_Pipeline, pipeline_info);
+    pipelines.Add(m_CullPipeline, cull_pipeline_info);
+    pipelines.Add(m_DepthPyramidPipeline, depth_pyramid_pipeline_info);
+    if (VulkanFeatures::IsRtEnabled())
+      pipelines.Add(m_RTPipeline, rt_pipeline_info);
+
+    const TUint32 pipeline_count = pipelines.GetCount();
+    m_PipelineCreateMs = pipelines.Compile();
+    const bool warm_cache = VulkanPipelineCache::Get() && VulkanPipelineCache::Ref().IsWarm();
+    LOG_INFO("created %u pipelines in %.2f ms [pipeline cache: %s]", pipeline_count, m_PipelineCreateMs, warm_cache ? "warm" : "cold");
+
+    // edited shaders rebuild their pipelines in the background, the current ones keep rendering until the swap
+    m_ShaderReloader = make_handle<ShaderReloader>(GetAssetFolderPath() + "shaders", m_FramesInFlight);
+    m_ShaderReloader->Watch(m_Pipeline, pipeline_info);
+    m_ShaderReloader->Watch(m_CullPipeline, cull_pipeline_info);
+    m_ShaderReloader->Watch(m_DepthPyramidPipeline, depth_pyramid_pipeline_info);
+    if (VulkanFeatures::IsRtEnabled())
+      m_ShaderReloader->Watch(m_RTPipeline, rt_pipeline_info);
 
     // create framebuffers and sync objects
     std::vector<Handle<ImageView>> swapchain_images = swapchain->GetImageViews();
     std::vector<Handle<ImageView>> swapchain_depth_images = swapchain->GetDepthImageViews();
-    for (size_t i = 0; i < swapchain_images.size(); i++) {
+    for (TUint32 i = 0; i < m_FramesInFlight; i++) {
       m_ImageAvailable.push_back(make_handle<Semaphore>());
-      m_RenderFinished.push_back(make_handle<Semaphore>());
       m_QueueSubmit.push_back(make_handle<Fence>(VK_FENCE_CREATE_SIGNALED_BIT));
     }
 
+    for (size_t i = 0; i < swapchain_images.size(); i++) {
+      m_RenderFinished.push_back(make_handle<Semaphore>());
+      m_ImagesInFlight.push_back(nullptr);
+    }
+
     // allocate command buffers
     m_CommandBuffers = cmd_pool->AllocateCommandBuffers(static_cast<TUint32>(swapchain_images.size()));
+    m_DrawList = make_handle<IndirectDrawList>(static_cast<TUint32>(swapchain_images.size()));
+    m_Recorder = make_handle<ParallelDrawRecorder>(static_cast<TUint32>(swapchain_images.size()));
+    m_Culler = make_handle<FrustumCuller>();
+    m_LodSelector = make_handle<LodSelector>();
+    m_GpuTimestamps = make_handle<TimestampQueryPool>(static_cast<TUint32>(swapchain_images.size()));
+    m_TimestampFrames.assign(swapchain_images.size(), UINT64_MAX);
+
+    // the ray generation shader traces the slot named by tlas_index
+    if (VulkanFeatures::IsRtEnabled()) {
+      m_SceneTLAS = make_handle<TopLevelAS>(SCENE_TLAS_INITIAL_CAPACITY, static_cast<TUint32>(swapchain_images.size()));
+      m_SceneTLASHandle = VulkanBindless::Ref().AddAccelerationStructure(m_SceneTLAS);
+    }
 
     // recreate framebuffers on window resize
     swapchain->RegisterSwapchainCreateCallbackFunc([this]() -> void {
-      std::vector<Sink> sinks = {sink_color, sink_depth, sink_accum};
-      m_Rendergraph->Build(sinks);
-      Handle<VulkanSwapchain> swapchain = VulkanState::Ref().GetSwapchainHandle();
-      m_Extent = swapchain->GetExtent();
+      if (BuildRenderGraph())
+        CreateImguiTextures();
+      m_Extent = VulkanState::Ref().GetSwapchainExtent();
     });
 
     // initial flag buffer
     for (size_t i = 0; i < swapchain_images.size(); i++) {
       m_ClearAccumFlag.push_back(true);
     }
+
+    // with more than one frame in flight the next frame is updated while the render thread submits this one
+    if (m_FramesInFlight > 1u) {
+      m_RenderThread = std::jthread([this](std::stop_token stop_token) -> void { RenderLoop(stop_token); });
+    }
+
+    LOG_INFO("renderer started [frames in flight: %u, pipelined: %s]", m_FramesInFlight, IsPipelined() ? "yes" : "no");
   }
 
-  Renderer::~Renderer() { ImGuiContext::Destroy(); }
+  Renderer::~Renderer() {
+    if (m_RenderThread.joinable()) {
+      m_RenderThread.request_stop();
+      m_RenderThread.join();
+    }
+
+    // the snapshots hold imgui draw lists and meshes, both have to go before the contexts they belong to
+    for (FrameSnapshot &frame : m_Snapshots) {
+      frame.ImGui.Clear();
+      frame.Meshes.clear();
+    }
+
+    if (VulkanBindless::Get())
+      VulkanBindless::Ref().Release(BindlessDescriptorType::ACCELERATION_STRUCTURE, m_SceneTLASHandle);
+
+    ImGuiContext::Destroy();
+  }
 
   void Renderer::StartFrame() {
     MAU_PROFILE_SCOPE("Renderer::StartFrame");
@@ -138,95 +278,424 @@ namespace mau {
 
   void Renderer::EndFrame() {
     MAU_PROFILE_SCOPE("Renderer::EndFrame");
-    Handle<VulkanSwapchain> swapchain = VulkanState::Ref().GetSwapchainHandle();
-    Handle<VulkanDevice>    device = VulkanState::Ref().GetDeviceHandle();
+    FrameSnapshot &frame = m_Snapshots[m_SnapshotIndex];
+
+    // meshes only the older snapshot kept alive are released while the render thread is idle
+    Vector<Handle<Mesh>> released = std::move(frame.Meshes);
+    CaptureFrame(frame);
+
+    if (!IsPipelined()) {
+      UpdateResources();
+      RenderFrame(frame);
+      m_FrameStats = frame.Stats;
+      return;
+    }
+
+    // the render thread is done with the other snapshot once the previous frame is submitted
+    WaitFrame();
+    released.clear();
+    UpdateResources();
+
+    {
+      std::lock_guard<std::mutex> lock(m_RenderMutex);
+      m_PendingFrame = &frame;
+    }
+    m_RenderStart.notify_one();
+
+    m_SnapshotIndex = (m_SnapshotIndex + 1u) % static_cast<TUint32>(m_Snapshots.size());
+  }
+
+  void Renderer::WaitFrame() {
+    if (!IsPipelined())
+      return;
+
+    MAU_PROFILE_SCOPE("Renderer::WaitFrame");
+    std::exception_ptr error = nullptr;
+
+    {
+      std::unique_lock<std::mutex> lock(m_RenderMutex);
+      m_RenderDone.wait(lock, [this]() -> bool { return m_PendingFrame == nullptr; });
+      std::swap(error, m_RenderError);
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    // the last frame handed to the render thread is the snapshot that is not captured next
+    m_FrameStats = m_Snapshots[(m_SnapshotIndex + 1u) % m_Snapshots.size()].Stats;
+  }
+
+  void Renderer::UpdateResources() {
+    MAU_PROFILE_SCOPE("Renderer::UpdateResources");
+
+    // released geometry ranges come back frames in flight frames later, by then the render thread waited for the fences
+    // of every frame that could draw them
+    GeometryArena::Ref().NextFrame(m_FramesInFlight);
+
+    // streamed textures move to fresh bindless slots with the next descriptor update, the frames in flight keep
+    // sampling the placeholder slots until they retire
+    if (TextureStreamer::Ref().Update() > 0u) {
+      VulkanBindless::Ref().UpdatePendingTextures();
+    }
+
+    VulkanBindless::Ref().ReleaseDeferred();
+    VulkanState::Ref().GetUploadRing()->Retire();
+  }
+
+  void Renderer::RenderLoop(std::stop_token stop_token) {
+    MAU_PROFILE_THREAD("render thread");
+
+    while (true) {
+      FrameSnapshot *frame = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_RenderMutex);
+        if (!m_RenderStart.wait(lock, stop_token, [this]() -> bool { return m_PendingFrame != nullptr; }))
+          return;
+
+        frame = m_PendingFrame;
+      }
+
+      std::exception_ptr error = nullptr;
+      try {
+        RenderFrame(*frame);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(m_RenderMutex);
+        m_RenderError = error;
+        m_PendingFrame = nullptr;
+      }
+      m_RenderDone.notify_all();
+    }
+  }
+
+  void Renderer::CaptureFrame(FrameSnapshot &frame) {
+    MAU_PROFILE_SCOPE("Renderer::CaptureFrame");
+    const Clock::time_point start = Clock::now();
+    ImGuiTest();
+
+    frame.ViewCamera = m_Camera;
+    frame.ViewportWidth = m_CurrentViewportWidth;
+    frame.ViewportHeight = m_CurrentViewportHeight;
+    frame.DirLightColor = m_DirLightColor;
+    frame.DirLightDirection = m_DirLightDirection;
+    frame.HasScene = m_DrawScene;
+    frame.EnableDenoiser = EnableDenoiser;
+    frame.EnableIndirectDraw = EnableIndirectDraw;
+    frame.EnableParallelRecording = EnableParallelRecording;
+    frame.EnableFrustumCulling = EnableFrustumCulling;
+    frame.EnableGpuCulling = EnableGpuCulling;
+    frame.EnableOcclusionCulling = EnableOcclusionCulling;
+    frame.EnableLod = EnableLod;
+    frame.LodErrorPixels = LodErrorPixels;
+    frame.Draws.clear();
+    frame.Instances.clear();
+    frame.Meshes.clear();
+    frame.Stats = {.Frame = m_FrameNumber++};
+
+    // the render thread never touches the scene, every submesh becomes one draw with the world transform cached by
+    // Scene::UpdateTransforms
+    bool transform_updated = false;
+    if (m_DrawScene) {
+      m_DrawScene->Each([&frame, &transform_updated](Entity entity) -> void {
+        if (!entity.Has<MeshComponent>())
+          return;
+
+        const TUint32                  entity_id = static_cast<TUint32>(entity.GetId());
+        const WorldTransformComponent &transform = entity.Get<WorldTransformComponent>();
+        MeshComponent                 &mesh = entity.Get<MeshComponent>();
+
+        const glm::mat4       &model = transform.Matrix;
+        const Vector<SubMesh> &submeshes = mesh.MeshObject->GetSubMeshes();
+        for (TUint32 i = 0; i < submeshes.size(); i++) {
+          const SubMesh &submesh = submeshes[i];
+          frame.Draws.push_back({
+              .Model = model,
+              .Geometry = &*submesh.GetGeometry(),
+              .Material = submesh.GetMaterial() ? get_bindless_index(submesh.GetMaterial()->GetMaterialHandle()) : UINT32_MAX,
+              .Bounds = submesh.GetBounds(),
+              .Sphere = submesh.GetBoundingSphere(),
+              .Key = make_tlas_instance_key(entity_id, i),
+              .Lods = &submesh.GetLods(),
+          });
+
+          if (Handle<BottomLevelAS> blas = submesh.GetAccel()) {
+            frame.Instances.push_back({.Key = make_tlas_instance_key(entity_id, i), .Model = model, .BLAS = blas->GetDeviceAddress(), .CustomIndex = blas->GetCustomIndex()});
+          }
+        }
+
+        frame.Meshes.push_back(mesh.MeshObject);
+        transform_updated = transform_updated || transform.Updated;
+      });
+    }
+
+    frame.ClearAccum = m_ClearAccum || transform_updated;
+    m_ClearAccum = false;
+    m_DrawScene = nullptr;
+
+    ImGuiContext::Ref().EndFrame(frame.ImGui);
+    frame.Stats.CaptureMs = elapsed_ms(start);
+  }
+
+  void Renderer::RenderFrame(FrameSnapshot &frame) {
+    MAU_PROFILE_SCOPE("Renderer::RenderFrame");
+    const Clock::time_point frame_start = Clock::now();
+    m_Frame = &frame;
+
+    // shared with the main thread, borrowed instead of copied
+    VulkanSwapchain &swapchain = *VulkanState::Ref().GetSwapchainHandle();
+    VulkanDevice    &device = *VulkanState::Ref().GetDeviceHandle();
+    UploadRing      &upload_ring = *VulkanState::Ref().GetUploadRing();
 
     Handle<Fence> queue_submit = m_QueueSubmit[m_CurrentFrame];
-    queue_submit->Wait();
+    {
+      MAU_PROFILE_SCOPE("Renderer::WaitFence");
+      const Clock::time_point start = Clock::now();
+      queue_submit->Wait();
+      frame.Stats.FenceWaitMs = elapsed_ms(start);
+    }
 
     Handle<Semaphore> image_available = m_ImageAvailable[m_CurrentFrame];
-    Handle<Semaphore> render_finished = m_RenderFinished[m_CurrentFrame];
-    TUint32           image_index = swapchain->GetNextImageIndex(image_available);
+    TUint32           image_index = swapchain.GetNextImageIndex(image_available);
+    Handle<Semaphore> render_finished = m_RenderFinished[image_index];
+
+    // with more swapchain images than frames in flight an older frame can still be rendering to this image
+    if (m_ImagesInFlight[image_index] && m_ImagesInFlight[image_index] != queue_submit) {
+      m_ImagesInFlight[image_index]->Wait();
+    }
+    m_ImagesInFlight[image_index] = queue_submit;
     queue_submit->Reset();
 
+    // the last command buffer recorded into this image finished, its timestamps are final
+    if (m_TimestampFrames[image_index] != UINT64_MAX && m_GpuTimestamps->GetElapsedMs(image_index, frame.Stats.GpuMs)) {
+      frame.Stats.GpuFrame = m_TimestampFrames[image_index];
+    }
+    m_TimestampFrames[image_index] = frame.Stats.Frame;
+
+    // rebuilt pipelines are swapped in before recording, the replaced ones are released once no frame in flight uses them.
+    // a new ray tracing pipeline restarts accumulation
+    const bool pipelines_swapped = m_ShaderReloader->Update(frame.Stats.Frame);
+
+    if (frame.ClearAccum || pipelines_swapped) {
+      for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
+        m_ClearAccumFlag[i] = true;
+    }
+
+    VertexShaderData data = m_PushConstant->GetData();
+    data.dir_light_color = frame.DirLightColor;
+    data.dir_light_direction = frame.DirLightDirection;
+    m_PushConstant->Update(data);
+
     // recreate render target on viewport resize
-    if (m_CurrentViewportWidth != m_ImGuiViewportWidth || m_CurrentViewportHeight != m_ImGuiViewportHeight) {
-      m_ImGuiViewportWidth = m_CurrentViewportWidth;
-      m_ImGuiViewportHeight = m_CurrentViewportHeight;
+    if (frame.ViewportWidth != m_ImGuiViewportWidth || frame.ViewportHeight != m_ImGuiViewportHeight) {
+      m_ImGuiViewportWidth = frame.ViewportWidth;
+      m_ImGuiViewportHeight = frame.ViewportHeight;
 
-      vkDeviceWaitIdle(device->GetDevice());
+      // locks the queues, the main thread may be submitting uploads
+      device.WaitIdle();
 
       CreateViewportBuffers(m_ImGuiViewportWidth, m_ImGuiViewportHeight);
+      BuildRenderGraph();
       CreateImguiTextures();
-      std::vector<Sink> sinks = {sink_color, sink_depth, sink_accum};
-      m_Rendergraph->Build(sinks);
 
-      VertexShaderData data = m_PushConstant->GetData();
-      data.mvp = m_Camera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight)));
+      data.mvp = frame.ViewCamera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight)));
       m_PushConstant->Update(data);
     }
 
-    ImGuiTest(image_index);
+    frame.ImGui.ReplaceTexture(IMGUI_VIEWPORT_TEXTURE_ID, imgui_texture_ids[image_index]);
+
+    if (m_SceneTLAS)
+      UpdateSceneTLAS(frame);
+
+    // slots released by retired frames are recycled, descriptors written since the last frame land in one update
+    VulkanBindless::Ref().Update(frame.Stats.Frame, m_FramesInFlight);
+
+    {
+      const Clock::time_point start = Clock::now();
+      RecordCommandBuffer(static_cast<TUint64>(image_index));
+      frame.Stats.RecordMs = elapsed_ms(start);
+    }
 
-    RecordCommandBuffer(static_cast<TUint64>(image_index));
+    {
+      MAU_PROFILE_SCOPE("Renderer::Submit");
+      const Clock::time_point start = Clock::now();
 
-    Handle<VulkanQueue>  graphics_queue = device->GetGraphicsQueue();
-    Handle<PresentQueue> present_queue = device->GetPresentQueue();
+      const Handle<VulkanQueue> &graphics_queue = device.GetGraphicsQueue();
+
+      // the frame waits for resource uploads enqueued so far, the main thread retires them
+      TimelinePoint uploads = upload_ring.GetPendingPoint();
+
+      // offscreen images are never acquired or presented, the fence alone paces the frames
+      if (m_Headless) {
+        graphics_queue->Submit(m_CommandBuffers[static_cast<TUint64>(image_index)], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, nullptr, nullptr, queue_submit, uploads);
+      } else {
+        graphics_queue->Submit(m_CommandBuffers[static_cast<TUint64>(image_index)], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, image_available, render_finished, queue_submit, uploads);
+        device.GetPresentQueue()->Present(image_index, VulkanState::Ref().GetSwapchainHandle(), render_finished);
+      }
+
+      frame.Stats.SubmitMs = elapsed_ms(start);
+    }
 
-    graphics_queue->Submit(m_CommandBuffers[static_cast<TUint64>(image_index)], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, image_available, render_finished, queue_submit);
-    present_queue->Present(image_index, swapchain, render_finished);
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
 
-    m_CurrentFrame = (m_CurrentFrame + 1) % swapchain->GetImages().size();
+    frame.Stats.DrawCount = m_DrawList->GetDrawCount();
+    frame.Stats.BatchCount = m_DrawList->GetBatchCount();
+    frame.Stats.RenderMs = elapsed_ms(frame_start);
+    m_Frame = nullptr;
   }
 
-  void Renderer::Render(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+  bool Renderer::PrepareRender(TUint32 frame_index) {
+    MAU_PROFILE_SCOPE("Renderer::PrepareRender");
+    const Camera   &camera = m_Frame->ViewCamera;
     const glm::vec2 window_size = glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight));
     CameraBuffer    buff = {
-           .view_proj = m_Camera.GetMVP(window_size),
-           .view_inverse = glm::inverse(m_Camera.GetView()),
-           .proj_inverse = glm::inverse(m_Camera.GetProj(window_size)),
+           .view_proj = camera.GetMVP(window_size),
+           .view_inverse = glm::inverse(camera.GetView()),
+           .proj_inverse = glm::inverse(camera.GetProj(window_size)),
     };
     m_CameraBuffer->Update(std::move(buff));
 
-    m_PushConstant->Bind(cmd, m_Pipeline);
+    // every visible submesh becomes one entry of the draw list, the shader picks its transform and material by instance
+    // index. ray tracing still sees the whole scene through the tlas. culled on the gpu the list keeps every draw
+    const Vector<SnapshotDraw> &draws = m_Frame->Draws;
+    const bool                  gpu_culling = IsGpuCulling();
+    m_DrawList->Clear();
+
+    // levels are picked for every draw before culling, so a draw leaving the view keeps its level
+    if (!draws.empty()) {
+      LodInput input = {
+          .Models = &draws[0].Model,
+          .Spheres = &draws[0].Sphere,
+          .Lods = &draws[0].Lods,
+          .Keys = &draws[0].Key,
+          .Stride = sizeof(SnapshotDraw),
+          .Count = static_cast<TUint32>(draws.size()),
+      };
+      const LodView   view = make_lod_view(camera.Position, camera.GetProj(window_size), window_size.y, m_Frame->LodErrorPixels, m_Frame->EnableLod);
+      const LodStats &stats = m_LodSelector->Select(view, input, m_DrawLevels);
+      m_Frame->Stats.TriangleCount = stats.TriangleCount;
+      m_Frame->Stats.LodTriangleCount = stats.SelectedTriangleCount;
+      m_Frame->Stats.LodMs = stats.SelectMs;
+    }
+
+    if (m_Frame->EnableFrustumCulling && !gpu_culling && !draws.empty()) {
+      CullInput input = {
+          .Models = &draws[0].Model,
+          .Boxes = &draws[0].Bounds,
+          .Spheres = &draws[0].Sphere,
+          .Stride = sizeof(SnapshotDraw),
+          .Count = static_cast<TUint32>(draws.size()),
+      };
+      const CullStats &stats = m_Culler->Cull(make_frustum(camera.GetMVP(window_size)), input, m_VisibleDraws);
+      m_Frame->Stats.CulledCount = stats.CulledCount;
+      m_Frame->Stats.CullMs = stats.CullMs;
+
+      for (TUint32 index : m_VisibleDraws) {
+        const SnapshotDraw &draw = draws[index];
+        m_DrawList->Add(*draw.Geometry, draw.Model, draw.Material, draw.Bounds, draw.Sphere, get_draw_lod(draw, m_DrawLevels[index]));
+      }
+    } else {
+      for (TUint32 index = 0; index < draws.size(); index++) {
+        const SnapshotDraw &draw = draws[index];
+        m_DrawList->Add(*draw.Geometry, draw.Model, draw.Material, draw.Bounds, draw.Sphere, get_draw_lod(draw, m_DrawLevels[index]));
+      }
+    }
+
+    VertexShaderData data = m_PushConstant->GetData();
+    data.mvp = camera.GetMVP(window_size);
+    data.material_index = UINT32_MAX;
+    data.storage_image_index = UINT32_MAX;
+    data.camera_buffer_index = get_bindless_index(m_CameraBufferHandle);
+    data.accum_image_index = UINT32_MAX;
+    data.draw_data_address = m_DrawList->Upload(frame_index);
+    m_PushConstant->Update(data);
+
+    // the pyramid of a frame's first run after a graph build was discarded by its initial barriers
+    if (gpu_culling) {
+      const bool occlusion = m_Frame->EnableOcclusionCulling && m_Rendergraph->HasStarted(frame_index);
+      m_GpuCuller->Prepare(frame_index, m_Frame->Stats.Frame, *m_DrawList, camera.GetMVP(window_size), occlusion);
+
+      const GpuCullStats &stats = m_GpuCuller->GetStats();
+      m_Frame->Stats.GpuCullFrame = stats.Frame;
+      m_Frame->Stats.GpuTestedCount = stats.TestedCount;
+      m_Frame->Stats.GpuVisibleCount = stats.VisibleCount;
+    }
+
+    // a multi draw indirect list is a handful of calls, only per draw recording is worth splitting
+    const bool indirect = m_Frame->EnableIndirectDraw && m_DrawList->IsMultiDrawIndirectEnabled();
+    return m_Frame->EnableParallelRecording && !indirect && m_Recorder->GetChunkCount(m_DrawList->GetDrawCount()) > 1u;
+  }
+
+  void Renderer::RenderCull(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    if (!IsGpuCulling())
+      return;
+
+    MAU_PROFILE_SCOPE("Renderer::RenderCull");
+    m_GpuCuller->RecordCull(cmd, frame_index, m_CullPipeline);
+  }
+
+  void Renderer::RenderDepthPyramid(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    // a pyramid skipped for a frame is stale, occlusion waits until it was built again
+    if (!IsGpuCulling() || !m_Frame->EnableOcclusionCulling) {
+      m_GpuCuller->InvalidatePyramid();
+      return;
+    }
+
+    MAU_PROFILE_SCOPE("Renderer::RenderDepthPyramid");
+    const glm::vec2 window_size = glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight));
+    m_GpuCuller->RecordPyramid(cmd, frame_index, m_DepthPyramidPipeline, m_Frame->ViewCamera.GetMVP(window_size));
+  }
+
+  void Renderer::Render(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    MAU_PROFILE_SCOPE("Renderer::Render");
+
     vkCmdBindPipeline(cmd->Get(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline->Get());
+    m_PushConstant->Bind(cmd, m_Pipeline);
 
     const std::vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
     vkCmdBindDescriptorSets(cmd->Get(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline->GetLayout(), 0u, static_cast<TUint32>(sets.size()), sets.data(), 0u, nullptr);
 
-    if (m_DrawScene) {
-      m_DrawScene->Each([this, &cmd](Entity entity) -> void {
-        VkDeviceSize        offsets[] = {0u};
-        TransformComponent &transform = entity.Get<TransformComponent>();
-        MeshComponent      &mesh = entity.Get<MeshComponent>();
-
-        glm::mat4 mvp = m_Camera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight))) * getModelMatrix(transform);
-        for (const auto &submesh : mesh.MeshObject->GetSubMeshes()) {
-          m_PushConstant->Update({
-              .color = m_PushConstant->GetData().color,
-              .mvp = mvp,
-              .material_index = submesh.GetMaterial() ? submesh.GetMaterial()->GetMaterialHandle() : UINT32_MAX,
-              .storage_image_index = UINT32_MAX,
-              .camera_buffer_index = m_CameraBufferHandle,
-              .accum_image_index = UINT32_MAX,
-          });
-          m_PushConstant->Bind(cmd, m_Pipeline);
-
-          vkCmdBindVertexBuffers(cmd->Get(), 0u, 1u, submesh.GetVertexBuffer()->Ref(), offsets);
-          vkCmdBindIndexBuffer(cmd->Get(), submesh.GetIndexBuffer()->Get(), 0u, VK_INDEX_TYPE_UINT32);
-          vkCmdDrawIndexed(cmd->Get(), submesh.GetIndexCount(), 1, 0, 0, 0);
-        }
-      });
+    if (IsGpuCulling()) {
+      m_DrawList->RecordIndirectCount(cmd, m_GpuCuller->GetCulledCommands(frame_index), m_GpuCuller->GetCounts(frame_index));
+    } else if (m_Frame->EnableIndirectDraw) {
+      m_DrawList->RecordIndirect(cmd, frame_index);
+    } else {
+      m_DrawList->RecordDirect(cmd);
     }
-    m_DrawScene = nullptr;
+  }
+
+  void Renderer::RenderParallel(Handle<CommandBuffer> cmd, TUint32 frame_index, const VkCommandBufferInheritanceInfo &inheritance, const VkViewport &viewport, const VkRect2D &scissor) {
+    MAU_PROFILE_SCOPE("Renderer::RenderParallel");
+
+    const Vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
+    const VertexShaderData         data = m_PushConstant->GetData();
+
+    const SecondaryRecordState state = {
+        .Inheritance = inheritance,
+        .Pipeline = m_Pipeline->Get(),
+        .Layout = m_Pipeline->GetLayout(),
+        .DescriptorSets = sets.data(),
+        .DescriptorSetCount = static_cast<TUint32>(sets.size()),
+        .PushConstants = &data,
+        .PushConstantSize = static_cast<TUint32>(sizeof(VertexShaderData)),
+        .Viewport = viewport,
+        .Scissor = scissor,
+        .Indirect = m_Frame->EnableIndirectDraw,
+    };
+
+    m_Recorder->Record(cmd, *m_DrawList, frame_index, state);
   }
 
   void Renderer::RenderRT(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    const Camera   &camera = m_Frame->ViewCamera;
     const glm::vec2 window_size = glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight));
     CameraBuffer    buff = {
-           .view_proj = m_Camera.GetMVP(window_size),
-           .view_inverse = glm::inverse(m_Camera.GetView()),
-           .proj_inverse = glm::inverse(m_Camera.GetProj(window_size)),
+           .view_proj = camera.GetMVP(window_size),
+           .view_inverse = glm::inverse(camera.GetView()),
+           .proj_inverse = glm::inverse(camera.GetProj(window_size)),
     };
     m_CameraBuffer->Update(std::move(buff));
 
@@ -235,60 +704,71 @@ namespace mau {
     const Vector<VkDescriptorSet> &sets = VulkanBindless::Ref().GetDescriptorSet();
     vkCmdBindDescriptorSets(cmd->Get(), VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_RTPipeline->GetLayout(), 0u, static_cast<TUint32>(sets.size()), sets.data(), 0u, nullptr);
 
-    glm::mat4     mvp = m_Camera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight)));
+    glm::mat4     mvp = camera.GetMVP(glm::vec2(static_cast<float>(m_ImGuiViewportWidth), static_cast<float>(m_ImGuiViewportHeight)));
     const TUint32 current_frame = m_ClearAccumFlag[frame_index] ? 0 : m_PushConstant->GetData().current_frame + 1;
     m_ClearAccumFlag[frame_index] = false;
     m_PushConstant->Update({
         .color = m_PushConstant->GetData().color,
         .mvp = mvp,
         .material_index = 0u,
-        .storage_image_index = sink_color_handles[frame_index],
-        .camera_buffer_index = m_CameraBufferHandle,
+        .storage_image_index = get_bindless_index(sink_color_handles[frame_index]),
+        .camera_buffer_index = get_bindless_index(m_CameraBufferHandle),
         .current_frame = current_frame,
-        .accum_image_index = sink_accum_handles[frame_index],
-        .albedo_image_index = sink_albedo_handles[frame_index],
-        .normal_image_index = sink_normal_handles[frame_index],
+        .accum_image_index = get_bindless_index(sink_accum_handles[frame_index]),
+        .albedo_image_index = get_bindless_index(sink_albedo_handles[frame_index]),
+        .normal_image_index = get_bindless_index(sink_normal_handles[frame_index]),
+        .tlas_index = get_bindless_index(m_SceneTLASHandle),
         .dir_light_color = m_PushConstant->GetData().dir_light_color,
         .dir_light_direction = m_PushConstant->GetData().dir_light_direction,
     });
     m_PushConstant->Bind(cmd, m_RTPipeline);
 
-    if (m_DrawScene) {
-      bool transform_updated = false;
-
-      m_DrawScene->Each([this, &cmd, &transform_updated](Entity entity) -> void {
-        TransformComponent &transform = entity.Get<TransformComponent>();
-        MeshComponent      &mesh = entity.Get<MeshComponent>();
-
-        if (transform.Updated)
-          transform_updated = true;
-
-        glm::mat4 model = getModelMatrix(transform);
-        mesh.MeshObject->GetAccel()->UpdateTransform(model, cmd);
-      });
+    // changes pile up in the table while the ray tracing pass is not recorded
+    const TLASInstanceChanges changes = m_TLASInstances.TakeChanges();
+    m_SceneTLAS->Record(cmd, frame_index, m_TLASInstances, changes);
+    m_Frame->Stats.TLASCopiedCount = changes.RecordCount;
 
+    if (m_Frame->HasScene) {
       RTSBTRegion region = m_RTPipeline->GetSBTRegion();
       vkCmdTraceRaysKHR(cmd->Get(), &region.RayGen, &region.RayMiss, &region.RayClosestHit, &region.RayCall, m_ImGuiViewportWidth, m_ImGuiViewportHeight, 1);
+    }
+  }
 
-      Handle<ImageResource> current_image = sink_color.GetResource(frame_index);
-      Handle<ImageResource> current_albedo = sink_albedo.GetResource(frame_index);
-      Handle<ImageResource> current_normal = sink_normal.GetResource(frame_index);
+  void Renderer::UpdateSceneTLAS(FrameSnapshot &frame) {
+    MAU_PROFILE_SCOPE("Renderer::UpdateSceneTLAS");
 
-      if (EnableDenoiser) {
-        Denoiser::Ref().ImageToBuffers(cmd, current_image->GetImage(), current_albedo->GetImage(), current_normal->GetImage(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        Denoiser::Ref().Denoise(cmd);
-        Denoiser::Ref().BufferToImage(cmd, current_image->GetImage(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-      } else {
-        TransitionImageLayout(cmd, current_image->GetImage(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-      }
+    // instances of entities that are gone or lost their mesh are not set and removed
+    m_TLASInstances.BeginFrame();
+    for (const SnapshotInstance &instance : frame.Instances) {
+      m_TLASInstances.Set(instance.Key, instance.Model, instance.BLAS, instance.CustomIndex);
+    }
+    m_TLASInstances.EndFrame();
 
-      if (transform_updated) {
-        for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-          m_ClearAccumFlag[i] = true;
-      }
+    const TUint32 count = m_TLASInstances.GetCount();
+    frame.Stats.TLASInstanceCount = count;
+    if (m_SceneTLAS->Fits(count))
+      return;
+
+    TUint32 capacity = m_SceneTLAS->GetCapacity();
+    while (capacity < count) {
+      capacity *= 2u;
     }
 
-    m_DrawScene = nullptr;
+    // frames in flight still build and trace the old tlas through the old slot, both are kept until they retired. the
+    // new tlas takes a fresh slot that the ray generation shader is pointed at
+    VulkanBindless::Ref().Release(BindlessDescriptorType::ACCELERATION_STRUCTURE, m_SceneTLASHandle);
+    VulkanBindless::Ref().Defer(m_SceneTLAS);
+    m_SceneTLAS = make_handle<TopLevelAS>(capacity, GetImageCount());
+    m_SceneTLASHandle = VulkanBindless::Ref().AddAccelerationStructure(m_SceneTLAS);
+
+    // the new instance buffer is empty
+    m_TLASInstances.MarkAllChanged();
+    LOG_INFO("scene tlas grown to %u instances", capacity);
+  }
+
+  void Renderer::SetCamera(const Camera &camera) {
+    m_Camera = camera;
+    m_ClearAccum = true;
   }
 
   void Renderer::UpdateCamera() {
@@ -327,8 +807,7 @@ namespace mau {
     }
 
     if (updated) {
-      for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-        m_ClearAccumFlag[i] = true;
+      m_ClearAccum = true;
     }
   }
 
@@ -338,44 +817,61 @@ namespace mau {
     Handle<CommandBuffer> cmd = m_CommandBuffers[idx];
     cmd->Reset();
     cmd->Begin();
+    VulkanBindless::Ref().RecordMaterialUpdates(cmd);
+    m_GpuTimestamps->Begin(cmd, static_cast<TUint32>(idx));
+
+    // the draw list is built before the graph records, the culler's buffers may grow and the barriers in front of the
+    // cull pass have to name the new ones
+    if (!VulkanFeatures::IsRtEnabled())
+      m_RecordParallel = PrepareRender(static_cast<TUint32>(idx));
 
     m_Rendergraph->Execute(cmd, idx);
 
+    m_GpuTimestamps->End(cmd, static_cast<TUint32>(idx));
     MAU_GPU_COLLECT(cmd->Get());
     cmd->End();
   }
 
-  void Renderer::ImGuiTest(TUint32 idx) {
-    VertexShaderData data = m_PushConstant->GetData();
-
+  void Renderer::ImGuiTest() {
     if (ImGui::Begin("Test Window")) {
       if (ImGui::DragFloat3("Position", &m_Camera.Position[0])) {
-        for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-          m_ClearAccumFlag[i] = true;
+        m_ClearAccum = true;
       }
 
-      if (ImGui::ColorEdit3("Global Light Color", &data.dir_light_color[0])) {
-        m_PushConstant->Update(data);
-        for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-          m_ClearAccumFlag[i] = true;
+      if (ImGui::ColorEdit3("Global Light Color", &m_DirLightColor[0])) {
+        m_ClearAccum = true;
       }
 
-      if (ImGui::DragFloat("Global Light Intensity", &data.dir_light_color.w)) {
-        m_PushConstant->Update(data);
-        for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-          m_ClearAccumFlag[i] = true;
+      if (ImGui::DragFloat("Global Light Intensity", &m_DirLightColor.w)) {
+        m_ClearAccum = true;
       }
 
-      if (ImGui::SliderFloat3("Global Light Direction", &data.dir_light_direction[0], -1.0f, 1.0f)) {
-        glm::vec3 new_dir = data.dir_light_direction;
+      if (ImGui::SliderFloat3("Global Light Direction", &m_DirLightDirection[0], -1.0f, 1.0f)) {
+        glm::vec3 new_dir = m_DirLightDirection;
         new_dir = glm::normalize(new_dir);
-        data.dir_light_direction.x = new_dir.x;
-        data.dir_light_direction.y = new_dir.y;
-        data.dir_light_direction.z = new_dir.z;
-        m_PushConstant->Update(data);
-        for (size_t i = 0; i < m_ClearAccumFlag.size(); i++)
-          m_ClearAccumFlag[i] = true;
+        m_DirLightDirection.x = new_dir.x;
+        m_DirLightDirection.y = new_dir.y;
+        m_DirLightDirection.z = new_dir.z;
+        m_ClearAccum = true;
       }
+
+      ImGui::Checkbox("Indirect Draw", &EnableIndirectDraw);
+      ImGui::Checkbox("Parallel Recording", &EnableParallelRecording);
+      ImGui::Checkbox("Frustum Culling", &EnableFrustumCulling);
+      ImGui::Checkbox("GPU Culling", &EnableGpuCulling);
+      ImGui::Checkbox("Occlusion Culling", &EnableOcclusionCulling);
+      ImGui::Checkbox("LOD", &EnableLod);
+      ImGui::SliderFloat("LOD Error (px)", &LodErrorPixels, 0.25f, 8.0f);
+      ImGui::Text("Draws: %u, Indirect Batches: %u", m_FrameStats.DrawCount, m_FrameStats.BatchCount);
+      ImGui::Text("Culled: %u (%.3f ms)", m_FrameStats.CulledCount, m_FrameStats.CullMs);
+      ImGui::Text("Triangles: %llu -> %llu with LOD (%.3f ms)", static_cast<unsigned long long>(m_FrameStats.TriangleCount),
+                  static_cast<unsigned long long>(m_FrameStats.LodTriangleCount), m_FrameStats.LodMs);
+      if (m_FrameStats.GpuCullFrame != UINT64_MAX)
+        ImGui::Text("GPU Visible: %u of %u (frame %llu)", m_FrameStats.GpuVisibleCount, m_FrameStats.GpuTestedCount, static_cast<unsigned long long>(m_FrameStats.GpuCullFrame));
+      ImGui::Text("TLAS Instances: %u, Copied: %u", m_FrameStats.TLASInstanceCount, m_FrameStats.TLASCopiedCount);
+      ImGui::Text("Frames In Flight: %u, Pipelined: %s", m_FramesInFlight, IsPipelined() ? "yes" : "no");
+      ImGui::Text("Render: %.2f ms (fence %.2f, record %.2f, submit %.2f)", m_FrameStats.RenderMs, m_FrameStats.FenceWaitMs, m_FrameStats.RecordMs, m_FrameStats.SubmitMs);
+      ImGui::Text("Capture: %.2f ms, GPU: %.2f ms", m_FrameStats.CaptureMs, m_FrameStats.GpuMs);
     }
     ImGui::End();
 
@@ -383,75 +879,97 @@ namespace mau {
       const bool viewport_hovered = ImGui::IsWindowHovered();
       ImGuiContext::Ref().BlockEvents(!viewport_hovered);
 
-      const ImVec2 viewport_size = ImVec2(m_ImGuiViewportWidth, m_ImGuiViewportHeight);
+      // the render thread resizes the viewport images to what was asked for last frame
+      const ImVec2 viewport_size = ImVec2(m_CurrentViewportWidth, m_CurrentViewportHeight);
       ImVec2       avail_size = ImGui::GetContentRegionAvail();
 
-      m_CurrentViewportWidth = static_cast<TUint32>(avail_size.x);
-      m_CurrentViewportHeight = static_cast<TUint32>(avail_size.y);
+      if (!m_Headless) {
+        m_CurrentViewportWidth = static_cast<TUint32>(avail_size.x);
+        m_CurrentViewportHeight = static_cast<TUint32>(avail_size.y);
+      }
 
-      ImGui::Image(imgui_texture_ids[idx], viewport_size);
+      ImGui::Image(IMGUI_VIEWPORT_TEXTURE_ID, viewport_size);
     }
     ImGui::End();
   }
 
   void Renderer::CreateViewportBuffers(TUint32 width, TUint32 height) {
-    sink_color_handles.clear();
-    sink_accum_handles.clear();
-    sink_albedo_handles.clear();
-    sink_normal_handles.clear();
-
-    const VkFormat color_format = VulkanState::Ref().GetSwapchainColorFormat();
-    const VkFormat depth_format = VulkanState::Ref().GetSwapchainDepthFormat();
-    const TUint64  image_count = VulkanState::Ref().GetSwapchainImageViews().size();
+    const TUint64 image_count = VulkanState::Ref().GetSwapchainImageViews().size();
 
-    std::vector<Handle<Resource>> color_images = {};
-    std::vector<Handle<Resource>> depth_images = {};
+    // the accumulation buffer carries over frames, it keeps dedicated memory
     std::vector<Handle<Resource>> accum_images = {};
-    std::vector<Handle<Resource>> albedo_images = {};
-    std::vector<Handle<Resource>> normal_images = {};
-
     for (TUint64 i = 0; i < image_count; i++) {
-      Handle<Image> color =
-          make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
-                             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
-      Handle<ImageView> color_view = make_handle<ImageView>(color, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
-
-      Handle<Image>     depth = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, depth_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
-      Handle<ImageView> depth_view = make_handle<ImageView>(depth, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT);
-
       Handle<Image>     accum = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
                                                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT);
       Handle<ImageView> accum_view = make_handle<ImageView>(accum, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+      accum_images.push_back(make_handle<ImageResource>(accum, accum_view));
+    }
+    sink_accum.AssignResources(accum_images);
+    release_storage_images(sink_accum_handles);
+
+    // everything else is written before it is read in a frame, the graph places it in pooled memory
+    const TransientImageDesc color_desc = {
+        .Width = width,
+        .Height = height,
+        .Format = VK_FORMAT_R32G32B32A32_SFLOAT,
+        .Usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+    };
+    const TransientImageDesc gbuffer_desc = {
+        .Width = width,
+        .Height = height,
+        .Format = VK_FORMAT_R32G32B32A32_SFLOAT,
+        .Usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+    };
+    m_Rendergraph->SetTransient("imgui-viewport-color", color_desc);
+    m_Rendergraph->SetTransient("rt-albedo-buffer", gbuffer_desc);
+    m_Rendergraph->SetTransient("rt-normal-buffer", gbuffer_desc);
 
-      Handle<Image>     alb = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
-                                             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-      Handle<ImageView> alb_view = make_handle<ImageView>(alb, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+    m_GpuCuller->CreatePyramid(width, height);
 
-      Handle<Image>     norm = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
-                                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-      Handle<ImageView> norm_view = make_handle<ImageView>(norm, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+    Denoiser::Ref().AllocateBuffers(width, height);
+  }
 
-      color_images.push_back(make_handle<ImageResource>(color, color_view));
-      depth_images.push_back(make_handle<ImageResource>(depth, depth_view));
-      accum_images.push_back(make_handle<ImageResource>(accum, accum_view));
-      albedo_images.push_back(make_handle<ImageResource>(alb, alb_view));
-      normal_images.push_back(make_handle<ImageResource>(norm, norm_view));
-
-      if (VulkanFeatures::IsRtEnabled()) {
-        sink_color_handles.push_back(VulkanBindless::Ref().AddStorageImage(color_view));
-        sink_accum_handles.push_back(VulkanBindless::Ref().AddStorageImage(accum_view));
-        sink_albedo_handles.push_back(VulkanBindless::Ref().AddStorageImage(alb_view));
-        sink_normal_handles.push_back(VulkanBindless::Ref().AddStorageImage(norm_view));
+  bool Renderer::BuildRenderGraph() {
+    std::vector<Sink> sinks = {sink_accum, m_GpuCuller->GetCommandsSink(), m_GpuCuller->GetCountsSink(), m_GpuCuller->GetPyramidSink()};
+    if (!m_Rendergraph->Build(sinks))
+      throw GraphicsException("failed to build render graph");
+
+    // images kept by the transient pool keep their bindless slots
+    const bool rebind = m_Rendergraph->GetTransientStats().CreatedImages > 0u || sink_accum_handles.empty();
+    if (!rebind)
+      return false;
+
+    release_storage_images(sink_color_handles);
+    release_storage_images(sink_accum_handles);
+    release_storage_images(sink_albedo_handles);
+    release_storage_images(sink_normal_handles);
+
+    // the depth pyramid reads the raster depth, ray tracing writes the viewport images
+    const TUint32 image_count = static_cast<TUint32>(VulkanState::Ref().GetSwapchainImageViews().size());
+    if (!VulkanFeatures::IsRtEnabled()) {
+      Vector<Handle<ImageView>> depth_views = {};
+      VkSampleCountFlagBits     depth_samples = VK_SAMPLE_COUNT_1_BIT;
+      for (TUint32 i = 0; i < image_count; i++) {
+        Handle<ImageResource> depth = m_Rendergraph->GetResource("lambertian-msaa-depth", i);
+        depth_views.push_back(depth->GetImageView());
+        depth_samples = depth->GetImage()->GetSamples();
+      }
+      m_GpuCuller->BindDepth(depth_views, depth_samples);
+    } else {
+      for (TUint32 i = 0; i < image_count; i++) {
+        Handle<ImageResource> color = m_Rendergraph->GetResource("imgui-viewport-color", i);
+        Handle<ImageResource> accum = sink_accum.GetResource(i);
+        Handle<ImageResource> albedo = m_Rendergraph->GetResource("rt-albedo-buffer", i);
+        Handle<ImageResource> normal = m_Rendergraph->GetResource("rt-normal-buffer", i);
+
+        sink_color_handles.push_back(VulkanBindless::Ref().AddStorageImage(color->GetImageView()));
+        sink_accum_handles.push_back(VulkanBindless::Ref().AddStorageImage(accum->GetImageView()));
+        sink_albedo_handles.push_back(VulkanBindless::Ref().AddStorageImage(albedo->GetImageView()));
+        sink_normal_handles.push_back(VulkanBindless::Ref().AddStorageImage(normal->GetImageView()));
       }
     }
 
-    sink_color.AssignResources(color_images);
-    sink_depth.AssignResources(depth_images);
-    sink_accum.AssignResources(accum_images);
-    sink_albedo.AssignResources(albedo_images);
-    sink_normal.AssignResources(normal_images);
-
-    Denoiser::Ref().AllocateBuffers(width, height);
+    return true;
   }
 
   void Renderer::CreateImguiTextures() {
@@ -463,7 +981,7 @@ namespace mau {
     imgui_texture_ids.clear();
 
     for (TUint64 i = 0; i < image_count; i++) {
-      Handle<ImageResource> resource = sink_color.GetResource(i);
+      Handle<ImageResource> resource = m_Rendergraph->GetResource("imgui-viewport-color", static_cast<TUint32>(i));
 
       ImTextureID texture_id = ImGui_ImplVulkan_AddTexture(sampler.Get(), resource->GetImageView()->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
       imgui_texture_ids.push_back(reinterpret_cast<void *>(texture_id));
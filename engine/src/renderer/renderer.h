@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <glm/glm.hpp>
 
 #include <engine/types.h>
@@ -14,11 +19,19 @@
 #include "graphics/vulkan-image.h"
 #include "graphics/vulkan-buffers.h"
 #include "graphics/vulkan-push-constant.h"
+#include "graphics/vulkan-query.h"
 #include "scene/mesh.h"
 #include "scene/camera.h"
 
+#include "renderer/frame-snapshot.h"
+#include "renderer/frustum-culler.h"
+#include "renderer/gpu-culler.h"
+#include "renderer/indirect-draw-list.h"
+#include "renderer/lod-selector.h"
+#include "renderer/parallel-recorder.h"
 #include "renderer/rendergraph/graph.h"
 #include "renderer/rendergraph/sink.h"
+#include "renderer/shader-reloader.h"
 
 namespace mau {
 
@@ -34,10 +47,12 @@ namespace mau {
     TUint32 accum_image_index;
     TUint32 albedo_image_index;
     TUint32 normal_image_index;
-    TUint32 pad1;
+    TUint32 tlas_index;
 
     glm::vec4 dir_light_color;
     glm::vec4 dir_light_direction;
+
+    TUint64 draw_data_address;
   };
 
   struct CameraBuffer {
@@ -48,46 +63,117 @@ namespace mau {
 
   class Renderer: public Singleton<Renderer> {
     friend class Singleton<Renderer>;
-    Renderer(void *window_ptr);
+    Renderer(void *window_ptr, TUint32 frames_in_flight);
     ~Renderer();
 
   public:
     void StartFrame();
+    // captures the frame and hands it to the render thread, with a single frame in flight it is rendered right away
     void EndFrame();
+    // blocks until the render thread submitted the last frame, rethrows what it threw
+    void WaitFrame();
+    // builds and uploads the draw list, true when the raster pass should be recorded with RenderParallel
+    bool PrepareRender(TUint32 frame_index);
+    // culls the uploaded draw list on the gpu, nothing is recorded when the cpu culled it
+    void RenderCull(Handle<CommandBuffer> cmd, TUint32 frame_index);
+    void RenderDepthPyramid(Handle<CommandBuffer> cmd, TUint32 frame_index);
     void Render(Handle<CommandBuffer> cmd, TUint32 frame_index);
+    void RenderParallel(Handle<CommandBuffer> cmd, TUint32 frame_index, const VkCommandBufferInheritanceInfo &inheritance, const VkViewport &viewport, const VkRect2D &scissor);
     void RenderRT(Handle<CommandBuffer> cmd, TUint32 frame_index);
     void SubmitScene(Handle<Scene> scene) { m_DrawScene = scene; }
 
+    // only valid while a frame is recorded
+    inline ImDrawData *GetImGuiDrawData() { return m_Frame ? m_Frame->ImGui.Get() : nullptr; }
+    inline bool        IsDenoising() const { return m_Frame && m_Frame->HasScene && m_Frame->EnableDenoiser; }
+    inline bool        IsGpuCulling() const { return m_Frame && m_Frame->EnableGpuCulling && m_Frame->EnableIndirectDraw && m_GpuCullingSupported; }
+    inline bool        IsRecordingParallel() const { return m_RecordParallel; }
+    // stats of the last submitted frame, main thread only
+    inline const FrameStats &GetFrameStats() const { return m_FrameStats; }
+    inline bool              IsPipelined() const { return m_RenderThread.joinable(); }
+    inline TUint32           GetFramesInFlight() const { return m_FramesInFlight; }
+    inline TUint32           GetImageCount() const { return static_cast<TUint32>(m_CommandBuffers.size()); }
+    // time the constructor spent loading shaders and creating pipelines, compare runs with and without cache files
+    inline TFloat64 GetShaderLoadMs() const { return m_ShaderLoadMs; }
+    inline TFloat64 GetPipelineCreateMs() const { return m_PipelineCreateMs; }
+
+    // replaces the camera the next captured frame is drawn with, input still moves it afterwards
+    void SetCamera(const Camera &camera);
+
+    // raster path state, for recording outside a frame while the render thread is idle
+    inline const Handle<Pipeline>                       &GetRasterPipeline() const { return m_Pipeline; }
+    inline const Handle<Renderpass>                     &GetRasterRenderpass() const { return m_RasterRenderpass; }
+    inline const Handle<PushConstant<VertexShaderData>> &GetPushConstant() const { return m_PushConstant; }
+    inline const Handle<ParallelDrawRecorder>           &GetRecorder() const { return m_Recorder; }
+
   private:
+    void CaptureFrame(FrameSnapshot &frame);
+    // main thread while the render thread is idle, the geometry arena, the texture streamer and the upload ring are
+    // only advanced here
+    void UpdateResources();
+    void RenderFrame(FrameSnapshot &frame);
+    void RenderLoop(std::stop_token stop_token);
     void RecordCommandBuffer(TUint64 idx);
-    void ImGuiTest(TUint32 idx);
+    void ImGuiTest();
     void CreateViewportBuffers(TUint32 width, TUint32 height);
+    // true when the viewport images changed and their bindless slots and imgui textures have to follow
+    bool BuildRenderGraph();
     void CreateImguiTextures();
     void UpdateCamera();
+    // render thread, before the bindless update. grows the scene tlas when the instances outgrew it
+    void UpdateSceneTLAS(FrameSnapshot &frame);
 
   public:
     bool EnableDenoiser = false;
+    bool EnableIndirectDraw = true;
+    bool EnableParallelRecording = true;
+    bool EnableFrustumCulling = true;
+    bool EnableGpuCulling = true;
+    bool EnableOcclusionCulling = true;
+    bool EnableLod = true;
+    // largest error in pixels a level of detail may show
+    TFloat32 LodErrorPixels = 1.0f;
 
   private:
     TUint64    m_CurrentFrame = 0u;
+    TUint32    m_FramesInFlight = 1u;
     VkExtent2D m_Extent = {};
+    bool       m_Headless = false;
+    TFloat64   m_ShaderLoadMs = 0.0;
+    TFloat64   m_PipelineCreateMs = 0.0;
 
-    Handle<VertexShader>               m_VertexShader = nullptr;
-    Handle<FragmentShader>             m_FragmentShader = nullptr;
     Handle<Pipeline>                   m_Pipeline = nullptr;
+    Handle<Renderpass>                 m_RasterRenderpass = nullptr;
+    Handle<IndirectDrawList>           m_DrawList = nullptr;
+    Handle<ParallelDrawRecorder>       m_Recorder = nullptr;
+    Handle<FrustumCuller>              m_Culler = nullptr;
+    Vector<TUint32>                    m_VisibleDraws = {}; // render thread, indices into the snapshot draws
+    Handle<LodSelector>                m_LodSelector = nullptr;
+    Vector<TUint8>                     m_DrawLevels = {}; // render thread, [snapshot draw]
+    Handle<GpuCuller>                  m_GpuCuller = nullptr;
+    Handle<ComputePipeline>            m_CullPipeline = nullptr;
+    Handle<ComputePipeline>            m_DepthPyramidPipeline = nullptr;
+    bool                               m_GpuCullingSupported = false;
+    bool                               m_RecordParallel = false;
     std::vector<Handle<CommandBuffer>> m_CommandBuffers = {};
-    std::vector<Handle<Semaphore>>     m_ImageAvailable = {};
-    std::vector<Handle<Semaphore>>     m_RenderFinished = {};
-    std::vector<Handle<Fence>>         m_QueueSubmit = {};
+    std::vector<Handle<Semaphore>>     m_ImageAvailable = {}; // [frame]
+    std::vector<Handle<Fence>>         m_QueueSubmit = {};    // [frame]
+    std::vector<Handle<Semaphore>>     m_RenderFinished = {}; // [image]
+    std::vector<Handle<Fence>>         m_ImagesInFlight = {}; // [image], fence of the frame that last rendered to it
 
     // rt
-    Handle<RTClosestHitShader> m_RTCHit = nullptr;
-    Handle<RTMissShader>       m_RTMiss = nullptr;
-    Handle<RTRayGenShader>     m_RTGen = nullptr;
-    Handle<RTPipeline>         m_RTPipeline = nullptr;
+    Handle<RTPipeline> m_RTPipeline = nullptr;
+
+    // one tlas for the whole scene, instances are keyed by entity and submesh and only changed records are uploaded.
+    // render thread only
+    Handle<TopLevelAS>          m_SceneTLAS = nullptr;
+    AccelerationStructureHandle m_SceneTLASHandle = UINT32_MAX;
+    TLASInstanceTable           m_TLASInstances = {};
 
     Handle<RenderGraph> m_Rendergraph = nullptr;
 
+    // replaces m_Pipeline, m_RTPipeline and the compute pipelines when their shaders change, declared after them so it goes first
+    Handle<ShaderReloader> m_ShaderReloader = nullptr;
+
     // temp
     Handle<Scene>                                 m_DrawScene = nullptr;
     Handle<PushConstant<VertexShaderData>>        m_PushConstant = nullptr;
@@ -95,11 +181,7 @@ namespace mau {
     BufferHandle                                  m_CameraBufferHandle = 0u;
     std::vector<bool>                             m_ClearAccumFlag = {};
 
-    Sink                     sink_color = Sink("imgui-viewport-color");
-    Sink                     sink_depth = Sink("imgui-viewport-depth");
     Sink                     sink_accum = Sink("rt-accum-buffer");
-    Sink                     sink_albedo = Sink("rt-albedo-buffer");
-    Sink                     sink_normal = Sink("rt-normal-buffer");
     Sampler                  sampler;
     std::vector<void *>      imgui_texture_ids = {};
     std::vector<ImageHandle> sink_color_handles = {};
@@ -107,13 +189,37 @@ namespace mau {
     std::vector<ImageHandle> sink_albedo_handles = {};
     std::vector<ImageHandle> sink_normal_handles = {};
 
-    Camera m_Camera;
+    // main thread state, copied into a snapshot every frame
+    Camera     m_Camera;
+    glm::vec4  m_DirLightColor = glm::vec4(1.0f, 1.0f, 1.0f, 24.0f);
+    glm::vec4  m_DirLightDirection = glm::vec4(-0.138, 0.924, -0.356, 0.0f);
+    bool       m_ClearAccum = true;
+    FrameStats m_FrameStats = {};
+    TUint64    m_FrameNumber = 0u;
+
+    // gpu time of every swapchain image's command buffer and the frame that last recorded it, render thread only
+    Handle<TimestampQueryPool> m_GpuTimestamps = nullptr;
+    Vector<TUint64>            m_TimestampFrames = {};
 
+    // size of the viewport images, render thread only
     TUint32 m_ImGuiViewportWidth = 800u;
     TUint32 m_ImGuiViewportHeight = 600u;
 
+    // size the viewport window asks for, main thread only
     TUint32 m_CurrentViewportWidth = 800u;
     TUint32 m_CurrentViewportHeight = 600u;
+
+    // frame pipelining, the main thread captures one snapshot while the render thread draws the other
+    std::array<FrameSnapshot, 2u> m_Snapshots = {};
+    TUint32                       m_SnapshotIndex = 0u;
+    FrameSnapshot                *m_Frame = nullptr;
+
+    std::jthread                m_RenderThread = {};
+    std::mutex                  m_RenderMutex = {};
+    std::condition_variable_any m_RenderStart = {};
+    std::condition_variable     m_RenderDone = {};
+    FrameSnapshot              *m_PendingFrame = nullptr;
+    std::exception_ptr          m_RenderError = nullptr;
   };
 
 } // namespace mau
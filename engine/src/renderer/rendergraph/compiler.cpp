@@ -0,0 +1,468 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace mau {
+
+  static constexpr TUint32 NO_PASS = UINT32_MAX;
+
+  // a graph resource or the sink of a pass, sinks are resolved to the graph resource they hand on
+  struct GraphName {
+    TUint32 Resource = UINT32_MAX;
+    TUint32 Producer = NO_PASS;
+    String  Source = "";
+  };
+
+  // what the accesses since the last write left behind. visible is what the last write was already made visible to
+  struct ResourceState {
+    VkImageLayout        Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags WriteStages = 0u;
+    VkAccessFlags        WriteAccess = 0u;
+    VkPipelineStageFlags ReadStages = 0u;
+    VkPipelineStageFlags VisibleStages = 0u;
+    VkAccessFlags        VisibleAccess = 0u;
+  };
+
+  // one access per resource and pass, usage none only keeps the pass ordered after the producer
+  struct PassAccess {
+    TUint32       Resource = 0u;
+    ResourceUsage Usage = ResourceUsage::NONE;
+  };
+
+  static ResourceState initial_state(const GraphResourceDesc &desc) {
+    ResourceState state = {};
+    if (desc.Initial == ResourceUsage::NONE)
+      return state;
+
+    const ResourceUsageInfo &info = GetResourceUsageInfo(desc.Initial);
+    state.Layout = desc.Type != ResourceType::BUFFER ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    if (info.Write) {
+      state.WriteStages = info.Stages;
+      state.WriteAccess = info.Access & RESOURCE_WRITE_ACCESS;
+    } else {
+      state.ReadStages = info.Stages;
+    }
+
+    return state;
+  }
+
+  // moves the resource into the usage, with a barrier when it has to wait for earlier accesses or change layout
+  static void apply_access(ResourceState &state, TUint32 resource, ResourceType type, ResourceUsage usage, Vector<GraphBarrier> *barriers) {
+    if (usage == ResourceUsage::NONE)
+      return;
+
+    const ResourceUsageInfo &info = GetResourceUsageInfo(usage);
+    const bool               image = type != ResourceType::BUFFER;
+    const VkImageLayout      layout = image ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    const bool               transition = layout != state.Layout;
+
+    GraphBarrier barrier = {
+        .Resource = resource,
+        .Type = type,
+        .DstStages = info.Stages,
+        .DstAccess = info.Access,
+        .OldLayout = state.Layout,
+        .NewLayout = layout,
+    };
+    bool needed = false;
+
+    if (info.Write || transition) {
+      // writes and transitions wait for every access since the last write, earlier reads only have to finish
+      barrier.SrcStages = state.WriteStages | state.ReadStages;
+      barrier.SrcAccess = state.WriteAccess;
+      needed = transition || barrier.SrcStages != 0u;
+
+      if (transition && info.Discard)
+        barrier.OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      if (info.Write) {
+        state.WriteStages = info.Stages;
+        state.WriteAccess = info.Access & RESOURCE_WRITE_ACCESS;
+        state.ReadStages = 0u;
+        state.VisibleStages = 0u;
+        state.VisibleAccess = 0u;
+      } else {
+        // later reads in other stages have to wait for the transition
+        state.WriteStages = info.Stages;
+        state.WriteAccess = 0u;
+        state.ReadStages = info.Stages;
+        state.VisibleStages = info.Stages;
+        state.VisibleAccess = info.Access;
+      }
+    } else {
+      // reads in the same layout wait for the last write once per stage and access
+      if (state.WriteStages != 0u && ((info.Stages & ~state.VisibleStages) != 0u || (info.Access & ~state.VisibleAccess) != 0u)) {
+        barrier.SrcStages = state.WriteStages;
+        barrier.SrcAccess = state.WriteAccess;
+        needed = true;
+
+        state.VisibleStages |= info.Stages;
+        state.VisibleAccess |= info.Access;
+      }
+      state.ReadStages |= info.Stages;
+    }
+
+    if (needed && barriers) {
+      if (barrier.SrcStages == 0u)
+        barrier.SrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+      barriers->push_back(barrier);
+    }
+
+    state.Layout = layout;
+  }
+
+  // kahn's algorithm, of all passes ready to run the one added first goes next so graphs that are in order stay so
+  static bool sort_passes(const Vector<bool> &include, const Vector<Vector<TUint32>> &successors, Vector<TUint32> &order) {
+    const TUint32   pass_count = static_cast<TUint32>(include.size());
+    Vector<TUint32> incoming(pass_count, 0u);
+    TUint32         included = 0u;
+
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      if (!include[p])
+        continue;
+      included++;
+      for (TUint32 s : successors[p]) {
+        if (include[s])
+          incoming[s]++;
+      }
+    }
+
+    std::priority_queue<TUint32, Vector<TUint32>, std::greater<TUint32>> ready;
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      if (include[p] && incoming[p] == 0u)
+        ready.push(p);
+    }
+
+    order.clear();
+    while (!ready.empty()) {
+      const TUint32 p = ready.top();
+      ready.pop();
+      order.push_back(p);
+
+      for (TUint32 s : successors[p]) {
+        if (include[s] && --incoming[s] == 0u)
+          ready.push(s);
+      }
+    }
+
+    return order.size() == included;
+  }
+
+  static void add_edge(Vector<Vector<TUint32>> &successors, TUint32 from, TUint32 to) {
+    if (from != NO_PASS && from != to)
+      successors[from].push_back(to);
+  }
+
+  static bool lifetimes_overlap(const GraphPlacement &a, const GraphPlacement &b) {
+    return a.FirstUse != UINT32_MAX && b.FirstUse != UINT32_MAX && a.FirstUse <= b.LastUse && b.FirstUse <= a.LastUse;
+  }
+
+  static TUint64 align_up(TUint64 value, TUint64 alignment) { return (value + alignment - 1u) / alignment * alignment; }
+
+  // largest first, every transient resource goes to the lowest offset of its heap that is not taken by one alive at
+  // the same time
+  static void place_transients(const Vector<GraphResourceDesc> &resources, CompiledGraph &result) {
+    Vector<TUint32> transients = {};
+    for (TUint32 r = 0u; r < resources.size(); r++) {
+      if (resources[r].Transient)
+        transients.push_back(r);
+    }
+
+    std::stable_sort(transients.begin(), transients.end(), [&](TUint32 a, TUint32 b) -> bool { return resources[a].Size > resources[b].Size; });
+
+    Vector<TUint32>                      placed = {};
+    Vector<std::pair<TUint64, TUint64>> taken = {};
+    for (TUint32 r : transients) {
+      GraphPlacement &placement = result.Placements[r];
+      const TUint64   size = resources[r].Size;
+      const TUint64   alignment = std::max<TUint64>(resources[r].Alignment, 1u);
+
+      taken.clear();
+      for (TUint32 other : placed) {
+        const GraphPlacement &other_placement = result.Placements[other];
+        if (other_placement.Heap == placement.Heap && lifetimes_overlap(placement, other_placement))
+          taken.push_back(std::make_pair(other_placement.Offset, other_placement.Offset + resources[other].Size));
+      }
+      std::sort(taken.begin(), taken.end());
+
+      TUint64 offset = 0u;
+      for (const auto &range : taken) {
+        if (range.second <= offset)
+          continue;
+        if (offset + size <= range.first)
+          break;
+        offset = align_up(range.second, alignment);
+      }
+
+      placement.Offset = offset;
+      placed.push_back(r);
+
+      if (result.HeapSizes.size() <= placement.Heap)
+        result.HeapSizes.resize(placement.Heap + 1u, 0u);
+      result.HeapSizes[placement.Heap] = std::max(result.HeapSizes[placement.Heap], offset + size);
+      result.UnaliasedSize += size;
+    }
+
+    for (TUint64 size : result.HeapSizes) {
+      result.TransientSize += size;
+    }
+  }
+
+  // a transient resource starts undefined, after everything its memory was used for: by the resources it overlaps,
+  // earlier in this run or later in the last one, and by itself in the last run
+  static void begin_transient(Vector<ResourceState> &states, TUint32 resource, const Vector<TUint32> &aliases) {
+    ResourceState state = {
+        .WriteStages = states[resource].WriteStages,
+        .WriteAccess = states[resource].WriteAccess,
+        .ReadStages = states[resource].ReadStages,
+    };
+
+    for (TUint32 alias : aliases) {
+      state.WriteStages |= states[alias].WriteStages;
+      state.WriteAccess |= states[alias].WriteAccess;
+      state.ReadStages |= states[alias].ReadStages;
+    }
+
+    states[resource] = state;
+  }
+
+  bool RenderGraphCompiler::Compile(const Vector<GraphResourceDesc> &resources, const Vector<GraphPassDesc> &passes, const Vector<String> &outputs, CompiledGraph &result) {
+    result = {};
+
+    const TUint32 resource_count = static_cast<TUint32>(resources.size());
+    const TUint32 pass_count = static_cast<TUint32>(passes.size());
+
+    // collect every name, graph resources first
+    UnorderedMap<String, GraphName> names = {};
+    for (TUint32 r = 0u; r < resource_count; r++) {
+      if (!names.insert(std::make_pair(resources[r].Name, GraphName{.Resource = r})).second) {
+        result.Error = "resource [" + resources[r].Name + "] is declared twice";
+        return false;
+      }
+      if (resources[r].Transient && (resources[r].Initial != ResourceUsage::NONE || resources[r].Final != ResourceUsage::NONE)) {
+        result.Error = "transient resource [" + resources[r].Name + "] cannot be handed over outside the graph";
+        return false;
+      }
+    }
+
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      for (const GraphAccess &access : passes[p].Accesses) {
+        if (access.Sink.empty())
+          continue;
+
+        if (!names.insert(std::make_pair(access.Sink, GraphName{.Producer = p, .Source = access.Source})).second) {
+          result.Error = "sink [" + access.Sink + "] of pass [" + passes[p].Name + "] already exists";
+          return false;
+        }
+      }
+    }
+
+    // follow sinks back to the resource they hand on
+    for (auto &name : names) {
+      const GraphName *current = &name.second;
+      for (size_t step = 0u; current->Resource == UINT32_MAX; step++) {
+        auto it = names.find(current->Source);
+        if (it == names.end() || step > names.size()) {
+          result.Error = "cannot find source [" + current->Source + "] of pass [" + passes[current->Producer].Name + "]";
+          return false;
+        }
+        current = &it->second;
+      }
+      name.second.Resource = current->Resource;
+    }
+
+    for (const auto &name : names) {
+      result.Resources.insert(std::make_pair(name.first, name.second.Resource));
+    }
+
+    // one access per resource and pass
+    Vector<Vector<PassAccess>> pass_accesses(pass_count);
+    Vector<Vector<TUint32>>    data_successors(pass_count);
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      for (const GraphAccess &access : passes[p].Accesses) {
+        auto it = names.find(access.Source);
+        if (it == names.end()) {
+          result.Error = "cannot find source [" + access.Source + "] of pass [" + passes[p].Name + "]";
+          return false;
+        }
+
+        add_edge(data_successors, it->second.Producer, p);
+
+        Vector<PassAccess> &accesses = pass_accesses[p];
+        auto                existing = std::find_if(accesses.begin(), accesses.end(), [&](const PassAccess &other) -> bool { return other.Resource == it->second.Resource; });
+        if (existing == accesses.end()) {
+          accesses.push_back({.Resource = it->second.Resource, .Usage = access.Usage});
+        } else if (existing->Usage == ResourceUsage::NONE) {
+          existing->Usage = access.Usage;
+        } else if (access.Usage != ResourceUsage::NONE && access.Usage != existing->Usage) {
+          result.Error = "pass [" + passes[p].Name + "] uses resource [" + resources[existing->Resource].Name + "] as " + GetResourceUsageName(existing->Usage) + " and " +
+                         GetResourceUsageName(access.Usage);
+          return false;
+        }
+      }
+    }
+
+    // build order, producers before the passes using their sinks
+    if (!sort_passes(Vector<bool>(pass_count, true), data_successors, result.BuildOrder)) {
+      result.Error = "passes use each other's sinks in a cycle";
+      return false;
+    }
+
+    // keep what the outputs need, walking back from their producers
+    Vector<bool>    kept(pass_count, false);
+    Vector<TUint32> stack = {};
+    for (const String &output : outputs) {
+      auto it = names.find(output);
+      if (it == names.end()) {
+        result.Error = "cannot find output [" + output + "]";
+        return false;
+      }
+      if (it->second.Producer != NO_PASS)
+        stack.push_back(it->second.Producer);
+    }
+
+    Vector<Vector<TUint32>> predecessors(pass_count);
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      for (TUint32 s : data_successors[p]) {
+        predecessors[s].push_back(p);
+      }
+    }
+
+    while (!stack.empty()) {
+      const TUint32 p = stack.back();
+      stack.pop_back();
+      if (kept[p])
+        continue;
+
+      kept[p] = true;
+      for (TUint32 producer : predecessors[p]) {
+        stack.push_back(producer);
+      }
+    }
+
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      if (!kept[p])
+        result.Culled.push_back(p);
+    }
+
+    // a name is written by one pass, after everything else that reads it
+    Vector<Vector<TUint32>>       successors = data_successors;
+    UnorderedMap<String, TUint32> writers = {};
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      if (!kept[p])
+        continue;
+
+      for (const GraphAccess &access : passes[p].Accesses) {
+        if (access.Usage == ResourceUsage::NONE || !GetResourceUsageInfo(access.Usage).Write)
+          continue;
+
+        auto writer = writers.insert(std::make_pair(access.Source, p));
+        if (!writer.second && writer.first->second != p) {
+          result.Error = "[" + access.Source + "] is written by passes [" + passes[writer.first->second].Name + "] and [" + passes[p].Name + "]";
+          return false;
+        }
+      }
+    }
+
+    for (TUint32 p = 0u; p < pass_count; p++) {
+      if (!kept[p])
+        continue;
+
+      for (const GraphAccess &access : passes[p].Accesses) {
+        auto writer = writers.find(access.Source);
+        if (writer != writers.end())
+          add_edge(successors, p, writer->second);
+      }
+    }
+
+    Vector<TUint32> order = {};
+    if (!sort_passes(kept, successors, order)) {
+      result.Error = "passes read and write each other's resources in a cycle";
+      return false;
+    }
+
+    for (TUint32 p : order) {
+      result.Passes.push_back({.Pass = p});
+    }
+
+    // transient resources live from their first to their last use and must be written before they are read
+    result.Placements.resize(resource_count);
+    for (TUint32 r = 0u; r < resource_count; r++) {
+      result.Placements[r].Heap = resources[r].Heap;
+    }
+
+    for (TUint32 i = 0u; i < order.size(); i++) {
+      for (const PassAccess &access : pass_accesses[order[i]]) {
+        GraphPlacement &placement = result.Placements[access.Resource];
+        if (!resources[access.Resource].Transient || access.Usage == ResourceUsage::NONE)
+          continue;
+
+        if (placement.FirstUse == UINT32_MAX) {
+          if (!GetResourceUsageInfo(access.Usage).Write) {
+            result.Error = "transient resource [" + resources[access.Resource].Name + "] is read by pass [" + passes[order[i]].Name + "] before it is written";
+            return false;
+          }
+          placement.FirstUse = i;
+        }
+        placement.LastUse = i;
+      }
+    }
+
+    place_transients(resources, result);
+
+    // transient resources sharing memory, the ones used first have to be done before the others start
+    Vector<Vector<TUint32>> aliases(resource_count);
+    for (TUint32 a = 0u; a < resource_count; a++) {
+      for (TUint32 b = a + 1u; b < resource_count; b++) {
+        const GraphPlacement &pa = result.Placements[a];
+        const GraphPlacement &pb = result.Placements[b];
+        if (!resources[a].Transient || !resources[b].Transient || pa.Heap != pb.Heap || pa.FirstUse == UINT32_MAX || pb.FirstUse == UINT32_MAX)
+          continue;
+
+        if (pa.Offset < pb.Offset + resources[b].Size && pb.Offset < pa.Offset + resources[a].Size) {
+          aliases[a].push_back(b);
+          aliases[b].push_back(a);
+        }
+      }
+    }
+
+    // the first run starts with every carried over resource undefined. every later run starts where the one before
+    // left off, which is the same state each time: after a write nothing from before is left, and reads only add
+    // stages that are already there the second time
+    Vector<ResourceState> states(resource_count);
+    for (TUint32 r = 0u; r < resource_count; r++) {
+      states[r] = initial_state(resources[r]);
+    }
+
+    for (TUint32 run = 0u; run < 2u; run++) {
+      const bool first = run == 0u;
+
+      for (TUint32 i = 0u; i < result.Passes.size(); i++) {
+        CompiledPass &compiled = result.Passes[i];
+        for (const PassAccess &access : pass_accesses[compiled.Pass]) {
+          if (resources[access.Resource].Transient && result.Placements[access.Resource].FirstUse == i)
+            begin_transient(states, access.Resource, aliases[access.Resource]);
+          apply_access(states[access.Resource], access.Resource, resources[access.Resource].Type, access.Usage, first ? &compiled.FirstBarriers : &compiled.Barriers);
+        }
+      }
+
+      for (TUint32 r = 0u; r < resource_count; r++) {
+        apply_access(states[r], r, resources[r].Type, resources[r].Final, first ? &result.FirstFinalBarriers : &result.FinalBarriers);
+
+        // handed over outside the graph, it comes back as it did the first time
+        if (resources[r].Initial != ResourceUsage::NONE)
+          states[r] = initial_state(resources[r]);
+      }
+    }
+
+    for (const CompiledPass &compiled : result.Passes) {
+      result.BarrierCount += static_cast<TUint32>(compiled.Barriers.size());
+    }
+    result.BarrierCount += static_cast<TUint32>(result.FinalBarriers.size());
+
+    return true;
+  }
+
+} // namespace mau
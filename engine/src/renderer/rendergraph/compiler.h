@@ -0,0 +1,98 @@
+#pragma once
+
+#include <engine/types.h>
+#include "usage.h"
+
+namespace mau {
+
+  // a resource the graph does not produce itself, like the backbuffer or the viewport images. initial is the access
+  // that touched it before the graph runs, none means it lives across frames and is in the state the graph left it
+  // in last time. final is the access the graph leaves it ready for, none leaves it as the last pass did
+  // transient resources are undefined at the start of every run and only live from their first to their last use.
+  // they are placed in shared memory, resources of the same heap that are never alive at the same time overlap
+  struct GraphResourceDesc {
+    String        Name = "";
+    ResourceType  Type = ResourceType::IMAGE;
+    ResourceUsage Initial = ResourceUsage::NONE;
+    ResourceUsage Final = ResourceUsage::NONE;
+    bool          Transient = false;
+    TUint32       Heap = 0u;
+    TUint64       Size = 0u;
+    TUint64       Alignment = 1u;
+  };
+
+  // a pass reads or writes the resource behind source. a non empty sink hands the resource on under that name, passes
+  // that use the sink run after this one. a resource name is written by one pass at most, and after every other
+  // pass that reads it
+  struct GraphAccess {
+    String        Source = "";
+    String        Sink = "";
+    ResourceUsage Usage = ResourceUsage::NONE;
+  };
+
+  struct GraphPassDesc {
+    String              Name = "";
+    Vector<GraphAccess> Accesses = {};
+  };
+
+  // one image or buffer barrier
+  struct GraphBarrier {
+    TUint32              Resource = 0u;
+    ResourceType         Type = ResourceType::IMAGE;
+    VkPipelineStageFlags SrcStages = 0u;
+    VkPipelineStageFlags DstStages = 0u;
+    VkAccessFlags        SrcAccess = 0u;
+    VkAccessFlags        DstAccess = 0u;
+    VkImageLayout        OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout        NewLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  };
+
+  // resources carried over between runs are undefined the first time the graph runs for a frame, so that run gets
+  // barriers of its own
+  struct CompiledPass {
+    TUint32              Pass = 0u;
+    Vector<GraphBarrier> Barriers = {};
+    Vector<GraphBarrier> FirstBarriers = {};
+  };
+
+  // first and last use are positions in the compiled passes, a transient resource no kept pass uses has none and
+  // may overlap anything
+  struct GraphPlacement {
+    TUint32 Heap = 0u;
+    TUint64 Offset = 0u;
+    TUint32 FirstUse = UINT32_MAX;
+    TUint32 LastUse = 0u;
+  };
+
+  struct CompiledGraph {
+    // passes in execution order, culled passes are left out
+    Vector<CompiledPass> Passes = {};
+    Vector<TUint32>      Culled = {};
+    // every pass including the culled ones, a pass comes after the passes whose sinks it uses
+    Vector<TUint32> BuildOrder = {};
+    // recorded after the last pass, moves resources into their final usage
+    Vector<GraphBarrier> FinalBarriers = {};
+    Vector<GraphBarrier> FirstFinalBarriers = {};
+    // barriers of every run but the first
+    TUint32 BarrierCount = 0u;
+    // graph resource behind every name, sinks resolve to the resource they hand on
+    UnorderedMap<String, TUint32> Resources = {};
+    // by resource, only transient resources are placed
+    Vector<GraphPlacement> Placements = {};
+    // bytes each heap needs for one run, their sum and what the transient resources take without overlapping
+    Vector<TUint64> HeapSizes = {};
+    TUint64         TransientSize = 0u;
+    TUint64         UnaliasedSize = 0u;
+    String          Error = "";
+  };
+
+  // orders passes by what they read and write, culls the ones whose results are never used and places the barriers
+  // between them. works on names and usages only, so graphs can be compiled and checked without a device
+  class RenderGraphCompiler {
+  public:
+    // outputs are the names that must be produced. false when a name is missing, written twice, a transient resource
+    // is read before it is written or the passes depend on each other in a cycle, the reason is in the error of the result
+    static bool Compile(const Vector<GraphResourceDesc> &resources, const Vector<GraphPassDesc> &passes, const Vector<String> &outputs, CompiledGraph &result);
+  };
+
+} // namespace mau
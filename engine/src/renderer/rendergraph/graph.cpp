@@ -1,19 +1,91 @@
 #include "graph.h"
 
+#include <algorithm>
+#include <engine/log.h>
+
 #include "graphics/vulkan-state.h"
 
 namespace mau {
 
-  RenderGraph::RenderGraph() { }
+  static VkImageAspectFlags image_aspect(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_D32_SFLOAT:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+      return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+      return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+      return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+  }
+
+  // fills in what the description takes from its reference, one of the first resolved_count transient images or a
+  // global resource
+  static bool resolve_transient(TransientImageDesc &desc, const Vector<TransientImage> &transients, size_t resolved_count, const UnorderedMap<String, Sink> &sinks) {
+    if (!desc.Reference.empty()) {
+      TUint32  width = 0u;
+      TUint32  height = 0u;
+      VkFormat format = VK_FORMAT_UNDEFINED;
+
+      auto resolved_end = transients.begin() + resolved_count;
+      auto transient = std::find_if(transients.begin(), resolved_end, [&](const TransientImage &other) -> bool { return other.Name == desc.Reference; });
+      auto sink = sinks.find(desc.Reference);
+      if (transient != resolved_end) {
+        width = transient->Desc.Width;
+        height = transient->Desc.Height;
+        format = transient->Desc.Format;
+      } else if (sink != sinks.end()) {
+        Handle<ImageResource> image = sink->second.GetResource(0u);
+        if (!image)
+          return false;
+        width = image->GetImage()->GetWidth();
+        height = image->GetImage()->GetHeight();
+        format = image->GetImage()->GetFormat();
+      } else {
+        return false;
+      }
+
+      desc.Width = desc.Width == 0u ? width : desc.Width;
+      desc.Height = desc.Height == 0u ? height : desc.Height;
+      desc.Format = desc.Format == VK_FORMAT_UNDEFINED ? format : desc.Format;
+      desc.Reference = "";
+    }
+
+    return desc.Width > 0u && desc.Height > 0u && desc.Format != VK_FORMAT_UNDEFINED && desc.Usage != 0u;
+  }
+
+  RenderGraph::RenderGraph(): m_Pool(make_handle<TransientPool>()) { }
 
   RenderGraph::~RenderGraph() { }
 
   void RenderGraph::AddPass(Handle<Pass> pass) { m_Passes.push_back(pass); }
 
-  void RenderGraph::Build(const std::vector<Sink> &global_sinks) {
+  void RenderGraph::AddOutput(const String &name) { m_Outputs.push_back(name); }
+
+  void RenderGraph::SetTransient(const String &name, const TransientImageDesc &desc) {
+    auto it = std::find_if(m_Transients.begin(), m_Transients.end(), [&](const TransientImage &transient) -> bool { return transient.Name == name; });
+    if (it != m_Transients.end()) {
+      it->Desc = desc;
+    } else {
+      m_Transients.push_back({.Name = name, .Desc = desc});
+    }
+  }
+
+  Handle<Resource> RenderGraph::GetResource(const String &name, TUint32 current_frame) const {
+    auto it = m_Compiled.Resources.find(name);
+    if (it == m_Compiled.Resources.end() || it->second >= m_Resources.size())
+      return nullptr;
+    return m_Resources[it->second].GetResource(current_frame);
+  }
+
+  bool RenderGraph::Build(const std::vector<Sink> &global_sinks) {
     m_GlobalSinks.clear();
+    m_Resources.clear();
 
-    Handle<VulkanSwapchain> swapchain = VulkanState::Ref().GetSwapchainHandle();
+    const Handle<VulkanSwapchain> &swapchain = VulkanState::Ref().GetSwapchainHandle();
 
     // setup global resources
     std::vector<Handle<Resource>> swapchain_images = {};
@@ -26,22 +98,102 @@ namespace mau {
       swapchain_depth_images.push_back(depthbuffer);
     }
 
+    // backbuffers come back from presentation and go back to it, offscreen images are left ready to be copied out
+    const ResourceUsage backbuffer_usage = VulkanState::Ref().IsHeadless() ? ResourceUsage::TRANSFER_READ : ResourceUsage::PRESENT;
+
     Sink backbuffer("$backbuffer");
     backbuffer.AssignResources(swapchain_images);
+    backbuffer.SetUsage(backbuffer_usage, backbuffer_usage);
 
     Sink depthbuffer("$depthbuffer");
     depthbuffer.AssignResources(swapchain_depth_images);
 
-    m_GlobalSinks.insert(std::make_pair(backbuffer.GetName(), backbuffer));
-    m_GlobalSinks.insert(std::make_pair(depthbuffer.GetName(), depthbuffer));
-
+    m_Resources.push_back(backbuffer);
+    m_Resources.push_back(depthbuffer);
     for (const auto &sink : global_sinks) {
+      m_Resources.push_back(sink);
+    }
+
+    for (const auto &sink : m_Resources) {
       m_GlobalSinks.insert(std::make_pair(sink.GetName(), sink));
     }
 
-    // setup passes
-    for (auto &pass : m_Passes) {
-      pass->Build(m_GlobalSinks, static_cast<TUint32>(swapchain_images.size()));
+    // order passes and place barriers, only names and usages are needed for it
+    Vector<GraphResourceDesc> resources = {};
+    for (const auto &sink : m_Resources) {
+      resources.push_back({
+          .Name = sink.GetName(),
+          .Type = sink.GetType(),
+          .Initial = sink.GetInitialUsage(),
+          .Final = sink.GetFinalUsage(),
+      });
+    }
+
+    // transient images of the graph and of its passes, placed in memory by the compiler
+    Vector<TransientImage> transients = m_Transients;
+    for (const auto &pass : m_Passes) {
+      transients.insert(transients.end(), pass->GetTransients().begin(), pass->GetTransients().end());
+    }
+
+    for (size_t i = 0u; i < transients.size(); i++) {
+      TransientImage &transient = transients[i];
+      if (!resolve_transient(transient.Desc, transients, i, m_GlobalSinks)) {
+        LOG_ERROR("failed to resolve transient image [%s]", transient.Name.c_str());
+        return false;
+      }
+
+      GraphResourceDesc desc = {.Name = transient.Name, .Type = ResourceType::IMAGE, .Transient = true};
+      m_Pool->GetRequirements(transient.Desc, desc.Size, desc.Alignment, desc.Heap);
+      resources.push_back(desc);
+    }
+
+    Vector<GraphPassDesc> passes = {};
+    for (const auto &pass : m_Passes) {
+      passes.push_back({.Name = pass->GetName(), .Accesses = pass->GetAccesses()});
+    }
+
+    if (!RenderGraphCompiler::Compile(resources, passes, m_Outputs, m_Compiled)) {
+      LOG_ERROR("failed to compile render graph: %s", m_Compiled.Error.c_str());
+      m_Compiled = {};
+      return false;
+    }
+
+    // unchanged images stay where they were, the others are placed in the frame's memory
+    const TUint32 frame_count = static_cast<TUint32>(swapchain_images.size());
+    m_Pool->Reserve(m_Compiled.HeapSizes, frame_count);
+
+    for (const TransientImage &transient : transients) {
+      const GraphPlacement         &placement = m_Compiled.Placements[m_Resources.size()];
+      std::vector<Handle<Resource>> images = {};
+      for (TUint32 frame = 0u; frame < frame_count; frame++) {
+        images.push_back(m_Pool->Acquire(transient.Desc, placement.Heap, placement.Offset, frame));
+      }
+
+      Sink sink(transient.Name);
+      sink.AssignResources(images);
+      m_Resources.push_back(sink);
+      m_GlobalSinks.insert(std::make_pair(transient.Name, sink));
+    }
+
+    m_Pool->Trim();
+    m_TransientStats = {
+        .Images = static_cast<TUint32>(transients.size()),
+        .Frames = frame_count,
+        .CreatedImages = m_Pool->GetCreatedCount(),
+        .ReusedImages = m_Pool->GetReusedCount(),
+        .Bytes = m_Compiled.TransientSize * frame_count,
+        .AllocatedBytes = m_Pool->GetAllocatedSize(),
+        .UnaliasedBytes = m_Compiled.UnaliasedSize * frame_count,
+    };
+
+    // setup passes, culled ones too so a later build can bring them back
+    bool built = true;
+    for (TUint32 p : m_Compiled.BuildOrder) {
+      Handle<Pass> &pass = m_Passes[p];
+      if (!pass->Build(m_GlobalSinks, static_cast<TUint32>(swapchain_images.size()))) {
+        LOG_ERROR("failed to build pass [%s]", pass->GetName().c_str());
+        built = false;
+      }
 
       const UnorderedMap<String, Sink> &pass_sinks = pass->GetSinks();
 
@@ -50,13 +202,84 @@ namespace mau {
       }
     }
 
-    // finished
+    m_FrameStarted.assign(swapchain_images.size(), false);
+
+    LOG_INFO("render graph built [passes: %zu, culled: %zu, barriers: %u]", m_Compiled.Passes.size(), m_Compiled.Culled.size(), m_Compiled.BarrierCount);
+    LOG_INFO("render graph transient memory: %.1f MB for %u images in %u frames, %.1f MB without aliasing [created: %u, reused: %u]",
+             static_cast<TFloat64>(m_TransientStats.Bytes) / (1024.0 * 1024.0), m_TransientStats.Images, m_TransientStats.Frames,
+             static_cast<TFloat64>(m_TransientStats.UnaliasedBytes) / (1024.0 * 1024.0), m_TransientStats.CreatedImages, m_TransientStats.ReusedImages);
+    return built;
   }
 
   void RenderGraph::Execute(Handle<CommandBuffer> cmd, TUint32 current_Frame) {
-    for (auto &pass : m_Passes) {
-      pass->Execute(cmd, current_Frame);
+    if (current_Frame >= m_FrameStarted.size())
+      return;
+
+    const bool first = !m_FrameStarted[current_Frame];
+    for (const CompiledPass &compiled : m_Compiled.Passes) {
+      RecordBarriers(cmd, first ? compiled.FirstBarriers : compiled.Barriers, current_Frame);
+      m_Passes[compiled.Pass]->Execute(cmd, current_Frame);
     }
+
+    RecordBarriers(cmd, first ? m_Compiled.FirstFinalBarriers : m_Compiled.FinalBarriers, current_Frame);
+    m_FrameStarted[current_Frame] = true;
+  }
+
+  void RenderGraph::RecordBarriers(Handle<CommandBuffer> cmd, const Vector<GraphBarrier> &barriers, TUint32 current_frame) {
+    VkPipelineStageFlags src_stages = 0u;
+    VkPipelineStageFlags dst_stages = 0u;
+
+    m_ImageBarriers.clear();
+    m_BufferBarriers.clear();
+
+    for (const GraphBarrier &barrier : barriers) {
+      Handle<Resource> resource = m_Resources[barrier.Resource].GetResource(current_frame);
+
+      if (barrier.Type == ResourceType::IMAGE) {
+        Handle<ImageResource> image_resource = resource;
+        Handle<Image>         image = image_resource->GetImage();
+
+        m_ImageBarriers.push_back({
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = barrier.SrcAccess,
+            .dstAccessMask = barrier.DstAccess,
+            .oldLayout = barrier.OldLayout,
+            .newLayout = barrier.NewLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image->GetImage(),
+            .subresourceRange = {.aspectMask = image_aspect(image->GetFormat()), .baseMipLevel = 0u, .levelCount = image->GetMipLevels(), .baseArrayLayer = 0u, .layerCount = 1u},
+        });
+      } else if (barrier.Type == ResourceType::BUFFER) {
+        Handle<BufferResource> buffer_resource = resource;
+
+        m_BufferBarriers.push_back({
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = barrier.SrcAccess,
+            .dstAccessMask = barrier.DstAccess,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = buffer_resource->GetBuffer()->Get(),
+            .offset = 0u,
+            .size = VK_WHOLE_SIZE,
+        });
+      } else {
+        // textures are uploaded once and only ever sampled
+        continue;
+      }
+
+      src_stages |= barrier.SrcStages;
+      dst_stages |= barrier.DstStages;
+    }
+
+    if (m_ImageBarriers.empty() && m_BufferBarriers.empty())
+      return;
+
+    // everything in front of a pass goes into one call
+    vkCmdPipelineBarrier(cmd->Get(), src_stages, dst_stages, 0u, 0u, nullptr, static_cast<TUint32>(m_BufferBarriers.size()), m_BufferBarriers.data(),
+                         static_cast<TUint32>(m_ImageBarriers.size()), m_ImageBarriers.data());
   }
 
 } // namespace mau
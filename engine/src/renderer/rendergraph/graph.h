@@ -2,6 +2,8 @@
 
 #include "graphics/vulkan-commands.h"
 #include "pass.h"
+#include "compiler.h"
+#include "transient-pool.h"
 
 namespace mau {
 
@@ -12,12 +14,43 @@ namespace mau {
 
   public:
     void AddPass(Handle<Pass> pass);
-    void Build(const std::vector<Sink> &global_sinks = {});
+    // names the passes have to produce, passes that do not contribute to any of them are culled
+    void AddOutput(const String &name);
+    // declares a transient image or changes its description, images whose lifetimes do not overlap share memory.
+    // takes effect with the next build
+    void SetTransient(const String &name, const TransientImageDesc &desc);
+    // orders the passes and places the barriers between them, then builds every pass. false when the passes do not
+    // form a valid graph or one of them could not be built
+    bool Build(const std::vector<Sink> &global_sinks = {});
     void Execute(Handle<CommandBuffer> cmd, TUint32 current_Frame);
 
+    // the resource behind a global, transient or sink name
+    Handle<Resource> GetResource(const String &name, TUint32 current_frame) const;
+    // false until the frame ran once since the last build, resources carried over from earlier frames start undefined
+    // in its first run
+    inline bool HasStarted(TUint32 current_frame) const { return current_frame < m_FrameStarted.size() && m_FrameStarted[current_frame]; }
+
+    inline const CompiledGraph        &GetCompiled() const { return m_Compiled; }
+    inline const TransientMemoryStats &GetTransientStats() const { return m_TransientStats; }
+
+  private:
+    void RecordBarriers(Handle<CommandBuffer> cmd, const Vector<GraphBarrier> &barriers, TUint32 current_frame);
+
   private:
     std::vector<Handle<Pass>>  m_Passes = {};
+    Vector<String>             m_Outputs = {};
+    Vector<TransientImage>     m_Transients = {};
     UnorderedMap<String, Sink> m_GlobalSinks = {};
+    // graph resources in the order they were handed to the compiler
+    Vector<Sink>  m_Resources = {};
+    CompiledGraph m_Compiled = {};
+    // frames that ran since the last build, the resources of the others are still undefined
+    Vector<bool>          m_FrameStarted = {};
+    Handle<TransientPool> m_Pool = nullptr;
+    TransientMemoryStats  m_TransientStats = {};
+
+    Vector<VkImageMemoryBarrier>  m_ImageBarriers = {};
+    Vector<VkBufferMemoryBarrier> m_BufferBarriers = {};
   };
 
 } // namespace mau
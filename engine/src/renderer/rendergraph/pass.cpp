@@ -1,5 +1,6 @@
 #include "pass.h"
 
+#include <algorithm>
 #include <engine/log.h>
 
 namespace mau {
@@ -37,13 +38,19 @@ namespace mau {
     return PostBuild(swapchain_image_count);
   }
 
-  void Pass::RegisterSource(const String &name) {
+  void Pass::RegisterSource(const String &name, ResourceUsage usage) {
     if (m_Sources.contains(name)) {
       LOG_WARN("source with name [%s] already exists in pass [%s]", name.c_str(), m_Name.c_str());
       return;
     }
 
     m_Sources.insert(std::make_pair(name, Source(name)));
+    m_Accesses.push_back({.Source = name, .Usage = usage});
+  }
+
+  void Pass::RegisterTransient(const String &name, const TransientImageDesc &desc, ResourceUsage usage) {
+    m_Transients.push_back({.Name = name, .Desc = desc});
+    RegisterSource(name, usage);
   }
 
   void Pass::RegisterSink(const String &input_source, const String &name) {
@@ -53,6 +60,16 @@ namespace mau {
     }
 
     m_Sinks.insert(std::make_pair(name, Sink(input_source, name)));
+
+    // the sink is handed on with the usage of its source
+    auto access = std::find_if(m_Accesses.begin(), m_Accesses.end(), [&](const GraphAccess &other) -> bool { return other.Source == input_source; });
+    if (access == m_Accesses.end()) {
+      m_Accesses.push_back({.Source = input_source, .Sink = name});
+    } else if (access->Sink.empty()) {
+      access->Sink = name;
+    } else {
+      m_Accesses.push_back({.Source = input_source, .Sink = name, .Usage = access->Usage});
+    }
   }
 
 } // namespace mau
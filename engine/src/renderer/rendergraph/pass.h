@@ -3,6 +3,8 @@
 #include <engine/types.h>
 #include "source.h"
 #include "sink.h"
+#include "compiler.h"
+#include "transient-pool.h"
 #include "graphics/vulkan-commands.h"
 
 namespace mau {
@@ -18,17 +20,26 @@ namespace mau {
     bool         Build(const UnorderedMap<String, Sink> &sinks, TUint32 swapchain_image_count);
     virtual void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) = 0;
 
+    inline const String                     &GetName() const { return m_Name; }
     inline const UnorderedMap<String, Sink> &GetSinks() const { return m_Sinks; }
+    inline const Vector<GraphAccess>        &GetAccesses() const { return m_Accesses; }
+    inline const Vector<TransientImage>     &GetTransients() const { return m_Transients; }
 
   protected:
-    void         RegisterSource(const String &name);
+    // the usage tells the render graph how the pass touches the source, it places the barriers around the pass
+    void         RegisterSource(const String &name, ResourceUsage usage);
+    // hands the resource of the source on under a new name, passes using it run after this one
     void         RegisterSink(const String &input_source, const String &name);
+    // an image the render graph creates for the pass, it is registered as source with the usage
+    void         RegisterTransient(const String &name, const TransientImageDesc &desc, ResourceUsage usage);
     virtual bool PostBuild(TUint32 swapchain_image_count) = 0;
 
   protected:
     const String                 m_Name = "";
     UnorderedMap<String, Source> m_Sources = {};
     UnorderedMap<String, Sink>   m_Sinks = {};
+    Vector<GraphAccess>          m_Accesses = {};
+    Vector<TransientImage>       m_Transients = {};
   };
 
 } // namespace mau
@@ -0,0 +1,51 @@
+#include "denoiser-pass.h"
+
+#include "optix/denoiser.h"
+#include "renderer/renderer.h"
+
+namespace mau {
+
+  DenoiserPass::DenoiserPass(): Pass("denoiser-pass") {
+    RegisterSource("rt-color", ResourceUsage::TRANSFER_READ);
+    RegisterSource("rt-albedo", ResourceUsage::TRANSFER_READ);
+    RegisterSource("rt-normal", ResourceUsage::TRANSFER_READ);
+    RegisterSink("rt-color", "denoiser-color");
+  }
+
+  DenoiserPass::~DenoiserPass() { }
+
+  bool DenoiserPass::PostBuild(TUint32 swapchain_image_count) { return true; }
+
+  void DenoiserPass::Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    // the barriers around the pass stay when the denoiser is off, the color image is then passed on as it is
+    if (!Renderer::Ref().IsDenoising())
+      return;
+
+    MAU_GPU_ZONE(cmd->Get(), "DenoiserPass::Execute");
+    Handle<ImageResource> color = m_Sources.at("rt-color").GetResource(frame_index);
+    Handle<ImageResource> albedo = m_Sources.at("rt-albedo").GetResource(frame_index);
+    Handle<ImageResource> normal = m_Sources.at("rt-normal").GetResource(frame_index);
+
+    Denoiser::Ref().ImageToBuffers(cmd, color->GetImage(), albedo->GetImage(), normal->GetImage());
+    Denoiser::Ref().Denoise(cmd);
+  }
+
+  DenoiserOutputPass::DenoiserOutputPass(): Pass("denoiser-output-pass") {
+    RegisterSource("denoiser-color", ResourceUsage::TRANSFER_WRITE);
+    RegisterSink("denoiser-color", "denoised-color");
+  }
+
+  DenoiserOutputPass::~DenoiserOutputPass() { }
+
+  bool DenoiserOutputPass::PostBuild(TUint32 swapchain_image_count) { return true; }
+
+  void DenoiserOutputPass::Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    if (!Renderer::Ref().IsDenoising())
+      return;
+
+    MAU_GPU_ZONE(cmd->Get(), "DenoiserOutputPass::Execute");
+    Handle<ImageResource> color = m_Sources.at("denoiser-color").GetResource(frame_index);
+    Denoiser::Ref().BufferToImage(cmd, color->GetImage());
+  }
+
+} // namespace mau
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "renderer/rendergraph/pass.h"
+
+namespace mau {
+
+  // copies the traced color, albedo and normal images out to the denoiser and runs it
+  class DenoiserPass: public Pass {
+  public:
+    DenoiserPass();
+    ~DenoiserPass();
+
+  private:
+    bool PostBuild(TUint32 swapchain_image_count) override;
+    void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) override;
+  };
+
+  // copies the denoised result back into the color image. a pass of its own as the image is read before and written
+  // after denoising, in two different layouts
+  class DenoiserOutputPass: public Pass {
+  public:
+    DenoiserOutputPass();
+    ~DenoiserOutputPass();
+
+  private:
+    bool PostBuild(TUint32 swapchain_image_count) override;
+    void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) override;
+  };
+
+} // namespace mau
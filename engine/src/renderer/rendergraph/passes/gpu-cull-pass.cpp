@@ -0,0 +1,36 @@
+#include "gpu-cull-pass.h"
+
+#include "renderer/renderer.h"
+
+namespace mau {
+
+  GpuCullPass::GpuCullPass(): Pass("gpu-cull-pass") {
+    RegisterSource("gpu-cull-commands", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    RegisterSource("gpu-cull-counts", ResourceUsage::STORAGE_READ_WRITE_COMPUTE);
+    RegisterSource("hiz-pyramid", ResourceUsage::SAMPLED_COMPUTE);
+    RegisterSink("gpu-cull-commands", "gpu-culled-commands");
+    RegisterSink("gpu-cull-counts", "gpu-culled-counts");
+  }
+
+  GpuCullPass::~GpuCullPass() { }
+
+  bool GpuCullPass::PostBuild(TUint32 swapchain_image_count) { return true; }
+
+  void GpuCullPass::Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    // the barriers around the pass stay when the draws are culled on the cpu, nothing reads the buffers then
+    Renderer::Ref().RenderCull(cmd, frame_index);
+  }
+
+  DepthPyramidPass::DepthPyramidPass(): Pass("depth-pyramid-pass") {
+    RegisterSource("lambertian-depth", ResourceUsage::SAMPLED_COMPUTE);
+    RegisterSource("hiz-pyramid", ResourceUsage::STORAGE_WRITE_COMPUTE);
+    RegisterSink("hiz-pyramid", "hiz-pyramid-next");
+  }
+
+  DepthPyramidPass::~DepthPyramidPass() { }
+
+  bool DepthPyramidPass::PostBuild(TUint32 swapchain_image_count) { return true; }
+
+  void DepthPyramidPass::Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) { Renderer::Ref().RenderDepthPyramid(cmd, frame_index); }
+
+} // namespace mau
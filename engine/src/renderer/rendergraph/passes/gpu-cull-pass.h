@@ -0,0 +1,30 @@
+#pragma once
+
+#include "renderer/rendergraph/pass.h"
+
+namespace mau {
+
+  // fills the draw list and culls it on the gpu into the commands and counts the lambertian pass draws from. tests
+  // against the depth pyramid of the previous frame, so it runs before the pyramid pass writes the next one
+  class GpuCullPass: public Pass {
+  public:
+    GpuCullPass();
+    ~GpuCullPass();
+
+  private:
+    bool PostBuild(TUint32 swapchain_image_count) override;
+    void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) override;
+  };
+
+  // reduces the lambertian depth into the depth pyramid the next frame is culled against
+  class DepthPyramidPass: public Pass {
+  public:
+    DepthPyramidPass();
+    ~DepthPyramidPass();
+
+  private:
+    bool PostBuild(TUint32 swapchain_image_count) override;
+    void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) override;
+  };
+
+} // namespace mau
@@ -3,11 +3,15 @@
 #include <imgui.h>
 #include <backends/imgui_impl_vulkan.h>
 
-#include "graphics/vulkan-state.h"
+#include "renderer/renderer.h"
 
 namespace mau {
 
-  ImGuiPass::ImGuiPass(): Pass("imgui-pass") { RegisterSource("$backbuffer"); }
+  ImGuiPass::ImGuiPass(const String &viewport_source): Pass("imgui-pass") {
+    RegisterSource(viewport_source, ResourceUsage::SAMPLED_FRAGMENT);
+    RegisterSource("$backbuffer", ResourceUsage::COLOR_ATTACHMENT_WRITE);
+    RegisterSink("$backbuffer", "$present");
+  }
 
   ImGuiPass::~ImGuiPass() { }
 
@@ -24,8 +28,10 @@ namespace mau {
 
     if (m_Renderpass == nullptr) {
       m_Renderpass = make_handle<Renderpass>();
+      // the render graph hands the backbuffer over in the attachment layout and prepares it for presentation after
       LoadStoreOp op;
-      m_Renderpass->AddColorAttachment(source_image->GetImage()->GetFormat(), source_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+      m_Renderpass->AddColorAttachment(source_image->GetImage()->GetFormat(), source_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                       VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
       m_Renderpass->Build(VK_PIPELINE_BIND_POINT_GRAPHICS, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_NONE,
                           VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
     }
@@ -47,9 +53,11 @@ namespace mau {
         .extent = {m_Width, m_Height},
     };
 
+    // the draw data is a copy taken when the frame was captured, imgui itself may already be in the next frame
     m_Renderpass->Begin(cmd, m_Framebuffers[frame_index], area);
-    ImGui::Render();
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd->Get());
+    if (ImDrawData *draw_data = Renderer::Ref().GetImGuiDrawData()) {
+      ImGui_ImplVulkan_RenderDrawData(draw_data, cmd->Get());
+    }
     m_Renderpass->End(cmd);
   }
 
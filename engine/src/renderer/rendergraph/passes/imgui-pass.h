@@ -8,7 +8,8 @@ namespace mau {
 
   class ImGuiPass: public Pass {
   public:
-    ImGuiPass();
+    // draws imgui over the backbuffer, the viewport source is sampled by the viewport window
+    ImGuiPass(const String &viewport_source);
     ~ImGuiPass();
 
   public:
@@ -2,30 +2,48 @@
 
 #include "renderer/renderer.h"
 #include "graphics/vulkan-state.h"
-#include "graphics/vulkan-features.h"
 
 namespace mau {
 
-  LambertianPass::LambertianPass(): Pass("lambertian-pass") {
-    RegisterSource("imgui-viewport-color");
-    RegisterSource("imgui-viewport-depth");
+  LambertianPass::LambertianPass(VkFormat depth_format): Pass("lambertian-pass") {
+    RegisterSource("imgui-viewport-color", ResourceUsage::COLOR_ATTACHMENT_WRITE);
+    RegisterSink("imgui-viewport-color", "lambertian-color");
+
+    // draws culled on the gpu, the buffers are left untouched when the cpu culls
+    RegisterSource("gpu-culled-commands", ResourceUsage::INDIRECT_READ);
+    RegisterSource("gpu-culled-counts", ResourceUsage::INDIRECT_READ);
+
+    // multisampled targets the size of the viewport, resolved into it
+    const TransientImageDesc msaa_color = {
+        .Samples = VK_SAMPLE_COUNT_4_BIT,
+        .Usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .Reference = "imgui-viewport-color",
+    };
+    const TransientImageDesc msaa_depth = {
+        .Format = depth_format,
+        .Samples = VK_SAMPLE_COUNT_4_BIT,
+        .Usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .Aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+        .Reference = "imgui-viewport-color",
+    };
+    RegisterTransient("lambertian-msaa-color", msaa_color, ResourceUsage::COLOR_ATTACHMENT_WRITE);
+    RegisterTransient("lambertian-msaa-depth", msaa_depth, ResourceUsage::DEPTH_ATTACHMENT_WRITE);
+    // the depth pyramid is built from it
+    RegisterSink("lambertian-msaa-depth", "lambertian-depth");
   }
 
   LambertianPass::~LambertianPass() { }
 
   bool LambertianPass::PostBuild(TUint32 swapchain_image_count) {
     m_Framebuffers.clear();
-    m_MSAAImages.clear();
-    m_MSAAImageViews.clear();
-    m_MSAADepthImages.clear();
-    m_MSAADepthImageViews.clear();
 
     const Source         &source = m_Sources.at("imgui-viewport-color");
+    const Source         &msaa_source = m_Sources.at("lambertian-msaa-color");
+    const Source         &msaa_depth_source = m_Sources.at("lambertian-msaa-depth");
     Handle<ImageResource> source_image = source.GetResource(0u);
-
-    const Source         &depth_source = m_Sources.at("imgui-viewport-depth");
-    Handle<ImageResource> depth_source_image = depth_source.GetResource(0u);
-    if (!source_image || !depth_source_image)
+    Handle<ImageResource> msaa_image = msaa_source.GetResource(0u);
+    Handle<ImageResource> msaa_depth_image = msaa_depth_source.GetResource(0u);
+    if (!source_image || !msaa_image || !msaa_depth_image)
       return false;
 
     TUint32 width = source_image->GetImage()->GetWidth();
@@ -34,28 +52,17 @@ namespace mau {
     m_Width = width;
     m_Height = height;
 
-    for (TUint32 i = 0; i < swapchain_image_count; i++) {
-      Handle<Image>     img = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_4_BIT, source_image->GetImage()->GetFormat(), VK_IMAGE_TILING_OPTIMAL,
-                                             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-      Handle<ImageView> img_view = make_handle<ImageView>(img, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
-      Handle<Image>     depth_img = make_handle<Image>(width, height, 1, 1, 1, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_4_BIT, depth_source_image->GetImage()->GetFormat(), VK_IMAGE_TILING_OPTIMAL,
-                                                   VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
-      Handle<ImageView> depth_img_view = make_handle<ImageView>(depth_img, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT);
-
-      m_MSAAImages.push_back(img);
-      m_MSAAImageViews.push_back(img_view);
-      m_MSAADepthImages.push_back(depth_img);
-      m_MSAADepthImageViews.push_back(depth_img_view);
-    }
-
     if (m_Renderpass == nullptr) {
+      // the render graph moves every attachment into and out of its attachment layout
       m_Renderpass = make_handle<Renderpass>();
       LoadStoreOp op;
-      m_Renderpass->AddColorAttachment(m_MSAAImages[0]->GetFormat(), m_MSAAImages[0]->GetSamples(), op, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-      op.StoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-      m_Renderpass->SetDepthAttachment(m_MSAADepthImages[0]->GetFormat(), m_MSAADepthImages[0]->GetSamples(), op, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-      op.StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-      m_Renderpass->SetResolveAttachment(source_image->GetImage()->GetFormat(), source_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      m_Renderpass->AddColorAttachment(msaa_image->GetImage()->GetFormat(), msaa_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                       VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+      // the depth is kept for the depth pyramid
+      m_Renderpass->SetDepthAttachment(msaa_depth_image->GetImage()->GetFormat(), msaa_depth_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                                       VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+      m_Renderpass->SetResolveAttachment(source_image->GetImage()->GetFormat(), source_image->GetImage()->GetSamples(), op, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
       m_Renderpass->Build(VK_PIPELINE_BIND_POINT_GRAPHICS, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, VK_ACCESS_NONE,
                           VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
@@ -63,9 +70,10 @@ namespace mau {
 
     for (TUint32 i = 0; i < swapchain_image_count; i++) {
       Handle<ImageResource> this_source_image = source.GetResource(i);
-      Handle<ImageResource> this_depth_source_image = depth_source.GetResource(i);
+      Handle<ImageResource> this_msaa_image = msaa_source.GetResource(i);
+      Handle<ImageResource> this_msaa_depth_image = msaa_depth_source.GetResource(i);
 
-      std::vector<Handle<ImageView>> image_views = {m_MSAAImageViews[i], m_MSAADepthImageViews[i], this_source_image->GetImageView()};
+      std::vector<Handle<ImageView>> image_views = {this_msaa_image->GetImageView(), this_msaa_depth_image->GetImageView(), this_source_image->GetImageView()};
 
       Handle<Framebuffer> fbo = make_handle<Framebuffer>(image_views, m_Renderpass, width, height);
       m_Framebuffers.push_back(fbo);
@@ -93,20 +101,27 @@ namespace mau {
         .extent = {m_Width, m_Height},
     };
 
-    if (VulkanFeatures::IsRtEnabled()) {
-      vkCmdSetViewport(cmd->Get(), 0u, 1u, &viewport);
-      vkCmdSetScissor(cmd->Get(), 0u, 1u, &scissor);
-
-      Renderer::Ref().RenderRT(cmd, frame_index);
+    // large scenes are recorded into secondary command buffers by several threads
+    if (Renderer::Ref().IsRecordingParallel()) {
+      const VkCommandBufferInheritanceInfo inheritance = {
+          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+          .pNext = nullptr,
+          .renderPass = m_Renderpass->Get(),
+          .subpass = 0u,
+          .framebuffer = m_Framebuffers[frame_index]->Get(),
+      };
+
+      m_Renderpass->Begin(cmd, m_Framebuffers[frame_index], area, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+      Renderer::Ref().RenderParallel(cmd, frame_index, inheritance, viewport, scissor);
     } else {
       m_Renderpass->Begin(cmd, m_Framebuffers[frame_index], area);
       vkCmdSetViewport(cmd->Get(), 0u, 1u, &viewport);
       vkCmdSetScissor(cmd->Get(), 0u, 1u, &scissor);
 
       Renderer::Ref().Render(cmd, frame_index);
-
-      m_Renderpass->End(cmd);
     }
+
+    m_Renderpass->End(cmd);
   }
 
 } // namespace mau
@@ -8,7 +8,7 @@ namespace mau {
 
   class LambertianPass: public Pass {
   public:
-    LambertianPass();
+    LambertianPass(VkFormat depth_format);
     ~LambertianPass();
 
   public:
@@ -20,10 +20,6 @@ namespace mau {
   private:
     Handle<Renderpass>               m_Renderpass = nullptr;
     std::vector<Handle<Framebuffer>> m_Framebuffers = {};
-    std::vector<Handle<Image>>       m_MSAAImages = {};
-    std::vector<Handle<ImageView>>   m_MSAAImageViews = {};
-    std::vector<Handle<Image>>       m_MSAADepthImages = {};
-    std::vector<Handle<ImageView>>   m_MSAADepthImageViews = {};
     TUint32                          m_Width = 0u;
     TUint32                          m_Height = 0u;
   };
@@ -0,0 +1,26 @@
+#include "raytracing-pass.h"
+
+#include "renderer/renderer.h"
+
+namespace mau {
+
+  RayTracingPass::RayTracingPass(): Pass("raytracing-pass") {
+    RegisterSource("imgui-viewport-color", ResourceUsage::STORAGE_WRITE_RAYTRACING);
+    RegisterSource("rt-accum-buffer", ResourceUsage::STORAGE_READ_WRITE_RAYTRACING);
+    RegisterSource("rt-albedo-buffer", ResourceUsage::STORAGE_WRITE_RAYTRACING);
+    RegisterSource("rt-normal-buffer", ResourceUsage::STORAGE_WRITE_RAYTRACING);
+    RegisterSink("imgui-viewport-color", "rt-color");
+    RegisterSink("rt-albedo-buffer", "rt-albedo");
+    RegisterSink("rt-normal-buffer", "rt-normal");
+  }
+
+  RayTracingPass::~RayTracingPass() { }
+
+  bool RayTracingPass::PostBuild(TUint32 swapchain_image_count) { return true; }
+
+  void RayTracingPass::Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) {
+    MAU_GPU_ZONE(cmd->Get(), "RayTracingPass::Execute");
+    Renderer::Ref().RenderRT(cmd, frame_index);
+  }
+
+} // namespace mau
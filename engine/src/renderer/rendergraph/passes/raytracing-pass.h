@@ -0,0 +1,18 @@
+#pragma once
+
+#include "renderer/rendergraph/pass.h"
+
+namespace mau {
+
+  // traces the viewport into the color, accumulation, albedo and normal storage images
+  class RayTracingPass: public Pass {
+  public:
+    RayTracingPass();
+    ~RayTracingPass();
+
+  private:
+    bool PostBuild(TUint32 swapchain_image_count) override;
+    void Execute(Handle<CommandBuffer> cmd, TUint32 frame_index) override;
+  };
+
+} // namespace mau
@@ -4,20 +4,18 @@
 #include <engine/utils/handle.h>
 #include "graphics/vulkan-image.h"
 #include "graphics/vulkan-buffers.h"
+#include "usage.h"
 
 namespace mau {
 
-  enum class ResourceType {
-    IMAGE,
-    TEXTURE,
-    BUFFER,
-  };
-
   class Resource: public HandledObject {
   public:
     Resource(ResourceType type): m_Type(type) { }
     virtual ~Resource() { }
 
+  public:
+    inline ResourceType GetType() const { return m_Type; }
+
   protected:
     const ResourceType m_Type;
   };
@@ -47,11 +45,16 @@ namespace mau {
 
   class BufferResource: public Resource {
   public:
-    BufferResource(Handle<UniformBuffer> buffer): Resource(ResourceType::BUFFER), m_Buffer(buffer) { ASSERT(buffer); }
+    BufferResource(Handle<Buffer> buffer): Resource(ResourceType::BUFFER), m_Buffer(buffer) { ASSERT(buffer); }
     ~BufferResource() = default;
 
+  public:
+    // buffers that grow are swapped in place, the graph reads the buffer when it records its barriers
+    inline void           SetBuffer(Handle<Buffer> buffer) { m_Buffer = buffer; }
+    inline Handle<Buffer> GetBuffer() const { return m_Buffer; }
+
   private:
-    Handle<UniformBuffer> m_Buffer = nullptr;
+    Handle<Buffer> m_Buffer = nullptr;
   };
 
 } // namespace mau
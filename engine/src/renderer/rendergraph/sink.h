@@ -14,10 +14,18 @@ namespace mau {
 
   public:
     void AssignResources(const std::vector<Handle<Resource>> &resources) { m_Resources = resources; }
+    // the access before the render graph runs and the one it leaves the resource ready for, see GraphResourceDesc
+    void SetUsage(ResourceUsage initial, ResourceUsage final) {
+      m_InitialUsage = initial;
+      m_FinalUsage = final;
+    }
 
     inline const String    &GetName() const { return m_Name; }
     inline const String    &GetInputSourceName() const { return m_InputSourceName; }
     inline bool             IsConnecting() const { return m_Connecting; }
+    inline ResourceUsage    GetInitialUsage() const { return m_InitialUsage; }
+    inline ResourceUsage    GetFinalUsage() const { return m_FinalUsage; }
+    inline ResourceType     GetType() const { return m_Resources.empty() ? ResourceType::IMAGE : m_Resources[0]->GetType(); }
     inline Handle<Resource> GetResource(TUint32 current_frame) const {
       ASSERT(current_frame < m_Resources.size());
       return m_Resources[current_frame];
@@ -27,6 +35,8 @@ namespace mau {
     const String                  m_InputSourceName = "";
     const String                  m_Name = "";
     const bool                    m_Connecting = false;
+    ResourceUsage                 m_InitialUsage = ResourceUsage::NONE;
+    ResourceUsage                 m_FinalUsage = ResourceUsage::NONE;
     std::vector<Handle<Resource>> m_Resources = {}; // per frame
   };
 
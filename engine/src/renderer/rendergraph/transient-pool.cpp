@@ -0,0 +1,126 @@
+#include "transient-pool.h"
+
+#include <algorithm>
+#include <engine/assert.h>
+
+namespace mau {
+
+  static VkImageCreateInfo image_create_info(const TransientImageDesc &desc) {
+    ASSERT(desc.Width > 0u && desc.Height > 0u && desc.Format != VK_FORMAT_UNDEFINED);
+
+    return {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0u,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = desc.Format,
+        .extent = {desc.Width, desc.Height, 1u},
+        .mipLevels = 1u,
+        .arrayLayers = 1u,
+        .samples = desc.Samples,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = desc.Usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0u,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+  }
+
+  void TransientPool::GetRequirements(const TransientImageDesc &desc, TUint64 &size, TUint64 &alignment, TUint32 &heap) {
+    auto cached = std::find_if(m_Requirements.begin(), m_Requirements.end(), [&](const Requirements &requirements) -> bool { return requirements.Desc == desc; });
+    if (cached == m_Requirements.end()) {
+      const VkImageCreateInfo create_info = image_create_info(desc);
+      VkMemoryRequirements    requirements = {};
+      TUint32                 memory_type = 0u;
+      GetImageMemoryRequirements(create_info, requirements, memory_type);
+
+      auto type = std::find(m_MemoryTypes.begin(), m_MemoryTypes.end(), memory_type);
+      if (type == m_MemoryTypes.end())
+        type = m_MemoryTypes.insert(m_MemoryTypes.end(), memory_type);
+
+      m_Requirements.push_back({
+          .Desc = desc,
+          .Size = requirements.size,
+          .Alignment = requirements.alignment,
+          .Heap = static_cast<TUint32>(type - m_MemoryTypes.begin()),
+      });
+      cached = m_Requirements.end() - 1;
+    }
+
+    size = cached->Size;
+    alignment = cached->Alignment;
+    heap = cached->Heap;
+  }
+
+  void TransientPool::Reserve(const Vector<TUint64> &heap_sizes, TUint32 frame_count) {
+    m_Created = 0u;
+    m_Reused = 0u;
+    m_Blocks.resize(frame_count);
+
+    for (Vector<Handle<ImageMemory>> &blocks : m_Blocks) {
+      blocks.resize(m_MemoryTypes.size());
+
+      for (size_t heap = 0u; heap < blocks.size(); heap++) {
+        const TUint64 size = heap < heap_sizes.size() ? heap_sizes[heap] : 0u;
+        if (size == 0u) {
+          blocks[heap] = nullptr;
+          continue;
+        }
+
+        // a smaller viewport gives memory back, anything else that fits keeps its block and images
+        if (blocks[heap] && blocks[heap]->GetSize() >= size && blocks[heap]->GetSize() / 2u <= size)
+          continue;
+
+        blocks[heap] = make_handle<ImageMemory>(size, m_MemoryTypes[heap]);
+      }
+    }
+  }
+
+  Handle<ImageResource> TransientPool::Acquire(const TransientImageDesc &desc, TUint32 heap, TUint64 offset, TUint32 frame) {
+    ASSERT(frame < m_Blocks.size() && heap < m_Blocks[frame].size() && m_Blocks[frame][heap]);
+    Handle<ImageMemory> memory = m_Blocks[frame][heap];
+
+    for (PooledImage &image : m_Images) {
+      if (!image.Used && image.Frame == frame && image.Heap == heap && image.Offset == offset && image.Memory == memory && image.Desc == desc) {
+        image.Used = true;
+        m_Reused++;
+        return image.Resource;
+      }
+    }
+
+    Handle<Image>     image = make_handle<Image>(image_create_info(desc), memory, offset);
+    Handle<ImageView> view = make_handle<ImageView>(image, VK_IMAGE_VIEW_TYPE_2D, desc.Aspect);
+
+    m_Images.push_back({
+        .Desc = desc,
+        .Heap = heap,
+        .Frame = frame,
+        .Offset = offset,
+        .Memory = memory,
+        .Resource = make_handle<ImageResource>(image, view),
+        .Used = true,
+    });
+    m_Created++;
+
+    return m_Images.back().Resource;
+  }
+
+  void TransientPool::Trim() {
+    std::erase_if(m_Images, [](const PooledImage &image) -> bool { return !image.Used; });
+    for (PooledImage &image : m_Images) {
+      image.Used = false;
+    }
+  }
+
+  TUint64 TransientPool::GetAllocatedSize() const {
+    TUint64 size = 0u;
+    for (const Vector<Handle<ImageMemory>> &blocks : m_Blocks) {
+      for (const Handle<ImageMemory> &block : blocks) {
+        size += block ? block->GetSize() : 0u;
+      }
+    }
+    return size;
+  }
+
+} // namespace mau
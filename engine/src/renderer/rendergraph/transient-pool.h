@@ -0,0 +1,88 @@
+#pragma once
+
+#include <engine/types.h>
+#include "resources.h"
+#include "graphics/vulkan-image.h"
+
+namespace mau {
+
+  // a 2d image the render graph creates for one frame at a time. width, height and format left at zero are taken
+  // from the reference, a global resource or a transient image declared before this one
+  struct TransientImageDesc {
+    TUint32               Width = 0u;
+    TUint32               Height = 0u;
+    VkFormat              Format = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+    VkImageUsageFlags     Usage = 0u;
+    VkImageAspectFlags    Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    String                Reference = "";
+
+    bool operator==(const TransientImageDesc &other) const = default;
+  };
+
+  struct TransientImage {
+    String             Name = "";
+    TransientImageDesc Desc = {};
+  };
+
+  // bytes are summed over all frames
+  struct TransientMemoryStats {
+    TUint32 Images = 0u;
+    TUint32 Frames = 0u;
+    // by the last build, images whose description and place in memory did not change are kept
+    TUint32 CreatedImages = 0u;
+    TUint32 ReusedImages = 0u;
+    TUint64 Bytes = 0u;
+    TUint64 AllocatedBytes = 0u;
+    TUint64 UnaliasedBytes = 0u;
+  };
+
+  // memory and images of the transient resources of a render graph. every frame has one block per heap, a heap being
+  // the memory type its images go into. blocks are kept while they are large enough and not much too large
+  class TransientPool: public HandledObject {
+  public:
+    TransientPool() = default;
+    ~TransientPool() = default;
+
+  public:
+    // size, alignment and heap of an image with a resolved description
+    void GetRequirements(const TransientImageDesc &desc, TUint64 &size, TUint64 &alignment, TUint32 &heap);
+    // starts a build, makes room for the heap sizes in every frame
+    void Reserve(const Vector<TUint64> &heap_sizes, TUint32 frame_count);
+    // the image placed at offset in a frame's heap, created unless the last build had it there already
+    Handle<ImageResource> Acquire(const TransientImageDesc &desc, TUint32 heap, TUint64 offset, TUint32 frame);
+    // drops what was not acquired since the last call
+    void Trim();
+
+    inline TUint32 GetCreatedCount() const { return m_Created; }
+    inline TUint32 GetReusedCount() const { return m_Reused; }
+    TUint64        GetAllocatedSize() const;
+
+  private:
+    struct PooledImage {
+      TransientImageDesc    Desc = {};
+      TUint32               Heap = 0u;
+      TUint32               Frame = 0u;
+      TUint64               Offset = 0u;
+      Handle<ImageMemory>   Memory = nullptr;
+      Handle<ImageResource> Resource = nullptr;
+      bool                  Used = false;
+    };
+
+    struct Requirements {
+      TransientImageDesc Desc = {};
+      TUint64            Size = 0u;
+      TUint64            Alignment = 0u;
+      TUint32            Heap = 0u;
+    };
+
+  private:
+    Vector<TUint32>                     m_MemoryTypes = {}; // by heap
+    Vector<Vector<Handle<ImageMemory>>> m_Blocks = {};      // by frame and heap
+    Vector<PooledImage>                 m_Images = {};
+    Vector<Requirements>                m_Requirements = {};
+    TUint32                             m_Created = 0u;
+    TUint32                             m_Reused = 0u;
+  };
+
+} // namespace mau
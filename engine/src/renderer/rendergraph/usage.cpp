@@ -0,0 +1,74 @@
+#include "usage.h"
+
+#include <engine/assert.h>
+
+namespace mau {
+
+  // clang-format off
+  static const ResourceUsageInfo USAGE_INFOS[] = {
+    // NONE
+    {},
+    // COLOR_ATTACHMENT_WRITE
+    {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, true},
+    // DEPTH_ATTACHMENT_WRITE
+    {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+     VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, true},
+    // SAMPLED_FRAGMENT
+    {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, false},
+    // SAMPLED_COMPUTE
+    {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, false},
+    // SAMPLED_RAYTRACING
+    {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, false},
+    // STORAGE_WRITE_COMPUTE
+    {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true, true},
+    // STORAGE_WRITE_RAYTRACING
+    {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true, true},
+    // STORAGE_READ_WRITE_COMPUTE
+    {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true, false},
+    // STORAGE_READ_WRITE_RAYTRACING
+    {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true, false},
+    // TRANSFER_READ
+    {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, false},
+    // TRANSFER_WRITE
+    {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, false},
+    // UNIFORM_READ
+    {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false, false},
+    // INDIRECT_READ
+    {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false, false},
+    // PRESENT, chained to the stage the acquire semaphore is waited on
+    {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false, false},
+  };
+
+  static const char *USAGE_NAMES[] = {
+    "none",
+    "color-attachment-write",
+    "depth-attachment-write",
+    "sampled-fragment",
+    "sampled-compute",
+    "sampled-raytracing",
+    "storage-write-compute",
+    "storage-write-raytracing",
+    "storage-read-write-compute",
+    "storage-read-write-raytracing",
+    "transfer-read",
+    "transfer-write",
+    "uniform-read",
+    "indirect-read",
+    "present",
+  };
+  // clang-format on
+
+  static_assert(sizeof(USAGE_INFOS) / sizeof(USAGE_INFOS[0]) == static_cast<size_t>(ResourceUsage::COUNT));
+  static_assert(sizeof(USAGE_NAMES) / sizeof(USAGE_NAMES[0]) == static_cast<size_t>(ResourceUsage::COUNT));
+
+  const ResourceUsageInfo &GetResourceUsageInfo(ResourceUsage usage) {
+    ASSERT(usage < ResourceUsage::COUNT);
+    return USAGE_INFOS[static_cast<size_t>(usage)];
+  }
+
+  const char *GetResourceUsageName(ResourceUsage usage) {
+    ASSERT(usage < ResourceUsage::COUNT);
+    return USAGE_NAMES[static_cast<size_t>(usage)];
+  }
+
+} // namespace mau
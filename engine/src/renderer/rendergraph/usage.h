@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <engine/types.h>
+
+namespace mau {
+
+  enum class ResourceType {
+    IMAGE,
+    TEXTURE,
+    BUFFER,
+  };
+
+  // how a pass touches a source. the graph derives stages, access masks and image layouts from it, so passes never
+  // transition their resources themselves
+  enum class ResourceUsage : TUint8 {
+    // only the description is looked at (size, format), no gpu access
+    NONE,
+    // render pass attachments, cleared on load
+    COLOR_ATTACHMENT_WRITE,
+    DEPTH_ATTACHMENT_WRITE,
+    SAMPLED_FRAGMENT,
+    SAMPLED_COMPUTE,
+    SAMPLED_RAYTRACING,
+    // storage writes cover every texel, what was there before is dropped
+    STORAGE_WRITE_COMPUTE,
+    STORAGE_WRITE_RAYTRACING,
+    STORAGE_READ_WRITE_COMPUTE,
+    STORAGE_READ_WRITE_RAYTRACING,
+    TRANSFER_READ,
+    TRANSFER_WRITE,
+    UNIFORM_READ,
+    INDIRECT_READ,
+    // handed to the presentation engine, or taken back from it when used as initial usage
+    PRESENT,
+    COUNT,
+  };
+
+  struct ResourceUsageInfo {
+    VkPipelineStageFlags Stages = 0u;
+    VkAccessFlags        Access = 0u;
+    VkImageLayout        Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    bool                 Write = false;
+    // the previous contents are not needed, an image can be transitioned from undefined
+    bool Discard = false;
+  };
+
+  // the part of an access mask that has to be made available, read bits only matter on the destination side
+  static constexpr VkAccessFlags RESOURCE_WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                         VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+  const ResourceUsageInfo &GetResourceUsageInfo(ResourceUsage usage);
+  const char              *GetResourceUsageName(ResourceUsage usage);
+
+} // namespace mau
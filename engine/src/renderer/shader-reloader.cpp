@@ -0,0 +1,286 @@
+#include "shader-reloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <engine/log.h>
+#include <engine/memory.h>
+#include <engine/profiler.h>
+
+#include "graphics/shader-cache.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  FileWatcher::FileWatcher(const String &directory, TUint32 interval_ms): m_Directory(directory), m_IntervalMs(interval_ms) {
+    // the first scan only remembers the write times, files that exist at startup are not changes
+    Scan(false);
+    m_Thread = std::jthread([this](std::stop_token stop_token) -> void { Poll(stop_token); });
+  }
+
+  Vector<String> FileWatcher::TakeChanges() {
+    std::lock_guard lock(m_Mutex);
+    return std::exchange(m_Changes, {});
+  }
+
+  void FileWatcher::Poll(std::stop_token stop_token) {
+    MAU_PROFILE_THREAD("file watcher");
+
+    while (!stop_token.stop_requested()) {
+      {
+        // wakes up early when the watcher is destroyed
+        std::unique_lock lock(m_Mutex);
+        m_Wake.wait_for(lock, stop_token, std::chrono::milliseconds(m_IntervalMs), []() -> bool { return false; });
+      }
+
+      if (!stop_token.stop_requested())
+        Scan(true);
+    }
+  }
+
+  void FileWatcher::Scan(bool report) {
+    MAU_PROFILE_SCOPE("FileWatcher::Scan");
+
+    Vector<String>  changes = {};
+    std::error_code error = {};
+    for (auto it = std::filesystem::recursive_directory_iterator(m_Directory, std::filesystem::directory_options::skip_permission_denied, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+      if (!it->is_regular_file(error))
+        continue;
+
+      const auto write_time = it->last_write_time(error);
+      if (error)
+        continue;
+
+      const String path = get_shader_dependency_path(it->path().string());
+      auto         known = m_WriteTimes.find(path);
+      if (known == m_WriteTimes.end()) {
+        m_WriteTimes.emplace(path, write_time);
+        if (report)
+          changes.push_back(path);
+      } else if (known->second != write_time) {
+        known->second = write_time;
+        changes.push_back(path);
+      }
+    }
+
+    if (error && !report)
+      LOG_WARN("failed to watch %s: %s", m_Directory.c_str(), error.message().c_str());
+
+    if (changes.empty())
+      return;
+
+    std::lock_guard lock(m_Mutex);
+    for (String &path : changes) {
+      if (std::find(m_Changes.begin(), m_Changes.end(), path) == m_Changes.end())
+        m_Changes.push_back(std::move(path));
+    }
+  }
+
+  // true when one of the files the shader was built from is in changed
+  template <typename T> static bool depends_on(const Handle<T> &shader, const Vector<String> &changed) {
+    if (!shader)
+      return false;
+
+    for (const String &dependency : shader->GetDependencies()) {
+      if (std::find(changed.begin(), changed.end(), dependency) != changed.end())
+        return true;
+    }
+    return false;
+  }
+
+  // render thread. takes a changed shader out of the copied create info, so the rebuild thread fills an empty slot and
+  // never releases a handle the render thread shares
+  template <typename T> static bool take_changed(Handle<T> &shader, const Vector<String> &changed, String &path) {
+    if (!depends_on(shader, changed))
+      return false;
+
+    path = shader->GetPath();
+    shader = nullptr;
+    return true;
+  }
+
+  // rebuild thread. a shader that fails to compile leaves the slot invalid and the old pipeline in use
+  template <typename T> static bool load_shader(Handle<T> &shader, const String &path) {
+    if (path.empty())
+      return true;
+
+    T *loaded = nullptr;
+    MAU_ALLOC(loaded, T, path);
+    shader = loaded;
+    if (shader->IsValid())
+      return true;
+
+    LOG_ERROR("failed to reload shader %s, keeping the previous pipeline", path.c_str());
+    return false;
+  }
+
+  ShaderReloader::ShaderReloader(const String &shader_directory, TUint32 frames_in_flight): m_Watcher(shader_directory), m_FramesInFlight(frames_in_flight) {
+    LOG_INFO("watching %s for shader changes", shader_directory.c_str());
+  }
+
+  ShaderReloader::~ShaderReloader() {
+    if (m_RebuildThread.joinable())
+      m_RebuildThread.join();
+
+    // pipelines finished after the last swap were never handed out
+    for (Rebuild &rebuild : m_Rebuilds) {
+      if (rebuild.Graphics)
+        MAU_FREE(rebuild.Graphics);
+      if (rebuild.RayTracing)
+        MAU_FREE(rebuild.RayTracing);
+      if (rebuild.Compute)
+        MAU_FREE(rebuild.Compute);
+    }
+  }
+
+  void ShaderReloader::Watch(Handle<Pipeline> &pipeline, const PipelineCreateInfo &create_info) {
+    m_Watched.push_back({.Graphics = &pipeline, .GraphicsInfo = create_info});
+  }
+
+  void ShaderReloader::Watch(Handle<RTPipeline> &pipeline, const RTPipelineCreateInfo &create_info) {
+    m_Watched.push_back({.RayTracing = &pipeline, .RayTracingInfo = create_info});
+  }
+
+  void ShaderReloader::Watch(Handle<ComputePipeline> &pipeline, const ComputePipelineCreateInfo &create_info) {
+    m_Watched.push_back({.Compute = &pipeline, .ComputeInfo = create_info});
+  }
+
+  bool ShaderReloader::Update(TUint64 frame) {
+    MAU_PROFILE_SCOPE("ShaderReloader::Update");
+
+    // a frame recorded before the swap may still be executing until frames_in_flight newer frames were submitted
+    std::erase_if(m_Retired, [&](const Retired &retired) -> bool { return frame >= retired.Frame + m_FramesInFlight; });
+
+    for (String &path : m_Watcher.TakeChanges()) {
+      if (std::find(m_Pending.begin(), m_Pending.end(), path) == m_Pending.end())
+        m_Pending.push_back(std::move(path));
+    }
+
+    // rendering goes on with the current pipelines until the rebuild thread is done
+    if (m_Rebuilding.load(std::memory_order_acquire))
+      return false;
+
+    const bool swapped = !m_Rebuilds.empty() && SwapRebuilt(frame);
+
+    // changes that arrived during a rebuild start the next one, based on the pipelines just swapped in
+    if (!m_Pending.empty())
+      StartRebuild();
+
+    return swapped;
+  }
+
+  void ShaderReloader::StartRebuild() {
+    MAU_PROFILE_SCOPE("ShaderReloader::StartRebuild");
+
+    for (TUint32 i = 0; i < m_Watched.size(); i++) {
+      Rebuild rebuild = {
+          .Watched = i,
+          .IsCompute = m_Watched[i].Compute != nullptr,
+          .GraphicsInfo = m_Watched[i].GraphicsInfo,
+          .RayTracingInfo = m_Watched[i].RayTracingInfo,
+          .ComputeInfo = m_Watched[i].ComputeInfo,
+      };
+
+      bool changed = false;
+      if (m_Watched[i].Graphics) {
+        changed |= take_changed(rebuild.GraphicsInfo.Vertex, m_Pending, rebuild.ShaderPaths[0]);
+        changed |= take_changed(rebuild.GraphicsInfo.Fragment, m_Pending, rebuild.ShaderPaths[1]);
+      } else if (m_Watched[i].Compute) {
+        changed |= take_changed(rebuild.ComputeInfo.Compute, m_Pending, rebuild.ShaderPaths[0]);
+      } else {
+        changed |= take_changed(rebuild.RayTracingInfo.RayGen, m_Pending, rebuild.ShaderPaths[0]);
+        changed |= take_changed(rebuild.RayTracingInfo.Miss, m_Pending, rebuild.ShaderPaths[1]);
+        changed |= take_changed(rebuild.RayTracingInfo.ClosestHit, m_Pending, rebuild.ShaderPaths[2]);
+      }
+
+      if (changed)
+        m_Rebuilds.push_back(std::move(rebuild));
+    }
+    m_Pending.clear();
+
+    if (m_Rebuilds.empty())
+      return;
+
+    if (m_RebuildThread.joinable())
+      m_RebuildThread.join();
+
+    // a thread of its own instead of the job system, frame recording keeps every worker
+    m_Rebuilding.store(true, std::memory_order_release);
+    m_RebuildThread = std::jthread([this]() -> void {
+      MAU_PROFILE_THREAD("shader reload");
+      const auto start = Clock::now();
+
+      for (Rebuild &rebuild : m_Rebuilds) {
+        RunRebuild(rebuild);
+      }
+
+      LOG_INFO("finished %u pipeline rebuilds in %.2f ms", static_cast<TUint32>(m_Rebuilds.size()), std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count());
+      m_Rebuilding.store(false, std::memory_order_release);
+    });
+  }
+
+  void ShaderReloader::RunRebuild(Rebuild &rebuild) {
+    MAU_PROFILE_SCOPE("ShaderReloader::RunRebuild");
+
+    try {
+      // graphics pipelines always have a render pass, ray tracing and compute pipelines never do
+      if (rebuild.GraphicsInfo.Pass) {
+        const bool loaded = load_shader(rebuild.GraphicsInfo.Vertex, rebuild.ShaderPaths[0]) && load_shader(rebuild.GraphicsInfo.Fragment, rebuild.ShaderPaths[1]);
+        if (loaded)
+          MAU_ALLOC(rebuild.Graphics, Pipeline, rebuild.GraphicsInfo);
+      } else if (rebuild.IsCompute) {
+        if (load_shader(rebuild.ComputeInfo.Compute, rebuild.ShaderPaths[0]))
+          MAU_ALLOC(rebuild.Compute, ComputePipeline, rebuild.ComputeInfo);
+      } else {
+        const bool loaded = load_shader(rebuild.RayTracingInfo.RayGen, rebuild.ShaderPaths[0]) && load_shader(rebuild.RayTracingInfo.Miss, rebuild.ShaderPaths[1]) &&
+                            load_shader(rebuild.RayTracingInfo.ClosestHit, rebuild.ShaderPaths[2]);
+        // the shader binding table is built with the pipeline
+        if (loaded)
+          MAU_ALLOC(rebuild.RayTracing, RTPipeline, rebuild.RayTracingInfo);
+      }
+    } catch (const std::exception &exception) {
+      LOG_ERROR("failed to rebuild pipeline, keeping the previous one: %s", exception.what());
+    }
+  }
+
+  bool ShaderReloader::SwapRebuilt(TUint64 frame) {
+    MAU_PROFILE_SCOPE("ShaderReloader::SwapRebuilt");
+
+    if (m_RebuildThread.joinable())
+      m_RebuildThread.join();
+
+    TUint32 swapped = 0u;
+    for (Rebuild &rebuild : m_Rebuilds) {
+      Watched &watched = m_Watched[rebuild.Watched];
+
+      if (rebuild.Graphics) {
+        m_Retired.push_back({.Graphics = *watched.Graphics, .Frame = frame});
+        *watched.Graphics = rebuild.Graphics;
+        watched.GraphicsInfo = rebuild.GraphicsInfo;
+        swapped++;
+      }
+
+      if (rebuild.RayTracing) {
+        m_Retired.push_back({.RayTracing = *watched.RayTracing, .Frame = frame});
+        *watched.RayTracing = rebuild.RayTracing;
+        watched.RayTracingInfo = rebuild.RayTracingInfo;
+        swapped++;
+      }
+
+      if (rebuild.Compute) {
+        m_Retired.push_back({.Compute = *watched.Compute, .Frame = frame});
+        *watched.Compute = rebuild.Compute;
+        watched.ComputeInfo = rebuild.ComputeInfo;
+        swapped++;
+      }
+    }
+    m_Rebuilds.clear();
+
+    if (swapped)
+      LOG_INFO("swapped in %u rebuilt pipelines", swapped);
+    return swapped > 0u;
+  }
+
+} // namespace mau
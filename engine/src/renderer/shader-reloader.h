@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <engine/types.h>
+
+#include "graphics/vulkan-pipeline.h"
+
+namespace mau {
+
+  // polls the files below a folder on a thread of its own and collects those whose write time changed
+  class FileWatcher {
+  public:
+    FileWatcher(const String &directory, TUint32 interval_ms = 250u);
+    ~FileWatcher() = default;
+
+  public:
+    // normalized paths of the files written since the last call
+    Vector<String> TakeChanges();
+
+  private:
+    void Poll(std::stop_token stop_token);
+    void Scan(bool report);
+
+  private:
+    String                                                m_Directory = "";
+    TUint32                                               m_IntervalMs = 0u;
+    UnorderedMap<String, std::filesystem::file_time_type> m_WriteTimes = {}; // poll thread only
+    std::mutex                                            m_Mutex = {};
+    std::condition_variable_any                           m_Wake = {};
+    Vector<String>                                        m_Changes = {};
+    std::jthread                                          m_Thread = {};
+  };
+
+  // rebuilds pipelines whose shaders changed on disk. shaders and pipelines are created on a rebuild thread while the
+  // previous pipelines keep rendering, the render thread swaps the new ones in between frames and releases the old
+  // ones once no frame in flight can use them
+  class ShaderReloader: public HandledObject {
+  public:
+    ShaderReloader(const String &shader_directory, TUint32 frames_in_flight);
+    ~ShaderReloader();
+
+  public:
+    // the pipeline handle is replaced in place, it has to outlive the reloader. create_info is what it was created with
+    void Watch(Handle<Pipeline> &pipeline, const PipelineCreateInfo &create_info);
+    void Watch(Handle<RTPipeline> &pipeline, const RTPipelineCreateInfo &create_info);
+    void Watch(Handle<ComputePipeline> &pipeline, const ComputePipelineCreateInfo &create_info);
+
+    // render thread, before a frame is recorded. true when a pipeline was replaced
+    bool Update(TUint64 frame);
+
+  private:
+    struct Watched {
+      Handle<Pipeline>         *Graphics = nullptr;
+      Handle<RTPipeline>       *RayTracing = nullptr;
+      Handle<ComputePipeline>  *Compute = nullptr;
+      PipelineCreateInfo        GraphicsInfo = {};
+      RTPipelineCreateInfo      RayTracingInfo = {};
+      ComputePipelineCreateInfo ComputeInfo = {};
+    };
+
+    // a copy of the create info made on the render thread with the changed shaders taken out, the rebuild thread
+    // loads the shaders from ShaderPaths into the empty slots and creates the pipeline
+    struct Rebuild {
+      TUint32                   Watched = 0u;
+      bool                      IsCompute = false;
+      PipelineCreateInfo        GraphicsInfo = {};
+      RTPipelineCreateInfo      RayTracingInfo = {};
+      ComputePipelineCreateInfo ComputeInfo = {};
+      String                    ShaderPaths[3] = {};
+      Pipeline                 *Graphics = nullptr;
+      RTPipeline               *RayTracing = nullptr;
+      ComputePipeline          *Compute = nullptr;
+    };
+
+    struct Retired {
+      Handle<Pipeline>        Graphics = nullptr;
+      Handle<RTPipeline>      RayTracing = nullptr;
+      Handle<ComputePipeline> Compute = nullptr;
+      TUint64                 Frame = 0u;
+    };
+
+  private:
+    void StartRebuild();
+    bool SwapRebuilt(TUint64 frame);
+    static void RunRebuild(Rebuild &rebuild);
+
+  private:
+    FileWatcher       m_Watcher;
+    TUint32           m_FramesInFlight = 1u;
+    Vector<Watched>   m_Watched = {};
+    Vector<Retired>   m_Retired = {};
+    Vector<String>    m_Pending = {};
+    Vector<Rebuild>   m_Rebuilds = {};
+    std::atomic<bool> m_Rebuilding = false;
+    std::jthread      m_RebuildThread = {};
+  };
+
+} // namespace mau
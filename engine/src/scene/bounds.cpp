@@ -0,0 +1,34 @@
+#include "bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mau {
+
+  static inline const glm::vec3 &get_position(const glm::vec3 *positions, TUint32 stride, TUint64 index) {
+    return *reinterpret_cast<const glm::vec3 *>(reinterpret_cast<const TUint8 *>(positions) + index * stride);
+  }
+
+  void compute_bounds(const glm::vec3 *positions, TUint32 stride, TUint64 count, BoundingBox &box, BoundingSphere &sphere) {
+    box = {};
+    sphere = {};
+    if (positions == nullptr || count == 0u)
+      return;
+
+    for (TUint64 i = 0; i < count; i++) {
+      box.Grow(get_position(positions, stride, i));
+    }
+
+    // squared distances first, one square root at the end
+    const glm::vec3 center = box.GetCenter();
+    TFloat32        radius_squared = 0.0f;
+    for (TUint64 i = 0; i < count; i++) {
+      const glm::vec3 offset = get_position(positions, stride, i) - center;
+      radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+
+    sphere.Center = center;
+    sphere.Radius = std::sqrt(radius_squared);
+  }
+
+} // namespace mau
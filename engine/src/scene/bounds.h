@@ -0,0 +1,34 @@
+#pragma once
+
+#include <limits>
+#include <glm/glm.hpp>
+#include <engine/types.h>
+
+namespace mau {
+
+  // local space bounds of a submesh, an empty box has Min above Max
+  struct BoundingBox {
+    glm::vec3 Min = glm::vec3(std::numeric_limits<TFloat32>::max());
+    glm::vec3 Max = glm::vec3(-std::numeric_limits<TFloat32>::max());
+
+    inline bool      IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+    inline glm::vec3 GetCenter() const { return 0.5f * (Min + Max); }
+    inline glm::vec3 GetExtent() const { return 0.5f * (Max - Min); }
+    inline void      Grow(const glm::vec3 &point) {
+      Min = glm::min(Min, point);
+      Max = glm::max(Max, point);
+    }
+  };
+
+  struct BoundingSphere {
+    glm::vec3 Center = glm::vec3(0.0f);
+    TFloat32  Radius = -1.0f;
+
+    inline bool IsEmpty() const { return Radius < 0.0f; }
+  };
+
+  // positions are read with a byte stride like BvhGeometry, e.g. &vertices[0].pos with stride sizeof(Vertex). the sphere
+  // is centered on the box and reaches the farthest vertex, tighter than the half diagonal for most meshes
+  void compute_bounds(const glm::vec3 *positions, TUint32 stride, TUint64 count, BoundingBox &box, BoundingSphere &sphere);
+
+} // namespace mau
@@ -0,0 +1,819 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <engine/assert.h>
+#include <engine/core/job-system.h>
+#include <engine/log.h>
+#include <engine/profiler.h>
+
+#include "core/simd.h"
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  // child references. a leaf keeps its first triangle in the low bits and the triangle count minus one above them
+  constexpr TUint32 BVH_LEAF_BIT = 1u << 31u;
+  constexpr TUint32 BVH_LEAF_COUNT_SHIFT = 27u;
+  constexpr TUint32 BVH_LEAF_FIRST_MASK = (1u << BVH_LEAF_COUNT_SHIFT) - 1u;
+  constexpr TUint32 BVH_EMPTY_CHILD = UINT32_MAX;
+
+  // traversal stack entries every thread starts with, only deeper trees grow it
+  constexpr TUint32 BVH_STACK_SIZE = 256u;
+  constexpr TUint32 BVH_MAX_BIN_COUNT = 32u;
+
+  // nodes with more primitives than this build their subtrees as separate jobs
+  constexpr TUint32 BVH_TASK_THRESHOLD = 4096u;
+  // nodes with more primitives than this bin and bound them in parallel
+  constexpr TUint32 BVH_PARALLEL_BIN_THRESHOLD = 65536u;
+  constexpr TUint32 BVH_PARALLEL_GRAIN = 16384u;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  struct BvhBounds {
+    glm::vec3 Min = glm::vec3(BVH_INFINITY);
+    glm::vec3 Max = glm::vec3(-BVH_INFINITY);
+
+    inline void Grow(const glm::vec3 &point) {
+      Min = glm::min(Min, point);
+      Max = glm::max(Max, point);
+    }
+
+    inline void Grow(const BvhBounds &bounds) {
+      Min = glm::min(Min, bounds.Min);
+      Max = glm::max(Max, bounds.Max);
+    }
+
+    inline TFloat32 GetArea() const {
+      const glm::vec3 extent = Max - Min;
+      if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f)
+        return 0.0f;
+      return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+  };
+
+  struct BvhPrimitive {
+    BvhBounds Bounds = {};
+    glm::vec3 Centroid = glm::vec3(0.0f);
+  };
+
+  // leaves have a count, inner nodes two children next to each other
+  struct BvhBinaryNode {
+    BvhBounds Bounds = {};
+    TUint32   Left = 0u;
+    TUint32   First = 0u;
+    TUint32   Count = 0u;
+
+    inline bool IsLeaf() const { return Count > 0u; }
+  };
+
+  struct BvhBin {
+    BvhBounds Bounds = {};
+    TUint32   Count = 0u;
+  };
+
+  // per axis bins of a range of primitives, merged when binned in parallel
+  struct BvhBinning {
+    BvhBin Bins[3][BVH_MAX_BIN_COUNT] = {};
+  };
+
+  struct BvhSplit {
+    TUint32  BinCount = 0u;
+    TUint32  Axis = UINT32_MAX;
+    TUint32  Bin = 0u;
+    TFloat32 Cost = BVH_INFINITY;
+  };
+
+  // top down binned sah split of primitives into a binary tree, the primitive order ends up in leaf order
+  class BvhBinaryBuilder {
+  public:
+    BvhBinaryBuilder(const Vector<BvhPrimitive> &primitives, const BvhBuildOptions &options, bool parallel)
+        : m_Primitives(primitives), m_Options(options), m_Parallel(parallel) {
+      m_Options.BinCount = std::clamp(options.BinCount, 2u, BVH_MAX_BIN_COUNT);
+      m_Options.MaxLeafSize = std::clamp(options.MaxLeafSize, 1u, BVH_MAX_LEAF_SIZE);
+    }
+
+  public:
+    void Build() {
+      const TUint32 count = static_cast<TUint32>(m_Primitives.size());
+
+      m_Indices.resize(count);
+      for (TUint32 i = 0u; i < count; i++) {
+        m_Indices[i] = i;
+      }
+
+      // a binary tree with single primitive leaves has 2n - 1 nodes, so children can be taken without locking
+      m_Nodes.resize(std::max(2u * count, 1u));
+      m_NodeCount.store(1u);
+
+      JobCounter counter = {};
+      BuildNode(0u, 0u, count, counter);
+      if (m_Parallel) {
+        JobSystem::Ref().Wait(counter);
+      }
+
+      m_Nodes.resize(m_NodeCount.load());
+    }
+
+  public:
+    inline const Vector<BvhBinaryNode> &GetNodes() const { return m_Nodes; }
+    inline const Vector<TUint32>       &GetIndices() const { return m_Indices; }
+
+  private:
+    void Bound(TUint32 begin, TUint32 end, BvhBounds &bounds, BvhBounds &centroids) const {
+      for (TUint32 i = begin; i < end; i++) {
+        const BvhPrimitive &primitive = m_Primitives[m_Indices[i]];
+        bounds.Grow(primitive.Bounds);
+        centroids.Grow(primitive.Centroid);
+      }
+    }
+
+    void Bin(TUint32 begin, TUint32 end, const BvhBounds &centroids, TUint32 bin_count, BvhBinning &binning) const {
+      const glm::vec3 scale = BinScale(centroids, bin_count);
+      for (TUint32 i = begin; i < end; i++) {
+        const BvhPrimitive &primitive = m_Primitives[m_Indices[i]];
+        for (TUint32 axis = 0u; axis < 3u; axis++) {
+          BvhBin &bin = binning.Bins[axis][BinIndex(primitive.Centroid[axis], centroids.Min[axis], scale[axis], bin_count)];
+          bin.Bounds.Grow(primitive.Bounds);
+          bin.Count++;
+        }
+      }
+    }
+
+    glm::vec3 BinScale(const BvhBounds &centroids, TUint32 bin_count) const {
+      const glm::vec3 extent = centroids.Max - centroids.Min;
+      const TFloat32  bins = static_cast<TFloat32>(bin_count);
+      return glm::vec3(extent.x > 0.0f ? bins / extent.x : 0.0f, extent.y > 0.0f ? bins / extent.y : 0.0f, extent.z > 0.0f ? bins / extent.z : 0.0f);
+    }
+
+    TUint32 BinIndex(TFloat32 centroid, TFloat32 min, TFloat32 scale, TUint32 bin_count) const {
+      const TInt32 bin = static_cast<TInt32>((centroid - min) * scale);
+      return static_cast<TUint32>(std::clamp(bin, 0, static_cast<TInt32>(bin_count) - 1));
+    }
+
+    void MakeLeaf(BvhBinaryNode &node, TUint32 begin, TUint32 end) {
+      node.First = begin;
+      node.Count = end - begin;
+    }
+
+    // cheapest split plane, no axis when the centroids do not spread along any. kept out of BuildNode so the
+    // bins are off the stack while recursing
+    BvhSplit FindSplit(TUint32 begin, TUint32 end, const BvhBounds &centroids, bool parallel_range) const {
+      // small nodes are most of the tree, more bins than primitives only adds to sweeping
+      BvhSplit split = {.BinCount = std::min(m_Options.BinCount, std::max(end - begin, 4u))};
+
+      BvhBinning binning = {};
+      if (parallel_range) {
+        std::mutex mutex = {};
+        JobSystem::Ref().ParallelFor(end - begin, BVH_PARALLEL_GRAIN, [&](TUint32 range_begin, TUint32 range_end) {
+          BvhBinning range_binning = {};
+          Bin(begin + range_begin, begin + range_end, centroids, split.BinCount, range_binning);
+
+          std::lock_guard<std::mutex> lock(mutex);
+          for (TUint32 axis = 0u; axis < 3u; axis++) {
+            for (TUint32 b = 0u; b < split.BinCount; b++) {
+              binning.Bins[axis][b].Bounds.Grow(range_binning.Bins[axis][b].Bounds);
+              binning.Bins[axis][b].Count += range_binning.Bins[axis][b].Count;
+            }
+          }
+        });
+      } else {
+        Bin(begin, end, centroids, split.BinCount, binning);
+      }
+
+      // sweep the bins from the right to get the cost of every split plane, then from the left to pick the best
+      const glm::vec3 centroid_extent = centroids.Max - centroids.Min;
+      for (TUint32 axis = 0u; axis < 3u; axis++) {
+        if (centroid_extent[axis] <= 0.0f)
+          continue;
+
+        const BvhBin *bins = binning.Bins[axis];
+
+        TFloat32  right_cost[BVH_MAX_BIN_COUNT];
+        BvhBounds right_bounds = {};
+        TUint32   right_count = 0u;
+        for (TUint32 b = split.BinCount - 1u; b > 0u; b--) {
+          right_bounds.Grow(bins[b].Bounds);
+          right_count += bins[b].Count;
+          right_cost[b - 1u] = right_bounds.GetArea() * static_cast<TFloat32>(right_count);
+        }
+
+        BvhBounds left_bounds = {};
+        TUint32   left_count = 0u;
+        for (TUint32 b = 0u; b + 1u < split.BinCount; b++) {
+          left_bounds.Grow(bins[b].Bounds);
+          left_count += bins[b].Count;
+          if (left_count == 0u || left_count == end - begin)
+            continue;
+
+          const TFloat32 cost = left_bounds.GetArea() * static_cast<TFloat32>(left_count) + right_cost[b];
+          if (cost < split.Cost) {
+            split.Cost = cost;
+            split.Axis = axis;
+            split.Bin = b;
+          }
+        }
+      }
+
+      return split;
+    }
+
+    void BuildNode(TUint32 node_index, TUint32 begin, TUint32 end, JobCounter &counter) {
+      BvhBinaryNode &node = m_Nodes[node_index];
+      const TUint32  count = end - begin;
+      const bool     parallel_range = m_Parallel && count > BVH_PARALLEL_BIN_THRESHOLD;
+
+      BvhBounds centroids = {};
+      if (parallel_range) {
+        std::mutex mutex = {};
+        JobSystem::Ref().ParallelFor(count, BVH_PARALLEL_GRAIN, [&](TUint32 range_begin, TUint32 range_end) {
+          BvhBounds bounds = {}, range_centroids = {};
+          Bound(begin + range_begin, begin + range_end, bounds, range_centroids);
+
+          std::lock_guard<std::mutex> lock(mutex);
+          node.Bounds.Grow(bounds);
+          centroids.Grow(range_centroids);
+        });
+      } else {
+        Bound(begin, end, node.Bounds, centroids);
+      }
+
+      if (count == 1u) {
+        MakeLeaf(node, begin, end);
+        return;
+      }
+
+      const BvhSplit split = FindSplit(begin, end, centroids, parallel_range);
+
+      const TFloat32 area = node.Bounds.GetArea();
+      const TFloat32 split_cost = m_Options.TraversalCost + m_Options.IntersectionCost * (area > 0.0f ? split.Cost / area : 0.0f);
+      const TFloat32 leaf_cost = m_Options.IntersectionCost * static_cast<TFloat32>(count);
+
+      if (count <= m_Options.MaxLeafSize && (split.Axis == UINT32_MAX || leaf_cost <= split_cost)) {
+        MakeLeaf(node, begin, end);
+        return;
+      }
+
+      TUint32 middle = begin + count / 2u;
+      if (split.Axis != UINT32_MAX) {
+        const TFloat32 min = centroids.Min[split.Axis];
+        const TFloat32 scale = BinScale(centroids, split.BinCount)[split.Axis];
+        const auto     partition = std::partition(m_Indices.begin() + begin, m_Indices.begin() + end, [&](TUint32 index) -> bool {
+          return BinIndex(m_Primitives[index].Centroid[split.Axis], min, scale, split.BinCount) <= split.Bin;
+        });
+        middle = static_cast<TUint32>(partition - m_Indices.begin());
+      }
+
+      // coincident centroids cannot be told apart by any plane, halves keep the leaves small
+      if (middle == begin || middle == end) {
+        middle = begin + count / 2u;
+      }
+
+      const TUint32 left = m_NodeCount.fetch_add(2u);
+      node.Left = left;
+
+      if (m_Parallel && count > BVH_TASK_THRESHOLD) {
+        JobSystem::Ref().Schedule([this, left, begin, middle, &counter]() { BuildNode(left, begin, middle, counter); }, &counter);
+        BuildNode(left + 1u, middle, end, counter);
+      } else {
+        BuildNode(left, begin, middle, counter);
+        BuildNode(left + 1u, middle, end, counter);
+      }
+    }
+
+  private:
+    const Vector<BvhPrimitive> &m_Primitives;
+    BvhBuildOptions             m_Options = {};
+    bool                        m_Parallel = false;
+
+    Vector<BvhBinaryNode> m_Nodes = {};
+    Vector<TUint32>       m_Indices = {};
+    std::atomic<TUint32>  m_NodeCount = 0u;
+  };
+
+  // moller trumbore, t is only written when the hit is within [t_min, t_max]
+  static inline bool intersect_triangle(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &v0, const glm::vec3 &e1, const glm::vec3 &e2, TFloat32 t_min, TFloat32 t_max,
+                                        TFloat32 &t, TFloat32 &u, TFloat32 &v) {
+    const glm::vec3 p = glm::cross(direction, e2);
+    const TFloat32  det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f)
+      return false;
+
+    const TFloat32  inv_det = 1.0f / det;
+    const glm::vec3 s = origin - v0;
+    const TFloat32  hit_u = glm::dot(s, p) * inv_det;
+    if (hit_u < 0.0f || hit_u > 1.0f)
+      return false;
+
+    const glm::vec3 q = glm::cross(s, e1);
+    const TFloat32  hit_v = glm::dot(direction, q) * inv_det;
+    if (hit_v < 0.0f || hit_u + hit_v > 1.0f)
+      return false;
+
+    const TFloat32 hit_t = glm::dot(e2, q) * inv_det;
+    if (hit_t < t_min || hit_t > t_max)
+      return false;
+
+    t = hit_t;
+    u = hit_u;
+    v = hit_v;
+    return true;
+  }
+
+  // zero direction components would turn slab tests into 0 * inf
+  static inline glm::vec3 safe_inverse(const glm::vec3 &direction) {
+    glm::vec3 inverse = glm::vec3(0.0f);
+    for (TUint32 axis = 0u; axis < 3u; axis++) {
+      const TFloat32 d = std::fabs(direction[axis]) > 1e-20f ? direction[axis] : std::copysign(1e-20f, direction[axis]);
+      inverse[axis] = 1.0f / d;
+    }
+    return inverse;
+  }
+
+  struct BvhStackEntry {
+    TUint32  Child;
+    TFloat32 Distance;
+  };
+
+  // a popped node pushes at most Width children, so the stack never holds more than Width - 1 entries per level of the
+  // path plus the children of the last node. capacity is that bound for the built tree. every thread keeps one stack per
+  // entry type and grows it to the deepest tree it traversed, queries don't allocate once it is big enough
+  template <typename T> static T *traversal_stack(TUint32 capacity) {
+    static thread_local Vector<T> stack(BVH_STACK_SIZE);
+    if (stack.size() < capacity) {
+      stack.resize(capacity);
+    }
+    return stack.data();
+  }
+
+  // pushes the hit children of a node so the nearest one is popped first
+  static inline void push_children(BvhStackEntry *stack, TUint32 &size, const TUint32 *children, const TFloat32 *distances, TUint32 mask) {
+    const TUint32 first = size;
+    while (mask != 0u) {
+      const TUint32 c = static_cast<TUint32>(std::countr_zero(mask));
+      mask &= mask - 1u;
+
+      TUint32 i = size++;
+      while (i > first && stack[i - 1u].Distance < distances[c]) {
+        stack[i] = stack[i - 1u];
+        i--;
+      }
+      stack[i] = {children[c], distances[c]};
+    }
+  }
+
+  template <TUint32 Width> void Bvh<Width>::Build(const Vector<BvhGeometry> &geometries, const BvhBuildOptions &options) {
+    MAU_PROFILE_SCOPE("Bvh::Build");
+    const Clock::time_point build_start = Clock::now();
+
+    m_Nodes.clear();
+    m_Triangles.clear();
+    m_Stats = {};
+    m_StackSize = 1u;
+    m_BoundsMin = glm::vec3(BVH_INFINITY);
+    m_BoundsMax = glm::vec3(-BVH_INFINITY);
+
+    JobSystem *jobs = JobSystem::Get();
+    const bool parallel = options.Parallel && jobs != nullptr && jobs->GetWorkerCount() > 0u;
+
+    Vector<TUint32> first_triangle(geometries.size() + 1u, 0u);
+    for (size_t g = 0; g < geometries.size(); g++) {
+      first_triangle[g + 1u] = first_triangle[g] + static_cast<TUint32>(geometries[g].IndexCount / 3u);
+    }
+
+    const TUint32 triangle_count = first_triangle.back();
+    ASSERT(triangle_count < BVH_LEAF_FIRST_MASK);
+    if (triangle_count == 0u)
+      return;
+
+    // world space triangles and their bounds
+    Vector<Triangle>     triangles(triangle_count);
+    Vector<BvhPrimitive> primitives(triangle_count);
+
+    auto prepare = [&](TUint32 begin, TUint32 end) {
+      TUint32 g = static_cast<TUint32>(std::upper_bound(first_triangle.begin(), first_triangle.end(), begin) - first_triangle.begin()) - 1u;
+      for (TUint32 i = begin; i < end; i++) {
+        while (i >= first_triangle[g + 1u]) {
+          g++;
+        }
+
+        const BvhGeometry &geometry = geometries[g];
+        const TUint32      primitive = i - first_triangle[g];
+
+        glm::vec3 vertices[3];
+        for (TUint32 k = 0u; k < 3u; k++) {
+          const TUint32    index = geometry.Indices[3u * primitive + k];
+          const glm::vec3 &position = *reinterpret_cast<const glm::vec3 *>(reinterpret_cast<const TUint8 *>(geometry.Positions) + static_cast<TUint64>(index) * geometry.PositionStride);
+          vertices[k] = glm::vec3(geometry.Transform * glm::vec4(position, 1.0f));
+        }
+
+        triangles[i] = {vertices[0], g, vertices[1] - vertices[0], primitive, vertices[2] - vertices[0], 0u};
+
+        BvhPrimitive &bounds = primitives[i];
+        bounds.Bounds.Grow(vertices[0]);
+        bounds.Bounds.Grow(vertices[1]);
+        bounds.Bounds.Grow(vertices[2]);
+        bounds.Centroid = 0.5f * (bounds.Bounds.Min + bounds.Bounds.Max);
+      }
+    };
+
+    if (parallel) {
+      jobs->ParallelFor(triangle_count, BVH_PARALLEL_GRAIN, prepare);
+    } else {
+      prepare(0u, triangle_count);
+    }
+
+    const Clock::time_point binary_start = Clock::now();
+
+    BvhBinaryBuilder builder(primitives, options, parallel);
+    builder.Build();
+
+    const Vector<BvhBinaryNode> &binary = builder.GetNodes();
+    const Vector<TUint32>       &indices = builder.GetIndices();
+
+    m_Stats.BinaryMs = elapsed_ms(binary_start);
+    const Clock::time_point collapse_start = Clock::now();
+
+    m_Triangles.resize(triangle_count);
+    for (TUint32 i = 0u; i < triangle_count; i++) {
+      m_Triangles[i] = triangles[indices[i]];
+    }
+
+    m_BoundsMin = binary[0].Bounds.Min;
+    m_BoundsMax = binary[0].Bounds.Max;
+
+    const TFloat32 root_area = binary[0].Bounds.GetArea();
+    const TFloat32 inv_root_area = root_area > 0.0f ? 1.0f / root_area : 0.0f;
+
+    // every wide node takes the children of a binary node and keeps opening its largest inner child until it
+    // has Width of them. the root is always an inner node so traversal can start without checking
+    struct CollapseItem {
+      TUint32 Binary;
+      TUint32 Wide;
+      TUint32 Depth;
+    };
+
+    m_Nodes.reserve(binary.size() / 2u + 1u);
+    m_Nodes.emplace_back();
+
+    Vector<CollapseItem> pending = {{0u, 0u, 1u}};
+    TFloat64             sah_cost = 0.0;
+
+    while (!pending.empty()) {
+      const CollapseItem item = pending.back();
+      pending.pop_back();
+
+      m_Stats.MaxDepth = std::max(m_Stats.MaxDepth, item.Depth);
+      sah_cost += options.TraversalCost * binary[item.Binary].Bounds.GetArea() * inv_root_area;
+
+      TUint32 children[Width];
+      TUint32 child_count = 0u;
+
+      const BvhBinaryNode &parent = binary[item.Binary];
+      if (parent.IsLeaf()) {
+        children[child_count++] = item.Binary;
+      } else {
+        children[child_count++] = parent.Left;
+        children[child_count++] = parent.Left + 1u;
+      }
+
+      while (child_count < Width) {
+        TUint32  largest = UINT32_MAX;
+        TFloat32 largest_area = -1.0f;
+        for (TUint32 c = 0u; c < child_count; c++) {
+          const BvhBinaryNode &child = binary[children[c]];
+          if (!child.IsLeaf() && child.Bounds.GetArea() > largest_area) {
+            largest = c;
+            largest_area = child.Bounds.GetArea();
+          }
+        }
+
+        if (largest == UINT32_MAX)
+          break;
+
+        const TUint32 opened = children[largest];
+        children[largest] = binary[opened].Left;
+        children[child_count++] = binary[opened].Left + 1u;
+      }
+
+      Node node = {};
+      for (TUint32 c = 0u; c < Width; c++) {
+        for (TUint32 axis = 0u; axis < 3u; axis++) {
+          node.Bounds[axis][c] = BVH_INFINITY;
+          node.Bounds[axis + 3u][c] = -BVH_INFINITY;
+        }
+        node.Child[c] = BVH_EMPTY_CHILD;
+      }
+
+      for (TUint32 c = 0u; c < child_count; c++) {
+        const BvhBinaryNode &child = binary[children[c]];
+        for (TUint32 axis = 0u; axis < 3u; axis++) {
+          node.Bounds[axis][c] = child.Bounds.Min[axis];
+          node.Bounds[axis + 3u][c] = child.Bounds.Max[axis];
+        }
+
+        if (child.IsLeaf()) {
+          node.Child[c] = BVH_LEAF_BIT | ((child.Count - 1u) << BVH_LEAF_COUNT_SHIFT) | child.First;
+          sah_cost += options.IntersectionCost * child.Bounds.GetArea() * inv_root_area * static_cast<TFloat32>(child.Count);
+          m_Stats.LeafCount++;
+          m_Stats.MaxDepth = std::max(m_Stats.MaxDepth, item.Depth + 1u);
+        } else {
+          node.Child[c] = static_cast<TUint32>(m_Nodes.size());
+          m_Nodes.emplace_back();
+          pending.push_back({children[c], node.Child[c], item.Depth + 1u});
+        }
+      }
+
+      m_Nodes[item.Wide] = node;
+    }
+
+    m_StackSize = (Width - 1u) * m_Stats.MaxDepth + 1u;
+
+    m_Stats.CollapseMs = elapsed_ms(collapse_start);
+    m_Stats.BuildMs = elapsed_ms(build_start);
+    m_Stats.TriangleCount = triangle_count;
+    m_Stats.BinaryNodeCount = static_cast<TUint32>(binary.size());
+    m_Stats.NodeCount = static_cast<TUint32>(m_Nodes.size());
+    m_Stats.SahCost = static_cast<TFloat32>(sah_cost);
+  }
+
+  template <TUint32 Width> bool Bvh<Width>::Intersect(const BvhRay &ray, BvhHit &hit) const {
+    using Float = SimdFloat<Width>;
+
+    if (m_Nodes.empty())
+      return false;
+
+    const glm::vec3 inverse = safe_inverse(ray.Direction);
+
+    // the near plane of every slab is the min bound for positive directions and the max bound otherwise
+    const TUint32 near_x = inverse.x >= 0.0f ? 0u : 3u;
+    const TUint32 near_y = inverse.y >= 0.0f ? 1u : 4u;
+    const TUint32 near_z = inverse.z >= 0.0f ? 2u : 5u;
+
+    const Float origin_x = Float::Broadcast(ray.Origin.x), origin_y = Float::Broadcast(ray.Origin.y), origin_z = Float::Broadcast(ray.Origin.z);
+    const Float inverse_x = Float::Broadcast(inverse.x), inverse_y = Float::Broadcast(inverse.y), inverse_z = Float::Broadcast(inverse.z);
+    const Float t_min = Float::Broadcast(ray.TMin);
+
+    TFloat32 t_max = ray.TMax;
+    TUint32  hit_triangle = UINT32_MAX;
+
+    BvhStackEntry *stack = traversal_stack<BvhStackEntry>(m_StackSize);
+    TUint32        size = 0u;
+    stack[size++] = {0u, ray.TMin};
+
+    while (size > 0u) {
+      const BvhStackEntry entry = stack[--size];
+      if (entry.Distance > t_max)
+        continue;
+
+      if (entry.Child & BVH_LEAF_BIT) {
+        const TUint32 first = entry.Child & BVH_LEAF_FIRST_MASK;
+        const TUint32 count = ((entry.Child & ~BVH_LEAF_BIT) >> BVH_LEAF_COUNT_SHIFT) + 1u;
+        for (TUint32 i = first; i < first + count; i++) {
+          const Triangle &triangle = m_Triangles[i];
+          if (intersect_triangle(ray.Origin, ray.Direction, triangle.Vertex0, triangle.Edge1, triangle.Edge2, ray.TMin, t_max, t_max, hit.U, hit.V)) {
+            hit_triangle = i;
+          }
+        }
+        continue;
+      }
+
+      const Node &node = m_Nodes[entry.Child];
+
+      const Float near_t = Max(Max((Float::Load(node.Bounds[near_x]) - origin_x) * inverse_x, (Float::Load(node.Bounds[near_y]) - origin_y) * inverse_y),
+                               Max((Float::Load(node.Bounds[near_z]) - origin_z) * inverse_z, t_min));
+      const Float far_t = Min(Min((Float::Load(node.Bounds[(near_x + 3u) % 6u]) - origin_x) * inverse_x, (Float::Load(node.Bounds[(near_y + 3u) % 6u]) - origin_y) * inverse_y),
+                              Min((Float::Load(node.Bounds[(near_z + 3u) % 6u]) - origin_z) * inverse_z, Float::Broadcast(t_max)));
+
+      const TUint32 mask = (near_t <= far_t).GetBits();
+      if (mask == 0u)
+        continue;
+
+      TFloat32 distances[Width];
+      near_t.Store(distances);
+      push_children(stack, size, node.Child, distances, mask);
+    }
+
+    if (hit_triangle == UINT32_MAX)
+      return false;
+
+    const Triangle &triangle = m_Triangles[hit_triangle];
+    hit.T = t_max;
+    hit.Geometry = triangle.Geometry;
+    hit.Primitive = triangle.Primitive;
+    return true;
+  }
+
+  template <TUint32 Width> bool Bvh<Width>::Occluded(const BvhRay &ray) const {
+    using Float = SimdFloat<Width>;
+
+    if (m_Nodes.empty())
+      return false;
+
+    const glm::vec3 inverse = safe_inverse(ray.Direction);
+
+    const TUint32 near_x = inverse.x >= 0.0f ? 0u : 3u;
+    const TUint32 near_y = inverse.y >= 0.0f ? 1u : 4u;
+    const TUint32 near_z = inverse.z >= 0.0f ? 2u : 5u;
+
+    const Float origin_x = Float::Broadcast(ray.Origin.x), origin_y = Float::Broadcast(ray.Origin.y), origin_z = Float::Broadcast(ray.Origin.z);
+    const Float inverse_x = Float::Broadcast(inverse.x), inverse_y = Float::Broadcast(inverse.y), inverse_z = Float::Broadcast(inverse.z);
+    const Float t_min = Float::Broadcast(ray.TMin), t_max = Float::Broadcast(ray.TMax);
+
+    // any hit ends the query, children are visited in whatever order they come
+    TUint32 *stack = traversal_stack<TUint32>(m_StackSize);
+    TUint32  size = 0u;
+    stack[size++] = 0u;
+
+    while (size > 0u) {
+      const TUint32 child = stack[--size];
+
+      if (child & BVH_LEAF_BIT) {
+        const TUint32 first = child & BVH_LEAF_FIRST_MASK;
+        const TUint32 count = ((child & ~BVH_LEAF_BIT) >> BVH_LEAF_COUNT_SHIFT) + 1u;
+        for (TUint32 i = first; i < first + count; i++) {
+          const Triangle &triangle = m_Triangles[i];
+          TFloat32        t = 0.0f, u = 0.0f, v = 0.0f;
+          if (intersect_triangle(ray.Origin, ray.Direction, triangle.Vertex0, triangle.Edge1, triangle.Edge2, ray.TMin, ray.TMax, t, u, v))
+            return true;
+        }
+        continue;
+      }
+
+      const Node &node = m_Nodes[child];
+
+      const Float near_t = Max(Max((Float::Load(node.Bounds[near_x]) - origin_x) * inverse_x, (Float::Load(node.Bounds[near_y]) - origin_y) * inverse_y),
+                               Max((Float::Load(node.Bounds[near_z]) - origin_z) * inverse_z, t_min));
+      const Float far_t = Min(Min((Float::Load(node.Bounds[(near_x + 3u) % 6u]) - origin_x) * inverse_x, (Float::Load(node.Bounds[(near_y + 3u) % 6u]) - origin_y) * inverse_y),
+                              Min((Float::Load(node.Bounds[(near_z + 3u) % 6u]) - origin_z) * inverse_z, t_max));
+
+      TUint32 mask = (near_t <= far_t).GetBits();
+      while (mask != 0u) {
+        stack[size++] = node.Child[std::countr_zero(mask)];
+        mask &= mask - 1u;
+      }
+    }
+
+    return false;
+  }
+
+  // eight rays in structure of arrays layout
+  struct BvhPacketVector {
+    SimdFloat8 X, Y, Z;
+  };
+
+  static inline BvhPacketVector packet_cross(const BvhPacketVector &a, const BvhPacketVector &b) {
+    return {a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X};
+  }
+
+  static inline SimdFloat8 packet_dot(const BvhPacketVector &a, const BvhPacketVector &b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+
+  static inline BvhPacketVector packet_broadcast(const glm::vec3 &v) { return {SimdFloat8::Broadcast(v.x), SimdFloat8::Broadcast(v.y), SimdFloat8::Broadcast(v.z)}; }
+
+  template <TUint32 Width> void Bvh<Width>::IntersectPacket(const BvhRay *rays, BvhHit *hits, TUint32 count) const {
+    ASSERT(count <= BVH_PACKET_SIZE);
+
+    for (TUint32 i = 0u; i < count; i++) {
+      hits[i] = {};
+    }
+
+    if (m_Nodes.empty() || count == 0u)
+      return;
+
+    // unused lanes get an empty interval so they never hit anything
+    alignas(32) TFloat32 lanes[9][BVH_PACKET_SIZE];
+    for (TUint32 i = 0u; i < BVH_PACKET_SIZE; i++) {
+      const BvhRay   &ray = rays[std::min(i, count - 1u)];
+      const glm::vec3 inverse = safe_inverse(ray.Direction);
+      for (TUint32 axis = 0u; axis < 3u; axis++) {
+        lanes[axis][i] = ray.Origin[axis];
+        lanes[axis + 3u][i] = ray.Direction[axis];
+        lanes[axis + 6u][i] = inverse[axis];
+      }
+    }
+
+    alignas(32) TFloat32 t_min_lanes[BVH_PACKET_SIZE];
+    alignas(32) TFloat32 t_max_lanes[BVH_PACKET_SIZE];
+    for (TUint32 i = 0u; i < BVH_PACKET_SIZE; i++) {
+      t_min_lanes[i] = i < count ? rays[i].TMin : 0.0f;
+      t_max_lanes[i] = i < count ? rays[i].TMax : -BVH_INFINITY;
+    }
+
+    const BvhPacketVector origin = {SimdFloat8::Load(lanes[0]), SimdFloat8::Load(lanes[1]), SimdFloat8::Load(lanes[2])};
+    const BvhPacketVector direction = {SimdFloat8::Load(lanes[3]), SimdFloat8::Load(lanes[4]), SimdFloat8::Load(lanes[5])};
+    const BvhPacketVector inverse = {SimdFloat8::Load(lanes[6]), SimdFloat8::Load(lanes[7]), SimdFloat8::Load(lanes[8])};
+    const SimdFloat8      t_min = SimdFloat8::Load(t_min_lanes);
+    SimdFloat8            t_max = SimdFloat8::Load(t_max_lanes);
+
+    const SimdFloat8 zero = SimdFloat8::Broadcast(0.0f);
+    const SimdFloat8 one = SimdFloat8::Broadcast(1.0f);
+    const SimdFloat8 epsilon = SimdFloat8::Broadcast(1e-12f);
+
+    SimdFloat8 hit_u = zero, hit_v = zero;
+    TUint32    hit_triangles[BVH_PACKET_SIZE];
+    std::fill(hit_triangles, hit_triangles + BVH_PACKET_SIZE, UINT32_MAX);
+
+    // a node is entered once for the whole packet, children are ordered by the nearest entry of any ray
+    BvhStackEntry *stack = traversal_stack<BvhStackEntry>(m_StackSize);
+    TUint32        size = 0u;
+    stack[size++] = {0u, 0.0f};
+
+    while (size > 0u) {
+      const TUint32 child = stack[--size].Child;
+
+      if (child & BVH_LEAF_BIT) {
+        const TUint32 first = child & BVH_LEAF_FIRST_MASK;
+        const TUint32 leaf_count = ((child & ~BVH_LEAF_BIT) >> BVH_LEAF_COUNT_SHIFT) + 1u;
+        for (TUint32 i = first; i < first + leaf_count; i++) {
+          const Triangle       &triangle = m_Triangles[i];
+          const BvhPacketVector e1 = packet_broadcast(triangle.Edge1);
+          const BvhPacketVector e2 = packet_broadcast(triangle.Edge2);
+          const BvhPacketVector v0 = packet_broadcast(triangle.Vertex0);
+
+          const BvhPacketVector p = packet_cross(direction, e2);
+          const SimdFloat8      det = packet_dot(e1, p);
+          const SimdFloat8      inv_det = one / det;
+          const BvhPacketVector s = {origin.X - v0.X, origin.Y - v0.Y, origin.Z - v0.Z};
+          const SimdFloat8      u = packet_dot(s, p) * inv_det;
+          const BvhPacketVector q = packet_cross(s, e1);
+          const SimdFloat8      v = packet_dot(direction, q) * inv_det;
+          const SimdFloat8      t = packet_dot(e2, q) * inv_det;
+
+          const SimdMask8 valid = ((det > epsilon) | (det < zero - epsilon)) & (u >= zero) & (v >= zero) & (u + v <= one) & (t >= t_min) & (t <= t_max);
+
+          TUint32 mask = valid.GetBits();
+          if (mask == 0u)
+            continue;
+
+          t_max = Select(valid, t, t_max);
+          hit_u = Select(valid, u, hit_u);
+          hit_v = Select(valid, v, hit_v);
+          while (mask != 0u) {
+            hit_triangles[std::countr_zero(mask)] = i;
+            mask &= mask - 1u;
+          }
+        }
+        continue;
+      }
+
+      const Node &node = m_Nodes[child];
+
+      TFloat32 distances[Width];
+      TUint32  mask = 0u;
+      for (TUint32 c = 0u; c < Width; c++) {
+        if (node.Child[c] == BVH_EMPTY_CHILD)
+          continue;
+
+        const SimdFloat8 x0 = (SimdFloat8::Broadcast(node.Bounds[0][c]) - origin.X) * inverse.X, x1 = (SimdFloat8::Broadcast(node.Bounds[3][c]) - origin.X) * inverse.X;
+        const SimdFloat8 y0 = (SimdFloat8::Broadcast(node.Bounds[1][c]) - origin.Y) * inverse.Y, y1 = (SimdFloat8::Broadcast(node.Bounds[4][c]) - origin.Y) * inverse.Y;
+        const SimdFloat8 z0 = (SimdFloat8::Broadcast(node.Bounds[2][c]) - origin.Z) * inverse.Z, z1 = (SimdFloat8::Broadcast(node.Bounds[5][c]) - origin.Z) * inverse.Z;
+
+        const SimdFloat8 near_t = Max(Max(Min(x0, x1), Min(y0, y1)), Max(Min(z0, z1), t_min));
+        const SimdFloat8 far_t = Min(Min(Max(x0, x1), Max(y0, y1)), Min(Max(z0, z1), t_max));
+
+        const TUint32 lanes_hit = (near_t <= far_t).GetBits();
+        if (lanes_hit == 0u)
+          continue;
+
+        alignas(32) TFloat32 near_lanes[BVH_PACKET_SIZE];
+        near_t.Store(near_lanes);
+
+        distances[c] = BVH_INFINITY;
+        for (TUint32 bits = lanes_hit; bits != 0u; bits &= bits - 1u) {
+          distances[c] = std::min(distances[c], near_lanes[std::countr_zero(bits)]);
+        }
+        mask |= 1u << c;
+      }
+
+      push_children(stack, size, node.Child, distances, mask);
+    }
+
+    alignas(32) TFloat32 t_lanes[BVH_PACKET_SIZE], u_lanes[BVH_PACKET_SIZE], v_lanes[BVH_PACKET_SIZE];
+    t_max.Store(t_lanes);
+    hit_u.Store(u_lanes);
+    hit_v.Store(v_lanes);
+
+    for (TUint32 i = 0u; i < count; i++) {
+      if (hit_triangles[i] == UINT32_MAX)
+        continue;
+
+      const Triangle &triangle = m_Triangles[hit_triangles[i]];
+      hits[i] = {
+          .T = t_lanes[i],
+          .U = u_lanes[i],
+          .V = v_lanes[i],
+          .Geometry = triangle.Geometry,
+          .Primitive = triangle.Primitive,
+      };
+    }
+  }
+
+  template class Bvh<4u>;
+  template class Bvh<8u>;
+
+} // namespace mau
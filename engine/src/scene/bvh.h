@@ -0,0 +1,122 @@
+#pragma once
+
+#include <limits>
+#include <glm/glm.hpp>
+#include <engine/types.h>
+
+namespace mau {
+
+  constexpr TFloat32 BVH_INFINITY = std::numeric_limits<TFloat32>::infinity();
+
+  // rays of a packet share one traversal, IntersectPacket takes up to this many
+  constexpr TUint32 BVH_PACKET_SIZE = 8u;
+
+  // leaves hold at most this many triangles, the count is packed into the child reference
+  constexpr TUint32 BVH_MAX_LEAF_SIZE = 16u;
+
+  struct BvhRay {
+    glm::vec3 Origin = glm::vec3(0.0f);
+    TFloat32  TMin = 0.0f;
+    glm::vec3 Direction = glm::vec3(0.0f, 0.0f, 1.0f);
+    TFloat32  TMax = BVH_INFINITY;
+  };
+
+  // barycentrics are those of vertex 1 and 2, primitive is the triangle index inside its geometry
+  struct BvhHit {
+    TFloat32 T = BVH_INFINITY;
+    TFloat32 U = 0.0f;
+    TFloat32 V = 0.0f;
+    TUint32  Geometry = UINT32_MAX;
+    TUint32  Primitive = UINT32_MAX;
+
+    inline bool IsHit() const { return Geometry != UINT32_MAX; }
+  };
+
+  // indexed triangles of one submesh. positions are read with a byte stride so vertex arrays can be passed as they
+  // are, e.g. Positions = &vertices[0].pos with PositionStride = sizeof(Vertex). the transform is baked into the bvh
+  struct BvhGeometry {
+    const glm::vec3 *Positions = nullptr;
+    TUint32          PositionStride = sizeof(glm::vec3);
+    TUint64          VertexCount = 0u;
+    const TUint32   *Indices = nullptr;
+    TUint64          IndexCount = 0u;
+    glm::mat4        Transform = glm::mat4(1.0f);
+  };
+
+  struct BvhBuildOptions {
+    TUint32  BinCount = 16u;
+    TUint32  MaxLeafSize = 8u;
+    TFloat32 TraversalCost = 1.0f;
+    TFloat32 IntersectionCost = 1.0f;
+    // subtrees and the binning of big nodes run as jobs, needs the job system
+    bool Parallel = true;
+  };
+
+  // sah cost is relative to the root's surface area, in units of one triangle test
+  struct BvhBuildStats {
+    TFloat64 BuildMs = 0.0;
+    TFloat64 BinaryMs = 0.0;
+    TFloat64 CollapseMs = 0.0;
+    TUint32  TriangleCount = 0u;
+    TUint32  BinaryNodeCount = 0u;
+    TUint32  NodeCount = 0u;
+    TUint32  LeafCount = 0u;
+    TUint32  MaxDepth = 0u;
+    TFloat32 SahCost = 0.0f;
+  };
+
+  // binned sah bvh over triangles, built as a binary tree and collapsed into nodes with Width children whose bounds
+  // are stored per axis so one ray is tested against every child at once. triangles are copied in leaf order with
+  // precomputed edges, the source arrays are not referenced after Build. queries are const and thread safe
+  template <TUint32 Width> class Bvh {
+    static_assert(Width == 4u || Width == 8u, "bvh nodes are 4 or 8 wide");
+
+  public:
+    Bvh() = default;
+    ~Bvh() = default;
+
+  public:
+    void Build(const Vector<BvhGeometry> &geometries, const BvhBuildOptions &options = {});
+
+    // closest hit within [TMin, TMax]
+    bool Intersect(const BvhRay &ray, BvhHit &hit) const;
+    // any hit within [TMin, TMax], for shadow and visibility rays
+    bool Occluded(const BvhRay &ray) const;
+    // closest hits of up to BVH_PACKET_SIZE rays traversed together, worth it for coherent rays like camera rays
+    void IntersectPacket(const BvhRay *rays, BvhHit *hits, TUint32 count) const;
+
+  public:
+    inline bool                 IsEmpty() const { return m_Triangles.empty(); }
+    inline const BvhBuildStats &GetStats() const { return m_Stats; }
+    inline glm::vec3            GetBoundsMin() const { return m_BoundsMin; }
+    inline glm::vec3            GetBoundsMax() const { return m_BoundsMax; }
+
+  private:
+    // bounds per child, [0, 3) min xyz and [3, 6) max xyz. a child is a node index, a leaf or empty
+    struct alignas(16) Node {
+      TFloat32 Bounds[6][Width];
+      TUint32  Child[Width];
+    };
+
+    struct Triangle {
+      glm::vec3 Vertex0;
+      TUint32   Geometry;
+      glm::vec3 Edge1;
+      TUint32   Primitive;
+      glm::vec3 Edge2;
+      TUint32   Padding;
+    };
+
+  private:
+    Vector<Node>     m_Nodes = {};
+    Vector<Triangle> m_Triangles = {};
+    BvhBuildStats    m_Stats = {};
+    TUint32          m_StackSize = 1u; // traversal stack entries the deepest path can need
+    glm::vec3        m_BoundsMin = glm::vec3(BVH_INFINITY);
+    glm::vec3        m_BoundsMax = glm::vec3(-BVH_INFINITY);
+  };
+
+  using Bvh4 = Bvh<4u>;
+  using Bvh8 = Bvh<8u>;
+
+} // namespace mau
@@ -0,0 +1,96 @@
+#include "camera-path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <engine/log.h>
+
+namespace mau {
+
+  static glm::vec3 catmull_rom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, TFloat32 t) {
+    const TFloat32 t2 = t * t;
+    const TFloat32 t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+  }
+
+  bool CameraPath::Load(const String &path) {
+    m_Keyframes.clear();
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      LOG_ERROR("failed to open camera path %s", path.c_str());
+      return false;
+    }
+
+    String  line = "";
+    TUint32 line_number = 0u;
+    while (std::getline(file, line)) {
+      line_number++;
+      line = line.substr(0, line.find('#'));
+      if (line.find_first_not_of(" \t\r") == String::npos)
+        continue;
+
+      CameraKeyframe     keyframe = {};
+      std::istringstream stream(line);
+      stream >> keyframe.Time >> keyframe.Position.x >> keyframe.Position.y >> keyframe.Position.z >> keyframe.Direction.x >> keyframe.Direction.y >> keyframe.Direction.z;
+
+      if (stream.fail() || glm::length(keyframe.Direction) == 0.0f) {
+        LOG_ERROR("invalid camera keyframe in %s:%u", path.c_str(), line_number);
+        m_Keyframes.clear();
+        return false;
+      }
+
+      if (!m_Keyframes.empty() && keyframe.Time <= m_Keyframes.back().Time) {
+        LOG_ERROR("camera keyframes out of order in %s:%u", path.c_str(), line_number);
+        m_Keyframes.clear();
+        return false;
+      }
+
+      keyframe.Direction = glm::normalize(keyframe.Direction);
+      m_Keyframes.push_back(keyframe);
+    }
+
+    if (m_Keyframes.empty()) {
+      LOG_ERROR("camera path %s has no keyframes", path.c_str());
+      return false;
+    }
+
+    LOG_INFO("camera path loaded %s [keyframes: %u, duration: %.2f s]", path.c_str(), static_cast<TUint32>(m_Keyframes.size()), GetDuration());
+    return true;
+  }
+
+  Camera CameraPath::Sample(TFloat32 time) const {
+    Camera camera = {};
+    if (m_Keyframes.empty())
+      return camera;
+
+    if (m_Keyframes.size() == 1u || GetDuration() <= 0.0f) {
+      camera.Position = m_Keyframes.front().Position;
+      camera.Direction = m_Keyframes.front().Direction;
+      return camera;
+    }
+
+    time = m_Keyframes.front().Time + std::fmod(std::max(time, 0.0f), GetDuration());
+
+    // first keyframe after time, the segment is [next - 1, next]
+    const auto   it = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time, [](TFloat32 t, const CameraKeyframe &keyframe) -> bool { return t < keyframe.Time; });
+    const size_t next = std::clamp(static_cast<size_t>(it - m_Keyframes.begin()), static_cast<size_t>(1u), m_Keyframes.size() - 1u);
+    const size_t last = m_Keyframes.size() - 1u;
+
+    const CameraKeyframe &k0 = m_Keyframes[next > 1u ? next - 2u : 0u];
+    const CameraKeyframe &k1 = m_Keyframes[next - 1u];
+    const CameraKeyframe &k2 = m_Keyframes[next];
+    const CameraKeyframe &k3 = m_Keyframes[std::min(next + 1u, last)];
+
+    const TFloat32 t = std::clamp((time - k1.Time) / (k2.Time - k1.Time), 0.0f, 1.0f);
+
+    camera.Position = catmull_rom(k0.Position, k1.Position, k2.Position, k3.Position, t);
+
+    // opposite directions have no halfway point, keep the earlier one until the end of the segment
+    const glm::vec3 direction = glm::mix(k1.Direction, k2.Direction, t);
+    camera.Direction = glm::length(direction) > 1e-4f ? glm::normalize(direction) : k1.Direction;
+    return camera;
+  }
+
+} // namespace mau
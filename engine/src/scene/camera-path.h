@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <engine/types.h>
+#include "scene/camera.h"
+
+namespace mau {
+
+  struct CameraKeyframe {
+    TFloat32  Time = 0.0f;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Direction = glm::vec3(0.0f, 0.0f, 1.0f);
+  };
+
+  // camera keyframes read from a text file, one "time px py pz dx dy dz" line per keyframe in increasing time,
+  // '#' starts a comment. positions follow a catmull-rom spline through the keyframes, directions are blended linearly
+  class CameraPath {
+  public:
+    CameraPath() = default;
+    ~CameraPath() = default;
+
+  public:
+    bool Load(const String &path);
+
+    // time counts from the first keyframe, past the last keyframe the path starts over
+    Camera Sample(TFloat32 time) const;
+
+  public:
+    inline bool                          IsEmpty() const { return m_Keyframes.empty(); }
+    inline TFloat32                      GetDuration() const { return m_Keyframes.empty() ? 0.0f : m_Keyframes.back().Time - m_Keyframes.front().Time; }
+    inline const Vector<CameraKeyframe> &GetKeyframes() const { return m_Keyframes; }
+
+  private:
+    Vector<CameraKeyframe> m_Keyframes = {};
+  };
+
+} // namespace mau
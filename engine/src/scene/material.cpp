@@ -1,6 +1,7 @@
 #include "material.h"
 
 #include "graphics/vulkan-bindless.h"
+#include "loader/texture-streamer.h"
 
 namespace mau {
 
@@ -8,16 +9,32 @@ namespace mau {
     GPUMaterial material = {};
 
     if (create_info.DiffuseMap != "") {
-      m_Diffuse = make_handle<Texture>(create_info.DiffuseMap);
-      material.Diffuse = VulkanBindless::Ref().AddTexture(m_Diffuse);
+      m_Diffuse = TextureStreamer::Ref().Load(create_info.DiffuseMap, TextureKind::COLOR);
+      m_DiffuseHandle = VulkanBindless::Ref().AddTexture(m_Diffuse);
     }
 
     if (create_info.NormalMap != "") {
-      m_Normal = make_handle<Texture>(create_info.NormalMap);
-      material.Normal = VulkanBindless::Ref().AddTexture(m_Normal);
+      m_Normal = TextureStreamer::Ref().Load(create_info.NormalMap, TextureKind::NORMAL);
+      m_NormalHandle = VulkanBindless::Ref().AddTexture(m_Normal);
     }
 
+    material.Diffuse = get_bindless_index(m_DiffuseHandle);
+    material.Normal = get_bindless_index(m_NormalHandle);
+
     m_MaterialHandle = VulkanBindless::Ref().AddMaterial(material);
   }
 
+  Material::~Material() {
+    if (!VulkanBindless::Get())
+      return;
+
+    VulkanBindless::Ref().Release(BindlessDescriptorType::MATERIAL, m_MaterialHandle);
+    VulkanBindless::Ref().Release(BindlessDescriptorType::TEXTURE, m_DiffuseHandle);
+    VulkanBindless::Ref().Release(BindlessDescriptorType::TEXTURE, m_NormalHandle);
+
+    // frames in flight may still sample the textures through the released slots
+    VulkanBindless::Ref().Defer(m_Diffuse);
+    VulkanBindless::Ref().Defer(m_Normal);
+  }
+
 } // namespace mau
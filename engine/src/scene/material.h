@@ -14,7 +14,7 @@ namespace mau {
   class Material: public HandledObject {
   public:
     Material(const MaterialCreateInfo &create_info);
-    ~Material() = default;
+    ~Material();
 
   public:
     inline MaterialHandle GetMaterialHandle() const { return m_MaterialHandle; }
@@ -22,6 +22,8 @@ namespace mau {
   private:
     Handle<Texture> m_Diffuse = nullptr;
     Handle<Texture> m_Normal = nullptr;
+    TextureHandle   m_DiffuseHandle = UINT32_MAX;
+    TextureHandle   m_NormalHandle = UINT32_MAX;
     MaterialHandle  m_MaterialHandle = UINT32_MAX;
   };
 
@@ -1,33 +1,37 @@
 #include "mesh.h"
 
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <filesystem>
+#include <memory>
 #include <engine/log.h>
+#include <engine/core/job-system.h>
+#include <engine/profiler.h>
+#include <engine/loader/cooker.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <glm/glm.hpp>
 #include "graphics/vulkan-bindless.h"
 #include "graphics/vulkan-features.h"
+#include "loader/mesh-cache.h"
 
 namespace mau {
 
-  struct Vertex {
-    glm::vec3 pos;
-    glm::vec3 normal;
-    glm::vec2 tex;
-  };
-
-  SubMesh::SubMesh(Handle<VertexBuffer> vertex_buffer, Handle<IndexBuffer> index_buffer, TUint32 index_count, Handle<Material> material)
-      : m_Vertices(vertex_buffer), m_Indices(index_buffer), m_IndexCount(index_count), m_Material(material) {
+  SubMesh::SubMesh(Handle<GeometryAllocation> geometry, Handle<Material> material, const MeshLodChain &lods): m_Geometry(geometry), m_Material(material), m_Lods(lods) {
 
     if (!VulkanFeatures::IsRtEnabled())
       return;
 
+    Handle<VertexBuffer> vertex_buffer = geometry->GetVertexBuffer();
+    Handle<IndexBuffer>  index_buffer = geometry->GetIndexBuffer();
+
+    // the shaders index from the start of the range, indices stay local to the submesh. ray tracing always sees the
+    // full detail level, it is the first one in the range
     RTObjectDesc desc = {
-        .VertexBuffer = vertex_buffer->GetDeviceAddress(),
-        .IndexBuffer = index_buffer->GetDeviceAddress(),
-        .Material = material->GetMaterialHandle(),
+        .VertexBuffer = vertex_buffer->GetDeviceAddress() + geometry->GetVertexByteOffset(),
+        .IndexBuffer = index_buffer->GetDeviceAddress() + geometry->GetIndexByteOffset(),
+        .Material = get_bindless_index(material->GetMaterialHandle()),
 
         .padding = {0, 0, 0},
     };
@@ -36,127 +40,240 @@ namespace mau {
     AccelerationBufferCreateInfo create_info = {
         .Vertices = vertex_buffer,
         .Indices = index_buffer,
+        .VertexOffset = geometry->GetVertexByteOffset(),
+        .IndexOffset = geometry->GetIndexByteOffset(),
         .VertexSize = sizeof(Vertex),
         .PositionOffset = offsetof(Vertex, pos),
-        .VertexCount = static_cast<TUint32>(vertex_buffer->GetSize() / sizeof(Vertex)),
-        .IndexCount = index_count,
-        .CustomIndex = m_RTDescHandle,
+        .VertexCount = static_cast<TUint32>(geometry->GetVertexCount()),
+        .IndexCount = lods.Levels[0].IndexCount,
+        .CustomIndex = get_bindless_index(m_RTDescHandle),
     };
 
     m_Accel = make_handle<BottomLevelAS>(create_info);
   }
 
+  using Clock = std::chrono::high_resolution_clock;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  struct VertexData {
+    Vector<Vertex>  vertices = {};
+    Vector<TUint32> indices = {};
+    MeshLodChain    lods = {};
+  };
+
+  static Handle<Material> make_material(const MaterialPaths &paths, const String &directory) {
+    MaterialCreateInfo create_info = {};
+
+    if (!paths.DiffuseMap.empty())
+      create_info.DiffuseMap = directory + "/" + paths.DiffuseMap;
+    if (!paths.NormalMap.empty())
+      create_info.NormalMap = directory + "/" + paths.NormalMap;
+
+    return make_handle<Material>(create_info);
+  }
+
   Mesh::Mesh(const String &filename) {
-    Assimp::Importer importer;
-    const aiScene   *scene = importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_RemoveRedundantMaterials);
+    MAU_PROFILE_SCOPE("Mesh::Mesh");
 
-    if (scene == nullptr) {
-      LOG_ERROR("failed to load mesh %s [reason: %s]", filename.c_str(), importer.GetErrorString());
+    const Clock::time_point load_start = Clock::now();
+
+    if (!LoadCooked(filename) && !Import(filename))
       return;
-    }
 
-    const String directory = std::filesystem::path(filename).parent_path().string();
+    m_LoadStats.SubMeshCount = static_cast<TUint32>(m_SubMeshes.size());
+    m_LoadStats.TotalTime = elapsed_ms(load_start);
 
-    struct VertexData {
-      Vector<Vertex>  vertices = {};
-      Vector<TUint32> indices = {};
-    };
+    LOG_INFO("loaded mesh %s [submeshes: %u, vertices: %llu, indices: %llu, lods: %u, lod indices: %llu, workers: %u, cooked: %s]", filename.c_str(), m_LoadStats.SubMeshCount,
+             static_cast<unsigned long long>(m_LoadStats.VertexCount), static_cast<unsigned long long>(m_LoadStats.IndexCount), m_LoadStats.LodCount,
+             static_cast<unsigned long long>(m_LoadStats.LodIndexCount), m_LoadStats.WorkerCount, m_LoadStats.Cooked ? "yes" : "no");
+    LOG_INFO("mesh load timings [import: %.2fms, convert: %.2fms, lods: %.2fms, materials: %.2fms, upload: %.2fms, accel: %.2fms, bounds: %.2fms, total: %.2fms]", m_LoadStats.ImportTime,
+             m_LoadStats.ConvertTime, m_LoadStats.LodTime, m_LoadStats.MaterialTime, m_LoadStats.UploadTime, m_LoadStats.AccelTime, m_LoadStats.BoundsTime, m_LoadStats.TotalTime);
+  }
 
-    UnorderedMap<TUint32, VertexData> submeshes = {};
+  Mesh::~Mesh() {
+    // submeshes are copied around by value, the mesh owns their slots. frames in flight may still trace the blas, it
+    // goes with the slot. the arena holds released geometry back on its own
+    if (VulkanBindless::Get()) {
+      for (const SubMesh &submesh : m_SubMeshes) {
+        VulkanBindless::Ref().Release(BindlessDescriptorType::RT_OBJECT_DESC, submesh.GetRTObjectHandle());
+        VulkanBindless::Ref().Defer(submesh.GetAccel());
+      }
+    }
 
-    auto process_mesh = [&](aiMesh *mesh) -> void {
-      const TUint32 material_index = mesh->mMaterialIndex;
+    m_SubMeshes.clear();
+  }
 
-      if (!submeshes.contains(material_index)) {
-        submeshes.insert(std::make_pair(material_index, VertexData{}));
-      }
+  bool Mesh::LoadCooked(const String &filename) {
+    MAU_PROFILE_SCOPE("Mesh::LoadCooked");
 
-      VertexData   &data = submeshes.at(material_index);
-      const TUint32 vertex_offset = static_cast<TUint32>(data.vertices.size());
+    const String cooked_path = GetCookedMeshPath(filename);
+    if (!std::filesystem::exists(cooked_path))
+      return false;
 
-      for (TUint32 i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vert;
-        vert.pos.x = mesh->mVertices[i].x;
-        vert.pos.y = mesh->mVertices[i].y;
-        vert.pos.z = mesh->mVertices[i].z;
+    // stamps of the source and everything it references, shipping without the source trusts the cooked file as is
+    const Clock::time_point map_start = Clock::now();
+    CookedMesh              cooked(cooked_path, filename);
+    m_LoadStats.ImportTime = elapsed_ms(map_start);
 
-        vert.normal.x = mesh->mNormals[i].x;
-        vert.normal.y = mesh->mNormals[i].y;
-        vert.normal.z = mesh->mNormals[i].z;
+    if (!cooked.IsValid())
+      return false;
 
-        if (mesh->mTextureCoords[0]) {
-          vert.tex.x = mesh->mTextureCoords[0][i].x;
-          vert.tex.y = 1.0f - mesh->mTextureCoords[0][i].y;
-        }
+    const String                     directory = std::filesystem::path(filename).parent_path().string();
+    const Vector<CookedSubMeshView> &views = cooked.GetSubMeshes();
+    Vector<Handle<Material>>         materials = {};
 
-        data.vertices.push_back(vert);
-      }
+    {
+      MAU_PROFILE_SCOPE("Mesh::Materials");
+      Clock::time_point start = Clock::now();
 
-      for (TUint32 i = 0; i < mesh->mNumFaces; i++) {
-        aiFace *face = &(mesh->mFaces[i]);
-        for (TUint32 j = 0; j < face->mNumIndices; j++) {
-          data.indices.push_back(vertex_offset + face->mIndices[j]);
-        }
+      for (const CookedSubMeshView &view : views) {
+        materials.push_back(make_material(view.Paths, directory));
       }
-    };
 
-    std::function<void(aiNode *)> process_node = [&](aiNode *node) -> void {
-      for (TUint32 i = 0; i < node->mNumMeshes; i++) {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        process_mesh(mesh);
-      }
+      m_LoadStats.MaterialTime = elapsed_ms(start);
+    }
+
+    {
+      // blocks go straight from the mapping into staging
+      MAU_PROFILE_SCOPE("Mesh::Upload");
+      Clock::time_point start = Clock::now();
 
-      for (TUint32 i = 0; i < node->mNumChildren; i++) {
-        process_node(node->mChildren[i]);
+      for (size_t i = 0; i < views.size(); i++) {
+        AddSubMesh(views[i].Vertices, views[i].VertexCount, views[i].Indices, views[i].IndexCount, views[i].Lods, materials[i]);
       }
-    };
 
-    process_node(scene->mRootNode);
+      m_LoadStats.UploadTime = elapsed_ms(start);
+    }
 
-    Vector<Handle<BottomLevelAS>> blases = {};
+    m_LoadStats.Cooked = true;
+    return true;
+  }
 
-    for (const auto &[material_index, vertex_data] : submeshes) {
-      const Vector<Vertex>  &vertices = vertex_data.vertices;
-      const Vector<TUint32> &indices = vertex_data.indices;
+  bool Mesh::Import(const String &filename) {
+    MAU_PROFILE_SCOPE("Mesh::Import");
 
-      Handle<VertexBuffer> vertex_buffer = make_handle<VertexBuffer>(vertices.size() * sizeof(vertices[0]), vertices.data());
-      Handle<IndexBuffer>  index_buffer = make_handle<IndexBuffer>(indices.size() * sizeof(indices[0]), indices.data());
-      TUint32              index_count = static_cast<TUint32>(indices.size());
-      Handle<Material>     material = nullptr;
+    Assimp::Importer importer;
+    const aiScene   *scene = nullptr;
 
-      if (material_index >= 0) {
-        aiMaterial        *ai_material = scene->mMaterials[material_index];
-        MaterialCreateInfo create_info = {};
+    {
+      Clock::time_point start = Clock::now();
+      scene = importer.ReadFile(filename, get_mesh_import_flags());
+      m_LoadStats.ImportTime = elapsed_ms(start);
+    }
 
-        const TUint32 diffuse_map_count = ai_material->GetTextureCount(aiTextureType_DIFFUSE);
-        const TUint32 normal_map_count = ai_material->GetTextureCount(aiTextureType_NORMALS);
+    if (scene == nullptr) {
+      LOG_ERROR("failed to load mesh %s [reason: %s]", filename.c_str(), importer.GetErrorString());
+      return false;
+    }
 
-        if (diffuse_map_count > 0) {
-          aiString texture_path;
-          ai_material->GetTexture(aiTextureType_DIFFUSE, 0, &texture_path);
-          create_info.DiffuseMap = directory + "/" + texture_path.C_Str();
-        }
+    const String directory = std::filesystem::path(filename).parent_path().string();
 
-        if (normal_map_count > 0) {
-          aiString texture_path;
-          ai_material->GetTexture(aiTextureType_NORMALS, 0, &texture_path);
-          create_info.NormalMap = directory + "/" + texture_path.C_Str();
-        }
+    // gather meshes per material so that every bucket can be sized up front
+    const Vector<MeshBucket>      buckets = gather_mesh_buckets(scene);
+    Vector<VertexData>            converted(buckets.size());
+    Vector<std::exception_ptr>    errors(buckets.size());
+    std::unique_ptr<JobCounter[]> counters = std::make_unique<JobCounter[]>(buckets.size());
+
+    // convert buckets on the job system, the main thread uploads every bucket as soon as it is ready
+    std::atomic<TUint64>    convert_time_ns = 0u;
+    std::atomic<TUint64>    lod_time_ns = 0u;
+    const Clock::time_point convert_start = Clock::now();
+
+    for (size_t index = 0; index < buckets.size(); index++) {
+      JobSystem::Ref().Schedule(
+          [&, index]() -> void {
+            MAU_PROFILE_SCOPE("Mesh::ConvertBucket");
+            const MeshBucket &bucket = buckets[index];
+            try {
+              VertexData &data = converted[index];
+              data.vertices.resize(bucket.vertex_count);
+              data.indices.resize(bucket.index_count);
+              convert_mesh_bucket(bucket, data.vertices.data(), data.indices.data());
+
+              // simplified levels are appended to the indices
+              const Clock::time_point lod_start = Clock::now();
+              data.lods = build_mesh_lods(data.vertices.data(), data.vertices.size(), data.indices);
+              lod_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - lod_start).count();
+            } catch (...) {
+              errors[index] = std::current_exception();
+            }
+
+            const TUint64 job_time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - convert_start).count();
+            for (TUint64 current = convert_time_ns; current < job_time && !convert_time_ns.compare_exchange_weak(current, job_time);) {
+            }
+          },
+          &counters[index]);
+    }
 
-        material = make_handle<Material>(create_info);
+    // textures are decoded and uploaded while the vertex data is being converted
+    Vector<Handle<Material>> materials = {};
+
+    {
+      MAU_PROFILE_SCOPE("Mesh::Materials");
+      Clock::time_point start = Clock::now();
+
+      for (const MeshBucket &bucket : buckets) {
+        materials.push_back(make_material(get_material_paths(scene, bucket.material_index), directory));
       }
 
-      SubMesh submesh(vertex_buffer, index_buffer, index_count, material);
-      m_SubMeshes.push_back(submesh);
-      blases.push_back(submesh.GetAccel());
+      m_LoadStats.MaterialTime = elapsed_ms(start);
     }
 
-    if (VulkanFeatures::IsRtEnabled()) {
-      m_TLAS = make_handle<AccelerationBuffer>(blases);
-      VulkanBindless::Ref().AddAccelerationStructure(m_TLAS);
+    {
+      MAU_PROFILE_SCOPE("Mesh::Upload");
+      Clock::time_point start = Clock::now();
+
+      for (size_t i = 0; i < buckets.size(); i++) {
+        JobSystem::Ref().Wait(counters[i]);
+
+        // the remaining jobs still reference the locals of this function
+        if (errors[i]) {
+          for (size_t j = i + 1u; j < buckets.size(); j++) {
+            JobSystem::Ref().Wait(counters[j]);
+          }
+          std::rethrow_exception(errors[i]);
+        }
+
+        VertexData &data = converted[i];
+        AddSubMesh(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), data.lods, materials[i]);
+        data = {};
+      }
+
+      m_LoadStats.UploadTime = elapsed_ms(start);
     }
+
+    m_LoadStats.ConvertTime = static_cast<TFloat64>(convert_time_ns.load()) * 1e-6;
+    m_LoadStats.LodTime = static_cast<TFloat64>(lod_time_ns.load()) * 1e-6;
+    m_LoadStats.WorkerCount = JobSystem::Ref().GetThreadCount();
+
+    LOG_INFO("%s is not cooked, run mau-cooker to skip the import", filename.c_str());
+    return true;
   }
 
-  Mesh::~Mesh() { m_SubMeshes.clear(); }
+  void Mesh::AddSubMesh(const Vertex *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count, const MeshLodChain &lods, Handle<Material> material) {
+    if (vertex_count == 0u || index_count == 0u || lods.Count == 0u)
+      return;
+
+    // every level in one allocation, the draw list picks a level by its range
+    Handle<GeometryAllocation> geometry = GeometryArena::Ref().Allocate(vertices, vertex_count, indices, index_count);
+
+    // the blas is built with the submesh, instances of it go into the renderer's scene tlas
+    const Clock::time_point start = Clock::now();
+    SubMesh                 submesh(geometry, material, lods);
+    m_LoadStats.AccelTime += elapsed_ms(start);
+
+    // culling tests these against the frustum every frame, cooked meshes get them here as well
+    const Clock::time_point bounds_start = Clock::now();
+    compute_bounds(&vertices[0].pos, sizeof(Vertex), vertex_count, submesh.m_Bounds, submesh.m_BoundingSphere);
+    m_LoadStats.BoundsTime += elapsed_ms(bounds_start);
+
+    m_SubMeshes.push_back(submesh);
+
+    m_LoadStats.VertexCount += vertex_count;
+    m_LoadStats.IndexCount += lods.Levels[0].IndexCount;
+    m_LoadStats.LodIndexCount += index_count - lods.Levels[0].IndexCount;
+    m_LoadStats.LodCount += lods.Count - 1u;
+  }
 
 } // namespace mau
@@ -2,35 +2,67 @@
 
 #include <engine/types.h>
 
+#include "graphics/vulkan-arena.h"
 #include "graphics/vulkan-buffers.h"
+#include "loader/mesh-lod.h"
+#include "bounds.h"
 #include "material.h"
 
 namespace mau {
 
+  // a range of the geometry arena, submeshes of every mesh share the arena buffers. the indices of every level of
+  // detail follow each other in the range, all of them index the same vertices
   class SubMesh {
     friend class Mesh;
 
   private:
-    SubMesh(Handle<VertexBuffer> vertex_buffer, Handle<IndexBuffer> index_buffer, TUint32 index_count, Handle<Material> material);
+    SubMesh(Handle<GeometryAllocation> geometry, Handle<Material> material, const MeshLodChain &lods);
 
   public:
     ~SubMesh() = default;
 
   public:
-    inline Handle<VertexBuffer>  GetVertexBuffer() const { return m_Vertices; }
-    inline Handle<IndexBuffer>   GetIndexBuffer() const { return m_Indices; }
-    inline TUint32               GetIndexCount() const { return m_IndexCount; }
-    inline Handle<Material>      GetMaterial() const { return m_Material; }
-    inline Handle<BottomLevelAS> GetAccel() const { return m_Accel; }
-    inline RTObjectHandle        GetRTObjectHandle() const { return m_RTDescHandle; }
+    inline Handle<GeometryAllocation> GetGeometry() const { return m_Geometry; }
+    // of the full detail level
+    inline TUint32                    GetIndexCount() const { return m_Lods.Levels[0].IndexCount; }
+    inline const MeshLodChain        &GetLods() const { return m_Lods; }
+    inline Handle<Material>           GetMaterial() const { return m_Material; }
+    inline Handle<BottomLevelAS>      GetAccel() const { return m_Accel; }
+    inline RTObjectHandle             GetRTObjectHandle() const { return m_RTDescHandle; }
+    inline const BoundingBox         &GetBounds() const { return m_Bounds; }
+    inline const BoundingSphere      &GetBoundingSphere() const { return m_BoundingSphere; }
 
   private:
-    Handle<VertexBuffer>  m_Vertices = nullptr;
-    Handle<IndexBuffer>   m_Indices = nullptr;
-    Handle<BottomLevelAS> m_Accel = nullptr;
-    Handle<Material>      m_Material = nullptr;
-    TUint32               m_IndexCount = 0u;
-    RTObjectHandle        m_RTDescHandle = 0u;
+    Handle<GeometryAllocation> m_Geometry = nullptr;
+    Handle<BottomLevelAS>      m_Accel = nullptr;
+    Handle<Material>           m_Material = nullptr;
+    RTObjectHandle             m_RTDescHandle = UINT32_MAX;
+    // local space, computed from the vertices when the mesh is loaded
+    BoundingBox                m_Bounds = {};
+    BoundingSphere             m_BoundingSphere = {};
+    MeshLodChain               m_Lods = {};
+  };
+
+  // per stage wall-clock timings of a mesh import, all in milliseconds
+  struct MeshLoadStats {
+    TFloat64 ImportTime = 0.0;
+    TFloat64 ConvertTime = 0.0;
+    TFloat64 MaterialTime = 0.0;
+    TFloat64 UploadTime = 0.0;
+    // blas builds and submesh bounds, part of the upload
+    TFloat64 AccelTime = 0.0;
+    TFloat64 BoundsTime = 0.0;
+    // lod chains summed over the workers, part of the conversion
+    TFloat64 LodTime = 0.0;
+    TFloat64 TotalTime = 0.0;
+    TUint32  WorkerCount = 0u;
+    TUint32  SubMeshCount = 0u;
+    TUint64  VertexCount = 0u;
+    TUint64  IndexCount = 0u;
+    // indices of the simplified levels, on top of IndexCount
+    TUint64  LodIndexCount = 0u;
+    TUint32  LodCount = 0u;
+    bool     Cooked = false;
   };
 
   class Mesh: public HandledObject {
@@ -39,12 +71,17 @@ namespace mau {
     ~Mesh();
 
   public:
-    inline const Vector<SubMesh>     &GetSubMeshes() const { return m_SubMeshes; }
-    inline Handle<AccelerationBuffer> GetAccel() const { return m_TLAS; }
+    inline const Vector<SubMesh> &GetSubMeshes() const { return m_SubMeshes; }
+    inline const MeshLoadStats   &GetLoadStats() const { return m_LoadStats; }
+
+  private:
+    bool LoadCooked(const String &filename);
+    bool Import(const String &filename);
+    void AddSubMesh(const Vertex *vertices, TUint64 vertex_count, const TUint32 *indices, TUint64 index_count, const MeshLodChain &lods, Handle<Material> material);
 
   private:
-    Vector<SubMesh>            m_SubMeshes = {};
-    Handle<AccelerationBuffer> m_TLAS = nullptr;
+    Vector<SubMesh> m_SubMeshes = {};
+    MeshLoadStats   m_LoadStats = {};
   };
 
 } // namespace mau
@@ -1,9 +1,47 @@
 #include <engine/scene/scene.h>
 #include <engine/assert.h>
+#include <engine/log.h>
+
+#include "transform-system.h"
 
 namespace mau {
 
-  Scene::Scene() { }
+  // depth of entity and everything below it from its parent's
+  static void update_depth(entt::registry &registry, entt::entity entity) {
+    Vector<entt::entity> stack = {entity};
+    while (!stack.empty()) {
+      const entt::entity  current = stack.back();
+      HierarchyComponent &hierarchy = registry.get<HierarchyComponent>(current);
+      stack.pop_back();
+
+      hierarchy.Depth = hierarchy.Parent != entt::null ? registry.get<HierarchyComponent>(hierarchy.Parent).Depth + 1u : 0u;
+      for (entt::entity child = hierarchy.FirstChild; child != entt::null; child = registry.get<HierarchyComponent>(child).NextSibling) {
+        stack.push_back(child);
+      }
+    }
+  }
+
+  static void unlink(entt::registry &registry, entt::entity entity) {
+    HierarchyComponent &hierarchy = registry.get<HierarchyComponent>(entity);
+    if (hierarchy.Parent == entt::null)
+      return;
+
+    HierarchyComponent &parent = registry.get<HierarchyComponent>(hierarchy.Parent);
+    if (parent.FirstChild == entity) {
+      parent.FirstChild = hierarchy.NextSibling;
+    } else {
+      entt::entity sibling = parent.FirstChild;
+      while (registry.get<HierarchyComponent>(sibling).NextSibling != entity) {
+        sibling = registry.get<HierarchyComponent>(sibling).NextSibling;
+      }
+      registry.get<HierarchyComponent>(sibling).NextSibling = hierarchy.NextSibling;
+    }
+
+    hierarchy.Parent = entt::null;
+    hierarchy.NextSibling = entt::null;
+  }
+
+  Scene::Scene() { m_TransformSystem = make_handle<TransformSystem>(); }
 
   Scene::~Scene() { m_Registry.clear(); }
 
@@ -12,6 +50,8 @@ namespace mau {
 
     Entity entity(entity_id, m_Registry);
     entity.Add<TransformComponent>();
+    entity.Add<HierarchyComponent>();
+    entity.Add<WorldTransformComponent>();
     entity.Add<NameComponent>(name.empty() ? std::to_string(static_cast<ENTT_ID_TYPE>(entity_id)) : name);
 
     return entity;
@@ -22,6 +62,35 @@ namespace mau {
     return Entity(entity_id, m_Registry);
   }
 
+  bool Scene::SetParent(Entity child, Entity parent) {
+    for (entt::entity ancestor = parent.GetId(); ancestor != entt::null; ancestor = m_Registry.get<HierarchyComponent>(ancestor).Parent) {
+      if (ancestor == child.GetId()) {
+        LOG_WARN("can't parent entity %u to its own subtree", static_cast<TUint32>(child.GetId()));
+        return false;
+      }
+    }
+
+    unlink(m_Registry, child.GetId());
+
+    HierarchyComponent &hierarchy = child.Get<HierarchyComponent>();
+    HierarchyComponent &parent_hierarchy = parent.Get<HierarchyComponent>();
+    hierarchy.Parent = parent.GetId();
+    hierarchy.NextSibling = parent_hierarchy.FirstChild;
+    parent_hierarchy.FirstChild = child.GetId();
+
+    update_depth(m_Registry, child.GetId());
+    child.Get<TransformComponent>().Updated = true;
+    return true;
+  }
+
+  void Scene::RemoveParent(Entity child) {
+    unlink(m_Registry, child.GetId());
+    update_depth(m_Registry, child.GetId());
+    child.Get<TransformComponent>().Updated = true;
+  }
+
+  TransformUpdateStats Scene::UpdateTransforms() { return m_TransformSystem->Update(m_Registry); }
+
   void Scene::Each(EntityIterator func) {
     for (auto [entity_id] : m_Registry.storage<entt::entity>().each()) {
       Entity entity(entity_id, m_Registry);
@@ -0,0 +1,140 @@
+#include "transform-system.h"
+
+#include <chrono>
+#include <cmath>
+#include <engine/profiler.h>
+#include <engine/core/job-system.h>
+
+namespace mau {
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  // entries of a level per job, a world matrix is a few dozen multiplies
+  constexpr TUint32 TRANSFORM_BATCH_GRAIN = 2048u;
+
+  static TFloat64 elapsed_ms(Clock::time_point start) { return std::chrono::duration<TFloat64, std::milli>(Clock::now() - start).count(); }
+
+  glm::mat4 compose_transform(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale) {
+    const TFloat32 cx = std::cos(rotation.x), sx = std::sin(rotation.x);
+    const TFloat32 cy = std::cos(rotation.y), sy = std::sin(rotation.y);
+    const TFloat32 cz = std::cos(rotation.z), sz = std::sin(rotation.z);
+
+    // rx * ry * rz written out, columns scaled
+    glm::mat4 transform = glm::mat4(1.0f);
+    transform[0] = glm::vec4(cy * cz, cx * sz + sx * sy * cz, sx * sz - cx * sy * cz, 0.0f) * scale.x;
+    transform[1] = glm::vec4(-cy * sz, cx * cz - sx * sy * sz, sx * cz + cx * sy * sz, 0.0f) * scale.y;
+    transform[2] = glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * scale.z;
+    transform[3] = glm::vec4(position, 1.0f);
+    return transform;
+  }
+
+  TransformUpdateStats TransformSystem::Update(entt::registry &registry) {
+    MAU_PROFILE_SCOPE("TransformSystem::Update");
+
+    TransformUpdateStats    stats = {};
+    const Clock::time_point gather_start = Clock::now();
+
+    TransformStorage       &transforms = registry.storage<TransformComponent>();
+    const HierarchyStorage &hierarchies = registry.storage<HierarchyComponent>();
+    WorldStorage           &worlds = registry.storage<WorldTransformComponent>();
+
+    for (entt::entity entity : m_Updated) {
+      if (worlds.contains(entity))
+        worlds.get(entity).Updated = false;
+    }
+    m_Updated.clear();
+
+    for (TransformBatch &batch : m_Levels) {
+      batch.Positions.clear();
+      batch.Rotations.clear();
+      batch.Scales.clear();
+      batch.Parents.clear();
+      batch.Worlds.clear();
+    }
+
+    // a dirty entity below one that was gathered already is part of its subtree
+    m_Update++;
+    for (auto [entity, transform] : transforms.each()) {
+      if (!transform.Updated)
+        continue;
+
+      stats.DirtyCount++;
+      Gather(transforms, hierarchies, worlds, entity);
+    }
+
+    stats.GatherMs = elapsed_ms(gather_start);
+    const Clock::time_point compute_start = Clock::now();
+
+    // levels in order, every entry of a level has its parent's world matrix from the level above or untouched
+    for (TransformBatch &batch : m_Levels) {
+      const TUint32 count = static_cast<TUint32>(batch.Worlds.size());
+      if (count == 0u)
+        continue;
+
+      auto compute = [&batch](TUint32 begin, TUint32 end) -> void {
+        for (TUint32 i = begin; i < end; i++) {
+          const glm::mat4 local = compose_transform(batch.Positions[i], batch.Rotations[i], batch.Scales[i]);
+          batch.Worlds[i]->Matrix = batch.Parents[i] ? *batch.Parents[i] * local : local;
+          batch.Worlds[i]->Updated = true;
+        }
+      };
+
+      if (JobSystem::Get() && count > TRANSFORM_BATCH_GRAIN)
+        JobSystem::Ref().ParallelFor(count, TRANSFORM_BATCH_GRAIN, compute);
+      else
+        compute(0u, count);
+
+      stats.UpdatedCount += count;
+      stats.LevelCount++;
+    }
+
+    stats.ComputeMs = elapsed_ms(compute_start);
+    return stats;
+  }
+
+  void TransformSystem::Gather(TransformStorage &transforms, const HierarchyStorage &hierarchies, WorldStorage &worlds, entt::entity root) {
+    m_Stack.clear();
+    m_Stack.push_back(root);
+
+    while (!m_Stack.empty()) {
+      const entt::entity entity = m_Stack.back();
+      m_Stack.pop_back();
+
+      // reached through a dirty ancestor after it was gathered on its own, its subtree is in already
+      if (!Visit(entity))
+        continue;
+
+      TransformComponent       &transform = transforms.get(entity);
+      const HierarchyComponent &hierarchy = hierarchies.get(entity);
+      transform.Updated = false;
+
+      if (hierarchy.Depth >= m_Levels.size())
+        m_Levels.resize(hierarchy.Depth + 1u);
+
+      TransformBatch &batch = m_Levels[hierarchy.Depth];
+      batch.Positions.push_back(transform.Position);
+      batch.Rotations.push_back(transform.Rotation);
+      batch.Scales.push_back(transform.Scale);
+      batch.Parents.push_back(hierarchy.Parent != entt::null ? &worlds.get(hierarchy.Parent).Matrix : nullptr);
+      batch.Worlds.push_back(&worlds.get(entity));
+      m_Updated.push_back(entity);
+
+      for (entt::entity child = hierarchy.FirstChild; child != entt::null; child = hierarchies.get(child).NextSibling) {
+        m_Stack.push_back(child);
+      }
+    }
+  }
+
+  bool TransformSystem::Visit(entt::entity entity) {
+    const TUint32 index = static_cast<TUint32>(entt::to_entity(entity));
+    if (index >= m_Visited.size())
+      m_Visited.resize(index + 1u, 0u);
+
+    if (m_Visited[index] == m_Update)
+      return false;
+
+    m_Visited[index] = m_Update;
+    return true;
+  }
+
+} // namespace mau
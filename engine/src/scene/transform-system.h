@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <engine/types.h>
+#include <engine/utils/handle.h>
+#include <engine/scene/components.h>
+#include <engine/scene/scene.h>
+
+namespace mau {
+
+  // local transform without a parent, the order getModelMatrix used plus the scale: translate, rotate around x,
+  // y and z, scale
+  glm::mat4 compose_transform(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale);
+
+  // keeps WorldTransformComponent up to date. dirty entities and their subtrees are gathered into one batch per
+  // depth, a batch only reads world matrices of the levels above it so its entries are computed in parallel
+  class TransformSystem: public HandledObject {
+  public:
+    TransformSystem() = default;
+    ~TransformSystem() = default;
+
+  public:
+    TransformUpdateStats Update(entt::registry &registry);
+
+  private:
+    // one depth of the tree, structure of arrays so the compute loop only streams what it needs
+    struct TransformBatch {
+      Vector<glm::vec3>                 Positions = {};
+      Vector<glm::vec3>                 Rotations = {};
+      Vector<glm::vec3>                 Scales = {};
+      Vector<const glm::mat4 *>         Parents = {}; // world matrix of the parent, null for roots
+      Vector<WorldTransformComponent *> Worlds = {};
+    };
+
+    using TransformStorage = entt::storage_for_t<TransformComponent>;
+    using HierarchyStorage = entt::storage_for_t<HierarchyComponent>;
+    using WorldStorage = entt::storage_for_t<WorldTransformComponent>;
+
+  private:
+    // storages are looked up once per update, a registry get goes through the type map every call
+    void Gather(TransformStorage &transforms, const HierarchyStorage &hierarchies, WorldStorage &worlds, entt::entity root);
+    bool Visit(entt::entity entity);
+
+  private:
+    Vector<TransformBatch> m_Levels = {};
+    Vector<TUint32>        m_Visited = {}; // [entity index], update the entity was gathered in
+    Vector<entt::entity>   m_Stack = {};
+    // world matrices changed by the last update, their flag is cleared by the next one
+    Vector<entt::entity>   m_Updated = {};
+    TUint32                m_Update = 0u;
+  };
+
+} // namespace mau
@@ -118,7 +118,16 @@ namespace mau {
 
   // ------------------------- WINDOW ------------------------- //
 
-  Window::Window(TUint32 width, TUint32 height, std::string_view name) {
+  Window::Window(TUint32 width, TUint32 height, std::string_view name, bool headless) {
+    m_Width = width;
+    m_Height = height;
+    m_Headless = headless;
+
+    if (headless) {
+      LOG_INFO("headless window [%u, %u]", width, height);
+      return;
+    }
+
     // initialize glfw
     glfwSetErrorCallback(glfw_error_callback);
     GLFW_CALL(glfwInit(), "failed to initialize glfw");
@@ -141,13 +150,14 @@ namespace mau {
     glfwSetWindowSizeCallback(window, glfw_window_resize_callback);
 
     m_InternalState = reinterpret_cast<void *>(window);
-    m_Width = width;
-    m_Height = height;
 
     LOG_INFO("window created [%u, %u]", width, height);
   }
 
   Window::~Window() {
+    if (m_Headless)
+      return;
+
     GLFWwindow *window = reinterpret_cast<GLFWwindow *>(m_InternalState);
     if (window) {
       glfwDestroyWindow(window);
@@ -158,6 +168,10 @@ namespace mau {
   }
 
   bool Window::ShouldClose() const noexcept {
+    // nothing can close a headless window, the engine's frame limit ends the run
+    if (m_Headless)
+      return false;
+
     GLFWwindow *window = reinterpret_cast<GLFWwindow *>(m_InternalState);
     if (window) {
       return glfwWindowShouldClose(window) == GLFW_TRUE;
@@ -166,7 +180,11 @@ namespace mau {
     return true;
   }
 
-  void Window::PollEvents() const noexcept { glfwPollEvents(); }
+  void Window::PollEvents() const noexcept {
+    if (!m_Headless) {
+      glfwPollEvents();
+    }
+  }
 
   void Window::RegisterEventCallback(std::function<void(Event &)> callback) noexcept { m_EventCallback = callback; }
 } // namespace mau
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <engine/engine.h>
 #include <engine/enums.h>
 #include <engine/log.h>
@@ -5,7 +8,8 @@
 
 using namespace mau;
 
-int main() {
+// --headless [frames] renders offscreen and exits after that many frames, 600 by default
+int main(int argc, char **argv) {
   EngineConfig config;
   config.Width = 1920u;
   config.Height = 1080u;
@@ -13,6 +17,11 @@ int main() {
   config.WindowName = "Mau Engine";
   config.ValidationSeverity = VulkanValidationLogSeverity::ERROR | VulkanValidationLogSeverity::WARNING;
 
+  if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+    config.Headless = true;
+    config.FrameLimit = argc > 2 ? static_cast<TUint32>(std::max(1, std::atoi(argv[2]))) : 600u;
+  }
+
   try {
     Engine::Create(config);
 